@@ -0,0 +1,384 @@
+#!/usr/bin/python
+
+# Copyright 2011 Chris M Bouzek
+#
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the version 3 of the GNU Lesser General Public License
+# as published by the Free Software Foundation.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU Lesser General Public License for more details.
+#
+# You should have received a copy of the GNU Lesser General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+"""Benchmarks the bindings against each other on the same points.
+
+Usage:
+  python bench_bindings.py [-n POINTS] [-q QUERIES] [-d DIMS] [-k K]
+      [--dist DISTRIBUTIONS] [--seed SEED] [--driver KDTREE_BENCH]
+      [--layout LAYOUTS] [--json] DIR [DIR ...]
+
+Each DIR holds one built kdtree module, e.g. build/lib.linux-x86_64-2.7 after
+"python kdtree_setup.py build" in the top level directory or in cython_with_c.
+The modules share a name, so each is measured in its own child process.
+-n, -d, -k and --dist take comma separated lists, and every combination is
+run.  --driver also runs cython_with_c/kdtree_bench.c's "suite" mode on each
+combination, which times the C core alone; use it for the largest sizes,
+which take too long to generate and convert in Python.  --layout lists the
+node layouts the driver is run with, "preorder" and/or "veb".
+
+The datasets are generated with the same xorshift generator and in the same
+order as kdtree_bench.c, so a given seed gives the same points everywhere:
+  uniform     uniform in the unit hypercube
+  clusters    gaussian around 16 uniform centers
+  duplicates  one distinct uniform point per 100 points, repeated
+  manifold    a closed 1-dimensional curve through all dimensions
+The queries are drawn from the same distribution after the tree's points.
+
+For every binding this reports the build time, the time per query when the
+whole batch is handed over in one call ("batch", which is the core's speed
+plus one conversion of the input), the median and 99th percentile time of a
+single call, the calls per second, and the memory the tree takes per point
+(from the growth of the resident set, so only meaningful for large trees).
+The top level module and cython_with_c share the C core in
+cython_with_c/kdtree_raw.c, so their batch times should agree; the pure
+Cython modules carry their own engine and are listed for comparison.
+
+--json prints everything as one JSON document, tagged with the commit it was
+measured at, so that runs can be compared across commits.  A run that fails
+is reported on stderr, and once the others are done the script exits with a
+nonzero status.
+"""
+
+import array
+import ctypes
+import gc
+import json
+import math
+import optparse
+import os
+import platform
+import subprocess
+import sys
+import time
+
+# the best clock available; Python 2 has no perf_counter
+timer = getattr(time, 'perf_counter', time.time)
+
+MASK = (1 << 64) - 1
+DISTRIBUTIONS = ('uniform', 'clusters', 'duplicates', 'manifold')
+NUM_CLUSTERS = 16
+CLUSTER_SIGMA = 0.02
+DUPLICATE_RATIO = 100
+
+
+class Xorshift(object):
+  """The generator of kdtree_bench.c, so both draw the same numbers."""
+
+  def __init__(self, seed):
+    # xorshift must not be seeded with zero
+    self.state = (0x9e3779b97f4a7c15 * (seed + 1)) & MASK
+
+  def uniform(self):
+    x = self.state
+    x ^= (x << 13) & MASK
+    x ^= x >> 7
+    x ^= (x << 17) & MASK
+    self.state = x
+    return (x >> 11) * (1.0 / 9007199254740992.0)
+
+  def gaussian(self):
+    u = self.uniform()
+    v = self.uniform()
+    # 1 - u keeps the logarithm finite
+    return math.sqrt(-2.0 * math.log(1.0 - u)) * math.cos(2 * math.pi * v)
+
+
+def make_coords(num_points, dims, dist, rand):
+  """Generates num_points coordinate tuples, as make_coords in kdtree_bench.c."""
+  num_shared = 0
+  if 'clusters' == dist:
+    num_shared = NUM_CLUSTERS
+  elif 'duplicates' == dist:
+    num_shared = num_points // DUPLICATE_RATIO + 1
+  shared = [rand.uniform() for i in range(num_shared * dims)]
+
+  coords = []
+  for i in range(num_points):
+    if dist in ('clusters', 'duplicates'):
+      pick = int(rand.uniform() * num_shared) * dims
+      point = shared[pick:pick + dims]
+      if 'clusters' == dist:
+        point = [c + CLUSTER_SIGMA * rand.gaussian() for c in point]
+    elif 'manifold' == dist:
+      t = rand.uniform()
+      point = [0.5 + 0.5 * math.sin(2 * math.pi * (d + 1) * t + d)
+               for d in range(dims)]
+    else:
+      point = [rand.uniform() for d in range(dims)]
+    coords.append(tuple(point))
+  return coords
+
+
+def make_dataset(num_points, num_queries, dims, dist, seed):
+  """Returns the tree's points as (number, coords) pairs and the queries as
+  (-1, coords) pairs, so no query is excluded from its own results."""
+  coords = make_coords(num_points + num_queries, dims, dist, Xorshift(seed))
+  points = [(i, coords[i]) for i in range(num_points)]
+  queries = [(-1, c) for c in coords[num_points:]]
+  return points, queries
+
+
+def percentile(values, percent):
+  """The nearest-rank percentile of sorted values, as in kdtree_bench.c."""
+  rank = int(math.ceil(percent / 100.0 * len(values)))
+  return values[max(rank, 1) - 1]
+
+
+def resident_bytes():
+  """The resident set size of this process, or None if it cannot be read."""
+  try:
+    with open('/proc/self/statm') as statm:
+      return int(statm.read().split()[1]) * os.sysconf('SC_PAGE_SIZE')
+  except (IOError, OSError, ValueError):
+    return None
+
+
+class HandWritten(object):
+  """The hand-written extension in the top level directory."""
+  name = "hand-written"
+
+  def __init__(self, kdtree):
+    self.kdtree = kdtree
+
+  def build(self, points):
+    return self.kdtree.build(points)
+
+  def prepare(self, queries):
+    return queries
+
+  def search(self, tree, query, k):
+    tree.run_nn_search(query[0], query[1], k)
+
+  def batch(self, tree, queries, k):
+    tree.run_nn_search_batch(queries, k)
+
+
+class CythonWithC(HandWritten):
+  """The Cython wrapper around the C core in cython_with_c."""
+  name = "cython_with_c"
+
+  def build(self, points):
+    return self.kdtree.KDTreeNode(points)
+
+
+class PureCython(object):
+  """The pure Cython modules, cython_wrapper and cython_simple."""
+  name = "cython_simple"
+
+  def __init__(self, kdtree):
+    self.kdtree = kdtree
+
+  def build(self, points):
+    return self.kdtree.fill_tree(self.prepare(points))
+
+  def prepare(self, points):
+    return [self.kdtree.PointData(num, coords) for num, coords in points]
+
+  def search(self, tree, query, k):
+    tree.run_nn_search(query, k)
+
+  batch = None
+
+
+class CythonPool(PureCython):
+  """The C-struct node pool of cython_wrapper."""
+  name = "cython_wrapper"
+
+  def build(self, points):
+    return self.kdtree.fill_pool(self.prepare(points))
+
+  def batch(self, tree, queries, k):
+    # ctypes arrays export 2-d buffers on Python 2 as well, which neither
+    # array.array nor memoryview.cast do
+    dims = len(queries[0][1])
+    flat = array.array('d', [c for num, point in queries for c in point])
+    coords = (ctypes.c_double * dims * len(queries))()
+    ctypes.memmove(coords, flat.buffer_info()[0], len(flat) * flat.itemsize)
+    out = (ctypes.c_int * k * len(queries))()
+    tree.run_nn_search_batch(coords, k, out)
+
+
+def pick_binding(kdtree):
+  """Recognizes which binding a kdtree module is."""
+  if hasattr(kdtree, 'build'):
+    return HandWritten(kdtree)
+  if hasattr(kdtree, 'KDForest'):
+    return CythonWithC(kdtree)
+  if hasattr(kdtree, 'fill_pool'):
+    return CythonPool(kdtree)
+  return PureCython(kdtree)
+
+
+def measure(path, num_points, num_queries, dims, k, dist, seed):
+  """Measures the kdtree module in path on one dataset and prints the result
+  as one JSON object."""
+  sys.path.insert(0, path)
+  import kdtree
+  binding = pick_binding(kdtree)
+  points, queries = make_dataset(num_points, num_queries, dims, dist, seed)
+  items = binding.prepare(queries)
+
+  gc.collect()
+  rss_before = resident_bytes()
+  start = timer()
+  tree = binding.build(points)
+  build = timer() - start
+  rss_after = resident_bytes()
+
+  times = []
+  for item in items:
+    start = timer()
+    binding.search(tree, item, k)
+    times.append(timer() - start)
+  times.sort()
+
+  batch = None
+  if binding.batch is not None and queries:
+    start = timer()
+    binding.batch(tree, queries, k)
+    batch = (timer() - start) / len(queries) * 1e6
+
+  result = {'binding': binding.name, 'distribution': dist, 'n': num_points,
+            'd': dims, 'k': k, 'queries': num_queries, 'seed': seed,
+            'build_s': build, 'batch_us': batch,
+            'query_p50_us': None, 'query_p99_us': None, 'qps': None,
+            'bytes_per_point': None}
+  if times:
+    result['query_p50_us'] = percentile(times, 50) * 1e6
+    result['query_p99_us'] = percentile(times, 99) * 1e6
+    result['qps'] = len(times) / sum(times)
+  if rss_before is not None and rss_after > rss_before and num_points > 0:
+    result['bytes_per_point'] = float(rss_after - rss_before) / num_points
+  print(json.dumps(result))
+
+
+def int_list(text):
+  return [int(float(item)) for item in text.split(',')]
+
+
+def run_child(args):
+  """Runs a child process and returns its last line parsed as JSON, or None
+  after reporting the failure on stderr if it failed or printed no result."""
+  child = subprocess.Popen(args, stdout=subprocess.PIPE)
+  output = child.communicate()[0]
+  lines = output.decode().strip().splitlines()
+  result = None
+  if 0 == child.returncode and lines:
+    try:
+      result = json.loads(lines[-1])
+    except ValueError:
+      pass
+  if result is None:
+    sys.stderr.write("failed (exit status %d): %s\n" %
+                     (child.returncode, " ".join(args)))
+  return result
+
+
+def commit_id():
+  """The commit this script was checked out at, or None outside git."""
+  try:
+    output = subprocess.Popen(['git', 'rev-parse', 'HEAD'], stdout=subprocess.PIPE,
+                              stderr=subprocess.PIPE,
+                              cwd=os.path.dirname(os.path.abspath(__file__)))
+    commit = output.communicate()[0].decode().strip()
+    return commit or None
+  except OSError:
+    return None
+
+
+def binding_name(result):
+  layout = result.get('layout', 'preorder')
+  return result['binding'] if layout == 'preorder' else result['binding'] + '/' + layout
+
+
+def format_number(value, fmt):
+  return "-" if value is None else fmt % value
+
+
+def main():
+  parser = optparse.OptionParser(usage="%prog [options] DIR [DIR ...]")
+  parser.add_option("-n", "--points", default="100000",
+                    help="tree sizes, comma separated")
+  parser.add_option("-q", "--queries", type="int", default=10000)
+  parser.add_option("-d", "--dims", default="3", help="dimensions, comma separated")
+  parser.add_option("-k", default="10", help="neighbor counts, comma separated")
+  parser.add_option("--dist", default="uniform",
+                    help="distributions, comma separated: " + ", ".join(DISTRIBUTIONS))
+  parser.add_option("--seed", type="int", default=1)
+  parser.add_option("--driver", help="path to a built kdtree_bench to run too")
+  parser.add_option("--layout", default="preorder",
+                    help="node layouts for --driver, comma separated: preorder, veb")
+  parser.add_option("--json", action="store_true", help="print JSON")
+  parser.add_option("--child", help=optparse.SUPPRESS_HELP)
+  options, dirs = parser.parse_args()
+  dists = options.dist.split(',')
+  for dist in dists:
+    if dist not in DISTRIBUTIONS:
+      parser.error("unknown distribution %s" % dist)
+  if options.child:
+    measure(options.child, int(options.points), options.queries, int(options.dims),
+            int(options.k), dists[0], options.seed)
+    return
+  layouts = options.layout.split(',')
+  for layout in layouts:
+    if layout not in ("preorder", "veb"):
+      parser.error("unknown layout %s" % layout)
+  if not dirs and not options.driver:
+    parser.error("give at least one directory holding a built kdtree module")
+
+  results = []
+  failures = 0
+  if not options.json:
+    print("%-15s %-10s %9s %4s %5s %10s %10s %10s %10s %10s %10s" %
+          ("binding", "dist", "n", "d", "k", "build (s)", "batch (us)",
+           "p50 (us)", "p99 (us)", "qps", "bytes/pt"))
+  for dist in dists:
+    for num_points in int_list(options.points):
+      for dims in int_list(options.dims):
+        for k in int_list(options.k):
+          runs = [[sys.executable, os.path.abspath(__file__), "--child", path,
+                   "-n", str(num_points), "-q", str(options.queries),
+                   "-d", str(dims), "-k", str(k), "--dist", dist,
+                   "--seed", str(options.seed)] for path in dirs]
+          if options.driver:
+            runs.extend([options.driver, "suite", str(num_points),
+                         str(options.queries), str(k), str(dims), dist,
+                         str(options.seed), layout] for layout in layouts)
+          for args in runs:
+            result = run_child(args)
+            if result is None:
+              failures += 1
+              continue
+            results.append(result)
+            if not options.json:
+              print("%-15s %-10s %9d %4d %5d %10.3f %10s %10s %10s %10s %10s" %
+                    (binding_name(result), dist, num_points, dims, k, result['build_s'],
+                     format_number(result.get('batch_us'), "%.2f"),
+                     format_number(result['query_p50_us'], "%.2f"),
+                     format_number(result['query_p99_us'], "%.2f"),
+                     format_number(result['qps'], "%.0f"),
+                     format_number(result['bytes_per_point'], "%.0f")))
+  if options.json:
+    print(json.dumps({'commit': commit_id(), 'python': platform.python_version(),
+                      'machine': platform.machine(), 'time': int(time.time()),
+                      'results': results}, indent=1, sort_keys=True))
+  if failures:
+    sys.exit("%d of the runs failed" % failures)
+
+
+if __name__ == "__main__":
+  main()
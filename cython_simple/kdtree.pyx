@@ -18,8 +18,16 @@
 # http://code.google.com/p/python-kdtree/
 # and
 # http://en.wikipedia.org/wiki/Kd-tree
+#
+# This module builds and searches its trees in Cython alone, to show how; it
+# does not use the C core in cython_with_c that the other bindings share.
+from cpython cimport array
 import array
 
+cdef extern from "stdlib.h":
+  void free(void* ptr)
+  void* malloc(size_t size)
+
 cdef class BestPair:
   """Represents distance to a node from another node."""
   cdef int node_num
@@ -142,35 +150,72 @@ cpdef print_preorder(KDTreeNode node):
   print_preorder(node.left)
   print_preorder(node.right)
 
-cdef KDTreeNode fill_tree_r(pointList, size_t depth):
-  """Constructs a KD-tree and returns the root node.  pointList is a list of PointData elements."""
-  if not pointList:
+cdef KDTreeNode fill_tree_r(pointList, size_t *order, size_t num_points, \
+                            const double *points, size_t dims, size_t depth):
+  """Constructs a KD-tree over the points order[0, num_points) and returns the root
+  node.  points holds the coordinates of pointList, dims per point, so the median
+  is found by partitioning order in C; only the nodes become Python objects."""
+  if 0 == num_points:
     # TODO would using a null sentinel node make all of this run faster?
     return None
 
-  cdef size_t dims = pointList[0].dims # assumes all points have the same dimension
   cdef size_t axis = pick_axis(depth, dims)
-  cdef PointData p
-  for p in pointList:
-    p.curr_axis = axis
-
-  # Sort point list and choose median as pivot element
-  pointList.sort()
+  cdef size_t median = num_points / 2
+  select_median(order, num_points, median, points, dims, axis)
 
-  cdef size_t median = len(pointList) / 2
-
-  pl_median = pointList[median]
-  cdef int next_depth = depth + 1
+  cdef PointData pl_median = pointList[order[median]]
+  cdef size_t next_depth = depth + 1
   cdef KDTreeNode node = KDTreeNode(pl_median.num, pl_median.coords)
-  node.left = fill_tree_r(pointList[0:median], next_depth)
-  node.right = fill_tree_r(pointList[median + 1:], next_depth)
+  node.left = fill_tree_r(pointList, order, median, points, dims, next_depth)
+  node.right = fill_tree_r(pointList, &order[median + 1], num_points - median - 1,
+                           points, dims, next_depth)
   return node
 
 cpdef KDTreeNode fill_tree(pointList):
   """Constructs a KD-tree and returns the root node.  pointList is a list of PointData elements."""
-  return fill_tree_r(pointList, 0)
+  cdef size_t num_points = len(pointList)
+  if 0 == num_points:
+    return None
 
-cdef size_t pick_axis(size_t depth, size_t dims):
+  cdef size_t dims = pointList[0].dims # assumes all points have the same dimension
+  cdef double *points = <double *>malloc(num_points * dims * sizeof(double))
+  cdef size_t *order = <size_t *>malloc(num_points * sizeof(size_t))
+  cdef size_t i
+  try:
+    if NULL == points or NULL == order:
+      raise MemoryError()
+    points_from_list(pointList, points, NULL, dims)
+    for i in range(num_points):
+      order[i] = i
+    return fill_tree_r(pointList, order, num_points, points, dims, 0)
+  finally:
+    free(order)
+    free(points)
+
+cdef int points_from_list(pointList, double *points, int *nums, size_t dims) except -1:
+  """Copies the coordinates of a list of PointData elements into points, dims per
+  point, and their numbers into nums unless it is NULL.  Coordinates held in an
+  array.array('d'), as PointData makes them, are read straight from its memory;
+  any other sequence is read item by item."""
+  cdef size_t i, d
+  cdef PointData p
+  cdef array.array coords
+  for i in range(len(pointList)):
+    p = pointList[i]
+    if p.dims != dims or len(p.coords) != dims:
+      raise ValueError("all points must have %d dimensions" % dims)
+    if NULL != nums:
+      nums[i] = p.num
+    if isinstance(p.coords, array.array) and 'd' == p.coords.typecode:
+      coords = p.coords
+      for d in range(dims):
+        points[i * dims + d] = coords.data.as_doubles[d]
+    else:
+      for d in range(dims):
+        points[i * dims + d] = p.coords[d]
+  return 0
+
+cdef inline size_t pick_axis(size_t depth, size_t dims) noexcept nogil:
   """Choose the axis to use based on the current depth and the number of dimensions.
   This is useful when building the tree and search for nearest neighbors.
   @param [in] depth The current depth in the tree.
@@ -290,3 +335,35 @@ cdef size_t add_best(nearest, size_t best_count, int node_num, coords, \
     nearest[best_count] = candidate
     return best_count + 1
   return best_count
+
+cdef void select_median(size_t *order, size_t num_points, size_t median,
+                        const double *points, size_t dims, size_t axis) noexcept nogil:
+  """Reorders order so the point of rank median along axis sits at order[median],
+  with no larger value before it and no smaller one after it."""
+  cdef Py_ssize_t lo = 0
+  cdef Py_ssize_t hi = num_points - 1
+  cdef Py_ssize_t i, j
+  cdef Py_ssize_t m = median
+  cdef double pivot
+  cdef size_t tmp
+  while hi > lo:
+    pivot = points[order[lo + (hi - lo) / 2] * dims + axis]
+    i = lo
+    j = hi
+    while i <= j:
+      while points[order[i] * dims + axis] < pivot:
+        i += 1
+      while points[order[j] * dims + axis] > pivot:
+        j -= 1
+      if i <= j:
+        tmp = order[i]
+        order[i] = order[j]
+        order[j] = tmp
+        i += 1
+        j -= 1
+    if m <= j:
+      hi = j
+    elif m >= i:
+      lo = i
+    else:
+      break
@@ -13,6 +13,13 @@
 # You should have received a copy of the GNU Lesser General Public License
 # along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
+from cpython cimport array
+from cpython.buffer cimport PyObject_GetBuffer, PyBuffer_Release, PyBuffer_FillInfo
+from cpython.buffer cimport PyObject_CheckBuffer
+from cpython.buffer cimport PyBUF_WRITABLE, PyBUF_FORMAT, PyBUF_C_CONTIGUOUS
+import array
+import threading
+
 cdef extern from "kdtree_raw.h":
   struct point_data:
     int num
@@ -25,17 +32,333 @@ cdef extern from "kdtree_raw.h":
     kdtree_node *left
     kdtree_node *right
 
-  extern void c_run_nn_search "run_nn_search" (kdtree_node *, size_t, point_data, int[])
+  ctypedef enum search_method:
+    SEARCH_DFS
+    SEARCH_BBF
+    SEARCH_INTERLEAVED
+    SEARCH_PACKET
+
+  enum:
+    KDTREE_STATS_ENABLED
+    STATS_LEVELS
+
+  struct search_stats:
+    size_t searches
+    size_t nodes_visited
+    size_t leaves_visited
+    size_t dist_evals
+    size_t far_pruned
+    size_t far_descended
+    size_t max_depth
+
+  struct build_stats:
+    size_t levels
+    size_t level_nodes[STATS_LEVELS]
+    double level_seconds[STATS_LEVELS]
+
+  extern void add_search_stats(search_stats *, search_stats *)
+  extern void get_build_stats(build_stats *)
+
+  struct query_context:
+    size_t max_neighbors
+    size_t dims
+    double *coords
+    int *best_nums
+    search_stats stats
+
+  extern query_context * new_query_context(size_t, size_t)
+  extern void free_query_context(query_context *)
+  extern void c_run_nn_search_context "run_nn_search_context" (kdtree_node *, query_context *, size_t, point_data *, search_method)
+  extern void c_run_forest_search_context "run_forest_search_context" (kdtree_forest *, query_context *, size_t, point_data *, size_t)
+  extern void c_run_nn_search_batch "run_nn_search_batch" (kdtree_node *, size_t, point_data **, size_t, int[], search_method, search_stats *) nogil
   extern kdtree_node * c_fill_tree "fill_tree" (point_data **, size_t)
+  extern kdtree_node * c_fill_tree_morton "fill_tree_morton" (point_data **, size_t)
+  extern kdtree_node * c_fill_tree_presorted "fill_tree_presorted" (point_data **, size_t)
+  extern kdtree_node * c_layout_tree_veb "layout_tree_veb" (kdtree_node *)
   extern void free_tree(kdtree_node *)
+  extern size_t tree_size(kdtree_node *)
+  extern size_t c_knn_graph "knn_graph" (kdtree_node *, size_t, int[], int[], double[]) nogil
+
+  struct pair_list:
+    size_t count
+    int *query_nums
+    int *ref_nums
+    double *dists
+
+  extern size_t c_knn_join "knn_join" (kdtree_node *, kdtree_node *, size_t, int[], int[], double[]) nogil
+  extern pair_list * c_radius_join "radius_join" (kdtree_node *, kdtree_node *, double) nogil
+  extern void free_pair_list(pair_list *)
+
+  struct kdtree_forest:
+    kdtree_node **trees
+    size_t num_trees
+
+  extern kdtree_forest * c_fill_forest "fill_forest" (point_data **, size_t, size_t, unsigned long)
+  extern void free_forest(kdtree_forest *)
+
+  struct kdtree_f32:
+    size_t num_nodes
+    size_t dims
+
+  extern kdtree_node * c_fill_tree_coords "fill_tree_coords" (double[], int[], size_t, size_t) nogil
+  extern kdtree_f32 * c_fill_tree_f32 "fill_tree_f32" (float[], int[], size_t, size_t) nogil
+  extern void free_tree_f32(kdtree_f32 *)
+  extern void c_run_nn_search_f32 "run_nn_search_f32" (kdtree_f32 *, size_t, double[], int, int[], int)
+
+  struct kdtree_q16:
+    size_t num_nodes
+    size_t dims
+
+  extern kdtree_q16 * c_fill_tree_q16 "fill_tree_q16" (double[], size_t, size_t) nogil
+  extern kdtree_q16 * c_fill_tree_q16_f32 "fill_tree_q16_f32" (float[], size_t, size_t) nogil
+  extern void free_tree_q16(kdtree_q16 *)
+  extern void c_run_nn_search_q16 "run_nn_search_q16" (kdtree_q16 *, query_context *, size_t, double[], int, int[])
+
+  ctypedef struct neighbor_iter:
+    pass
+
+  extern neighbor_iter * new_neighbor_iter(kdtree_node *, point_data *)
+  extern int next_neighbor(neighbor_iter *, int *, double *)
+  extern void free_neighbor_iter(neighbor_iter *)
 
 cdef extern from "stdlib.h":
   void free(void* ptr)
   void* malloc(size_t size)
 
+cdef extern from "string.h":
+  void* memcpy(void* dest, void* src, size_t size)
+  void* memset(void* dest, int c, size_t size)
+
+cdef point_data **make_points(pointList) except NULL:
+  """Converts a list of (number, coords) pairs into the point_data array that
+  the C code desires.  Release it with free_points."""
+  cdef size_t num_points = len(pointList)
+  cdef size_t i, d, dims
+  cdef point_data **points = <point_data **>malloc(num_points * sizeof(point_data *))
+  if not points:
+    raise MemoryError()
+  for i in xrange(num_points):
+    points[i] = NULL
+
+  try:
+    for i in xrange(num_points):
+      curr_point = pointList[i]
+      point_num = curr_point[0]
+
+      in_points = curr_point[1]
+      dims = len(in_points)
+
+      points[i] = <point_data *>malloc(sizeof(point_data))
+      if not points[i]:
+        raise MemoryError()
+
+      points[i].num = point_num
+      points[i].dims = dims;
+
+      points[i].coords = <double *>malloc(dims * sizeof(double))
+      if not points[i].coords:
+        raise MemoryError()
+
+      for d in xrange(dims):
+        points[i].coords[d] = in_points[d]
+  except:
+    free_points(points, num_points)
+    raise
+  return points
+
+cdef void free_points(point_data **points, size_t num_points):
+  """Frees a point_data array built by make_points."""
+  cdef size_t i
+  for i in xrange(num_points):
+    if NULL != points[i]:
+      if NULL != points[i].coords:
+        free(points[i].coords)
+        points[i].coords = NULL
+      free(points[i])
+      points[i] = NULL
+  free(points)
+
+cdef class QueryContext:
+  """Scratch buffers for searches of up to 'max_neighbors' neighbors of points
+  with up to 'dims' coordinates, so that a search need not allocate them.  A
+  context can be passed to any number of searches, but it is not thread safe;
+  use one per thread.  Searches given no context use one kept for the calling
+  thread."""
+  cdef query_context *ctx
+
+  def __cinit__(self, size_t max_neighbors, size_t dims):
+    self.ctx = new_query_context(max_neighbors, dims)
+
+  def __dealloc__(self):
+    if NULL != self.ctx:
+      free_query_context(self.ctx)
+      self.ctx = NULL
+
+  property max_neighbors:
+    def __get__(self):
+      return self.ctx.max_neighbors
+
+  def stats(self):
+    """Returns the counters of every search made with this context, as
+    KDTreeNode.stats does."""
+    return stats_dict(&self.ctx.stats, NULL)
+
+  property dims:
+    def __get__(self):
+      return self.ctx.dims
+
+_thread_contexts = threading.local()
+
+cdef QueryContext thread_context(size_t num_neighbors, size_t dims):
+  """Returns the calling thread's context, replacing it with a larger one if it
+  cannot hold a search for num_neighbors neighbors in dims dimensions."""
+  cdef QueryContext context = getattr(_thread_contexts, 'context', None)
+  if context is None:
+    context = QueryContext(num_neighbors, dims)
+    _thread_contexts.context = context
+  elif context.ctx.max_neighbors < num_neighbors or context.ctx.dims < dims:
+    context = QueryContext(max(num_neighbors, context.ctx.max_neighbors), 
+                           max(dims, context.ctx.dims))
+    _thread_contexts.context = context
+  return context
+
+cdef QueryContext search_context(QueryContext context, int search_num, search, 
+                                 size_t num_neighbors, point_data *pd):
+  """Picks the context for a search, copies the search coordinates into it and
+  points pd at them."""
+  cdef size_t search_len = len(search)
+  if context is None:
+    context = thread_context(num_neighbors, search_len)
+  elif context.ctx.max_neighbors < num_neighbors or context.ctx.dims < search_len:
+    raise ValueError("The context holds %d neighbors of %d coordinates" % 
+                     (context.ctx.max_neighbors, context.ctx.dims))
+
+  cdef size_t i
+  for i in xrange(search_len):
+    context.ctx.coords[i] = search[i]
+  pd.num = search_num
+  pd.coords = context.ctx.coords
+  pd.dims = search_len
+  pd.curr_axis = 0
+  return context
+
+cdef dict stats_dict(search_stats *stats, build_stats *build):
+  """Converts search counters, and optionally build costs, to a dict."""
+  result = {
+    'enabled': bool(KDTREE_STATS_ENABLED),
+    'searches': stats.searches,
+    'nodes_visited': stats.nodes_visited,
+    'leaves_visited': stats.leaves_visited,
+    'dist_evals': stats.dist_evals,
+    'far_pruned': stats.far_pruned,
+    'far_descended': stats.far_descended,
+    'max_depth': stats.max_depth,
+  }
+  cdef size_t level
+  if NULL != build:
+    result['build_levels'] = [(build.level_nodes[level], build.level_seconds[level])
+                              for level in xrange(min(build.levels, STATS_LEVELS))]
+  return result
+
+cdef inline void begin_stats(query_context *ctx, search_stats *before):
+  """Sets the context's counters aside so one search can be counted alone."""
+  if KDTREE_STATS_ENABLED:
+    before[0] = ctx.stats
+    memset(&ctx.stats, 0, sizeof(search_stats))
+
+cdef inline void end_stats(query_context *ctx, search_stats *before, search_stats *total):
+  """Adds the search counted since begin_stats to total and puts the 
+  context's own counters back."""
+  if KDTREE_STATS_ENABLED:
+    add_search_stats(total, &ctx.stats)
+    add_search_stats(&ctx.stats, before)
+
+cdef int get_buffer(obj, Py_buffer *view, int flags) except -1:
+  """Acquires a buffer as PyObject_GetBuffer does.  Python 2's array.array has
+  only the old buffer interface, so its memory is described by hand, with the 
+  format of its typecode for the callers to check; other typecodes get none.
+  The caller releases view."""
+  cdef array.array arr
+  if PyObject_CheckBuffer(obj) or not isinstance(obj, array.array):
+    PyObject_GetBuffer(obj, view, flags)
+    return 0
+  arr = obj
+  PyBuffer_FillInfo(view, obj, arr.data.as_voidptr, len(arr) * arr.itemsize, 
+                    0, flags & PyBUF_WRITABLE)
+  view.itemsize = arr.itemsize
+  if arr.typecode == 'i':
+    view.format = b'i'
+  elif arr.typecode == 'd':
+    view.format = b'd'
+  elif arr.typecode == 'f':
+    view.format = b'f'
+  return 0
+
+cdef int get_int_buffer(out, Py_buffer *view, size_t num_results) except -1:
+  """Acquires 'out', which must be a writable C-contiguous buffer of at least
+  num_results C ints, of any shape.  The caller releases view."""
+  get_buffer(out, view, PyBUF_WRITABLE | PyBUF_FORMAT | PyBUF_C_CONTIGUOUS)
+  if view.format == NULL or view.format not in (b'i', b'@i') or view.itemsize != sizeof(int):
+    PyBuffer_Release(view)
+    raise TypeError("out must be a buffer of C ints.")
+  if <size_t>view.len < num_results * sizeof(int):
+    PyBuffer_Release(view)
+    raise ValueError("out must hold at least %d ints." % num_results)
+  return 0
+
+cdef object copy_results(int *best_nums, size_t num_results, out):
+  """Returns the num_results node numbers as an array.array('i'), or copies 
+  them into the buffer 'out' and returns it."""
+  cdef array.array result
+  cdef Py_buffer view
+  if out is None:
+    result = array.clone(array.array('i'), num_results, False)
+    memcpy(result.data.as_ints, best_nums, num_results * sizeof(int))
+    return result
+  get_int_buffer(out, &view, num_results)
+  memcpy(view.buf, best_nums, num_results * sizeof(int))
+  PyBuffer_Release(&view)
+  return out
+
+cdef search_method to_search_method(method) except? SEARCH_DFS:
+  """Maps a method name onto the C traversal."""
+  if method == 'dfs':
+    return SEARCH_DFS
+  elif method == 'bbf':
+    return SEARCH_BBF
+  elif method == 'interleaved':
+    return SEARCH_INTERLEAVED
+  elif method == 'packet':
+    return SEARCH_PACKET
+  raise ValueError("Unknown search method '%s'" % method)
+
+cdef class NeighborIterator:
+  """Iterates over the points of a KDTreeNode nearest first, as 
+  (number, squared distance) pairs.  Made by KDTreeNode.neighbors_iter."""
+  cdef neighbor_iter *it
+  # keeps the tree alive while the iterator walks it
+  cdef object tree
+
+  def __dealloc__(self):
+    if NULL != self.it:
+      free_neighbor_iter(self.it)
+      self.it = NULL
+
+  def __iter__(self):
+    return self
+
+  def __next__(self):
+    cdef int num
+    cdef double dist
+    if NULL == self.it or not next_neighbor(self.it, &num, &dist):
+      raise StopIteration
+    return (num, dist)
+
 cdef class KDTreeNode:
   """A C extension class to the KDTree C code"""
   cdef kdtree_node *root
+  cdef search_stats search_totals
+  cdef build_stats build
 
   def __dealloc__(self):
     """free the memory associated with root and its children"""
@@ -44,80 +367,385 @@ cdef class KDTreeNode:
       # TODO let the C code handle this once we've fixed the NULL assignment problem
       self.root = NULL
 
-  def __init__(self, pointList):
+  def __init__(self, pointList, build='median', layout='preorder'):
+    """Builds the tree over a list of (number, coords) pairs.  build='median'
+    splits every node at the median; build='presorted' builds the same tree
+    from lists sorted once per axis, which is faster for up to about 4 
+    dimensions; build='morton' bulk loads the points along a Morton curve 
+    instead, which is much faster to build for 2 or 3 dimensional data that is
+    rebuilt often, at the cost of a less balanced tree and a bounding box per
+    node.  layout='veb' then moves the nodes into van Emde Boas order, which 
+    speeds up searches of trees much larger than the cache a little and gives
+    the same results."""
     cdef point_data **points
-    cdef double * coords = NULL
-    cdef size_t num_points, i, d, point_num
-    cdef size_t dims = 0
+    cdef size_t num_points
+    if build not in ('median', 'presorted', 'morton'):
+      raise ValueError("build must be 'median', 'presorted' or 'morton'.")
+    if layout not in ('preorder', 'veb'):
+      raise ValueError("layout must be 'preorder' or 'veb'.")
     if NULL == self.root:
       num_points = len(pointList)
-      points = <point_data **>malloc(num_points * sizeof(point_data *))
-      if not points:
-        raise MemoryError()
-
+      points = make_points(pointList)
       try:
-        # build up the point_data array that the C code desires
-        for i in xrange(num_points):
-          curr_point = pointList[i]
-          point_num = curr_point[0]
+        if build == 'morton':
+          self.root = c_fill_tree_morton(points, num_points)
+        elif build == 'presorted':
+          self.root = c_fill_tree_presorted(points, num_points)
+        else:
+          self.root = c_fill_tree(points, num_points)
+        get_build_stats(&self.build)
+        if layout == 'veb':
+          self.root = c_layout_tree_veb(self.root)
+      finally:
+        free_points(points, num_points)
 
-          in_points = curr_point[1]
-          dims = len(in_points)
+  def stats(self):
+    """Returns what the searches of this tree have done so far, counted only
+    when the C code is built with KDTREE_STATS ('enabled' says whether it 
+    was): the number of 'searches', 'nodes_visited', 'leaves_visited', 
+    distance evaluations ('dist_evals'), far branches skipped by the bound 
+    ('far_pruned') and searched anyway ('far_descended'), and 'max_depth', the
+    deepest recursion or longest branch queue of any search.  'build_levels' 
+    lists a (nodes, seconds) pair for each level of the tree's build."""
+    return stats_dict(&self.search_totals, &self.build)
 
-          points[i] = <point_data *>malloc(sizeof(point_data))
-          if not points[i]:
-            raise MemoryError()
+  def reset_stats(self):
+    """Zeroes the search counters."""
+    memset(&self.search_totals, 0, sizeof(search_stats))
 
-          points[i].num = point_num
-          points[i].dims = dims;
+  def knn_graph(self, size_t num_neighbors):
+    """Finds the 'num_neighbors' nearest neighbors of every point in the tree,
+    excluding the point itself.  Returns a (nums, neighbors, distances) tuple of
+    arrays: row i of the flat len(nums) x num_neighbors 'neighbors' array holds 
+    the neighbors of point nums[i], nearest first, and 'distances' holds the
+    matching squared distances.  Missing neighbors are -1."""
+    cdef size_t num_points = tree_size(self.root)
+    cdef array.array nums = array.clone(array.array('i'), num_points, False)
+    cdef array.array neighbors = array.clone(array.array('i'), 
+                                             num_points * num_neighbors, False)
+    cdef array.array distances = array.clone(array.array('d'), 
+                                             num_points * num_neighbors, False)
+    with nogil:
+      c_knn_graph(self.root, num_neighbors, nums.data.as_ints, 
+                  neighbors.data.as_ints, distances.data.as_doubles)
+    return nums, neighbors, distances
 
-          points[i].coords = <double *>malloc(dims * sizeof(double))
-          if not points[i].coords:
-            raise MemoryError()
+  def knn_join(self, KDTreeNode reference not None, size_t num_neighbors):
+    """Finds the 'num_neighbors' nearest neighbors in the 'reference' tree of
+    every point in this tree, using a dual-tree traversal.  Joining a tree
+    with itself leaves each point out of its own neighbors.  Returns a (nums, neighbors, distances) tuple of
+    arrays laid out as for knn_graph."""
+    if (NULL != self.root and NULL != reference.root and 
+        self.root.data.dims != reference.root.data.dims):
+      raise ValueError("reference must have %d coordinates." % self.root.data.dims)
+    cdef size_t num_points = tree_size(self.root)
+    cdef array.array nums = array.clone(array.array('i'), num_points, False)
+    cdef array.array neighbors = array.clone(array.array('i'), 
+                                             num_points * num_neighbors, False)
+    cdef array.array distances = array.clone(array.array('d'), 
+                                             num_points * num_neighbors, False)
+    with nogil:
+      c_knn_join(self.root, reference.root, num_neighbors, nums.data.as_ints, 
+                 neighbors.data.as_ints, distances.data.as_doubles)
+    return nums, neighbors, distances
 
-          for d in xrange(dims):
-            points[i].coords[d] = in_points[d]
+  def radius_join(self, KDTreeNode reference not None, double radius):
+    """Finds every pair of a point in this tree and a point in the 'reference'
+    tree that lie within 'radius' of each other, using a dual-tree traversal.
+    Joining a tree with itself never pairs a point with itself.  Returns a (nums, ref_nums, 
+    distances) tuple of arrays with one entry per pair; distances are 
+    squared."""
+    if (NULL != self.root and NULL != reference.root and 
+        self.root.data.dims != reference.root.data.dims):
+      raise ValueError("reference must have %d coordinates." % self.root.data.dims)
+    cdef pair_list *pairs
+    with nogil:
+      pairs = c_radius_join(self.root, reference.root, radius * radius)
+    cdef array.array nums = array.clone(array.array('i'), pairs.count, False)
+    cdef array.array ref_nums = array.clone(array.array('i'), pairs.count, False)
+    cdef array.array distances = array.clone(array.array('d'), pairs.count, False)
+    cdef size_t i
+    for i in xrange(pairs.count):
+      nums.data.as_ints[i] = pairs.query_nums[i]
+      ref_nums.data.as_ints[i] = pairs.ref_nums[i]
+      distances.data.as_doubles[i] = pairs.dists[i]
+    free_pair_list(pairs)
+    return nums, ref_nums, distances
 
-        self.root = c_fill_tree(points, num_points)
-      finally:
-        for i in xrange(num_points):
-          if NULL != points[i]:
-            if NULL != points[i].coords:
-              free(points[i].coords)
-              points[i].coords = NULL
-            free(points[i])
-            points[i] = NULL
-        free(points)
-        points = NULL
-
-  cpdef run_nn_search(self, int search_num, search, size_t num_neighbors):
+  def run_nn_search_batch(self, searchList, size_t num_neighbors, method='dfs', out=None):
+    """Runs a nearest neighbor search for every (number, coords) pair in 
+    'searchList', in the same form as the list the tree was built from.  The
+    searches run in C in a cache-friendly order.  method='interleaved' runs
+    the depth-first searches several at a time, prefetching each one's next
+    node while the others run, which is faster on trees much larger than the
+    cache and gives the same results as 'dfs'.  method='packet' carries 
+    groups of 8 nearby searches through the tree together, computing each 
+    node's distances for all of them at once, which is faster for dense 
+    batches in 2 or 3 dimensions; neighbors at equal distances may come in
+    another order.  Returns a flat array of 
+    len(searchList) x num_neighbors node numbers in the order of searchList,
+    or writes them straight into 'out', a writable buffer of C ints such as
+    an array.array('i') or an ndarray, and returns it."""
+    cdef search_method c_method = to_search_method(method)
+    cdef size_t num_searches = len(searchList)
+    cdef array.array result = None
+    cdef Py_buffer view
+    cdef int *best
+    if out is None:
+      result = array.clone(array.array('i'), num_searches * num_neighbors, False)
+      best = result.data.as_ints
+    else:
+      get_int_buffer(out, &view, num_searches * num_neighbors)
+      best = <int *>view.buf
+
+    cdef point_data **searches = NULL
+    cdef size_t i
+    cdef search_stats batch_stats
+    memset(&batch_stats, 0, sizeof(search_stats))
+    try:
+      if num_searches > 0:
+        searches = make_points(searchList)
+        if NULL != self.root:
+          for i in xrange(num_searches):
+            if searches[i].dims != self.root.data.dims:
+              raise ValueError("Expected %d coordinates." % self.root.data.dims)
+        with nogil:
+          c_run_nn_search_batch(self.root, num_neighbors, searches, num_searches, 
+                                best, c_method, &batch_stats)
+        add_search_stats(&self.search_totals, &batch_stats)
+    finally:
+      if NULL != searches:
+        free_points(searches, num_searches)
+      if out is not None:
+        PyBuffer_Release(&view)
+    return result if out is None else out
+
+  cpdef run_nn_search(self, int search_num, search, size_t num_neighbors, method='dfs', 
+                      QueryContext context=None, out=None):
     """Runs a nearest neighbor search on the given point, which is defined
-    by the point number 'search_num' and search coordinates 'search'."""
-    cdef size_t search_len = len(search)
+    by the point number 'search_num' and search coordinates 'search'.
+    'method' selects the traversal: 'dfs' for depth-first recursion or 'bbf'
+    for a best-bin-first priority queue traversal.  'context' supplies the
+    scratch buffers; by default the calling thread's own are used.  Returns
+    an array.array('i') of the 'num_neighbors' node numbers, or writes them
+    into 'out', a writable buffer of C ints, and returns it."""
+    cdef search_method c_method = to_search_method(method)
     cdef point_data pd
-    pd.dims = search_len
-    pd.num = search_num
+    cdef search_stats before
+    context = search_context(context, search_num, search, num_neighbors, &pd)
+    begin_stats(context.ctx, &before)
+    c_run_nn_search_context(self.root, context.ctx, num_neighbors, &pd, c_method)
+    end_stats(context.ctx, &before, &self.search_totals)
+    return copy_results(context.ctx.best_nums, num_neighbors, out)
 
-    pd.coords = <double *>malloc(search_len * sizeof(double))
-    if not pd.coords:
+  def neighbors_iter(self, search, int search_num=-1):
+    """Returns an iterator over the points of the tree in order of their 
+    distance from the coordinates 'search', yielding (number, squared 
+    distance) pairs and skipping the point numbered 'search_num'.  Each step
+    does only the work needed to find the next point, so taking neighbors 
+    until some condition holds costs about as much as a search for that many,
+    without knowing how many in advance."""
+    cdef size_t search_len = len(search)
+    if NULL != self.root and search_len != self.root.data.dims:
+      raise ValueError("search must have %d coordinates." % self.root.data.dims)
+    cdef point_data pd
+    cdef double *coords = <double *>malloc((search_len + 1) * sizeof(double))
+    if NULL == coords:
       raise MemoryError()
-
     cdef size_t i
-    for i in xrange(search_len):
-      pd.coords[i] = search[i]
-
-    cdef int *best = <int *>malloc(num_neighbors * sizeof(int))
-    if not best:
-      raise MemoryError()
+    cdef NeighborIterator result = NeighborIterator.__new__(NeighborIterator)
     try:
-      c_run_nn_search(self.root, num_neighbors, pd, best)
-      output = []
-
-      for i in xrange(num_neighbors):
-        output.append(best[i])
-      return output
+      for i in xrange(search_len):
+        coords[i] = search[i]
+      pd.num = search_num
+      pd.coords = coords
+      pd.dims = search_len
+      pd.curr_axis = 0
+      result.it = new_neighbor_iter(self.root, &pd)
+      result.tree = self
     finally:
-      if NULL != best:
-        free(best)
-      if NULL != pd.coords:
-        free(pd.coords)
+      free(coords)
+    return result
+
+cdef class KDForest:
+  """A randomized kd-forest for approximate search in many dimensions.  Each of
+  the trees splits on axes picked at random among the highest-variance 
+  dimensions; a search shares one priority queue and one candidate list across
+  all of them."""
+  cdef kdtree_forest *forest
+
+  def __dealloc__(self):
+    """free the memory associated with the trees"""
+    if NULL != self.forest:
+      free_forest(self.forest)
+      self.forest = NULL
+
+  def __init__(self, pointList, size_t num_trees=4, unsigned long seed=0):
+    cdef point_data **points
+    cdef size_t num_points
+    if NULL == self.forest:
+      num_points = len(pointList)
+      points = make_points(pointList)
+      try:
+        self.forest = c_fill_forest(points, num_points, num_trees, seed)
+      finally:
+        free_points(points, num_points)
+
+  property num_trees:
+    def __get__(self):
+      return self.forest.num_trees
+
+  cpdef run_nn_search(self, int search_num, search, size_t num_neighbors, size_t max_checks=0,
+                      QueryContext context=None, out=None):
+    """Runs a nearest neighbor search across all trees on the given point, 
+    which is defined by the point number 'search_num' and search coordinates 
+    'search'.  The search stops after comparing 'max_checks' points, or 
+    searches exhaustively if it is 0.  'context' supplies the scratch 
+    buffers; by default the calling thread's own are used.  Returns an 
+    array.array('i') of node numbers, or writes them into 'out' as 
+    KDTreeNode.run_nn_search does."""
+    cdef point_data pd
+    context = search_context(context, search_num, search, num_neighbors, &pd)
+    c_run_forest_search_context(self.forest, context.ctx, num_neighbors, &pd, max_checks)
+    return copy_results(context.ctx.best_nums, num_neighbors, out)
+
+cdef class KDTreeF32:
+  """A kd tree stored in single precision, for data with no more than float
+  precision.  It takes a fraction of the memory of a KDTreeNode and searches
+  faster.  Build one with from_buffer."""
+  cdef kdtree_f32 *tree
+
+  def __dealloc__(self):
+    """free the memory associated with the tree"""
+    if NULL != self.tree:
+      free_tree_f32(self.tree)
+      self.tree = NULL
+
+  property num_nodes:
+    def __get__(self):
+      return self.tree.num_nodes if NULL != self.tree else 0
+
+  property dims:
+    def __get__(self):
+      return self.tree.dims if NULL != self.tree else 0
+
+  cpdef run_nn_search(self, int search_num, search, size_t num_neighbors, exact=False,
+                      QueryContext context=None, out=None):
+    """Runs a nearest neighbor search on the given point, as 
+    KDTreeNode.run_nn_search does.  Distances are computed in single 
+    precision, so neighbors at nearly the same distance may come out in the
+    wrong order; with 'exact' the tree is searched again in double precision
+    within the distance of the candidates found, so the neighbors are exact.
+    Returns an array.array('i') of node numbers, or writes them into 'out'."""
+    cdef point_data pd
+    context = search_context(context, search_num, search, num_neighbors, &pd)
+    if pd.dims != self.dims:
+      raise ValueError("The search point must have %d coordinates." % self.dims)
+    c_run_nn_search_f32(self.tree, num_neighbors, pd.coords, search_num, 
+                        context.ctx.best_nums, 1 if exact else 0)
+    return copy_results(context.ctx.best_nums, num_neighbors, out)
+
+cdef class KDTreeQ16:
+  """A kd tree whose nodes hold their coordinates quantized to 16 bits within
+  the box of their subtree, for point clouds too large for even a KDTreeF32.
+  Searches rerank their candidates from the coordinates the tree was built 
+  over, so results are exact; the tree holds on to that buffer rather than 
+  copying it, except for Python 2's array.array, which cannot be kept from 
+  resizing and is copied.  Points are numbered by their position in the 
+  buffer.  Build one with from_buffer(..., quantized=True)."""
+  cdef kdtree_q16 *tree
+  cdef Py_buffer view
+  cdef bint has_view
+
+  def __dealloc__(self):
+    """free the memory associated with the tree and let go of the coordinates"""
+    if NULL != self.tree:
+      free_tree_q16(self.tree)
+      self.tree = NULL
+    if self.has_view:
+      PyBuffer_Release(&self.view)
+      self.has_view = False
+
+  property num_nodes:
+    def __get__(self):
+      return self.tree.num_nodes if NULL != self.tree else 0
+
+  property dims:
+    def __get__(self):
+      return self.tree.dims if NULL != self.tree else 0
+
+  cpdef run_nn_search(self, int search_num, search, size_t num_neighbors,
+                      QueryContext context=None, out=None):
+    """Runs a nearest neighbor search on the given point, as 
+    KDTreeNode.run_nn_search does; 'search_num' is the position of the 
+    search point in the buffer, or -1.  Returns an array.array('i') of 
+    positions, or writes them into 'out'."""
+    cdef point_data pd
+    context = search_context(context, search_num, search, num_neighbors, &pd)
+    if pd.dims != self.dims:
+      raise ValueError("The search point must have %d coordinates." % self.dims)
+    c_run_nn_search_q16(self.tree, context.ctx, num_neighbors, pd.coords, 
+                        search_num, context.ctx.best_nums)
+    return copy_results(context.ctx.best_nums, num_neighbors, out)
+
+def from_buffer(coords, size_t dims, nums=None, quantized=False):
+  """Builds a tree over a flat C-contiguous buffer of coordinates, 'dims' per
+  point, such as an array.array or an ndarray.  The type of the tree follows
+  the type of the buffer: doubles give a KDTreeNode and floats a KDTreeF32.
+  'nums' numbers the points; by default they are numbered by their index.
+  With 'quantized' either type gives a KDTreeQ16 over the buffer, which 
+  cannot be resized while the tree lives, and numbers the points by position;
+  Python 2's array.array cannot be locked that way, so the tree copies it."""
+  cdef Py_buffer view
+  cdef array.array c_nums = None
+  cdef int *nums_ptr = NULL
+  cdef size_t num_points
+  cdef KDTreeNode double_tree
+  cdef KDTreeF32 float_tree
+  cdef KDTreeQ16 quant_tree
+  if dims == 0:
+    raise ValueError("dims must be positive.")
+  get_buffer(coords, &view, PyBUF_FORMAT | PyBUF_C_CONTIGUOUS)
+  try:
+    if view.format == NULL or view.format not in (b'd', b'@d', b'f', b'@f'):
+      raise TypeError("coords must be a buffer of C doubles or floats.")
+    num_points = <size_t>view.len // view.itemsize // dims
+    if num_points * dims * view.itemsize != <size_t>view.len:
+      raise ValueError("coords must hold a whole number of %d-d points." % dims)
+    if quantized:
+      if nums is not None:
+        raise ValueError("Quantized trees number points by position.")
+      # the tree reads the coordinates for as long as it lives, so it holds a
+      # view of its own; an array.array without the buffer protocol does not
+      # lock its memory for a view, so the tree views a private copy instead
+      if not PyObject_CheckBuffer(coords):
+        coords = array.copy(coords)
+      quant_tree = KDTreeQ16.__new__(KDTreeQ16)
+      get_buffer(coords, &quant_tree.view, PyBUF_FORMAT | PyBUF_C_CONTIGUOUS)
+      quant_tree.has_view = True
+      with nogil:
+        if view.itemsize == sizeof(float):
+          quant_tree.tree = c_fill_tree_q16_f32(<float *>quant_tree.view.buf, num_points, dims)
+        else:
+          quant_tree.tree = c_fill_tree_q16(<double *>quant_tree.view.buf, num_points, dims)
+      if NULL == quant_tree.tree:
+        raise ValueError("Too many points for a quantized tree.")
+      return quant_tree
+    if nums is not None:
+      c_nums = array.array('i', nums)
+      if <size_t>len(c_nums) != num_points:
+        raise ValueError("nums must number all %d points." % num_points)
+      nums_ptr = c_nums.data.as_ints
+
+    if view.itemsize == sizeof(float):
+      float_tree = KDTreeF32.__new__(KDTreeF32)
+      with nogil:
+        float_tree.tree = c_fill_tree_f32(<float *>view.buf, nums_ptr, num_points, dims)
+      return float_tree
+    double_tree = KDTreeNode.__new__(KDTreeNode)
+    with nogil:
+      double_tree.root = c_fill_tree_coords(<double *>view.buf, nums_ptr, num_points, dims)
+    get_build_stats(&double_tree.build)
+    return double_tree
+  finally:
+    PyBuffer_Release(&view)
@@ -0,0 +1,911 @@
+/*
+ * Copyright 2011 Chris M Bouzek
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the version 3 of the GNU Lesser General Public License
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Benchmarks the nearest neighbor searches.
+ *
+ * "traversal" times the depth-first and best-bin-first traversals against each
+ * other at d = 2, 8 and 32.  "forest" measures recall against queries per 
+ * second for randomized kd-forests at d = 128, over a range of tree counts and
+ * check budgets; its output is a whitespace separated table that plots 
+ * directly, e.g. in gnuplot:
+ *   plot for [t in "1 4 8"] 'forest.dat' using (\$1==t ? \$3 : 1/0):4 with lines
+ * "batch" times batches of searches run one at a time against the same 
+ * batches interleaved with prefetching and run as packets, on uniform points 
+ * in the given dimension; give it a tree far larger than the last level 
+ * cache, e.g. 2e7 points, to see the interleaving pay off, and many more 
+ * queries than points to see the packets pay off.
+ * "branches" times single searches of the double tree and of the single 
+ * precision tree, whose implicit layout has no child links to follow, at 
+ * d = 2 and 3, and counts their branch mispredictions where the machine 
+ * lets it.
+ * "graph" checks the k-nearest neighbor graph against brute force on uniform
+ * and on duplicated points, and exits with a nonzero status if any row 
+ * disagrees.
+ * "suite" builds one tree over a fixed-seed dataset of the given size, 
+ * dimension and distribution, times each query on its own, and prints one 
+ * JSON object with the build time, query p50/p99, QPS, branch mispredictions
+ * per query where the machine counts them, and the bytes the tree takes per 
+ * point.  The datasets match those of bench_bindings.py in the top
+ * level directory, which sweeps this mode alongside the Python bindings.  
+ * Giving "veb" as the layout moves the tree's nodes into van Emde Boas order
+ * after the build, and the build time includes the move.
+ *
+ * Build and run with:
+ *   gcc -O2 -fopenmp -o kdtree_bench kdtree_bench.c kdtree_raw.c -lm
+ *   ./kdtree_bench traversal [num_points] [num_queries] [num_neighbors]
+ *   ./kdtree_bench forest [num_points] [num_queries] [num_neighbors] > forest.dat
+ *   ./kdtree_bench batch [num_points] [num_queries] [num_neighbors] [dims]
+ *   ./kdtree_bench branches [num_points] [num_queries] [num_neighbors]
+ *   ./kdtree_bench graph [num_points] [num_queries] [num_neighbors] [dims]
+ *   ./kdtree_bench suite [num_points] [num_queries] [num_neighbors] [dims] 
+ *       [uniform|clusters|duplicates|manifold] [seed] [preorder|veb]
+ */
+#define _POSIX_C_SOURCE 199309L
+#ifdef __linux__
+/* for syscall */
+#define _GNU_SOURCE
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+#ifdef __linux__
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#endif
+#include "kdtree_raw.h"
+
+#ifndef OOM
+#define OOM 8
+#endif
+
+#define TWO_PI 6.283185307179586
+
+/* The number of clusters in the "clusters" distribution. */
+#define NUM_CLUSTERS 16
+/* The standard deviation of each coordinate around its cluster center. */
+#define CLUSTER_SIGMA 0.02
+/* The "duplicates" distribution has one distinct point per this many points. */
+#define DUPLICATE_RATIO 100
+
+/**
+ * The point distributions the suite can generate.
+ * DIST_UNIFORM is uniform in the unit hypercube.
+ * DIST_CLUSTERS is gaussian around NUM_CLUSTERS uniform centers.
+ * DIST_DUPLICATES repeats a few uniform points many times over.
+ * DIST_MANIFOLD lies on a closed 1-dimensional curve through all dimensions.
+ */
+typedef enum distribution {
+	DIST_UNIFORM = 0,
+	DIST_CLUSTERS,
+	DIST_DUPLICATES,
+	DIST_MANIFOLD
+} distribution;
+
+static const char *dist_names[] = {"uniform", "clusters", "duplicates", "manifold"};
+
+/**
+ * Returns a monotonic timestamp in seconds.
+ */
+static double now(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/**
+ * A small xorshift generator so runs are reproducible across platforms.
+ * @param [in] state The generator state.  Must not be zero.
+ * @return A uniformly distributed double in [0, 1).
+ */
+static double next_uniform(unsigned long long *state) {
+	unsigned long long x = *state;
+	x ^= x << 13;
+	x ^= x >> 7;
+	x ^= x << 17;
+	*state = x;
+	return (x >> 11) * (1.0 / 9007199254740992.0);
+}
+
+/**
+ * Draws a standard normal variate with the Box-Muller transform.
+ * @param [in] state The generator state.
+ * @return A normally distributed double.
+ */
+static double next_gaussian(unsigned long long *state) {
+	double u = next_uniform(state);
+	double v = next_uniform(state);
+	/* 1 - u keeps the logarithm finite */
+	return sqrt(-2.0 * log(1.0 - u)) * cos(TWO_PI * v);
+}
+
+/**
+ * Generates a dataset as one flat array of coordinates.  bench_bindings.py 
+ * draws the same numbers in the same order, so both see the same points.
+ * @param [in] num_points The number of points to generate.
+ * @param [in] dims The number of dimensions of each point.
+ * @param [in] dist The distribution to draw from.
+ * @param [in] state The random generator state.
+ * @return A newly malloc'd array of num_points * dims coordinates.
+ */
+static double *make_coords(size_t num_points, size_t dims, distribution dist,
+		unsigned long long *state) {
+	double *coords = malloc(num_points * dims * sizeof(double));
+	size_t num_shared = 0;
+	if (DIST_CLUSTERS == dist) {
+		num_shared = NUM_CLUSTERS;
+	} else if (DIST_DUPLICATES == dist) {
+		num_shared = num_points / DUPLICATE_RATIO + 1;
+	}
+	/* the cluster centers or the distinct points */
+	double *shared = malloc((num_shared * dims + 1) * sizeof(double));
+	if (NULL == coords || NULL == shared) {
+		fprintf(stderr, "Out of memory at %s: %d\n", __FILE__, __LINE__);
+		exit(OOM);
+	}
+
+	size_t i, d;
+	for (i = 0; i < num_shared * dims; i++) {
+		shared[i] = next_uniform(state);
+	}
+	for (i = 0; i < num_points; i++) {
+		double *point = &coords[i * dims];
+		if (DIST_CLUSTERS == dist || DIST_DUPLICATES == dist) {
+			size_t pick = (size_t)(next_uniform(state) * num_shared);
+			for (d = 0; d < dims; d++) {
+				point[d] = shared[pick * dims + d];
+				if (DIST_CLUSTERS == dist) {
+					point[d] += CLUSTER_SIGMA * next_gaussian(state);
+				}
+			}
+		} else if (DIST_MANIFOLD == dist) {
+			double t = next_uniform(state);
+			for (d = 0; d < dims; d++) {
+				point[d] = 0.5 + 0.5 * sin(TWO_PI * (d + 1) * t + d);
+			}
+		} else {
+			for (d = 0; d < dims; d++) {
+				point[d] = next_uniform(state);
+			}
+		}
+	}
+	free(shared);
+	return coords;
+}
+
+/**
+ * Returns the number of bytes currently allocated with malloc, or 0 if the C
+ * library cannot tell.
+ */
+static size_t heap_in_use(void) {
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+	struct mallinfo2 info = mallinfo2();
+	/* large blocks are mmapped and counted apart from the heap proper */
+	return info.uordblks + info.hblkhd;
+#else
+	return 0;
+#endif
+}
+
+/**
+ * Opens a counter of this thread's branch mispredictions in user space.
+ * @return The counter, stopped, or -1 if the kernel or the machine cannot 
+ * count them, as in most virtual machines.
+ */
+static int open_branch_misses(void) {
+#ifdef __linux__
+	struct perf_event_attr attr;
+	memset(&attr, 0, sizeof(attr));
+	attr.type = PERF_TYPE_HARDWARE;
+	attr.size = sizeof(attr);
+	attr.config = PERF_COUNT_HW_BRANCH_MISSES;
+	attr.disabled = 1;
+	attr.exclude_kernel = 1;
+	attr.exclude_hv = 1;
+	return (int)syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+#else
+	return -1;
+#endif
+}
+
+/**
+ * Zeroes and starts a counter.
+ * @param [in] counter The counter from open_branch_misses.  May be -1.
+ */
+static void start_counter(int counter) {
+#ifdef __linux__
+	if (counter >= 0) {
+		ioctl(counter, PERF_EVENT_IOC_RESET, 0);
+		ioctl(counter, PERF_EVENT_IOC_ENABLE, 0);
+	}
+#endif
+}
+
+/**
+ * Stops a counter and reads it.
+ * @param [in] counter The counter from open_branch_misses.  May be -1.
+ * @return The count since start_counter, or -1 if there is no counter.
+ */
+static long long stop_counter(int counter) {
+#ifdef __linux__
+	long long count;
+	if (counter >= 0) {
+		ioctl(counter, PERF_EVENT_IOC_DISABLE, 0);
+		if (sizeof(count) == read(counter, &count, sizeof(count))) {
+			return count;
+		}
+	}
+#endif
+	return -1;
+}
+
+/**
+ * Closes a counter.
+ * @param [in] counter The counter from open_branch_misses.  May be -1.
+ */
+static void close_counter(int counter) {
+#ifdef __linux__
+	if (counter >= 0) {
+		close(counter);
+	}
+#endif
+}
+
+/**
+ * Orders doubles ascending, for qsort.
+ */
+static int comp_double(const void *a, const void *b) {
+	double x = *(const double *)a;
+	double y = *(const double *)b;
+	return (x > y) - (x < y);
+}
+
+/**
+ * Returns the nearest-rank percentile of sorted values.
+ * @param [in] sorted The values, in ascending order.
+ * @param [in] count The number of values.  Must not be zero.
+ * @param [in] percent The percentile, from 0 to 100.
+ */
+static double percentile(const double sorted[], size_t count, double percent) {
+	size_t rank = (size_t)ceil(percent / 100.0 * count);
+	return sorted[(rank > 0) ? rank - 1 : 0];
+}
+
+/**
+ * Allocates num_points uniformly distributed points in the unit hypercube.
+ * @param [in] num_points The number of points to generate.
+ * @param [in] dims The number of dimensions of each point.
+ * @param [in] state The random generator state.
+ * @return A newly malloc'd array of newly malloc'd points.
+ */
+static point_data **make_points(size_t num_points, size_t dims, unsigned long long *state) {
+	point_data **points = malloc(num_points * sizeof(point_data *));
+	if (NULL == points) {
+		fprintf(stderr, "Out of memory at %s: %d\n", __FILE__, __LINE__);
+		exit(OOM);
+	}
+	size_t i, d;
+	for (i = 0; i < num_points; i++) {
+		points[i] = malloc(sizeof(point_data));
+		if (NULL == points[i]) {
+			fprintf(stderr, "Out of memory at %s: %d\n", __FILE__, __LINE__);
+			exit(OOM);
+		}
+		points[i]->coords = malloc(dims * sizeof(double));
+		if (NULL == points[i]->coords) {
+			fprintf(stderr, "Out of memory at %s: %d\n", __FILE__, __LINE__);
+			exit(OOM);
+		}
+		points[i]->num = (int)i;
+		points[i]->dims = dims;
+		points[i]->curr_axis = 0;
+		for (d = 0; d < dims; d++) {
+			points[i]->coords[d] = next_uniform(state);
+		}
+	}
+	return points;
+}
+
+/**
+ * Frees the points allocated by make_points.
+ * @param [in] points The points to free.
+ * @param [in] num_points The number of points in the array.
+ */
+static void free_points(point_data **points, size_t num_points) {
+	size_t i;
+	for (i = 0; i < num_points; i++) {
+		free(points[i]->coords);
+		free(points[i]);
+	}
+	free(points);
+}
+
+/**
+ * Times num_queries searches of the tree with the given traversal.
+ * @param [in] root The tree to search.
+ * @param [in] queries The points to search for.
+ * @param [in] num_queries The number of queries.
+ * @param [in] num_neighbors The number of neighbors per query.
+ * @param [in] method The traversal to use.
+ * @param [in] results Receives num_queries * num_neighbors node numbers.
+ * @return The elapsed time in seconds.
+ */
+static double time_queries(kdtree_node *root,
+		point_data **queries,
+		size_t num_queries,
+		size_t num_neighbors,
+		search_method method,
+		int results[]) {
+	size_t q;
+	double start = now();
+	for (q = 0; q < num_queries; q++) {
+		run_nn_search_method(root, num_neighbors, *queries[q],
+				&results[q * num_neighbors], method);
+	}
+	return now() - start;
+}
+
+/**
+ * Compares the depth-first and best-bin-first traversals.
+ * @param [in] num_points The number of points in each tree.
+ * @param [in] num_queries The number of queries to time.
+ * @param [in] num_neighbors The number of neighbors per query.
+ */
+static void bench_traversal(size_t num_points, size_t num_queries, size_t num_neighbors) {
+	size_t dim_list[] = {2, 8, 32};
+	size_t num_dims = sizeof(dim_list) / sizeof(dim_list[0]);
+
+	int *dfs_results = malloc(num_queries * num_neighbors * sizeof(int));
+	int *bbf_results = malloc(num_queries * num_neighbors * sizeof(int));
+	if (NULL == dfs_results || NULL == bbf_results) {
+		fprintf(stderr, "Out of memory at %s: %d\n", __FILE__, __LINE__);
+		exit(OOM);
+	}
+
+	printf("%6s %10s %8s %12s %12s %8s\n",
+			"dims", "points", "queries", "dfs (ms)", "bbf (ms)", "match");
+	size_t i;
+	for (i = 0; i < num_dims; i++) {
+		size_t dims = dim_list[i];
+		unsigned long long state = 0x9e3779b97f4a7c15ULL + dims;
+		point_data **points = make_points(num_points, dims, &state);
+		point_data **queries = make_points(num_queries, dims, &state);
+		size_t q;
+		for (q = 0; q < num_queries; q++) {
+			/* queries are not tree members, so nothing should be excluded */
+			queries[q]->num = -1;
+		}
+
+		kdtree_node *root = fill_tree(points, num_points);
+		double dfs = time_queries(root, queries, num_queries, num_neighbors,
+				SEARCH_DFS, dfs_results);
+		double bbf = time_queries(root, queries, num_queries, num_neighbors,
+				SEARCH_BBF, bbf_results);
+
+		/* both traversals are exact, so the neighbor lists should agree */
+		size_t mismatches = 0;
+		for (q = 0; q < num_queries * num_neighbors; q++) {
+			if (dfs_results[q] != bbf_results[q]) {
+				mismatches++;
+			}
+		}
+
+		printf("%6lu %10lu %8lu %12.2f %12.2f %8s\n",
+				(unsigned long)dims, (unsigned long)num_points,
+				(unsigned long)num_queries, dfs * 1000.0, bbf * 1000.0,
+				(0 == mismatches) ? "yes" : "no");
+
+		free_tree(root);
+		free_points(queries, num_queries);
+		free_points(points, num_points);
+	}
+
+	free(bbf_results);
+	free(dfs_results);
+}
+
+/**
+ * Finds the exact squared distance to the num_neighbors-th nearest neighbor by
+ * brute force.
+ * @param [in] points The points to search.
+ * @param [in] num_points The number of points.
+ * @param [in] search The point to search for.
+ * @param [in] num_neighbors The number of neighbors.
+ * @param [in] nearest Scratch space for num_neighbors distances.
+ * @return The squared distance of the farthest of the true nearest neighbors.
+ */
+static double brute_force_radius(point_data **points, size_t num_points,
+		const point_data *search, size_t num_neighbors, double nearest[]) {
+	size_t count = 0;
+	size_t i, x;
+	for (i = 0; i < num_points; i++) {
+		double sd = sqdist(points[i]->coords, search->coords, search->dims);
+		if (count == num_neighbors && sd >= nearest[count - 1]) {
+			continue;
+		}
+		if (count < num_neighbors) {
+			count++;
+		}
+		for (x = count - 1; x > 0 && nearest[x - 1] > sd; x--) {
+			nearest[x] = nearest[x - 1];
+		}
+		nearest[x] = sd;
+	}
+	return nearest[count - 1];
+}
+
+/**
+ * Measures recall against queries per second for randomized kd-forests.
+ * @param [in] num_points The number of points in the forest.
+ * @param [in] num_queries The number of queries to time.
+ * @param [in] num_neighbors The number of neighbors per query.
+ */
+static void bench_forest(size_t num_points, size_t num_queries, size_t num_neighbors) {
+	size_t dims = 128;
+	size_t tree_list[] = {1, 4, 8};
+	size_t check_list[] = {32, 64, 128, 256, 512, 1024, 2048, 4096};
+	size_t num_tree_counts = sizeof(tree_list) / sizeof(tree_list[0]);
+	size_t num_check_counts = sizeof(check_list) / sizeof(check_list[0]);
+
+	unsigned long long state = 0x9e3779b97f4a7c15ULL + dims;
+	point_data **points = make_points(num_points, dims, &state);
+	point_data **queries = make_points(num_queries, dims, &state);
+	double *radius = malloc(num_queries * sizeof(double));
+	double *scratch = malloc(num_neighbors * sizeof(double));
+	int *results = malloc(num_neighbors * sizeof(int));
+	point_data **by_num = malloc(num_points * sizeof(point_data *));
+	if (NULL == radius || NULL == scratch || NULL == results || NULL == by_num) {
+		fprintf(stderr, "Out of memory at %s: %d\n", __FILE__, __LINE__);
+		exit(OOM);
+	}
+
+	size_t q, i, t, c;
+	for (q = 0; q < num_queries; q++) {
+		queries[q]->num = -1;
+		radius[q] = brute_force_radius(points, num_points, queries[q], 
+				num_neighbors, scratch);
+	}
+	for (i = 0; i < num_points; i++) {
+		by_num[points[i]->num] = points[i];
+	}
+
+	printf("# dims %lu points %lu queries %lu neighbors %lu\n",
+			(unsigned long)dims, (unsigned long)num_points,
+			(unsigned long)num_queries, (unsigned long)num_neighbors);
+	printf("# %4s %10s %10s %8s %12s\n", "trees", "build (s)", "checks", "recall", "qps");
+	for (t = 0; t < num_tree_counts; t++) {
+		double start = now();
+		kdtree_forest *forest = fill_forest(points, num_points, tree_list[t], 0);
+		double build = now() - start;
+
+		for (c = 0; c < num_check_counts; c++) {
+			size_t hits = 0;
+			start = now();
+			for (q = 0; q < num_queries; q++) {
+				run_forest_search(forest, num_neighbors, *queries[q], results, check_list[c]);
+				for (i = 0; i < num_neighbors; i++) {
+					/* a neighbor counts if it is no farther than the true k-th */
+					if (results[i] >= 0 && sqdist(by_num[results[i]]->coords,
+								queries[q]->coords, dims) <= radius[q]) {
+						hits++;
+					}
+				}
+			}
+			double elapsed = now() - start;
+			printf("%6lu %10.2f %10lu %8.4f %12.1f\n",
+					(unsigned long)tree_list[t], build, (unsigned long)check_list[c],
+					(double)hits / (num_queries * num_neighbors), num_queries / elapsed);
+		}
+		printf("\n");
+		free_forest(forest);
+	}
+
+	free(by_num);
+	free(results);
+	free(scratch);
+	free(radius);
+	free_points(queries, num_queries);
+	free_points(points, num_points);
+}
+
+/**
+ * Builds one tree over a generated dataset, times each of num_queries queries
+ * drawn from the same distribution, and prints the results as one JSON object.
+ * @param [in] num_points The number of points in the tree.
+ * @param [in] num_queries The number of queries to time.
+ * @param [in] num_neighbors The number of neighbors per query.
+ * @param [in] dims The number of dimensions.
+ * @param [in] dist The distribution of the points and the queries.
+ * @param [in] seed The seed of the dataset.
+ * @param [in] veb Whether to move the tree into van Emde Boas order.
+ */
+static void bench_suite(size_t num_points, size_t num_queries, size_t num_neighbors,
+		size_t dims, distribution dist, unsigned long long seed, int veb) {
+	/* xorshift must not be seeded with zero */
+	unsigned long long state = 0x9e3779b97f4a7c15ULL * (seed + 1);
+	/* queries come from the same draw, so they share clusters and duplicates */
+	double *coords = make_coords(num_points + num_queries, dims, dist, &state);
+	double *times = malloc((num_queries + 1) * sizeof(double));
+	if (NULL == times) {
+		fprintf(stderr, "Out of memory at %s: %d\n", __FILE__, __LINE__);
+		exit(OOM);
+	}
+
+	size_t heap_before = heap_in_use();
+	double start = now();
+	kdtree_node *root = fill_tree_coords(coords, NULL, num_points, dims);
+	if (veb) {
+		root = layout_tree_veb(root);
+	}
+	double build = now() - start;
+	size_t heap_after = heap_in_use();
+
+	query_context *ctx = new_query_context(num_neighbors, dims);
+	point_data search;
+	search.num = -1;
+	search.dims = dims;
+	search.curr_axis = 0;
+	size_t q;
+	double total = 0;
+	int counter = open_branch_misses();
+	start_counter(counter);
+	for (q = 0; q < num_queries; q++) {
+		search.coords = &coords[(num_points + q) * dims];
+		start = now();
+		run_nn_search_context(root, ctx, num_neighbors, &search, SEARCH_DFS);
+		times[q] = now() - start;
+		total += times[q];
+	}
+	long long misses = stop_counter(counter);
+	close_counter(counter);
+	qsort(times, num_queries, sizeof(double), comp_double);
+
+	printf("{\"binding\": \"c\", \"distribution\": \"%s\", \"n\": %lu, \"d\": %lu, "
+			"\"k\": %lu, \"queries\": %lu, \"seed\": %llu, \"layout\": \"%s\", "
+			"\"build_s\": %.6f, ",
+			dist_names[dist], (unsigned long)num_points, (unsigned long)dims,
+			(unsigned long)num_neighbors, (unsigned long)num_queries, seed, 
+			veb ? "veb" : "preorder", build);
+	if (num_queries > 0) {
+		printf("\"query_p50_us\": %.3f, \"query_p99_us\": %.3f, \"qps\": %.1f, ",
+				percentile(times, num_queries, 50) * 1e6,
+				percentile(times, num_queries, 99) * 1e6, num_queries / total);
+	} else {
+		printf("\"query_p50_us\": null, \"query_p99_us\": null, \"qps\": null, ");
+	}
+	if (misses >= 0 && num_queries > 0) {
+		printf("\"branch_misses_per_query\": %.1f, ", (double)misses / num_queries);
+	} else {
+		printf("\"branch_misses_per_query\": null, ");
+	}
+	if (heap_after > heap_before && num_points > 0) {
+		printf("\"bytes_per_point\": %.1f}\n", 
+				(double)(heap_after - heap_before) / num_points);
+	} else {
+		printf("\"bytes_per_point\": null}\n");
+	}
+
+	free_query_context(ctx);
+	free_tree(root);
+	free(times);
+	free(coords);
+}
+
+/**
+ * Times batches of depth-first searches run one at a time against the same
+ * batches interleaved and run as packets, on a tree in preorder and then in 
+ * van Emde Boas order.  Interleaving only pays off once the tree is much 
+ * larger than the cache, and packets once the queries are dense.
+ * @param [in] num_points The number of points in the tree.
+ * @param [in] num_queries The number of queries per batch.
+ * @param [in] num_neighbors The number of neighbors per query.
+ * @param [in] dims The number of dimensions.
+ */
+static void bench_batch(size_t num_points, size_t num_queries, size_t num_neighbors,
+		size_t dims) {
+	unsigned long long state = 0x9e3779b97f4a7c15ULL + dims;
+	double *coords = make_coords(num_points + num_queries, dims, DIST_UNIFORM, &state);
+	point_data *data = malloc(num_queries * sizeof(point_data));
+	point_data **queries = malloc(num_queries * sizeof(point_data *));
+	int *dfs_results = malloc(num_queries * num_neighbors * sizeof(int));
+	int *interleaved_results = malloc(num_queries * num_neighbors * sizeof(int));
+	int *packet_results = malloc(num_queries * num_neighbors * sizeof(int));
+	if (NULL == data || NULL == queries || NULL == dfs_results || 
+			NULL == interleaved_results || NULL == packet_results) {
+		fprintf(stderr, "Out of memory at %s: %d\n", __FILE__, __LINE__);
+		exit(OOM);
+	}
+	size_t q;
+	for (q = 0; q < num_queries; q++) {
+		data[q].num = -1;
+		data[q].coords = &coords[(num_points + q) * dims];
+		data[q].dims = dims;
+		data[q].curr_axis = 0;
+		queries[q] = &data[q];
+	}
+
+	printf("%8s %6s %10s %8s %6s %12s %16s %12s %8s\n", "layout", "dims", "points", 
+			"queries", "k", "dfs (ms)", "interleaved (ms)", "packet (ms)", "match");
+	kdtree_node *root = fill_tree_coords(coords, NULL, num_points, dims);
+	int veb;
+	for (veb = 0; veb <= 1; veb++) {
+		if (veb) {
+			root = layout_tree_veb(root);
+		}
+		double start = now();
+		run_nn_search_batch(root, num_neighbors, queries, num_queries, dfs_results,
+				SEARCH_DFS, NULL);
+		double dfs = now() - start;
+		start = now();
+		run_nn_search_batch(root, num_neighbors, queries, num_queries, 
+				interleaved_results, SEARCH_INTERLEAVED, NULL);
+		double interleaved = now() - start;
+		start = now();
+		run_nn_search_batch(root, num_neighbors, queries, num_queries, 
+				packet_results, SEARCH_PACKET, NULL);
+		double packet = now() - start;
+		/* uniform points have no ties, so even packets agree exactly */
+		size_t size = num_queries * num_neighbors * sizeof(int);
+		int match = (0 == memcmp(dfs_results, interleaved_results, size) &&
+				0 == memcmp(dfs_results, packet_results, size));
+		printf("%8s %6lu %10lu %8lu %6lu %12.2f %16.2f %12.2f %8s\n", 
+				veb ? "veb" : "preorder", (unsigned long)dims, 
+				(unsigned long)num_points, (unsigned long)num_queries, 
+				(unsigned long)num_neighbors, dfs * 1000.0, interleaved * 1000.0,
+				packet * 1000.0, match ? "yes" : "no");
+	}
+
+	free_tree(root);
+	free(packet_results);
+	free(interleaved_results);
+	free(dfs_results);
+	free(queries);
+	free(data);
+	free(coords);
+}
+
+/**
+ * Formats a count per query for a table, or "-" if it was not counted.
+ * @param [in] buf Receives the text; at least 32 bytes.
+ * @param [in] count The count, or -1.
+ * @param [in] num_queries The number of queries.
+ * @return buf.
+ */
+static const char *per_query(char buf[], long long count, size_t num_queries) {
+	if (count < 0 || 0 == num_queries) {
+		return "-";
+	}
+	sprintf(buf, "%.1f", (double)count / num_queries);
+	return buf;
+}
+
+/**
+ * Times single searches of the double tree against the single precision 
+ * tree, and counts the branch mispredictions of each.
+ * @param [in] num_points The number of points in each tree.
+ * @param [in] num_queries The number of queries to time.
+ * @param [in] num_neighbors The number of neighbors per query.
+ */
+static void bench_branches(size_t num_points, size_t num_queries, size_t num_neighbors) {
+	size_t dim_list[] = {2, 3};
+	size_t num_dims = sizeof(dim_list) / sizeof(dim_list[0]);
+	int *best_nums = malloc((num_neighbors + 1) * sizeof(int));
+	if (NULL == best_nums) {
+		fprintf(stderr, "Out of memory at %s: %d\n", __FILE__, __LINE__);
+		exit(OOM);
+	}
+	int counter = open_branch_misses();
+
+	printf("%6s %10s %8s %6s %14s %14s %14s %14s\n", "dims", "points", "queries", 
+			"k", "double (ns)", "double misses", "f32 (ns)", "f32 misses");
+	size_t i;
+	for (i = 0; i < num_dims; i++) {
+		size_t dims = dim_list[i];
+		unsigned long long state = 0x9e3779b97f4a7c15ULL + dims;
+		double *coords = make_coords(num_points + num_queries, dims, DIST_UNIFORM, 
+				&state);
+		float *narrow = malloc(num_points * dims * sizeof(float) + 1);
+		if (NULL == narrow) {
+			fprintf(stderr, "Out of memory at %s: %d\n", __FILE__, __LINE__);
+			exit(OOM);
+		}
+		size_t c;
+		for (c = 0; c < num_points * dims; c++) {
+			narrow[c] = (float)coords[c];
+		}
+		kdtree_node *root = fill_tree_coords(coords, NULL, num_points, dims);
+		kdtree_f32 *tree = fill_tree_f32(narrow, NULL, num_points, dims);
+		query_context *ctx = new_query_context(num_neighbors, dims);
+		point_data search;
+		search.num = -1;
+		search.dims = dims;
+		search.curr_axis = 0;
+
+		size_t q;
+		start_counter(counter);
+		double start = now();
+		for (q = 0; q < num_queries; q++) {
+			search.coords = &coords[(num_points + q) * dims];
+			run_nn_search_context(root, ctx, num_neighbors, &search, SEARCH_DFS);
+		}
+		double dfs = now() - start;
+		long long dfs_misses = stop_counter(counter);
+
+		start_counter(counter);
+		start = now();
+		for (q = 0; q < num_queries; q++) {
+			run_nn_search_f32(tree, num_neighbors, &coords[(num_points + q) * dims], -1,
+					best_nums, 0);
+		}
+		double f32 = now() - start;
+		long long f32_misses = stop_counter(counter);
+
+		char dfs_buf[32], f32_buf[32];
+		printf("%6lu %10lu %8lu %6lu %14.1f %14s %14.1f %14s\n", 
+				(unsigned long)dims, (unsigned long)num_points, 
+				(unsigned long)num_queries, (unsigned long)num_neighbors,
+				dfs * 1e9 / num_queries, per_query(dfs_buf, dfs_misses, num_queries),
+				f32 * 1e9 / num_queries, per_query(f32_buf, f32_misses, num_queries));
+
+		free_query_context(ctx);
+		free_tree_f32(tree);
+		free_tree(root);
+		free(narrow);
+		free(coords);
+	}
+	close_counter(counter);
+	free(best_nums);
+}
+
+/**
+ * Checks the k-nearest neighbor graph against brute force on uniform points
+ * and on heavily duplicated ones, where many neighbors lie at distance zero
+ * and the bound carried from one query to the next is exact.  Prints the
+ * number of rows whose neighbor distances disagree for each distribution.
+ * @param [in] num_points The number of points in the tree.
+ * @param [in] num_neighbors The number of neighbors per point.
+ * @param [in] dims The number of dimensions.
+ * @return The total number of disagreeing rows.
+ */
+static size_t bench_graph(size_t num_points, size_t num_neighbors, size_t dims) {
+	distribution dist_list[] = {DIST_UNIFORM, DIST_DUPLICATES};
+	size_t num_dists = sizeof(dist_list) / sizeof(dist_list[0]);
+	size_t total = 0;
+
+	int *nums = malloc(num_points * sizeof(int));
+	int *best_nums = malloc(num_points * num_neighbors * sizeof(int));
+	double *best_dists = malloc(num_points * num_neighbors * sizeof(double));
+	double *scratch = malloc((num_neighbors + 1) * sizeof(double));
+	if (NULL == nums || NULL == best_nums || NULL == best_dists || NULL == scratch) {
+		fprintf(stderr, "Out of memory at %s: %d\n", __FILE__, __LINE__);
+		exit(OOM);
+	}
+
+	printf("%12s %10s %6s %6s %10s\n", "distribution", "points", "dims", "k", "mismatches");
+	size_t i;
+	for (i = 0; i < num_dists; i++) {
+		unsigned long long state = 0x9e3779b97f4a7c15ULL + dims;
+		double *coords = make_coords(num_points, dims, dist_list[i], &state);
+		kdtree_node *root = fill_tree_coords(coords, NULL, num_points, dims);
+		size_t rows = knn_graph(root, num_neighbors, nums, best_nums, best_dists);
+
+		size_t mismatches = 0;
+		size_t r, j, p;
+		for (r = 0; r < rows; r++) {
+			/* every point but the row's own, nearest first */
+			double *row_coords = &coords[nums[r] * dims];
+			size_t count = 0;
+			for (p = 0; p < num_points; p++) {
+				if ((int)p == nums[r]) {
+					continue;
+				}
+				double sd = sqdist(&coords[p * dims], row_coords, dims);
+				if (count == num_neighbors && sd >= scratch[count - 1]) {
+					continue;
+				}
+				if (count < num_neighbors) {
+					count++;
+				}
+				for (j = count - 1; j > 0 && scratch[j - 1] > sd; j--) {
+					scratch[j] = scratch[j - 1];
+				}
+				scratch[j] = sd;
+			}
+			for (j = 0; j < num_neighbors; j++) {
+				double expected = (j < count) ? scratch[j] : -1.0;
+				if (best_dists[r * num_neighbors + j] != expected) {
+					mismatches++;
+					break;
+				}
+			}
+		}
+
+		printf("%12s %10lu %6lu %6lu %10lu\n", dist_names[dist_list[i]],
+				(unsigned long)num_points, (unsigned long)dims,
+				(unsigned long)num_neighbors, (unsigned long)mismatches);
+		total += mismatches;
+		free_tree(root);
+		free(coords);
+	}
+
+	free(scratch);
+	free(best_dists);
+	free(best_nums);
+	free(nums);
+	return total;
+}
+
+int main(int argc, char **argv) {
+	const char *mode = (argc > 1) ? argv[1] : "traversal";
+	size_t num_points = (argc > 2) ? strtoul(argv[2], NULL, 10) : 100000;
+	size_t num_queries = (argc > 3) ? strtoul(argv[3], NULL, 10) : 1000;
+	size_t num_neighbors = (argc > 4) ? strtoul(argv[4], NULL, 10) : 3;
+
+	if (0 == strcmp(mode, "traversal")) {
+		bench_traversal(num_points, num_queries, num_neighbors);
+	} else if (0 == strcmp(mode, "forest")) {
+		bench_forest(num_points, num_queries, num_neighbors);
+	} else if (0 == strcmp(mode, "batch")) {
+		size_t dims = (argc > 5) ? strtoul(argv[5], NULL, 10) : 2;
+		if (0 == dims) {
+			fprintf(stderr, "zero dims\n");
+			return 1;
+		}
+		bench_batch(num_points, num_queries, num_neighbors, dims);
+	} else if (0 == strcmp(mode, "branches")) {
+		bench_branches(num_points, num_queries, num_neighbors);
+	} else if (0 == strcmp(mode, "graph")) {
+		size_t dims = (argc > 5) ? strtoul(argv[5], NULL, 10) : 2;
+		if (0 == dims) {
+			fprintf(stderr, "zero dims\n");
+			return 1;
+		}
+		return (0 == bench_graph(num_points, num_neighbors, dims)) ? 0 : 1;
+	} else if (0 == strcmp(mode, "suite")) {
+		size_t dims = (argc > 5) ? strtoul(argv[5], NULL, 10) : 2;
+		const char *dist_name = (argc > 6) ? argv[6] : "uniform";
+		unsigned long long seed = (argc > 7) ? strtoull(argv[7], NULL, 10) : 1;
+		const char *layout = (argc > 8) ? argv[8] : "preorder";
+		size_t dist;
+		for (dist = 0; dist <= DIST_MANIFOLD; dist++) {
+			if (0 == strcmp(dist_name, dist_names[dist])) {
+				break;
+			}
+		}
+		if (dist > DIST_MANIFOLD || 0 == dims) {
+			fprintf(stderr, "unknown distribution %s or zero dims\n", dist_name);
+			return 1;
+		}
+		if (0 != strcmp(layout, "preorder") && 0 != strcmp(layout, "veb")) {
+			fprintf(stderr, "unknown layout %s\n", layout);
+			return 1;
+		}
+		bench_suite(num_points, num_queries, num_neighbors, dims, (distribution)dist, seed,
+				0 == strcmp(layout, "veb"));
+	} else {
+		fprintf(stderr, "usage: %s traversal|forest|batch|branches|graph|suite [num_points] [num_queries] "
+				"[num_neighbors] [dims] [distribution] [seed] [layout]\n", argv[0]);
+		return 1;
+	}
+	return 0;
+}
@@ -13,15 +13,160 @@
  * You should have received a copy of the GNU Lesser General Public License
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
+#if defined(KDTREE_STATS) && !defined(_POSIX_C_SOURCE)
+/* for clock_gettime under strict -std=c99 */
+#define _POSIX_C_SOURCE 199309L
+#endif
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <math.h>
+#include <stdint.h>
+#include <limits.h>
 #include "kdtree_raw.h"
 
 #ifndef OOM
 #define OOM 8
 #endif
 
+/* The number of highest-variance dimensions a randomized split chooses from. */
+#ifndef RAND_DIMS
+#define RAND_DIMS 5
+#endif
+
+/* The number of points sampled when estimating per-dimension variance. */
+#ifndef VAR_SAMPLES
+#define VAR_SAMPLES 100
+#endif
+
+/* Marks a missing child in a flattened tree. */
+#define NO_CHILD ((size_t)-1)
+
+/* Subtree pairs at most this big are joined by brute force. */
+#ifndef JOIN_LEAF_SIZE
+#define JOIN_LEAF_SIZE 32
+#endif
+
+/* The number of bits in a Morton code. */
+#define MORTON_BITS 64
+
+/* The number of bits of a Morton code each radix sort pass sorts on. */
+#define RADIX_BITS 8
+
+/* The number of consecutive queries a thread takes at a time in knn_graph. */
+#ifndef KNN_BLOCK
+#define KNN_BLOCK 256
+#endif
+
+/* Searches for at most this many neighbors keep their candidates on the stack
+   when no query_context is given; larger ones allocate. */
+#ifndef SMALL_NEIGHBORS
+#define SMALL_NEIGHBORS 32
+#endif
+
+/* The number of branches a new query_context's queue can hold. */
+#define QUEUE_START 64
+
+/* Subtrees of at least this many points are built as separate OpenMP tasks. */
+#ifndef PAR_TASK_POINTS
+#define PAR_TASK_POINTS 32768
+#endif
+
+/* Medians of at least this many points are selected with parallel 
+   partitions. */
+#ifndef PAR_SELECT_POINTS
+#define PAR_SELECT_POINTS 1048576
+#endif
+
+/* The number of chunks a parallel partition splits its points into. */
+#define PAR_CHUNKS 64
+
+/* The number of cells each side of a box is divided into for quantized
+   coordinates. */
+#define QUANT_CELLS 65536.0
+
+/* The number of candidates a new context has room for in quantized 
+   searches. */
+#define QUANT_CANDIDATES 64
+
+/* Presorted builds hand subtrees of at most this many points to median 
+   selection, which is cheaper than splitting every sorted list for so few. */
+#ifndef PRESORT_LEAF_POINTS
+#define PRESORT_LEAF_POINTS 64
+#endif
+
+/* The number of searches an interleaved batch keeps in flight on each thread,
+   and the number of consecutive queries each thread takes at a time. */
+#ifndef INTERLEAVE_QUERIES
+#define INTERLEAVE_QUERIES 8
+#endif
+#define INTERLEAVE_RUN 1024
+
+/* Interleaved searches switch to another search only to wait for a node at 
+   least this many bytes away from its parent. */
+#ifndef INTERLEAVE_NEAR_BYTES
+#define INTERLEAVE_NEAR_BYTES 4096
+#endif
+
+/* The number of nearby searches a packet search carries through the tree 
+   together.  Eight doubles fill two AVX2 or one AVX-512 register. */
+#ifndef PACKET_QUERIES
+#define PACKET_QUERIES 8
+#endif
+
+/* Asks for the cache line holding addr ahead of its use. */
+#ifdef __GNUC__
+#define PREFETCH(addr) __builtin_prefetch(addr)
+#else
+#define PREFETCH(addr)
+#endif
+
+#if KDTREE_STATS_ENABLED
+#include <time.h>
+
+/* The counters of the search running on this thread, or NULL. */
+static _Thread_local search_stats *thread_stats = NULL;
+/* The recursion depth of the depth-first search running on this thread. */
+static _Thread_local size_t thread_depth = 0;
+/* The statistics of the last tree or forest built on this thread. */
+static _Thread_local build_stats thread_build;
+
+/* Counts one event of the search running on this thread. */
+#define COUNT(field) do { \
+	if (NULL != thread_stats) { \
+		thread_stats->field++; \
+	} \
+} while (0)
+
+/* Records that the search running on this thread got depth deep. */
+#define NOTE_DEPTH(depth) do { \
+	if (NULL != thread_stats && (depth) > thread_stats->max_depth) { \
+		thread_stats->max_depth = (depth); \
+	} \
+} while (0)
+
+/* Bracket the visit of a node by the depth-first search. */
+#define ENTER_NODE() do { \
+	thread_depth++; \
+	NOTE_DEPTH(thread_depth); \
+	COUNT(nodes_visited); \
+} while (0)
+#define LEAVE_NODE() (thread_depth--)
+
+/* Counts n events of the search running on this thread. */
+#define COUNT_N(field, n) do { \
+	if (NULL != thread_stats) { \
+		thread_stats->field += (n); \
+	} \
+} while (0)
+#else
+#define COUNT(field)
+#define COUNT_N(field, n)
+#define NOTE_DEPTH(depth)
+#define ENTER_NODE()
+#define LEAVE_NODE()
+#endif
+
 /**
  * Represents a neighbor of an arbitrary node.  This is a combination of node 
  * number and distance to said arbitrary node.
@@ -37,17 +182,84 @@ typedef struct best_pair {
  * Determine the largest element in the nearest neighbors array.
  * @param [in] nearest The array of nearest neighbors.
  * @param [in] count The number of current nearest neighbors.
+ * @param [in] num_neighbors The maximum number of nearest neighbors.
  * @return The largest value in the nearest neighbors array (i.e. the
- * neighbor that is farthest away).
+ * neighbor that is farthest away), or -1 if the array is not yet full.  Until
+ * num_neighbors candidates have been found no branch may be pruned.
  */
-static double largest_dist(best_pair nearest[], size_t count) {
+static double largest_dist(best_pair nearest[], size_t count, size_t num_neighbors) {
 	double largest = -1.0;
-	if (count > 0) {
+	if (count > 0 && count >= num_neighbors) {
 		largest = nearest[count - 1].dist;
 	}
 	return largest;
 }
 
+/**
+ * Computes the smallest squared distance from the search point to a box.
+ * @param [in] search The search point.
+ * @param [in] lo The lower corner of the box.
+ * @param [in] hi The upper corner of the box.
+ * @param [in] dims The number of dimensions.
+ * @return The squared distance, 0 if the point lies in the box.
+ */
+static double box_dist(const double search[], const double lo[], const double hi[], 
+		size_t dims) {
+	double dist = 0.0;
+	size_t d;
+	for (d = 0; d < dims; d++) {
+		double gap = 0.0;
+		if (search[d] < lo[d]) {
+			gap = lo[d] - search[d];
+		} else if (search[d] > hi[d]) {
+			gap = search[d] - hi[d];
+		}
+		dist += gap * gap;
+	}
+	return dist;
+}
+
+/**
+ * Finds the coordinate a node splits its subtree at along its axis: no point
+ * of its left subtree is greater and none of its right subtree is less.
+ * @param [in] node The node.
+ * @param [in] axis The node's axis.
+ * @return The split coordinate.
+ */
+static inline double split_coord(const kdtree_node *node, size_t axis) {
+	return (NULL == node->box) ? node->data->coords[axis] : 
+		node->box[2 * node->data->dims];
+}
+
+/**
+ * Bounds the squared distance from a search point to the points of a node's
+ * far child from below: by the distance to the split, or by the distance to
+ * the child's box when it has one, which is never less.
+ * @param [in] far The far child.
+ * @param [in] search The coordinates of the search point.
+ * @param [in] diff The split coordinate less the search point's along the axis.
+ * @return The lower bound.
+ */
+static inline double far_bound(const kdtree_node *far, const double search[], 
+		double diff) {
+	if (NULL == far->box) {
+		return diff * diff;
+	}
+	size_t dims = far->data->dims;
+	return box_dist(search, far->box, &far->box[dims], dims);
+}
+
+/**
+ * Finds the size of the blocks a tree's nodes are stored in.
+ * @param [in] root The root of the tree.  Must not be NULL.
+ * @return The size of a block.
+ */
+static size_t node_block_size(const kdtree_node *root) {
+	size_t dims = root->data->dims;
+	size_t box_size = (NULL == root->box) ? 0 : (2 * dims + 1) * sizeof(double);
+	return sizeof(kdtree_node) + sizeof(point_data) + dims * sizeof(double) + box_size;
+}
+
 /**
  * Choose the axis to use based on the current depth and the number of dimensions.
  * This is useful when building the tree and search for nearest neighbors.
@@ -59,6 +271,68 @@ static size_t pick_axis(size_t depth, size_t dims) {
 	return depth % dims;
 }
 
+/**
+ * Advances a xorshift random number generator.
+ * @param [in] state The generator state.  Must not be zero.
+ * @return The next pseudo-random number.
+ */
+static unsigned long long next_random(unsigned long long *state) {
+	unsigned long long x = *state;
+	x ^= x << 13;
+	x ^= x >> 7;
+	x ^= x << 17;
+	*state = x;
+	return x;
+}
+
+/**
+ * Choose a random axis among the dimensions with the highest variance.  The 
+ * variance is estimated from an evenly strided sample of the points.  This is
+ * how the trees of a randomized kd-forest are made to differ from each other.
+ * @param [in] points The points about to be split.
+ * @param [in] num_points The number of points in the points array.
+ * @param [in] rng The random generator state.
+ * @return The axis to use.
+ */
+static size_t pick_random_axis(point_data **points, size_t num_points, 
+		unsigned long long *rng) {
+	size_t dims = points[0]->dims;
+	size_t samples = (num_points < VAR_SAMPLES) ? num_points : VAR_SAMPLES;
+	size_t stride = num_points / samples;
+
+	/* the RAND_DIMS best axes seen so far, highest variance first */
+	size_t top_axes[RAND_DIMS];
+	double top_vars[RAND_DIMS];
+	size_t num_top = 0;
+
+	size_t d, s, t;
+	for (d = 0; d < dims; d++) {
+		double mean = 0.0;
+		double sq_mean = 0.0;
+		for (s = 0; s < samples; s++) {
+			double coord = points[s * stride]->coords[d];
+			mean += coord;
+			sq_mean += coord * coord;
+		}
+		mean /= samples;
+		double var = sq_mean / samples - mean * mean;
+
+		/* insertion into the sorted top list */
+		if (num_top < RAND_DIMS) {
+			num_top++;
+		} else if (var <= top_vars[RAND_DIMS - 1]) {
+			continue;
+		}
+		for (t = num_top - 1; t > 0 && top_vars[t - 1] < var; t--) {
+			top_vars[t] = top_vars[t - 1];
+			top_axes[t] = top_axes[t - 1];
+		}
+		top_vars[t] = var;
+		top_axes[t] = d;
+	}
+	return top_axes[next_random(rng) % num_top];
+}
+
 /**
  * Computes the Euclidean distance between two k-dimensional points.
  * @param [in] a The first point.
@@ -78,30 +352,254 @@ extern double sqdist(double a[], double b[], size_t dims) {
 }
 
 /**
- * Compares two point_data items based on the coordinate and their current axis.
- * @param [in] a The first point_data item to compare.  The curr_axis member must be 
- * set by the caller.
- * @param [in] b The second point_data item to compare.  The curr_axis member must be 
- * set by the caller.
- * @return -1 if a.coords[curr_axis] < b.coords[curr_axis], 
- * 1 if a.coords[curr_axis] > b.coords[curr_axis], 0 otherwise.
+ * Adds the counters of some searches to a running total.
+ * @param [in] total The total to add to.
+ * @param [in] stats The counters to add.
  */
-static int comp_axis(const void *a, const void *b) {
-	point_data * const *pa = a;
-	point_data * const *pb = b;
+extern void add_search_stats(search_stats *total, const search_stats *stats) {
+	total->searches += stats->searches;
+	total->nodes_visited += stats->nodes_visited;
+	total->leaves_visited += stats->leaves_visited;
+	total->dist_evals += stats->dist_evals;
+	total->far_pruned += stats->far_pruned;
+	total->far_descended += stats->far_descended;
+	if (stats->max_depth > total->max_depth) {
+		total->max_depth = stats->max_depth;
+	}
+}
 
-	size_t axis = (*pa)->curr_axis;
-	double a_coord = (*pa)->coords[axis];
-	double b_coord = (*pb)->coords[axis];
-	if (a_coord < b_coord) {
-		return -1;
+/**
+ * Adds the cost of one build to a running total.
+ * @param [in] total The total to add to.
+ * @param [in] stats The cost to add.
+ */
+static void add_build_stats(build_stats *total, const build_stats *stats) {
+	size_t level;
+	for (level = 0; level < STATS_LEVELS; level++) {
+		total->level_nodes[level] += stats->level_nodes[level];
+		total->level_seconds[level] += stats->level_seconds[level];
 	}
-	if (a_coord > b_coord) {
-		return 1;
+	if (stats->levels > total->levels) {
+		total->levels = stats->levels;
 	}
-	return 0;
 }
 
+/**
+ * Copies what building the last tree or forest on the calling thread cost.
+ * All zero unless built with KDTREE_STATS.
+ * @param [in] stats Receives the build statistics.
+ */
+extern void get_build_stats(build_stats *stats) {
+#if KDTREE_STATS_ENABLED
+	*stats = thread_build;
+#else
+	memset(stats, 0, sizeof(build_stats));
+#endif
+}
+
+/**
+ * Starts measuring a build on the calling thread.
+ * @return The zeroed statistics of the calling thread's build, or NULL if 
+ * builds are not measured.
+ */
+static build_stats *start_build_stats(void) {
+#if KDTREE_STATS_ENABLED
+	memset(&thread_build, 0, sizeof(build_stats));
+	return &thread_build;
+#else
+	return NULL;
+#endif
+}
+
+#if KDTREE_STATS_ENABLED
+/**
+ * Returns a monotonic timestamp in seconds, for timing build levels.
+ */
+static double stats_now(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+#endif
+
+/**
+ * Orders points along an axis, breaking ties by node number and then, for 
+ * points that share a number too, by address.  Every point then has a 
+ * distinct rank, so the median and the points on either side of it do not 
+ * depend on how the array happened to be arranged, and every selection 
+ * algorithm, sequential or parallel, builds the same tree.  Duplicate 
+ * coordinates are split by number, so the tree does not change from run to
+ * run with where the points were allocated.
+ * @param [in] a The first point.
+ * @param [in] b The second point.
+ * @param [in] axis The coordinate to compare.
+ * @return 1 if a comes before b, 0 otherwise.
+ */
+static inline int point_before(const point_data *a, const point_data *b, 
+		size_t axis) {
+	double x = a->coords[axis];
+	double y = b->coords[axis];
+	return x < y || (x == y && (a->num < b->num || 
+			(a->num == b->num && (uintptr_t)a < (uintptr_t)b)));
+}
+
+/**
+ * Reorders points so that the point of rank median along axis sits at
+ * points[median], with every point before it in point_before order ahead of it
+ * and every other point after it.  This is Hoare's selection, so it takes 
+ * expected linear time and needs no scratch memory, unlike sorting each level.
+ * @param [in] points The points to reorder.
+ * @param [in] num_points The number of points in the array.
+ * @param [in] median The rank to select.
+ * @param [in] axis The coordinate to select on.
+ */
+static void select_median(point_data **points, size_t num_points, size_t median, 
+		size_t axis) {
+	long lo = 0;
+	long hi = (long)num_points - 1;
+	long m = (long)median;
+	while (hi > lo) {
+		const point_data *pivot = points[lo + (hi - lo) / 2];
+		long i = lo;
+		long j = hi;
+		while (i <= j) {
+			while (point_before(points[i], pivot, axis)) {
+				i++;
+			}
+			while (point_before(pivot, points[j], axis)) {
+				j--;
+			}
+			if (i <= j) {
+				point_data *tmp = points[i];
+				points[i] = points[j];
+				points[j] = tmp;
+				i++;
+				j--;
+			}
+		}
+		if (m <= j) {
+			hi = j;
+		} else if (m >= i) {
+			lo = i;
+		} else {
+			break;
+		}
+	}
+}
+
+#ifdef _OPENMP
+/**
+ * Partitions points around pivot in parallel: first the points before pivot
+ * in point_before order, then pivot, then the rest.  Each group keeps its 
+ * original order, so the result is the same for any number of threads.  Must
+ * be called from within an OpenMP parallel region.
+ * @param [in] points The points to partition.
+ * @param [in] scratch Room for num_points pointers.
+ * @param [in] num_points The number of points in the array.
+ * @param [in] pivot The point to partition around.  Must be in points.
+ * @param [in] axis The coordinate to partition on.
+ * @return The index of pivot afterwards.
+ */
+static size_t par_partition(point_data **points, point_data **scratch, 
+		size_t num_points, const point_data *pivot, size_t axis) {
+	size_t chunk_size = (num_points + PAR_CHUNKS - 1) / PAR_CHUNKS;
+	size_t num_less[PAR_CHUNKS];
+	size_t num_more[PAR_CHUNKS];
+	long c;
+#pragma omp taskloop grainsize(1) shared(num_less, num_more)
+	for (c = 0; c < PAR_CHUNKS; c++) {
+		size_t first = c * chunk_size;
+		size_t last = (first + chunk_size < num_points) ? first + chunk_size : num_points;
+		size_t less = 0;
+		size_t more = 0;
+		size_t i;
+		for (i = first; i < last; i++) {
+			less += point_before(points[i], pivot, axis);
+			more += point_before(pivot, points[i], axis);
+		}
+		num_less[c] = less;
+		num_more[c] = more;
+	}
+
+	/* prefix sums give every chunk its place in either group */
+	size_t less_start[PAR_CHUNKS];
+	size_t more_start[PAR_CHUNKS];
+	size_t total_less = 0;
+	size_t total_more = 0;
+	for (c = 0; c < PAR_CHUNKS; c++) {
+		less_start[c] = total_less;
+		more_start[c] = total_more;
+		total_less += num_less[c];
+		total_more += num_more[c];
+	}
+
+#pragma omp taskloop grainsize(1) shared(less_start, more_start, total_less)
+	for (c = 0; c < PAR_CHUNKS; c++) {
+		size_t first = c * chunk_size;
+		size_t last = (first + chunk_size < num_points) ? first + chunk_size : num_points;
+		size_t less = less_start[c];
+		size_t more = total_less + 1 + more_start[c];
+		size_t i;
+		for (i = first; i < last; i++) {
+			if (point_before(points[i], pivot, axis)) {
+				scratch[less++] = points[i];
+			} else if (points[i] != pivot) {
+				scratch[more++] = points[i];
+			}
+		}
+	}
+	scratch[total_less] = (point_data *)pivot;
+
+#pragma omp taskloop grainsize(1)
+	for (c = 0; c < PAR_CHUNKS; c++) {
+		size_t first = c * chunk_size;
+		if (first < num_points) {
+			size_t len = (first + chunk_size < num_points) ? chunk_size : num_points - first;
+			memcpy(&points[first], &scratch[first], len * sizeof(point_data *));
+		}
+	}
+	return total_less;
+}
+
+/**
+ * Selects as select_median does, partitioning in parallel while the range 
+ * holding the median is large, and sequentially after that.  Must be called 
+ * from within an OpenMP parallel region.
+ * @param [in] points The points to reorder.
+ * @param [in] scratch Room for num_points pointers.
+ * @param [in] num_points The number of points in the array.
+ * @param [in] median The rank to select.
+ * @param [in] axis The coordinate to select on.
+ */
+static void par_select_median(point_data **points, point_data **scratch, 
+		size_t num_points, size_t median, size_t axis) {
+	size_t lo = 0;
+	size_t hi = num_points;
+	while (hi - lo >= PAR_SELECT_POINTS) {
+		/* the median of the first, middle and last points */
+		point_data *a = points[lo];
+		point_data *b = points[lo + (hi - lo) / 2];
+		point_data *c = points[hi - 1];
+		point_data *pivot;
+		if (point_before(a, b, axis)) {
+			pivot = point_before(b, c, axis) ? b : (point_before(a, c, axis) ? c : a);
+		} else {
+			pivot = point_before(a, c, axis) ? a : (point_before(b, c, axis) ? c : b);
+		}
+
+		size_t pos = lo + par_partition(&points[lo], &scratch[lo], hi - lo, pivot, axis);
+		if (pos == median) {
+			return;
+		} else if (median < pos) {
+			hi = pos;
+		} else {
+			lo = pos + 1;
+		}
+	}
+	select_median(&points[lo], hi - lo, median - lo, axis);
+}
+#endif
+
 /**
  * Debug method to print out the points array.
  * @param [in] points The points array to print.
@@ -115,176 +613,436 @@ static void print_points(const point_data **points, size_t sz) {
 }
 
 /**
- * Slices the points_data array.
- * Note that this does not perform a deep copy, but just copies the pointers so
- * they can be reordered without touching the original array.
- * @param [in] points The array of points to slice.
- * @param [in] start The starting point of the slice (inclusive).
- * @param [in] end The ending point of the slice (exclusive).
- * @return The slice of the array.
+ * The layout of a tree's nodes: one fixed-size block per node, in preorder.
+ * A subtree of n points takes n consecutive blocks, its root first, then its
+ * left subtree, then its right, so where every node goes is known before its
+ * subtrees are built, and they can be built in any order.
+ * @param stride The size of a block.
+ * @param stats Receives the cost of the build level by level, or NULL.
  */
-static point_data **slice(point_data **points, size_t start, size_t end) {
-	size_t slice_sz = end - start;
-	size_t cp_sz = slice_sz * sizeof(point_data *);
-	point_data **sliced = malloc(cp_sz);
-	if (NULL == sliced) {
-		fprintf(stderr, "Out of memory at %s: %d\n", __FILE__, __LINE__);
-		exit(OOM);
+typedef struct node_arena {
+	size_t stride;
+	build_stats *stats;
+} node_arena;
+
+/**
+ * Fills in a node block from the median point of its subtree.
+ * @param [in] block The block to fill in.
+ * @param [in] median The point to copy into the node.
+ * @param [in] axis The axis the node splits on.
+ * @return The node, with no children yet.
+ */
+static kdtree_node * init_node(char *block, const point_data *median, size_t axis) {
+	kdtree_node *node = (kdtree_node *)block;
+	node->left = NULL;
+	node->right = NULL;
+	node->box = NULL;
+	node->data = (point_data *)(node + 1);
+	node->data->coords = (double *)(node->data + 1);
+	/* deep copy points over */
+	memcpy(node->data->coords, median->coords, median->dims * sizeof(double));
+	node->data->dims = median->dims;
+	node->data->num = median->num;
+	node->data->curr_axis = axis;
+	return node;
+}
+
+#if KDTREE_STATS_ENABLED
+/**
+ * Adds the time spent splitting one node to the cost of its level.  Nodes may
+ * be built on several threads at once.
+ * @param [in] stats The cost of the build.  May be NULL.
+ * @param [in] depth The depth of the node.
+ * @param [in] seconds The time spent splitting it.
+ */
+static void note_level(build_stats *stats, size_t depth, double seconds) {
+	if (NULL == stats) {
+		return;
+	}
+	size_t level = (depth < STATS_LEVELS) ? depth : STATS_LEVELS - 1;
+#ifdef _OPENMP
+#pragma omp atomic
+#endif
+	stats->level_nodes[level]++;
+#ifdef _OPENMP
+#pragma omp atomic
+#endif
+	stats->level_seconds[level] += seconds;
+#ifdef _OPENMP
+#pragma omp critical
+#endif
+	if (depth + 1 > stats->levels) {
+		stats->levels = depth + 1;
 	}
-	memcpy(sliced, &(points[start]), cp_sz);
-	return sliced;
 }
+#endif
 
 /**
  * Builds up a tree using the given point_data.  
- * @param [in] points The points_data used to build the tree.  This function copies 
- * the pointers in this parameter so the caller is free to dispose of it after 
- * the call.  Note that the curr_axis field will be modified by this function.
+ * @param [in] points The points_data used to build the tree.  The array is
+ * reordered in place; the caller is free to dispose of it after the call.
  * @param [in] num_points The number of points in the points_data array.
  * @param [in] depth The current depth of the tree.  Used to correctly sort and 
  * split the points
- * @return A newly malloc'd KD tree node.
+ * @param [in] rng The random generator state used to pick randomized split axes,
+ * or NULL to cycle through the axes by depth.
+ * @param [in] arena The layout of the nodes.
+ * @param [in] block The first of the num_points blocks for this subtree.
+ * @return The root of the subtree.
  */
-static kdtree_node * fill_tree_r(point_data **points, size_t num_points, size_t depth) {
+static kdtree_node * fill_tree_r(point_data **points, size_t num_points, size_t depth,
+		unsigned long long *rng, const node_arena *arena, char *block) {
 	if (NULL == points || 0 == num_points) {
 		return NULL;
 	}
+#if KDTREE_STATS_ENABLED
+	double start = stats_now();
+#endif
 
 	size_t dims = points[0]->dims;
-
-	kdtree_node *node = malloc(sizeof(kdtree_node));
-	if (NULL == node) {
-		fprintf(stderr, "Out of memory at %s: %d\n", __FILE__, __LINE__);
-		exit(OOM);
-	}
-	/*memset(node, 0, sizeof *node);*/
-	node->left = NULL;
-	node->right = NULL;
-	node->data = NULL;
-
-	size_t axis = pick_axis(depth, dims);
-	/* Sort the points by axis; we need to mod the current axis before sorting to get
-	 * the comparison to work correctly */
-	size_t x;
-	for (x = 0; x < num_points; x++) {
-		points[x]->curr_axis = axis;
+	size_t axis;
+	if (NULL == rng) {
+		axis = pick_axis(depth, dims);
+	} else {
+		axis = pick_random_axis(points, num_points, rng);
 	}
-	qsort(points, num_points, sizeof(*points), comp_axis);
-
-	/* Print input */
-
+	/* Partition the points around the median along the axis */
 	size_t median = num_points / 2;
+	select_median(points, num_points, median, axis);
+
 	size_t left_sz = median;
 	size_t right_sz = num_points - median - 1;
-
-	point_data *p_median = points[median];
-	/* Set up the node's point data */
-	size_t data_sz = sizeof(*node->data);
-	node->data = malloc(data_sz);
-	if (NULL == node->data) {
-		fprintf(stderr, "Out of memory at %s: %d\n", __FILE__, __LINE__);
-		exit(OOM);
-	}
-	node->data->coords = NULL;
-
-	size_t coord_size = dims * sizeof(double);
-	node->data->coords = malloc(coord_size);
-	if (NULL == node->data->coords) {
-		fprintf(stderr, "Out of memory at %s: %d\n", __FILE__, __LINE__);
-		exit(OOM);
-	}
-	/* deep copy points over */
-	memcpy(node->data->coords, p_median->coords, coord_size);
-
-	node->data->dims = p_median->dims;
-	node->data->num = p_median->num;
-	node->data->curr_axis = axis;
+	kdtree_node *node = init_node(block, points[median], axis);
+#if KDTREE_STATS_ENABLED
+	note_level(arena->stats, depth, stats_now() - start);
+#endif
 
 	/* Now divide and recurse left/right */
 	size_t next_depth = depth + 1;
 	if (left_sz > 0) {
 		/* Left side goes from [0, median), i.e. does not include the median */
-		point_data **left_arr = slice(points, 0, median);
-		node->left = fill_tree_r(left_arr, median, next_depth);
-		free(left_arr);
+		node->left = fill_tree_r(points, median, next_depth, rng, arena, 
+				block + arena->stride);
 	}
 
 	/* Right side goes from [median + 1, num_points).  The current node is the median, and
 	 * we run up to the last element in the subarray.*/
 	if (right_sz > 0) {
-		point_data **right_arr = slice(points, median + 1, num_points);
-		node->right = fill_tree_r(right_arr, right_sz, next_depth);
-		free(right_arr);
+		node->right = fill_tree_r(&points[median + 1], right_sz, next_depth, rng, arena,
+				block + (median + 1) * arena->stride);
+	}
+	return node;
+}
+
+#ifdef _OPENMP
+/**
+ * Builds the same tree as fill_tree_r with axes cycled by depth, building
+ * large subtrees as OpenMP tasks and selecting the medians of very large ones
+ * with parallel partitions.  Must be called from within an OpenMP parallel 
+ * region.
+ * @param [in] points The points_data used to build the tree.  The array is
+ * reordered in place.
+ * @param [in] scratch Room for num_points pointers, used by parallel 
+ * partitions; may be NULL if num_points is below PAR_SELECT_POINTS.
+ * @param [in] num_points The number of points in the points_data array.
+ * @param [in] depth The current depth of the tree.
+ * @param [in] arena The layout of the nodes.
+ * @param [in] block The first of the num_points blocks for this subtree.
+ * @return The root of the subtree.
+ */
+static kdtree_node * fill_tree_par(point_data **points, point_data **scratch, 
+		size_t num_points, size_t depth, const node_arena *arena, char *block) {
+	if (num_points < PAR_TASK_POINTS) {
+		return fill_tree_r(points, num_points, depth, NULL, arena, block);
 	}
+#if KDTREE_STATS_ENABLED
+	double start = stats_now();
+#endif
+
+	size_t axis = pick_axis(depth, points[0]->dims);
+	size_t median = num_points / 2;
+	par_select_median(points, scratch, num_points, median, axis);
+
+	size_t right_sz = num_points - median - 1;
+	kdtree_node *node = init_node(block, points[median], axis);
+#if KDTREE_STATS_ENABLED
+	note_level(arena->stats, depth, stats_now() - start);
+#endif
+
+	/* both halves are big enough to be worth a task of their own */
+	size_t next_depth = depth + 1;
+#pragma omp task
+	node->left = fill_tree_par(points, scratch, median, next_depth, arena, 
+			block + arena->stride);
+#pragma omp task
+	node->right = fill_tree_par(&points[median + 1], 
+			(NULL == scratch) ? NULL : &scratch[median + 1], right_sz, next_depth, 
+			arena, block + (median + 1) * arena->stride);
+#pragma omp taskwait
 	return node;
 }
+#endif
+
+/**
+ * Builds a tree in a single allocation.  Each node is one block holding the
+ * kdtree_node, its point_data and its coordinates, and the blocks are laid out
+ * in preorder, so the tree is compact, a depth-first search walks it mostly
+ * forward, and the root block is the allocation that free_tree releases.
+ * Trees with axes cycled by depth are built in parallel when compiled with
+ * OpenMP; the tree is the same for any number of threads.
+ * @param [in] points The points_data used to build the tree.  The array is
+ * reordered in place.
+ * @param [in] num_points The number of points in the points_data array.
+ * @param [in] rng The random generator state used to pick randomized split axes,
+ * or NULL to cycle through the axes by depth.
+ * @param [in] stats Receives the cost of the build, or NULL.
+ * @return The root of the newly malloc'd tree, or NULL if there are no points.
+ */
+static kdtree_node * build_tree(point_data **points, size_t num_points, 
+		unsigned long long *rng, build_stats *stats) {
+	if (NULL == points || 0 == num_points) {
+		return NULL;
+	}
+	node_arena arena;
+	arena.stride = sizeof(kdtree_node) + sizeof(point_data) + 
+		points[0]->dims * sizeof(double);
+	arena.stats = stats;
+	char *blocks = malloc(num_points * arena.stride);
+	if (NULL == blocks) {
+		fprintf(stderr, "Out of memory at %s: %d\n", __FILE__, __LINE__);
+		exit(OOM);
+	}
+
+#ifdef _OPENMP
+	if (NULL == rng && num_points >= PAR_TASK_POINTS) {
+		point_data **scratch = NULL;
+		if (num_points >= PAR_SELECT_POINTS) {
+			scratch = malloc(num_points * sizeof(point_data *));
+			if (NULL == scratch) {
+				fprintf(stderr, "Out of memory at %s: %d\n", __FILE__, __LINE__);
+				exit(OOM);
+			}
+		}
+		kdtree_node *root = NULL;
+#pragma omp parallel
+#pragma omp single
+		root = fill_tree_par(points, scratch, num_points, 0, &arena, blocks);
+		free(scratch);
+		return root;
+	}
+#endif
+	return fill_tree_r(points, num_points, 0, rng, &arena, blocks);
+}
 
 /**
  * Builds up a tree using the given point_data.  
- * @param [in] points The points_data used to build the tree.  This function copies 
- * the pointers in this parameter so the caller is free to dispose of it after 
- * the call.
+ * @param [in] points The points_data used to build the tree.  The array is
+ * reordered in place; the caller is free to dispose of it after the call.
  * @param [in] num_points The number of points in the points_data array.
  * @return A newly malloc'd KD tree node.
  */
 extern kdtree_node * fill_tree(point_data **points, size_t num_points) {
-	return fill_tree_r(points, num_points, 0);
+	return build_tree(points, num_points, NULL, start_build_stats());
 }
 
 /**
- * Recursively free()s the elements of the tree.
- * @param [in] node The root of the tree to free.
+ * Builds up a tree from points stored contiguously, so that bindings holding a
+ * plain array of coordinates need not assemble point_data themselves.
+ * @param [in] coords The coordinates, dims per point.  The tree copies them, so
+ * the caller is free to dispose of them after the call.
+ * @param [in] nums The node numbers of the points, or NULL to number the points
+ * by their index.
+ * @param [in] num_points The number of points.
+ * @param [in] dims The number of dimensions of each point.
+ * @return A newly malloc'd KD tree node, or NULL if there are no points.
  */
-extern void free_tree(kdtree_node * node) {
-	if (NULL == node) {
-		return;
-	}
-	if (NULL != node->data) {
-		if (NULL != node->data->coords) {
-			free(node->data->coords);
-			node->data->coords = NULL;
-		}
-		free(node->data);
-		node->data = NULL;
+extern kdtree_node * fill_tree_coords(const double coords[], const int nums[], 
+		size_t num_points, size_t dims) {
+	if (0 == num_points) {
+		return NULL;
 	}
-	if (NULL != node->right) {
-		free_tree(node->right);
-		node->right = NULL;
+	point_data *data = malloc(num_points * sizeof(point_data));
+	point_data **points = malloc(num_points * sizeof(point_data *));
+	if (NULL == data || NULL == points) {
+		fprintf(stderr, "Out of memory at %s: %d\n", __FILE__, __LINE__);
+		exit(OOM);
 	}
-	if (NULL != node->left) {
-		free_tree(node->left);
-		node->left = NULL;
+	size_t x;
+	for (x = 0; x < num_points; x++) {
+		data[x].num = (NULL == nums) ? (int)x : nums[x];
+		/* the build only reads the coordinates before copying them */
+		data[x].coords = (double *)&coords[x * dims];
+		data[x].dims = dims;
+		data[x].curr_axis = 0;
+		points[x] = &data[x];
 	}
-	free(node);
-	node = NULL;
+	kdtree_node *root = fill_tree(points, num_points);
+	free(points);
+	free(data);
+	return root;
 }
 
-/* Functions directly related to KD-tree functionality */
-
 /**
- * Adds the search point to the list of nearest neighbors if it is closer than 
- * any of the current nearest neighbors. 
- * @param [in] nearest The current nearest neighbors.  Will be filled in
- * by this function.
- * @param [in] best_count The number of current nearest neighbors.
- * @param [in] neighbor The node to consider as a potential nearest neighbor.
- * @param [in] search The point for which the nearest neighbor search is being
- * done.
- * @param [in] num_neighbors The maximum number of nearest neighbors.
- * @return The number of current nearest neighbors.  If best_count < num_neigbors,
- * this will be one more than best_count; otherwise it will be equal to 
- * num_neighbors.
+ * Copies a tree whose shape the caller already has, such as one linked up by 
+ * hand from binding objects, into the core's layout so the core's searches can
+ * run on it.  Each node splits on the axis its depth picks, as in a built tree.
+ * @param [in] coords The coordinates of the nodes in preorder, dims per node, 
+ * the root first.  The tree copies them.
+ * @param [in] nums The node numbers of the nodes.
+ * @param [in] left The position of each node's left child, which must come 
+ * after the node, or -1 if it has none.
+ * @param [in] right The position of each node's right child, likewise.
+ * @param [in] num_nodes The number of nodes.
+ * @param [in] dims The number of dimensions of each node.
+ * @return A newly malloc'd KD tree node, or NULL if there are no nodes.
  */
-static size_t add_best(
-		best_pair nearest[],
-		size_t best_count, 
-		const kdtree_node *neighbor,
-		point_data search, 
-		size_t num_neighbors) {
-
-	double sd = sqdist(neighbor->data->coords, search.coords, search.dims);
-	size_t last_idx;
-	if (best_count < num_neighbors) {
+extern kdtree_node * fill_tree_shape(const double coords[], const int nums[], 
+		const long left[], const long right[], size_t num_nodes, size_t dims) {
+	if (0 == num_nodes) {
+		return NULL;
+	}
+	size_t stride = sizeof(kdtree_node) + sizeof(point_data) + dims * sizeof(double);
+	char *blocks = malloc(num_nodes * stride);
+	if (NULL == blocks) {
+		fprintf(stderr, "Out of memory at %s: %d\n", __FILE__, __LINE__);
+		exit(OOM);
+	}
+	size_t x;
+	for (x = 0; x < num_nodes; x++) {
+		point_data point;
+		point.num = nums[x];
+		point.coords = (double *)&coords[x * dims];
+		point.dims = dims;
+		init_node(blocks + x * stride, &point, 0);
+	}
+	/* children come after their parents, so each parent's axis is set first */
+	for (x = 0; x < num_nodes; x++) {
+		kdtree_node *node = (kdtree_node *)(blocks + x * stride);
+		size_t next_axis = pick_axis(node->data->curr_axis + 1, dims);
+		if (left[x] >= 0) {
+			node->left = (kdtree_node *)(blocks + left[x] * stride);
+			node->left->data->curr_axis = next_axis;
+		}
+		if (right[x] >= 0) {
+			node->right = (kdtree_node *)(blocks + right[x] * stride);
+			node->right->data->curr_axis = next_axis;
+		}
+	}
+	return (kdtree_node *)blocks;
+}
+
+/**
+ * Builds a randomized kd-forest using the given point_data.  Each tree splits
+ * on an axis chosen at random among the highest-variance dimensions, so the 
+ * trees partition the space differently and a search that shares its budget 
+ * across all of them finds close neighbors that any single tree would miss.
+ * The trees are built in parallel when compiled with OpenMP.
+ * @param [in] points The points_data used to build the forest.  The caller is
+ * free to dispose of it after the call.
+ * @param [in] num_points The number of points in the points_data array.
+ * @param [in] num_trees The number of trees to build.
+ * @param [in] seed The seed for the random split axes.  The same seed gives the
+ * same forest.
+ * @return A newly malloc'd forest.
+ */
+extern kdtree_forest * fill_forest(point_data **points, size_t num_points, 
+		size_t num_trees, unsigned long seed) {
+	kdtree_forest *forest = malloc(sizeof(kdtree_forest));
+	if (NULL == forest) {
+		fprintf(stderr, "Out of memory at %s: %d\n", __FILE__, __LINE__);
+		exit(OOM);
+	}
+	forest->num_trees = num_trees;
+	forest->trees = calloc(num_trees, sizeof(kdtree_node *));
+	if (NULL == forest->trees && num_trees > 0) {
+		fprintf(stderr, "Out of memory at %s: %d\n", __FILE__, __LINE__);
+		exit(OOM);
+	}
+
+	/* the trees may be built on other threads, so each measures its own build
+	 * and adds it to the calling thread's total */
+	build_stats *total = start_build_stats();
+	long t;
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
+	for (t = 0; t < (long)num_trees; t++) {
+		/* fill_tree_r reorders the array it is given, so each tree works on its 
+		 * own copy of the pointers; the points themselves are shared */
+		point_data **tree_points = malloc(num_points * sizeof(point_data *));
+		if (NULL == tree_points && num_points > 0) {
+			fprintf(stderr, "Out of memory at %s: %d\n", __FILE__, __LINE__);
+			exit(OOM);
+		}
+		memcpy(tree_points, points, num_points * sizeof(point_data *));
+
+		/* xorshift must not be seeded with zero */
+		unsigned long long rng = 0x9e3779b97f4a7c15ULL * (seed + t + 1);
+		build_stats tree_stats;
+		memset(&tree_stats, 0, sizeof(build_stats));
+		forest->trees[t] = build_tree(tree_points, num_points, &rng, 
+				(NULL != total) ? &tree_stats : NULL);
+		free(tree_points);
+		if (NULL != total) {
+#ifdef _OPENMP
+#pragma omp critical
+#endif
+			add_build_stats(total, &tree_stats);
+		}
+	}
+	return forest;
+}
+
+/**
+ * Frees a forest and all of its trees.
+ * @param [in] forest The forest to free.
+ */
+extern void free_forest(kdtree_forest *forest) {
+	if (NULL == forest) {
+		return;
+	}
+	size_t t;
+	for (t = 0; t < forest->num_trees; t++) {
+		free_tree(forest->trees[t]);
+		forest->trees[t] = NULL;
+	}
+	free(forest->trees);
+	forest->trees = NULL;
+	free(forest);
+}
+
+/**
+ * Frees a tree built by fill_tree or fill_tree_coords.  The whole tree lives in
+ * the root's allocation, so this must be given the root, not a subtree.
+ * @param [in] node The root of the tree to free.
+ */
+extern void free_tree(kdtree_node * node) {
+	free(node);
+}
+
+/* Functions directly related to KD-tree functionality */
+
+/**
+ * Inserts a candidate into the sorted list of nearest neighbors if it is closer
+ * than any of the current nearest neighbors.
+ * @param [in] nearest The current nearest neighbors.  Will be filled in
+ * by this function.
+ * @param [in] best_count The number of current nearest neighbors.
+ * @param [in] num The node number of the candidate.
+ * @param [in] sd The squared distance from the candidate to the search point.
+ * @param [in] num_neighbors The maximum number of nearest neighbors.
+ * @return The number of current nearest neighbors.  If best_count < num_neigbors,
+ * this will be one more than best_count; otherwise it will be equal to 
+ * num_neighbors.
+ */
+static size_t insert_best(
+		best_pair nearest[],
+		size_t best_count, 
+		int num,
+		double sd,
+		size_t num_neighbors) {
+	size_t last_idx;
+	if (best_count < num_neighbors) {
 		last_idx = best_count;
 	} else {
 		last_idx = best_count - 1;
@@ -292,7 +1050,7 @@ static size_t add_best(
 
 	size_t idx;
 	best_pair candidate;
-	candidate.node_num = neighbor->data->num;
+	candidate.node_num = num;
 	candidate.dist = sd;
 
 	best_pair pair;
@@ -300,6 +1058,10 @@ static size_t add_best(
 	/* search through linearly to maintain sorted order */
 	for (idx = 0; idx < best_count; idx++) {
 		pair = nearest[idx];
+		if (pair.dist == sd && pair.node_num == candidate.node_num) {
+			/* already seen, e.g. through another tree of a forest */
+			return best_count;
+		}
 		if (pair.dist > sd) {
 			/* push elements down */
 			for (x = last_idx; x > idx; x--) {
@@ -319,112 +1081,3976 @@ static size_t add_best(
 }
 
 /**
- * Searches for nearest neighbor of search using node as the root.
- * @param [in] node The node to consider as a potential nearest neighbor.
- * @param [in] search The point for which the nearest neighbor search is being
- * done.
+ * Inserts a candidate into the sorted list of nearest neighbors if it is closer
+ * than the farthest of them, as insert_best does, for searches that never see
+ * a point twice.  The list is shifted from the back, so the common case of a
+ * candidate that is not close enough costs one comparison.
+ * @param [in] nearest The current nearest neighbors.  Will be filled in
+ * by this function.
+ * @param [in] best_count The number of current nearest neighbors.
+ * @param [in] num The node number of the candidate.
+ * @param [in] sd The squared distance from the candidate to the search point.
+ * @param [in] num_neighbors The maximum number of nearest neighbors.  Must 
+ * not be 0.
+ * @return The number of current nearest neighbors.
+ */
+static inline size_t insert_sorted(
+		best_pair nearest[],
+		size_t best_count, 
+		int num,
+		double sd,
+		size_t num_neighbors) {
+	if (best_count >= num_neighbors && !(sd < nearest[num_neighbors - 1].dist)) {
+		return best_count;
+	}
+	/* shift the farther candidates down, dropping the last if full */
+	size_t idx = (best_count < num_neighbors) ? best_count++ : num_neighbors - 1;
+	while (idx > 0 && nearest[idx - 1].dist > sd) {
+		nearest[idx] = nearest[idx - 1];
+		idx--;
+	}
+	nearest[idx].node_num = num;
+	nearest[idx].dist = sd;
+	return best_count;
+}
+
+/**
+ * Adds the search point to the list of nearest neighbors if it is closer than 
+ * any of the current nearest neighbors. 
  * @param [in] nearest The current nearest neighbors.  Will be filled in
  * by this function.
  * @param [in] best_count The number of current nearest neighbors.
+ * @param [in] neighbor The node to consider as a potential nearest neighbor.
+ * @param [in] search The point for which the nearest neighbor search is being
+ * done.
  * @param [in] num_neighbors The maximum number of nearest neighbors.
- * @param [depth] The current depth in the search tree.
- *
  * @return The number of current nearest neighbors.  If best_count < num_neigbors,
  * this will be one more than best_count; otherwise it will be equal to 
  * num_neighbors.
  */
-static size_t nn_search(
-		const kdtree_node *node, 
-		point_data search,
-		best_pair nearest[], 
+static size_t add_best(
+		best_pair nearest[],
 		size_t best_count, 
-		size_t num_neighbors,
-		size_t depth) {
-  if (NULL == node) {
-    return best_count;
+		const kdtree_node *neighbor,
+		const point_data *search, 
+		size_t num_neighbors) {
+	COUNT(dist_evals);
+	double sd = sqdist(neighbor->data->coords, search->coords, search->dims);
+	return insert_best(nearest, best_count, neighbor->data->num, sd, num_neighbors);
+}
+
+/**
+ * Computes the squared distance between two single precision points.  The 
+ * loop is vectorized when compiled with OpenMP.
+ * @param [in] a The first point.
+ * @param [in] b The second point.
+ * @param [in] dims The number of dimensions.
+ * @return The squared distance, in single precision.
+ */
+static float sqdist_f32(const float a[], const float b[], size_t dims) {
+	float dist = 0.0f;
+	size_t d;
+#ifdef _OPENMP
+#pragma omp simd reduction(+:dist)
+#endif
+	for (d = 0; d < dims; d++) {
+		float diff = a[d] - b[d];
+		dist += diff * diff;
 	}
-	
-	int search_num = search.num;
-	size_t dims = search.dims;
-	size_t axis = pick_axis(depth, dims);
+	return dist;
+}
 
-	int node_num = node->data->num;
-	double neighbor_coord = node->data->coords[axis];
-	double search_coord = search.coords[axis];
+/**
+ * The layouts of the trees searched by dfs_search.
+ * LAYOUT_NODES is a tree of kdtree_nodes, built by any of the fill_tree 
+ * functions.
+ * LAYOUT_PACKED is a kdtree_packed.
+ * LAYOUT_F32 is a kdtree_f32 searched with distances in single precision, and
+ * LAYOUT_F32_WIDE one searched with distances in double precision.
+ */
+typedef enum tree_layout {
+	LAYOUT_NODES,
+	LAYOUT_PACKED,
+	LAYOUT_F32,
+	LAYOUT_F32_WIDE
+} tree_layout;
 
-  /* we need to check each node before assigning it as the final best choice to 
-	   ensure it is not equal to the searched-for point, hence 
-	   node_num != search_num */
-	if (NULL == node->left && NULL == node->right) {
-    if (node_num != search_num) {
-      best_count = add_best(nearest, best_count, node, search, num_neighbors);
+/**
+ * A depth-first search: the tree, the search point and the candidates.
+ * @param layout The layout of the tree.
+ * @param dims The number of dimensions.
+ * @param coords The coordinates of a packed tree.
+ * @param coords_f32 The coordinates of a single precision tree.
+ * @param nums The node numbers of a packed or single precision tree.
+ * @param search The coordinates of the search point.
+ * @param search_f32 The search point in single precision, for LAYOUT_F32.
+ * @param search_num The node number of the search point, which is never its 
+ * own neighbor.
+ * @param nearest The current nearest neighbors.  Single precision trees record
+ * their positions rather than their node numbers, so that they can be 
+ * reranked.
+ * @param num_neighbors The maximum number of nearest neighbors.  Must not be 0.
+ * @param radius A known upper bound on the squared distance to the 
+ * num_neighbors-th nearest neighbor, used for pruning until nearest fills up.
+ * Points at exactly this distance are still found.  -1 if no bound is known.
+ */
+typedef struct dfs_state {
+	tree_layout layout;
+	size_t dims;
+	const double *coords;
+	const float *coords_f32;
+	const int *nums;
+	const double *search;
+	const float *search_f32;
+	int search_num;
+	best_pair *nearest;
+	size_t num_neighbors;
+	double radius;
+} dfs_state;
+
+static size_t dfs_search(const dfs_state *state, tree_layout layout, 
+		const kdtree_node *node, size_t idx, size_t size, size_t depth, 
+		size_t best_count);
+
+/**
+ * Searches a subtree for the nearest neighbors depth first: the near child,
+ * then the node, then the far child if it may hold closer points.  This one
+ * routine searches every layout: trees of nodes by their links, and packed 
+ * and single precision trees by position, where a subtree of n nodes at idx
+ * has its left subtree of n / 2 nodes at idx + 1 and its right subtree after
+ * that.  Far children are skipped by their boxes in trees that have them, 
+ * and by the split otherwise.  It is inlined into dfs_search once per layout,
+ * so each copy is compiled for its layout alone.
+ * @param [in] state The search.
+ * @param [in] layout The layout of the tree, state->layout.
+ * @param [in] node The root of the subtree in a tree of nodes; NULL in other 
+ * layouts.
+ * @param [in] idx The position of the subtree's root in other layouts.
+ * @param [in] size The number of nodes in the subtree in other layouts.
+ * @param [in] depth The depth of the subtree's root.
+ * @param [in] best_count The number of current nearest neighbors.
+ * @return The number of current nearest neighbors.
+ */
+static inline size_t dfs_visit(const dfs_state *state, tree_layout layout, 
+		const kdtree_node *node, size_t idx, size_t size, size_t depth, 
+		size_t best_count) {
+	ENTER_NODE();
+	size_t dims = state->dims;
+	const double *search = state->search;
+	size_t num_neighbors = state->num_neighbors;
+	size_t left_sz = size / 2;
+	size_t right_sz = (size > 0) ? size - left_sz - 1 : 0;
+	const kdtree_node *left = NULL;
+	const kdtree_node *right = NULL;
+	size_t axis;
+	double split;
+	double dist;
+	int num;
+	int candidate;
+	if (LAYOUT_NODES == layout) {
+		const point_data *data = node->data;
+		const double *coords = data->coords;
+		axis = data->curr_axis;
+		split = split_coord(node, axis);
+		num = data->num;
+		candidate = num;
+		left = node->left;
+		right = node->right;
+		left_sz = (NULL != left);
+		right_sz = (NULL != right);
+		dist = (2 == dims) ? 
+			(coords[0] - search[0]) * (coords[0] - search[0]) + 
+			(coords[1] - search[1]) * (coords[1] - search[1]) : 
+			sqdist((double *)coords, (double *)search, dims);
+	} else if (LAYOUT_PACKED == layout) {
+		const double *coords = &state->coords[idx * dims];
+		axis = pick_axis(depth, dims);
+		split = coords[axis];
+		num = state->nums[idx];
+		candidate = num;
+		dist = (2 == dims) ? 
+			(coords[0] - search[0]) * (coords[0] - search[0]) + 
+			(coords[1] - search[1]) * (coords[1] - search[1]) : 
+			sqdist((double *)coords, (double *)search, dims);
+	} else {
+		const float *coords = &state->coords_f32[idx * dims];
+		axis = pick_axis(depth, dims);
+		split = coords[axis];
+		num = state->nums[idx];
+		candidate = (int)idx;
+		if (LAYOUT_F32 == layout) {
+			dist = sqdist_f32(coords, state->search_f32, dims);
+		} else {
+			size_t d;
+			dist = 0.0;
+			for (d = 0; d < dims; d++) {
+				double diff = (double)coords[d] - search[d];
+				dist += diff * diff;
+			}
+		}
+	}
+	if (0 == left_sz && 0 == right_sz) {
+		COUNT(leaves_visited);
+	}
+
+	/* as everywhere, the left child is near when diff > 0 */
+	double diff = split - search[axis];
+	int left_near = (diff > 0);
+	if (left_near && left_sz > 0) {
+		best_count = dfs_search(state, layout, left, idx + 1, left_sz, depth + 1, 
+				best_count);
+	} else if (!left_near && right_sz > 0) {
+		best_count = dfs_search(state, layout, right, idx + 1 + left_sz, right_sz, 
+				depth + 1, best_count);
+	}
+
+	if (num != state->search_num) {
+		COUNT(dist_evals);
+		best_count = insert_sorted(state->nearest, best_count, candidate, dist, 
+				num_neighbors);
+	}
+
+	if ((left_near ? right_sz : left_sz) > 0) {
+		const kdtree_node *far = left_near ? right : left;
+		double bound = (NULL == far) ? diff * diff : far_bound(far, search, diff);
+		int search_other;
+		if (best_count >= num_neighbors) {
+			search_other = (bound < state->nearest[num_neighbors - 1].dist);
+		} else {
+			/* the bound may be met exactly, e.g. by duplicates at distance 0 */
+			search_other = (state->radius < 0 || bound <= state->radius);
+		}
+		if (search_other) {
+			COUNT(far_descended);
+			best_count = left_near ? 
+				dfs_search(state, layout, right, idx + 1 + left_sz, right_sz, depth + 1,
+						best_count) :
+				dfs_search(state, layout, left, idx + 1, left_sz, depth + 1, best_count);
+		} else {
+			COUNT(far_pruned);
 		}
-    return best_count;
 	}
+	LEAVE_NODE();
+	return best_count;
+}
 
-  /* compare query point and current node along the axis to see which tree is
-     far and which is near */
+/**
+ * Searches a tree of nodes depth first, as dfs_visit does.
+ */
+static size_t dfs_nodes(const dfs_state *state, const kdtree_node *node, 
+		size_t depth, size_t best_count) {
+	return dfs_visit(state, LAYOUT_NODES, node, 0, 0, depth, best_count);
+}
 
-	kdtree_node *near;
-	kdtree_node *far;
-  if (search_coord < neighbor_coord) {
-    near = (kdtree_node *)node->left;
-    far = (kdtree_node *)node->right;
-	} else {
-    near = (kdtree_node *)node->right;
-    far = (kdtree_node *)node->left;
+/**
+ * Searches a packed tree depth first, as dfs_visit does.
+ */
+static size_t dfs_packed(const dfs_state *state, size_t idx, size_t size, 
+		size_t depth, size_t best_count) {
+	return dfs_visit(state, LAYOUT_PACKED, NULL, idx, size, depth, best_count);
+}
+
+/**
+ * Searches a single precision tree depth first, as dfs_visit does.
+ */
+static size_t dfs_f32(const dfs_state *state, size_t idx, size_t size, 
+		size_t depth, size_t best_count) {
+	return dfs_visit(state, LAYOUT_F32, NULL, idx, size, depth, best_count);
+}
+
+/**
+ * Searches a single precision tree depth first in double precision, as 
+ * dfs_visit does.
+ */
+static size_t dfs_f32_wide(const dfs_state *state, size_t idx, size_t size, 
+		size_t depth, size_t best_count) {
+	return dfs_visit(state, LAYOUT_F32_WIDE, NULL, idx, size, depth, best_count);
+}
+
+/**
+ * Searches a subtree depth first with the copy of dfs_visit for its layout.
+ * @param [in] state The search.
+ * @param [in] layout The layout of the tree, state->layout.
+ * @param [in] node The root of the subtree in a tree of nodes; NULL in other 
+ * layouts.
+ * @param [in] idx The position of the subtree's root in other layouts.
+ * @param [in] size The number of nodes in the subtree in other layouts.
+ * @param [in] depth The depth of the subtree's root.
+ * @param [in] best_count The number of current nearest neighbors.
+ * @return The number of current nearest neighbors.
+ */
+static inline size_t dfs_search(const dfs_state *state, tree_layout layout, 
+		const kdtree_node *node, size_t idx, size_t size, size_t depth, 
+		size_t best_count) {
+	switch (layout) {
+	case LAYOUT_NODES:
+		return dfs_nodes(state, node, depth, best_count);
+	case LAYOUT_PACKED:
+		return dfs_packed(state, idx, size, depth, best_count);
+	case LAYOUT_F32:
+		return dfs_f32(state, idx, size, depth, best_count);
+	default:
+		return dfs_f32_wide(state, idx, size, depth, best_count);
+	}
+}
+
+/**
+ * Searches a tree of nodes for the nearest neighbors of a point depth first.
+ * @param [in] root The root of the tree.  May be NULL.
+ * @param [in] search The point for which the nearest neighbor search is being
+ * done.
+ * @param [in] nearest The nearest neighbors.  Will be filled in by this 
+ * function.
+ * @param [in] num_neighbors The maximum number of nearest neighbors.
+ * @param [in] radius A known upper bound on the squared distance to the 
+ * num_neighbors-th nearest neighbor, or -1.  See dfs_state.
+ * @return The number of nearest neighbors found.
+ */
+static size_t nn_search(const kdtree_node *root, const point_data *search, 
+		best_pair nearest[], size_t num_neighbors, double radius) {
+	if (NULL == root || 0 == num_neighbors) {
+		return 0;
+	}
+	dfs_state state;
+	memset(&state, 0, sizeof(dfs_state));
+	state.layout = LAYOUT_NODES;
+	state.dims = search->dims;
+	state.search = search->coords;
+	state.search_num = search->num;
+	state.nearest = nearest;
+	state.num_neighbors = num_neighbors;
+	state.radius = radius;
+	return dfs_search(&state, state.layout, root, 0, 0, 0, 0);
+}
+
+/**
+ * An unexplored branch waiting in the best-bin-first priority queue.
+ * @param node The root of the unexplored subtree.
+ * @param bound A lower bound on the squared distance from the search point to
+ * any point in the subtree.
+ */
+typedef struct branch {
+	const kdtree_node *node;
+	double bound;
+} branch;
+
+/**
+ * A binary min-heap of branches keyed on their lower bound distance.
+ * @param items The heap storage.
+ * @param count The number of branches in the heap.
+ * @param capacity The number of branches items can hold.
+ */
+typedef struct branch_queue {
+	branch *items;
+	size_t count;
+	size_t capacity;
+} branch_queue;
+
+/**
+ * Adds a branch to the queue, growing the storage as needed.
+ * @param [in] queue The queue to add to.
+ * @param [in] item The branch to add.
+ */
+static void queue_push(branch_queue *queue, branch item) {
+	if (queue->count == queue->capacity) {
+		size_t capacity = (0 == queue->capacity) ? 64 : queue->capacity * 2;
+		branch *items = realloc(queue->items, capacity * sizeof(branch));
+		if (NULL == items) {
+			fprintf(stderr, "Out of memory at %s: %d\n", __FILE__, __LINE__);
+			exit(OOM);
+		}
+		queue->items = items;
+		queue->capacity = capacity;
+	}
+
+	/* sift up */
+	size_t idx = queue->count++;
+	while (idx > 0) {
+		size_t parent = (idx - 1) / 2;
+		if (queue->items[parent].bound <= item.bound) {
+			break;
+		}
+		queue->items[idx] = queue->items[parent];
+		idx = parent;
 	}
+	queue->items[idx] = item;
+}
 
-  /* search the near branch */
-  size_t next_depth = depth + 1;
+/**
+ * Removes the branch with the smallest lower bound from the queue.
+ * @param [in] queue The queue to remove from.  Must not be empty.
+ * @return The branch with the smallest lower bound.
+ */
+static branch queue_pop(branch_queue *queue) {
+	branch top = queue->items[0];
+	branch last = queue->items[--queue->count];
 
-	if (NULL != near) {
-	  best_count = nn_search(near, search, nearest, best_count, num_neighbors, next_depth);
+	/* sift down */
+	size_t idx = 0;
+	size_t child;
+	while ((child = 2 * idx + 1) < queue->count) {
+		if (child + 1 < queue->count &&
+				queue->items[child + 1].bound < queue->items[child].bound) {
+			child++;
+		}
+		if (last.bound <= queue->items[child].bound) {
+			break;
+		}
+		queue->items[idx] = queue->items[child];
+		idx = child;
 	}
+	if (queue->count > 0) {
+		queue->items[idx] = last;
+	}
+	return top;
+}
+
+/**
+ * Searches for nearest neighbor of search using a best-bin-first traversal.
+ * Rather than recursing depth first, unexplored far branches are kept in a 
+ * priority queue keyed on their lower bound distance, and the closest one is
+ * always expanded next.  This finds good candidates early, which in turn 
+ * shrinks the pruning radius sooner.  All roots share the one queue and the one
+ * nearest neighbors list, so several trees over the same points can be 
+ * searched together.
+ * @param [in] roots The roots of the trees to search.
+ * @param [in] num_roots The number of trees.
+ * @param [in] search The point for which the nearest neighbor search is being
+ * done.
+ * @param [in] nearest The current nearest neighbors.  Will be filled in
+ * by this function.
+ * @param [in] num_neighbors The maximum number of nearest neighbors.
+ * @param [in] max_checks Stop once this many points have been compared against
+ * the search point and the nearest neighbors list is full.  The result is then
+ * approximate.  0 searches until the result is exact.
+ * @param [in] queue The queue to keep the branches in.  It is emptied first
+ * and keeps its storage afterwards, so it can be reused.
+ * @return The number of nearest neighbors found.
+ */
+static size_t bbf_search(
+		kdtree_node * const roots[],
+		size_t num_roots,
+		const point_data *search,
+		best_pair nearest[],
+		size_t num_neighbors,
+		size_t max_checks,
+		branch_queue *queue) {
+	size_t best_count = 0;
+	size_t checks = 0;
+	int search_num = search->num;
+	queue->count = 0;
 
-  /* If the current node is closer overall than the current best */
-  if (node_num != search_num) {
-    best_count = add_best(nearest, best_count, node, search, num_neighbors);
+	size_t r;
+	for (r = 0; r < num_roots; r++) {
+		if (NULL != roots[r]) {
+			branch start = {roots[r], 0.0};
+			queue_push(queue, start);
+		}
 	}
 
-  /* maybe search the away branch */
-	if (NULL != far) {
-		double largest = largest_dist(nearest, best_count);
-		size_t search_other = 0;
-		if (largest < 0) {
-			search_other = 1;
-		} else {
-			double diff = neighbor_coord - search_coord;
-			if ((diff * diff) < largest) {
-				search_other = 1;
+	while (queue->count > 0) {
+		if (max_checks > 0 && checks >= max_checks && best_count >= num_neighbors) {
+			break;
+		}
+		branch curr = queue_pop(queue);
+		double largest = largest_dist(nearest, best_count, num_neighbors);
+		if (largest >= 0 && curr.bound >= largest) {
+			/* every remaining branch is at least this far away */
+			break;
+		}
+
+		/* walk down to a leaf, queueing the far branches as we go */
+		const kdtree_node *node = curr.node;
+		while (NULL != node) {
+			COUNT(nodes_visited);
+			if (NULL == node->left && NULL == node->right) {
+				COUNT(leaves_visited);
+			}
+			if (node->data->num != search_num) {
+				best_count = add_best(nearest, best_count, node, search, num_neighbors);
+				checks++;
+			}
+
+			size_t axis = node->data->curr_axis;
+			double diff = split_coord(node, axis) - search->coords[axis];
+			const kdtree_node *near;
+			const kdtree_node *far;
+			if (diff > 0) {
+				near = node->left;
+				far = node->right;
+			} else {
+				near = node->right;
+				far = node->left;
+			}
+
+			if (NULL != far) {
+				double bound = far_bound(far, search->coords, diff);
+				if (bound < curr.bound) {
+					bound = curr.bound;
+				}
+				largest = largest_dist(nearest, best_count, num_neighbors);
+				if (largest < 0 || bound < largest) {
+					branch other = {far, bound};
+					queue_push(queue, other);
+					COUNT(far_descended);
+					NOTE_DEPTH(queue->count);
+				} else {
+					COUNT(far_pruned);
+				}
 			}
+			node = near;
 		}
-		if (1 == search_other) {
-			best_count = nn_search(far, search, nearest, best_count, num_neighbors, next_depth);
+	}
+	return best_count;
+}
+
+/**
+ * Allocates the scratch space for searches of up to max_neighbors neighbors.
+ * @param [in] max_neighbors The largest number of neighbors a search may ask
+ * for.
+ * @param [in] dims The number of coordinates the context's coords can hold.
+ * @return A newly malloc'd context.  Release it with free_query_context.
+ */
+extern query_context * new_query_context(size_t max_neighbors, size_t dims) {
+	query_context *ctx = malloc(sizeof(query_context));
+	if (NULL == ctx) {
+		fprintf(stderr, "Out of memory at %s: %d\n", __FILE__, __LINE__);
+		exit(OOM);
+	}
+	ctx->max_neighbors = max_neighbors;
+	ctx->dims = dims;
+	/* one extra slot each, so that zero sizes still get a valid pointer */
+	ctx->coords = malloc((dims + 1) * sizeof(double));
+	ctx->best_nums = malloc((max_neighbors + 1) * sizeof(int));
+	ctx->nearest = malloc((max_neighbors + 1) * sizeof(best_pair));
+	ctx->upper = malloc((max_neighbors + 1) * sizeof(best_pair));
+	ctx->box = malloc((2 * dims + 1) * sizeof(double));
+	ctx->queue = malloc(QUEUE_START * sizeof(branch));
+	ctx->queue_capacity = QUEUE_START;
+	ctx->candidates = malloc(QUANT_CANDIDATES * sizeof(best_pair));
+	ctx->candidates_capacity = QUANT_CANDIDATES;
+	memset(&ctx->stats, 0, sizeof(search_stats));
+	if (NULL == ctx->coords || NULL == ctx->best_nums || NULL == ctx->nearest ||
+			NULL == ctx->upper || NULL == ctx->box || NULL == ctx->queue || 
+			NULL == ctx->candidates) {
+		fprintf(stderr, "Out of memory at %s: %d\n", __FILE__, __LINE__);
+		exit(OOM);
+	}
+	return ctx;
+}
+
+/**
+ * Frees a context allocated by new_query_context.
+ * @param [in] ctx The context to free.  May be NULL.
+ */
+extern void free_query_context(query_context *ctx) {
+	if (NULL == ctx) {
+		return;
+	}
+	free(ctx->candidates);
+	free(ctx->queue);
+	free(ctx->box);
+	free(ctx->upper);
+	free(ctx->nearest);
+	free(ctx->best_nums);
+	free(ctx->coords);
+	free(ctx);
+}
+
+/**
+ * Searches one or more trees for the nearest neighbors of search, using the
+ * candidate list and queue of ctx.
+ * @param [in] roots The roots of the trees to search.  Depth-first searches 
+ * only look at the first.
+ * @param [in] num_roots The number of trees.
+ * @param [in] ctx The scratch space.  Must hold num_neighbors candidates.
+ * @param [in] num_neighbors The maximum number of nearest neighbors.
+ * @param [in] search The point for which the nearest neighbor search is being
+ * done.
+ * @param [in] best_nums The nearest neighbors node numbers.  Will be filled in
+ * by this function; slots beyond the number of points found are set to -1.
+ * @param [in] method The traversal to use for the search.
+ * @param [in] max_checks The best-bin-first check budget; 0 means exact.
+ */
+static void search_context(
+		kdtree_node * const roots[],
+		size_t num_roots,
+		query_context *ctx,
+		size_t num_neighbors,
+		const point_data *search,
+		int best_nums[],
+		search_method method,
+		size_t max_checks) {
+#if KDTREE_STATS_ENABLED
+	thread_stats = &ctx->stats;
+	thread_depth = 0;
+	ctx->stats.searches++;
+#endif
+	size_t found;
+	if (SEARCH_BBF == method) {
+		branch_queue queue = {ctx->queue, 0, ctx->queue_capacity};
+		found = bbf_search(roots, num_roots, search, ctx->nearest, num_neighbors, 
+				max_checks, &queue);
+		/* the queue may have grown; keep the larger storage for next time */
+		ctx->queue = queue.items;
+		ctx->queue_capacity = queue.capacity;
+	} else {
+		found = nn_search(roots[0], search, ctx->nearest, num_neighbors, -1.0);
+	}
+#if KDTREE_STATS_ENABLED
+	thread_stats = NULL;
+#endif
+
+	size_t i;
+	for (i = 0; i < num_neighbors; i++) {
+		best_nums[i] = (i < found) ? ctx->nearest[i].node_num : -1;
+	}
+}
+
+/**
+ * Runs a search with a context that lives only for the call.  Small searches
+ * keep their candidates on the stack; larger ones allocate them.
+ * @param [in] roots The roots of the trees to search.
+ * @param [in] num_roots The number of trees.
+ * @param [in] num_neighbors The maximum number of nearest neighbors.
+ * @param [in] search The point for which the nearest neighbor search is being
+ * done.
+ * @param [in] best_nums The nearest neighbors node numbers.  Will be filled in
+ * by this function; slots beyond the number of points found are set to -1.
+ * @param [in] method The traversal to use for the search.
+ * @param [in] max_checks The best-bin-first check budget; 0 means exact.
+ */
+static void search_once(
+		kdtree_node * const roots[],
+		size_t num_roots,
+		size_t num_neighbors,
+		const point_data *search,
+		int best_nums[],
+		search_method method,
+		size_t max_checks) {
+	best_pair small_nearest[SMALL_NEIGHBORS];
+	query_context ctx;
+	memset(&ctx, 0, sizeof(query_context));
+	ctx.max_neighbors = num_neighbors;
+	ctx.best_nums = best_nums;
+	ctx.nearest = small_nearest;
+	if (num_neighbors > SMALL_NEIGHBORS) {
+		ctx.nearest = malloc(num_neighbors * sizeof(best_pair));
+		if (NULL == ctx.nearest) {
+			fprintf(stderr, "Out of memory at %s: %d\n", __FILE__, __LINE__);
+			exit(OOM);
 		}
 	}
-  return best_count;
+	search_context(roots, num_roots, &ctx, num_neighbors, search, best_nums, 
+			method, max_checks);
+	free(ctx.queue);
+	if (small_nearest != ctx.nearest) {
+		free(ctx.nearest);
+	}
 }
 
 /** 
  * Initializes the nearest neighbor search point and starts the search.
  *
  * @param [in] root The node to start the nearest neighbor search at.
+ * @param [in] num_neighbors The maximum number of nearest neighbors.
  * @param [in] search The point for which the nearest neighbor search is being
  * done.
  * @param [in] best_nums The nearest neighbors node numbers.  Will be filled in
- * by this function.
+ * by this function; slots beyond the number of points found are set to -1.
+ * @param [in] method The traversal to use for the search.
  */
 extern void
-run_nn_search(kdtree_node *root, 
+run_nn_search_method(kdtree_node *root, 
 		size_t num_neighbors, 
 		point_data search,
-		int best_nums[]) {
-	best_pair nearest[num_neighbors];
-	nn_search(root, search, nearest, 0, num_neighbors, 0);
+		int best_nums[],
+		search_method method) {
+	search_once(&root, 1, num_neighbors, &search, best_nums, method, 0);
+}
 
-	size_t i;
+/** 
+ * Searches for the nearest neighbors of search without allocating, using the
+ * scratch space of ctx.
+ *
+ * @param [in] root The node to start the nearest neighbor search at.
+ * @param [in] ctx The scratch space.  The results are left in ctx->best_nums;
+ * slots beyond the number of points found are set to -1.
+ * @param [in] num_neighbors The maximum number of nearest neighbors.  Must not
+ * exceed ctx->max_neighbors.
+ * @param [in] search The point for which the nearest neighbor search is being
+ * done.  Its coords may be ctx->coords.
+ * @param [in] method The traversal to use for the search.
+ */
+extern void
+run_nn_search_context(kdtree_node *root, 
+		query_context *ctx,
+		size_t num_neighbors, 
+		const point_data *search,
+		search_method method) {
+	search_context(&root, 1, ctx, num_neighbors, search, ctx->best_nums, method, 0);
+}
+
+/** 
+ * Searches all the trees of a forest for the nearest neighbors of search.  The
+ * trees share one best-bin-first queue and one nearest neighbors list.
+ *
+ * @param [in] forest The forest to search.
+ * @param [in] num_neighbors The maximum number of nearest neighbors.
+ * @param [in] search The point for which the nearest neighbor search is being
+ * done.
+ * @param [in] best_nums The nearest neighbors node numbers.  Will be filled in
+ * by this function; slots beyond the number of points found are set to -1.
+ * @param [in] max_checks The number of points to compare against search 
+ * across all trees before settling for an approximate answer.  0 means exact.
+ */
+extern void
+run_forest_search(kdtree_forest *forest, 
+		size_t num_neighbors, 
+		point_data search,
+		int best_nums[],
+		size_t max_checks) {
+	search_once(forest->trees, forest->num_trees, num_neighbors, &search, 
+			best_nums, SEARCH_BBF, max_checks);
+}
+
+/** 
+ * Searches all the trees of a forest as run_forest_search does, without 
+ * allocating, using the scratch space of ctx.
+ *
+ * @param [in] forest The forest to search.
+ * @param [in] ctx The scratch space.  The results are left in ctx->best_nums.
+ * @param [in] num_neighbors The maximum number of nearest neighbors.  Must not
+ * exceed ctx->max_neighbors.
+ * @param [in] search The point for which the nearest neighbor search is being
+ * done.  Its coords may be ctx->coords.
+ * @param [in] max_checks The number of points to compare against search 
+ * across all trees before settling for an approximate answer.  0 means exact.
+ */
+extern void
+run_forest_search_context(kdtree_forest *forest, 
+		query_context *ctx,
+		size_t num_neighbors, 
+		const point_data *search,
+		size_t max_checks) {
+	search_context(forest->trees, forest->num_trees, ctx, num_neighbors, search, 
+			ctx->best_nums, SEARCH_BBF, max_checks);
+}
+
+/**
+ * Counts the nodes in a tree.
+ * @param [in] node The root of the tree.
+ * @return The number of nodes in the tree.
+ */
+extern size_t tree_size(const kdtree_node *node) {
+	if (NULL == node) {
+		return 0;
+	}
+	return 1 + tree_size(node->left) + tree_size(node->right);
+}
+
+/**
+ * Collects the nodes of a tree in order (left subtree, node, right subtree).
+ * Consecutive nodes in this order tend to be close in space.
+ * @param [in] node The root of the tree.
+ * @param [in] nodes Receives the nodes.
+ * @param [in] count The number of nodes collected so far.
+ * @return The number of nodes collected.
+ */
+static size_t collect_in_order(const kdtree_node *node, const kdtree_node *nodes[], 
+		size_t count) {
+	while (NULL != node) {
+		count = collect_in_order(node->left, nodes, count);
+		nodes[count++] = node;
+		node = node->right;
+	}
+	return count;
+}
+
+/**
+ * Finds the nearest neighbors of every point in the tree (the k-nearest 
+ * neighbor graph), excluding each point from its own neighbors.  Queries are
+ * visited in tree order so that consecutive queries touch the same nodes, and
+ * each query starts with a pruning radius derived from the previous one: if p
+ * has its k-th neighbor at distance r, then q has at least k other points 
+ * within r + |p - q|.  Blocks of queries run in parallel when compiled with 
+ * OpenMP.
+ *
+ * @param [in] root The tree to search.
+ * @param [in] num_neighbors The number of neighbors per point.
+ * @param [in] nums Receives the node number of each row, tree_size(root) entries.
+ * @param [in] best_nums Receives tree_size(root) * num_neighbors node numbers; 
+ * row i holds the neighbors of nums[i], nearest first.  Slots that cannot be
+ * filled are set to -1.
+ * @param [in] best_dists Receives the squared distances matching best_nums, or
+ * -1 for unfilled slots.  May be NULL.
+ * @return The number of rows, i.e. the number of points in the tree.
+ */
+extern size_t knn_graph(kdtree_node *root, 
+		size_t num_neighbors,
+		int nums[],
+		int best_nums[],
+		double best_dists[]) {
+	size_t num_points = tree_size(root);
+	if (0 == num_points) {
+		return 0;
+	}
+
+	const kdtree_node **nodes = malloc(num_points * sizeof(kdtree_node *));
+	if (NULL == nodes) {
+		fprintf(stderr, "Out of memory at %s: %d\n", __FILE__, __LINE__);
+		exit(OOM);
+	}
+	collect_in_order(root, nodes, 0);
+
+	long num_blocks = (long)((num_points + KNN_BLOCK - 1) / KNN_BLOCK);
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
+	{
+		/* one candidate list per thread, reused for all of its blocks */
+		query_context *ctx = new_query_context(num_neighbors, 0);
+		best_pair *nearest = ctx->nearest;
+		long block;
+#ifdef _OPENMP
+#pragma omp for schedule(dynamic)
+#endif
+		for (block = 0; block < num_blocks; block++) {
+			size_t first = block * KNN_BLOCK;
+			size_t last = first + KNN_BLOCK;
+			if (last > num_points) {
+				last = num_points;
+			}
+
+			const point_data *prev = NULL;
+			double prev_largest = -1.0;
+			size_t i, j;
+			for (i = first; i < last; i++) {
+				point_data search = *nodes[i]->data;
+				double radius = -1.0;
+				if (NULL != prev && prev_largest >= 0) {
+					double reach = sqrt(prev_largest) + 
+						sqrt(sqdist(prev->coords, search.coords, search.dims));
+					/* pad the bound so rounding can never make it too tight */
+					radius = reach * reach * (1.0 + 1e-9);
+				}
+
+				size_t found = nn_search(root, &search, nearest, num_neighbors, radius);
+				nums[i] = search.num;
+				for (j = 0; j < num_neighbors; j++) {
+					size_t slot = i * num_neighbors + j;
+					best_nums[slot] = (j < found) ? nearest[j].node_num : -1;
+					if (NULL != best_dists) {
+						best_dists[slot] = (j < found) ? nearest[j].dist : -1.0;
+					}
+				}
+
+				prev = nodes[i]->data;
+				prev_largest = largest_dist(nearest, found, num_neighbors);
+			}
+		}
+
+		free_query_context(ctx);
+	}
+
+	free(nodes);
+	return num_points;
+}
+
+/**
+ * A tree flattened into preorder arrays, with the bounding box of every 
+ * subtree.  Used by the dual-tree joins to bound whole node pairs at once.
+ * @param num_nodes The number of nodes.
+ * @param dims The number of dimensions.
+ * @param nodes The nodes in preorder.  A subtree occupies a contiguous range.
+ * @param sizes The number of nodes in each subtree.
+ * @param left The index of each node's left child, or NO_CHILD.
+ * @param right The index of each node's right child, or NO_CHILD.
+ * @param lo The lower corner of each subtree's bounding box, dims per node.
+ * @param hi The upper corner of each subtree's bounding box, dims per node.
+ */
+typedef struct flat_tree {
+	size_t num_nodes;
+	size_t dims;
+	const kdtree_node **nodes;
+	size_t *sizes;
+	size_t *left;
+	size_t *right;
+	double *lo;
+	double *hi;
+} flat_tree;
+
+/**
+ * Recursively fills in a flat_tree.
+ * @param [in] node The root of the subtree to flatten.
+ * @param [in] flat The flat tree being filled in.
+ * @param [in] count The number of nodes flattened so far.  Updated by this 
+ * function.
+ * @return The index of node.
+ */
+static size_t flatten_r(const kdtree_node *node, flat_tree *flat, size_t *count) {
+	size_t idx = (*count)++;
+	size_t dims = flat->dims;
+	flat->nodes[idx] = node;
+	flat->left[idx] = (NULL == node->left) ? NO_CHILD : flatten_r(node->left, flat, count);
+	flat->right[idx] = (NULL == node->right) ? NO_CHILD : flatten_r(node->right, flat, count);
+	flat->sizes[idx] = *count - idx;
+
+	double *lo = &flat->lo[idx * dims];
+	double *hi = &flat->hi[idx * dims];
+	memcpy(lo, node->data->coords, dims * sizeof(double));
+	memcpy(hi, node->data->coords, dims * sizeof(double));
+
+	size_t children[2] = {flat->left[idx], flat->right[idx]};
+	size_t c, d;
+	for (c = 0; c < 2; c++) {
+		if (NO_CHILD == children[c]) {
+			continue;
+		}
+		const double *child_lo = &flat->lo[children[c] * dims];
+		const double *child_hi = &flat->hi[children[c] * dims];
+		for (d = 0; d < dims; d++) {
+			if (child_lo[d] < lo[d]) {
+				lo[d] = child_lo[d];
+			}
+			if (child_hi[d] > hi[d]) {
+				hi[d] = child_hi[d];
+			}
+		}
+	}
+	return idx;
+}
+
+/**
+ * Flattens a tree into preorder arrays with subtree bounding boxes.
+ * @param [in] root The tree to flatten.  Must not be NULL.
+ * @param [in] flat Filled in by this function.  Release with free_flat.
+ */
+static void flatten(const kdtree_node *root, flat_tree *flat) {
+	size_t num_nodes = tree_size(root);
+	size_t dims = root->data->dims;
+	flat->num_nodes = num_nodes;
+	flat->dims = dims;
+	flat->nodes = malloc(num_nodes * sizeof(kdtree_node *));
+	flat->sizes = malloc(num_nodes * sizeof(size_t));
+	flat->left = malloc(num_nodes * sizeof(size_t));
+	flat->right = malloc(num_nodes * sizeof(size_t));
+	flat->lo = malloc(num_nodes * dims * sizeof(double));
+	flat->hi = malloc(num_nodes * dims * sizeof(double));
+	if (NULL == flat->nodes || NULL == flat->sizes || NULL == flat->left || NULL == flat->right ||
+			NULL == flat->lo || NULL == flat->hi) {
+		fprintf(stderr, "Out of memory at %s: %d\n", __FILE__, __LINE__);
+		exit(OOM);
+	}
+	size_t count = 0;
+	flatten_r(root, flat, &count);
+}
+
+/**
+ * Frees the arrays of a flat_tree.
+ * @param [in] flat The flat tree to free.
+ */
+static void free_flat(flat_tree *flat) {
+	free(flat->nodes);
+	free(flat->sizes);
+	free(flat->left);
+	free(flat->right);
+	free(flat->lo);
+	free(flat->hi);
+	flat->nodes = NULL;
+	flat->sizes = NULL;
+	flat->left = NULL;
+	flat->right = NULL;
+	flat->lo = NULL;
+	flat->hi = NULL;
+}
+
+/**
+ * Computes the smallest squared distance between a point and a subtree's box.
+ * @param [in] coords The point.
+ * @param [in] flat The flattened tree.
+ * @param [in] idx The index of the subtree's root.
+ * @return A lower bound on the squared distance to any point in the subtree.
+ */
+static double point_box_dist(const double coords[], const flat_tree *flat, size_t idx) {
+	size_t dims = flat->dims;
+	const double *lo = &flat->lo[idx * dims];
+	const double *hi = &flat->hi[idx * dims];
+	double dist = 0.0;
+	size_t d;
+	for (d = 0; d < dims; d++) {
+		double gap = 0.0;
+		if (coords[d] < lo[d]) {
+			gap = lo[d] - coords[d];
+		} else if (coords[d] > hi[d]) {
+			gap = coords[d] - hi[d];
+		}
+		dist += gap * gap;
+	}
+	return dist;
+}
+
+/**
+ * Computes the smallest squared distance between the boxes of two subtrees.
+ * @param [in] a The first flattened tree.
+ * @param [in] ai The index of the subtree in a.
+ * @param [in] b The second flattened tree.
+ * @param [in] bi The index of the subtree in b.
+ * @return A lower bound on the squared distance between any point in the first
+ * subtree and any point in the second.
+ */
+static double box_box_dist(const flat_tree *a, size_t ai, const flat_tree *b, size_t bi) {
+	size_t dims = a->dims;
+	const double *a_lo = &a->lo[ai * dims];
+	const double *a_hi = &a->hi[ai * dims];
+	const double *b_lo = &b->lo[bi * dims];
+	const double *b_hi = &b->hi[bi * dims];
+	double dist = 0.0;
+	size_t d;
+	for (d = 0; d < dims; d++) {
+		double gap = 0.0;
+		if (a_hi[d] < b_lo[d]) {
+			gap = b_lo[d] - a_hi[d];
+		} else if (b_hi[d] < a_lo[d]) {
+			gap = a_lo[d] - b_hi[d];
+		}
+		dist += gap * gap;
+	}
+	return dist;
+}
+
+/**
+ * Tells which of two reference subtrees to join a query subtree with first.
+ * Boxes that overlap the query box are all at distance 0, which is common 
+ * near the top of two trees over the same space, so ties go to the box whose
+ * center is nearer.
+ * @param [in] query The flattened query tree.
+ * @param [in] qi The index of the query subtree.
+ * @param [in] ref The flattened reference tree.
+ * @param [in] a The index of one reference subtree.
+ * @param [in] b The index of the other.
+ * @return Nonzero if a should go before b.
+ */
+static int closer_box(const flat_tree *query, size_t qi, const flat_tree *ref,
+		size_t a, size_t b) {
+	double dist_a = box_box_dist(query, qi, ref, a);
+	double dist_b = box_box_dist(query, qi, ref, b);
+	if (dist_a != dist_b) {
+		return dist_a < dist_b;
+	}
+	size_t dims = query->dims;
+	const double *q_lo = &query->lo[qi * dims];
+	const double *q_hi = &query->hi[qi * dims];
+	double center_a = 0.0;
+	double center_b = 0.0;
+	size_t d;
+	for (d = 0; d < dims; d++) {
+		double q = q_lo[d] + q_hi[d];
+		double gap_a = ref->lo[a * dims + d] + ref->hi[a * dims + d] - q;
+		double gap_b = ref->lo[b * dims + d] + ref->hi[b * dims + d] - q;
+		center_a += gap_a * gap_a;
+		center_b += gap_b * gap_b;
+	}
+	return center_a < center_b;
+}
+
+/**
+ * The state of a dual-tree k-nearest neighbor join.
+ * @param query The flattened query tree.
+ * @param ref The flattened reference tree.  The same as query when a tree is
+ * joined with itself.
+ * @param num_neighbors The number of neighbors per query point.
+ * @param nearest The nearest neighbors of each query node, num_neighbors each.
+ * @param counts The number of nearest neighbors found for each query node.
+ * @param kth The squared distance to the num_neighbors-th neighbor of each 
+ * query node, or infinity while it has fewer.
+ * @param min_kth For each query node, the smallest kth in its subtree.
+ * @param spans The length of the diagonal of each query subtree's box.
+ * @param bounds For each query node, an upper bound on the squared distance 
+ * to the num_neighbors-th neighbor of every point in its subtree.
+ */
+typedef struct knn_join_state {
+	const flat_tree *query;
+	const flat_tree *ref;
+	size_t num_neighbors;
+	best_pair *nearest;
+	size_t *counts;
+	double *kth;
+	double *min_kth;
+	double *spans;
+	double *bounds;
+} knn_join_state;
+
+/**
+ * Recomputes the bound of a query node from its own point and its children.
+ * The bound is the smaller of two: the largest kth in the subtree, and the 
+ * smallest kth widened by the subtree's span, since the neighbors of any one
+ * point of the subtree are within that reach of all the others.
+ * @param [in] state The join state.
+ * @param [in] qi The index of the query node.
+ */
+static void join_update_bound(knn_join_state *state, size_t qi) {
+	double bound = state->kth[qi];
+	double min_kth = bound;
+	size_t children[2] = {state->query->left[qi], state->query->right[qi]};
+	size_t c;
+	for (c = 0; c < 2; c++) {
+		size_t qc = children[c];
+		if (NO_CHILD == qc) {
+			continue;
+		}
+		if (state->bounds[qc] > bound) {
+			bound = state->bounds[qc];
+		}
+		if (state->min_kth[qc] < min_kth) {
+			min_kth = state->min_kth[qc];
+		}
+	}
+	state->min_kth[qi] = min_kth;
+	double reach = sqrt(min_kth) + state->spans[qi];
+	state->bounds[qi] = (reach * reach < bound) ? reach * reach : bound;
+}
+
+/**
+ * Offers a reference point to the neighbor list of a query point.  A point is
+ * not its own neighbor when a tree is joined with itself.
+ * @param [in] state The join state.
+ * @param [in] qi The index of the query node.
+ * @param [in] ri The index of the reference node.
+ */
+static void join_add(knn_join_state *state, size_t qi, size_t ri) {
+	if (qi == ri && state->query == state->ref) {
+		return;
+	}
+	const point_data *q = state->query->nodes[qi]->data;
+	const point_data *r = state->ref->nodes[ri]->data;
+	double sd = sqdist(q->coords, r->coords, q->dims);
+	COUNT(dist_evals);
+	if (sd < state->kth[qi]) {
+		size_t k = state->num_neighbors;
+		best_pair *nearest = &state->nearest[qi * k];
+		state->counts[qi] = insert_sorted(nearest, state->counts[qi], r->num, sd, k);
+		if (state->counts[qi] >= k) {
+			state->kth[qi] = nearest[k - 1].dist;
+		}
+	}
+}
+
+/**
+ * Searches a reference subtree for the neighbors of a single query point.
+ * @param [in] state The join state.
+ * @param [in] qi The index of the query node.
+ * @param [in] ri The index of the reference subtree.
+ */
+static void knn_join_point(knn_join_state *state, size_t qi, size_t ri) {
+	const double *coords = state->query->nodes[qi]->data->coords;
+	if (point_box_dist(coords, state->ref, ri) >= state->kth[qi]) {
+		return;
+	}
+	join_add(state, qi, ri);
+
+	size_t rl = state->ref->left[ri];
+	size_t rr = state->ref->right[ri];
+	if (NO_CHILD != rl && NO_CHILD != rr &&
+			point_box_dist(coords, state->ref, rr) < point_box_dist(coords, state->ref, rl)) {
+		size_t tmp = rl;
+		rl = rr;
+		rr = tmp;
+	}
+	if (NO_CHILD != rl) {
+		knn_join_point(state, qi, rl);
+	}
+	if (NO_CHILD != rr) {
+		knn_join_point(state, qi, rr);
+	}
+}
+
+/**
+ * Offers a single reference point to every query point in a subtree.
+ * @param [in] state The join state.
+ * @param [in] ri The index of the reference node.
+ * @param [in] qi The index of the query subtree.
+ */
+static void knn_join_ref(knn_join_state *state, size_t ri, size_t qi) {
+	const double *coords = state->ref->nodes[ri]->data->coords;
+	if (point_box_dist(coords, state->query, qi) >= state->bounds[qi]) {
+		return;
+	}
+	join_add(state, qi, ri);
+	if (NO_CHILD != state->query->left[qi]) {
+		knn_join_ref(state, ri, state->query->left[qi]);
+	}
+	if (NO_CHILD != state->query->right[qi]) {
+		knn_join_ref(state, ri, state->query->right[qi]);
+	}
+	join_update_bound(state, qi);
+}
+
+/**
+ * Joins two small subtrees by comparing every query point against every 
+ * reference point.  Preorder keeps each subtree contiguous, so this is a pair
+ * of plain loops; the bounds are then rebuilt bottom up, which in preorder is
+ * back to front.
+ * @param [in] state The join state.
+ * @param [in] qi The index of the query subtree.
+ * @param [in] ri The index of the reference subtree.
+ */
+static void knn_join_leaves(knn_join_state *state, size_t qi, size_t ri) {
+	size_t q_end = qi + state->query->sizes[qi];
+	size_t r_end = ri + state->ref->sizes[ri];
+	size_t q, r;
+	for (q = qi; q < q_end; q++) {
+		const double *coords = state->query->nodes[q]->data->coords;
+		if (point_box_dist(coords, state->ref, ri) >= state->kth[q]) {
+			continue;
+		}
+		for (r = ri; r < r_end; r++) {
+			join_add(state, q, r);
+		}
+	}
+	for (q = q_end; q > qi; q--) {
+		join_update_bound(state, q - 1);
+	}
+}
+
+/**
+ * Joins every query point under qi with every reference point under ri.
+ * Because every node holds a point, the pairs split into the query point
+ * against the reference subtree, the reference point against the query 
+ * children, and the four child pairs.  A node pair is pruned when the 
+ * distance between their boxes exceeds the query node's bound.
+ * @param [in] state The join state.
+ * @param [in] qi The index of the query subtree.
+ * @param [in] ri The index of the reference subtree.
+ */
+static void knn_join_r(knn_join_state *state, size_t qi, size_t ri) {
+	if (box_box_dist(state->query, qi, state->ref, ri) >= state->bounds[qi]) {
+		return;
+	}
+	if (state->query->sizes[qi] <= JOIN_LEAF_SIZE && state->ref->sizes[ri] <= JOIN_LEAF_SIZE) {
+		knn_join_leaves(state, qi, ri);
+		return;
+	}
+
+
+	size_t q_children[2] = {state->query->left[qi], state->query->right[qi]};
+	size_t r_children[2] = {state->ref->left[ri], state->ref->right[ri]};
+	size_t c;
+
+	/* child pairs first: bounds tighten from the bottom up, so the single
+	 * points are offered once the bounds can prune them */
+	for (c = 0; c < 2; c++) {
+		size_t qc = q_children[c];
+		if (NO_CHILD == qc) {
+			continue;
+		}
+		size_t near = r_children[0];
+		size_t far = r_children[1];
+		if (NO_CHILD != near && NO_CHILD != far && 
+				closer_box(state->query, qc, state->ref, far, near)) {
+			near = r_children[1];
+			far = r_children[0];
+		}
+		if (NO_CHILD != near) {
+			knn_join_r(state, qc, near);
+		}
+		if (NO_CHILD != far) {
+			knn_join_r(state, qc, far);
+		}
+	}
+
+	knn_join_point(state, qi, ri);
+	for (c = 0; c < 2; c++) {
+		if (NO_CHILD != q_children[c]) {
+			knn_join_ref(state, ri, q_children[c]);
+		}
+	}
+	join_update_bound(state, qi);
+}
+
+/**
+ * Finds the nearest neighbors in a reference tree of every point in a query
+ * tree with a dual-tree traversal.  Rather than running one search per query,
+ * pairs of query and reference nodes are pruned together using the distance 
+ * between their bounding boxes, so the upper levels of the reference tree are 
+ * visited once per query subtree rather than once per query point.  Joining
+ * a tree with itself excludes each point from its own neighbors; points of 
+ * two different trees are always paired, whatever their node numbers.
+ *
+ * @param [in] query_root The tree holding the query points.
+ * @param [in] ref_root The tree holding the reference points.
+ * @param [in] num_neighbors The number of neighbors per query point.
+ * @param [in] nums Receives the node number of each row, tree_size(query_root)
+ * entries.
+ * @param [in] best_nums Receives tree_size(query_root) * num_neighbors node 
+ * numbers from the reference tree; row i holds the neighbors of nums[i], 
+ * nearest first.  Slots that cannot be filled are set to -1.
+ * @param [in] best_dists Receives the squared distances matching best_nums, or
+ * -1 for unfilled slots.  May be NULL.
+ * @return The number of rows, i.e. the number of points in the query tree.
+ * If the trees' points differ in dimension, every slot is left unfilled.
+ */
+extern size_t knn_join(kdtree_node *query_root,
+		kdtree_node *ref_root,
+		size_t num_neighbors,
+		int nums[],
+		int best_nums[],
+		double best_dists[]) {
+	if (NULL == query_root) {
+		return 0;
+	}
+	flat_tree query;
+	flat_tree ref;
+	flatten(query_root, &query);
+	size_t num_rows = query.num_nodes;
+	size_t dims = query.dims;
+
+	knn_join_state state;
+	state.query = &query;
+	state.ref = (ref_root == query_root) ? &query : &ref;
+	state.num_neighbors = num_neighbors;
+	state.nearest = malloc(num_rows * num_neighbors * sizeof(best_pair));
+	state.counts = calloc(num_rows, sizeof(size_t));
+	state.kth = malloc(num_rows * sizeof(double));
+	state.min_kth = malloc(num_rows * sizeof(double));
+	state.spans = malloc(num_rows * sizeof(double));
+	state.bounds = malloc(num_rows * sizeof(double));
+	if ((NULL == state.nearest && num_neighbors > 0) || NULL == state.counts || 
+			NULL == state.kth || NULL == state.min_kth || NULL == state.spans || 
+			NULL == state.bounds) {
+		fprintf(stderr, "Out of memory at %s: %d\n", __FILE__, __LINE__);
+		exit(OOM);
+	}
+	size_t i, j;
+	for (i = 0; i < num_rows; i++) {
+		double span = 0.0;
+		for (j = 0; j < dims; j++) {
+			double side = query.hi[i * dims + j] - query.lo[i * dims + j];
+			span += side * side;
+		}
+		state.spans[i] = sqrt(span);
+		state.kth[i] = INFINITY;
+		state.min_kth[i] = INFINITY;
+		state.bounds[i] = INFINITY;
+	}
+
+	/* points of other dimensions have no distance to these, so pair none */
+	if (NULL != ref_root && num_neighbors > 0 && 
+			ref_root->data->dims == query_root->data->dims) {
+		if (state.ref == &ref) {
+			flatten(ref_root, &ref);
+		}
+		knn_join_r(&state, 0, 0);
+		if (state.ref == &ref) {
+			free_flat(&ref);
+		}
+	}
+
+	for (i = 0; i < num_rows; i++) {
+		nums[i] = query.nodes[i]->data->num;
+		for (j = 0; j < num_neighbors; j++) {
+			size_t slot = i * num_neighbors + j;
+			best_nums[slot] = (j < state.counts[i]) ? state.nearest[slot].node_num : -1;
+			if (NULL != best_dists) {
+				best_dists[slot] = (j < state.counts[i]) ? state.nearest[slot].dist : -1.0;
+			}
+		}
+	}
+
+	free(state.bounds);
+	free(state.spans);
+	free(state.min_kth);
+	free(state.kth);
+	free(state.counts);
+	free(state.nearest);
+	free_flat(&query);
+	return num_rows;
+}
+
+/**
+ * Appends a pair to a pair_list, growing it as needed.
+ * @param [in] pairs The list to append to.
+ * @param [in] query_num The node number of the query point.
+ * @param [in] ref_num The node number of the reference point.
+ * @param [in] dist The squared distance between them.
+ */
+static void append_pair(pair_list *pairs, int query_num, int ref_num, double dist) {
+	if (pairs->count == pairs->capacity) {
+		size_t capacity = (0 == pairs->capacity) ? 256 : pairs->capacity * 2;
+		int *query_nums = realloc(pairs->query_nums, capacity * sizeof(int));
+		if (NULL != query_nums) {
+			pairs->query_nums = query_nums;
+		}
+		int *ref_nums = realloc(pairs->ref_nums, capacity * sizeof(int));
+		if (NULL != ref_nums) {
+			pairs->ref_nums = ref_nums;
+		}
+		double *dists = realloc(pairs->dists, capacity * sizeof(double));
+		if (NULL != dists) {
+			pairs->dists = dists;
+		}
+		if (NULL == query_nums || NULL == ref_nums || NULL == dists) {
+			fprintf(stderr, "Out of memory at %s: %d\n", __FILE__, __LINE__);
+			exit(OOM);
+		}
+		pairs->capacity = capacity;
+	}
+	pairs->query_nums[pairs->count] = query_num;
+	pairs->ref_nums[pairs->count] = ref_num;
+	pairs->dists[pairs->count] = dist;
+	pairs->count++;
+}
+
+/**
+ * The state of a dual-tree radius join.
+ * @param query The flattened query tree.
+ * @param ref The flattened reference tree.  The same as query when a tree is
+ * joined with itself.
+ * @param sq_radius The squared search radius.
+ * @param pairs The pairs found so far.
+ */
+typedef struct radius_join_state {
+	const flat_tree *query;
+	const flat_tree *ref;
+	double sq_radius;
+	pair_list *pairs;
+} radius_join_state;
+
+/**
+ * Records the pair of a query and a reference point if they are close enough.
+ * A point is not paired with itself when a tree is joined with itself.
+ * @param [in] state The join state.
+ * @param [in] qi The index of the query node.
+ * @param [in] ri The index of the reference node.
+ */
+static void radius_join_add(radius_join_state *state, size_t qi, size_t ri) {
+	if (qi == ri && state->query == state->ref) {
+		return;
+	}
+	const point_data *q = state->query->nodes[qi]->data;
+	const point_data *r = state->ref->nodes[ri]->data;
+	double sd = sqdist(q->coords, r->coords, q->dims);
+	if (sd <= state->sq_radius) {
+		append_pair(state->pairs, q->num, r->num, sd);
+	}
+}
+
+/**
+ * Finds the reference points under ri within the radius of query point qi.
+ * @param [in] state The join state.
+ * @param [in] qi The index of the query node.
+ * @param [in] ri The index of the reference subtree.
+ */
+static void radius_join_point(radius_join_state *state, size_t qi, size_t ri) {
+	const double *coords = state->query->nodes[qi]->data->coords;
+	if (point_box_dist(coords, state->ref, ri) > state->sq_radius) {
+		return;
+	}
+	radius_join_add(state, qi, ri);
+	if (NO_CHILD != state->ref->left[ri]) {
+		radius_join_point(state, qi, state->ref->left[ri]);
+	}
+	if (NO_CHILD != state->ref->right[ri]) {
+		radius_join_point(state, qi, state->ref->right[ri]);
+	}
+}
+
+/**
+ * Finds the query points under qi within the radius of reference point ri.
+ * @param [in] state The join state.
+ * @param [in] ri The index of the reference node.
+ * @param [in] qi The index of the query subtree.
+ */
+static void radius_join_ref(radius_join_state *state, size_t ri, size_t qi) {
+	const double *coords = state->ref->nodes[ri]->data->coords;
+	if (point_box_dist(coords, state->query, qi) > state->sq_radius) {
+		return;
+	}
+	radius_join_add(state, qi, ri);
+	if (NO_CHILD != state->query->left[qi]) {
+		radius_join_ref(state, ri, state->query->left[qi]);
+	}
+	if (NO_CHILD != state->query->right[qi]) {
+		radius_join_ref(state, ri, state->query->right[qi]);
+	}
+}
+
+/**
+ * Joins two small subtrees within the radius by brute force.
+ * @param [in] state The join state.
+ * @param [in] qi The index of the query subtree.
+ * @param [in] ri The index of the reference subtree.
+ */
+static void radius_join_leaves(radius_join_state *state, size_t qi, size_t ri) {
+	size_t q_end = qi + state->query->sizes[qi];
+	size_t r_end = ri + state->ref->sizes[ri];
+	size_t q, r;
+	for (q = qi; q < q_end; q++) {
+		const double *coords = state->query->nodes[q]->data->coords;
+		if (point_box_dist(coords, state->ref, ri) > state->sq_radius) {
+			continue;
+		}
+		for (r = ri; r < r_end; r++) {
+			radius_join_add(state, q, r);
+		}
+	}
+}
+
+/**
+ * Joins every query point under qi with every reference point under ri that
+ * lies within the radius.  See knn_join_r for how the pairs are split up.
+ * @param [in] state The join state.
+ * @param [in] qi The index of the query subtree.
+ * @param [in] ri The index of the reference subtree.
+ */
+static void radius_join_r(radius_join_state *state, size_t qi, size_t ri) {
+	if (box_box_dist(state->query, qi, state->ref, ri) > state->sq_radius) {
+		return;
+	}
+	if (state->query->sizes[qi] <= JOIN_LEAF_SIZE && state->ref->sizes[ri] <= JOIN_LEAF_SIZE) {
+		radius_join_leaves(state, qi, ri);
+		return;
+	}
+
+	radius_join_point(state, qi, ri);
+
+	size_t q_children[2] = {state->query->left[qi], state->query->right[qi]};
+	size_t r_children[2] = {state->ref->left[ri], state->ref->right[ri]};
+	size_t c, e;
+	for (c = 0; c < 2; c++) {
+		if (NO_CHILD == q_children[c]) {
+			continue;
+		}
+		radius_join_ref(state, ri, q_children[c]);
+		for (e = 0; e < 2; e++) {
+			if (NO_CHILD != r_children[e]) {
+				radius_join_r(state, q_children[c], r_children[e]);
+			}
+		}
+	}
+}
+
+/**
+ * Finds every pair of a query point and a reference point within a radius of
+ * each other with a dual-tree traversal, pruning node pairs whose bounding 
+ * boxes are further apart than the radius.  Joining a tree with itself does
+ * not pair a point with itself; points of two different trees are always 
+ * paired, whatever their node numbers.
+ *
+ * @param [in] query_root The tree holding the query points.
+ * @param [in] ref_root The tree holding the reference points.
+ * @param [in] sq_radius The squared search radius.  Pairs at exactly this
+ * distance are included.
+ * @return A newly malloc'd list of pairs, in no particular order.  Release it
+ * with free_pair_list.  The list is empty if the trees' points differ in 
+ * dimension.
+ */
+extern pair_list * radius_join(kdtree_node *query_root,
+		kdtree_node *ref_root,
+		double sq_radius) {
+	pair_list *pairs = calloc(1, sizeof(pair_list));
+	if (NULL == pairs) {
+		fprintf(stderr, "Out of memory at %s: %d\n", __FILE__, __LINE__);
+		exit(OOM);
+	}
+	if (NULL == query_root || NULL == ref_root || 
+			ref_root->data->dims != query_root->data->dims) {
+		return pairs;
+	}
+
+	flat_tree query;
+	flat_tree ref;
+	flatten(query_root, &query);
+	if (ref_root != query_root) {
+		flatten(ref_root, &ref);
+	}
+
+	radius_join_state state;
+	state.query = &query;
+	state.ref = (ref_root == query_root) ? &query : &ref;
+	state.sq_radius = sq_radius;
+	state.pairs = pairs;
+	radius_join_r(&state, 0, 0);
+
+	if (ref_root != query_root) {
+		free_flat(&ref);
+	}
+	free_flat(&query);
+	return pairs;
+}
+
+/**
+ * Frees a pair_list returned by radius_join.
+ * @param [in] pairs The list to free.
+ */
+extern void free_pair_list(pair_list *pairs) {
+	if (NULL == pairs) {
+		return;
+	}
+	free(pairs->query_nums);
+	free(pairs->ref_nums);
+	free(pairs->dists);
+	free(pairs);
+}
+
+/**
+ * An integer sort key, such as a Morton code, paired with the index of the 
+ * point it was computed from.
+ */
+typedef struct sort_key {
+	unsigned long long code;
+	size_t idx;
+} sort_key;
+
+/**
+ * The number of bits each dimension contributes to a Morton code.
+ * @param [in] dims The number of dimensions.
+ * @return The number of bits per dimension; at most 32.
+ */
+static size_t morton_bits(size_t dims) {
+	size_t used_dims = (dims < MORTON_BITS) ? dims : MORTON_BITS;
+	size_t bits = MORTON_BITS / used_dims;
+	return (bits > 32) ? 32 : bits;
+}
+
+/**
+ * Computes the Morton (Z-order) code of a point: each coordinate is quantized
+ * within the bounding box and the bits of the coordinates are interleaved, so
+ * that points close together on the curve are close together in space.  With
+ * more than MORTON_BITS dimensions only the first MORTON_BITS take part.
+ * @param [in] coords The point.
+ * @param [in] lo The lower corner of the bounding box.
+ * @param [in] scale For each dimension, the factor mapping the box extent onto
+ * the quantized range.
+ * @param [in] dims The number of dimensions.
+ * @return The Morton code.
+ */
+static unsigned long long morton_code(const double coords[], const double lo[], 
+		const double scale[], size_t dims) {
+	size_t used_dims = (dims < MORTON_BITS) ? dims : MORTON_BITS;
+	size_t bits = morton_bits(dims);
+	unsigned long long cells[MORTON_BITS];
+	size_t d, b;
+	for (d = 0; d < used_dims; d++) {
+		double cell = (coords[d] - lo[d]) * scale[d];
+		double max_cell = (double)((1ULL << bits) - 1);
+		cells[d] = (cell <= 0) ? 0 : (cell >= max_cell) ? (unsigned long long)max_cell : 
+			(unsigned long long)cell;
+	}
+
+	unsigned long long code = 0;
+	for (b = bits; b > 0; b--) {
+		for (d = 0; d < used_dims; d++) {
+			code = (code << 1) | ((cells[d] >> (b - 1)) & 1ULL);
+		}
+	}
+	return code;
+}
+
+/**
+ * Sorts keys by code with a least significant digit radix sort, which
+ * is stable, so keys with equal codes keep their order.  Each pass splits the
+ * keys into chunks that are counted and scattered in parallel when compiled 
+ * with OpenMP and there are enough keys to be worth it.
+ * @param [in] keys The keys to sort.
+ * @param [in] num_keys The number of keys.
+ * @param [in] code_bits The number of low bits of the codes that may be set.
+ */
+static void radix_sort_keys(sort_key *keys, size_t num_keys, size_t code_bits) {
+	const size_t buckets = (size_t)1 << RADIX_BITS;
+	size_t num_chunks = (num_keys >= PAR_TASK_POINTS) ? PAR_CHUNKS : 1;
+	size_t chunk_size = (num_keys + num_chunks - 1) / num_chunks;
+	sort_key *scratch = malloc(num_keys * sizeof(sort_key));
+	size_t *counts = malloc(num_chunks * buckets * sizeof(size_t));
+	if (NULL == scratch || NULL == counts) {
+		fprintf(stderr, "Out of memory at %s: %d\n", __FILE__, __LINE__);
+		exit(OOM);
+	}
+
+	sort_key *from = keys;
+	sort_key *to = scratch;
+	size_t shift;
+	for (shift = 0; shift < code_bits; shift += RADIX_BITS) {
+		long c;
+		memset(counts, 0, num_chunks * buckets * sizeof(size_t));
+#ifdef _OPENMP
+#pragma omp parallel for if (num_chunks > 1)
+#endif
+		for (c = 0; c < (long)num_chunks; c++) {
+			size_t *count = &counts[c * buckets];
+			size_t first = c * chunk_size;
+			size_t last = (first + chunk_size < num_keys) ? first + chunk_size : num_keys;
+			size_t i;
+			for (i = first; i < last; i++) {
+				count[(from[i].code >> shift) & (buckets - 1)]++;
+			}
+		}
+
+		/* turn the counts into where each chunk's run of each digit starts, in
+		 * digit order and then chunk order so that the sort stays stable */
+		size_t total = 0;
+		int all_same = 0;
+		size_t digit;
+		for (digit = 0; digit < buckets; digit++) {
+			size_t digit_start = total;
+			for (c = 0; c < (long)num_chunks; c++) {
+				size_t count = counts[c * buckets + digit];
+				counts[c * buckets + digit] = total;
+				total += count;
+			}
+			if (total - digit_start == num_keys) {
+				all_same = 1;
+			}
+		}
+		if (all_same) {
+			/* every key has the same digit, so this pass would not move any */
+			continue;
+		}
+
+#ifdef _OPENMP
+#pragma omp parallel for if (num_chunks > 1)
+#endif
+		for (c = 0; c < (long)num_chunks; c++) {
+			size_t *start = &counts[c * buckets];
+			size_t first = c * chunk_size;
+			size_t last = (first + chunk_size < num_keys) ? first + chunk_size : num_keys;
+			size_t i;
+			for (i = first; i < last; i++) {
+				to[start[(from[i].code >> shift) & (buckets - 1)]++] = from[i];
+			}
+		}
+		sort_key *tmp = from;
+		from = to;
+		to = tmp;
+	}
+
+	if (from != keys) {
+		memcpy(keys, from, num_keys * sizeof(sort_key));
+	}
+	free(counts);
+	free(scratch);
+}
+
+/**
+ * Computes Morton keys for a set of points and sorts them along the curve.
+ * @param [in] points The points.
+ * @param [in] num_points The number of points.
+ * @return A newly malloc'd array of num_points keys, sorted by code, with keys
+ * of equal codes in the order of their points.
+ */
+static sort_key *morton_order(point_data **points, size_t num_points) {
+	sort_key *keys = malloc(num_points * sizeof(sort_key));
+	if (NULL == keys) {
+		fprintf(stderr, "Out of memory at %s: %d\n", __FILE__, __LINE__);
+		exit(OOM);
+	}
+	size_t dims = points[0]->dims;
+	double lo[dims];
+	double scale[dims];
+	double cells = (double)(1ULL << morton_bits(dims));
+
+	size_t i, d;
+	for (d = 0; d < dims; d++) {
+		double lo_d = points[0]->coords[d];
+		double hi_d = lo_d;
+		for (i = 1; i < num_points; i++) {
+			double coord = points[i]->coords[d];
+			if (coord < lo_d) {
+				lo_d = coord;
+			} else if (coord > hi_d) {
+				hi_d = coord;
+			}
+		}
+		lo[d] = lo_d;
+		scale[d] = (hi_d > lo_d) ? cells / (hi_d - lo_d) : 0.0;
+	}
+
+	long p;
+#ifdef _OPENMP
+#pragma omp parallel for if (num_points >= PAR_TASK_POINTS)
+#endif
+	for (p = 0; p < (long)num_points; p++) {
+		keys[p].code = morton_code(points[p]->coords, lo, scale, dims);
+		keys[p].idx = p;
+	}
+	size_t used_dims = (dims < MORTON_BITS) ? dims : MORTON_BITS;
+	radix_sort_keys(keys, num_points, morton_bits(dims) * used_dims);
+	return keys;
+}
+
+/**
+ * Finds the most significant set bit of a nonzero code.
+ * @param [in] code The code.  Must not be zero.
+ * @return The bit's position, counting from 0 for the least significant bit.
+ */
+static size_t highest_bit(unsigned long long code) {
+#ifdef __GNUC__
+	return 63 - __builtin_clzll(code);
+#else
+	size_t pos = 0;
+	while (code >>= 1) {
+		pos++;
+	}
+	return pos;
+#endif
+}
+
+/**
+ * Fills in the box of a node from its point and its children's boxes.
+ * @param [in] node The node.  Its box must point at its storage, and its 
+ * children's boxes must be filled in.
+ * @param [in] split The coordinate the subtree is split at.
+ */
+static void set_box(kdtree_node *node, double split) {
+	size_t dims = node->data->dims;
+	double *lo = node->box;
+	double *hi = &node->box[dims];
+	const kdtree_node *children[2] = {node->left, node->right};
+	size_t c, d;
+	memcpy(lo, node->data->coords, dims * sizeof(double));
+	memcpy(hi, node->data->coords, dims * sizeof(double));
+	for (c = 0; c < 2; c++) {
+		if (NULL == children[c]) {
+			continue;
+		}
+		const double *child_lo = children[c]->box;
+		const double *child_hi = &children[c]->box[dims];
+		for (d = 0; d < dims; d++) {
+			if (child_lo[d] < lo[d]) {
+				lo[d] = child_lo[d];
+			}
+			if (child_hi[d] > hi[d]) {
+				hi[d] = child_hi[d];
+			}
+		}
+	}
+	node->box[2 * dims] = split;
+}
+
+/**
+ * Gives the nodes of a subtree split at medians their boxes, which follow 
+ * their coordinates in their blocks, bottom up.
+ * @param [in] node The root of the subtree.
+ */
+static void box_median_r(kdtree_node *node) {
+	if (NULL == node) {
+		return;
+	}
+	box_median_r(node->left);
+	box_median_r(node->right);
+	node->box = &node->data->coords[node->data->dims];
+	set_box(node, node->data->coords[node->data->curr_axis]);
+}
+
+/**
+ * Builds a subtree from points sorted along a Morton curve.  The points share
+ * the bits of their codes above the highest bit where the first and last 
+ * differ; that bit belongs to one axis and halves the points' common cell 
+ * along it, and since the codes are sorted the points with the bit clear all 
+ * come first.  So the split is found by a binary search rather than a 
+ * selection, and the points are never moved.  The node takes the first point
+ * with the bit set, which may lie anywhere in the upper half, so the subtree 
+ * is split at the highest coordinate of the lower half instead, read from the
+ * box of the left subtree.  Points that share one code are split by median.
+ * @param [in] codes The Morton codes of the points, sorted.
+ * @param [in] points The points, in the order of their codes.
+ * @param [in] num_points The number of points.
+ * @param [in] used_dims The number of dimensions interleaved in the codes.
+ * @param [in] depth The depth of the subtree's root.
+ * @param [in] arena The layout of the nodes, with room for a box in each block.
+ * @param [in] block The first of the num_points blocks for this subtree.
+ * @return The root of the subtree, its box filled in.
+ */
+static kdtree_node * fill_morton_r(const unsigned long long *codes, 
+		point_data **points, size_t num_points, size_t used_dims, size_t depth, 
+		const node_arena *arena, char *block) {
+	if (0 == num_points) {
+		return NULL;
+	}
+	if (codes[0] == codes[num_points - 1]) {
+		kdtree_node *root = fill_tree_r(points, num_points, depth, NULL, arena, block);
+		box_median_r(root);
+		return root;
+	}
+#if KDTREE_STATS_ENABLED
+	double start = stats_now();
+#endif
+
+	/* bits are interleaved from the first axis down, most significant first */
+	size_t bit = highest_bit(codes[0] ^ codes[num_points - 1]);
+	size_t axis = used_dims - 1 - bit % used_dims;
+	unsigned long long mask = 1ULL << bit;
+	size_t lo = 0;
+	size_t hi = num_points - 1;
+	while (lo < hi) {
+		size_t mid = lo + (hi - lo) / 2;
+		if (codes[mid] & mask) {
+			hi = mid;
+		} else {
+			lo = mid + 1;
+		}
+	}
+	size_t split = lo;
+
+	kdtree_node *node = init_node(block, points[split], axis);
+	node->box = &node->data->coords[node->data->dims];
+#if KDTREE_STATS_ENABLED
+	note_level(arena->stats, depth, stats_now() - start);
+#endif
+
+	size_t right_sz = num_points - split - 1;
+	size_t next_depth = depth + 1;
+#ifdef _OPENMP
+#pragma omp task if (split >= PAR_TASK_POINTS)
+#endif
+	node->left = fill_morton_r(codes, points, split, used_dims, next_depth, arena,
+			block + arena->stride);
+#ifdef _OPENMP
+#pragma omp task if (right_sz >= PAR_TASK_POINTS)
+#endif
+	node->right = fill_morton_r(&codes[split + 1], &points[split + 1], right_sz, 
+			used_dims, next_depth, arena, block + (split + 1) * arena->stride);
+#ifdef _OPENMP
+#pragma omp taskwait
+#endif
+	/* the lower half is never empty: its first point has the bit clear */
+	set_box(node, node->left->box[node->data->dims + axis]);
+	return node;
+}
+
+/**
+ * Builds up a tree by bulk loading the points along a Morton curve.  This 
+ * quantizes the points within their bounding box, radix sorts their Morton 
+ * codes and splits on the bits of the codes, so past the sort it does a binary
+ * search per node and a pass over the boxes, far less work than the median 
+ * splits of fill_tree; the tree is less balanced, but no deeper than the 
+ * number of bits in a code plus the median splits of points sharing a cell.
+ * Every node stores the bounding box of its subtree, 16 * dims + 8 bytes, and
+ * searches skip far subtrees by their boxes.  It suits low-dimensional data 
+ * that is rebuilt often.  With more than a few dimensions the cells get coarse
+ * and most of the work falls back to median splits.  The sort and the 
+ * subtrees are built in parallel when compiled with OpenMP.
+ * @param [in] points The points_data used to build the tree.  The array is
+ * reordered in place; the caller is free to dispose of it after the call.
+ * @param [in] num_points The number of points in the points_data array.
+ * @return A newly malloc'd KD tree node, or NULL if there are no points.
+ */
+extern kdtree_node * fill_tree_morton(point_data **points, size_t num_points) {
+	if (NULL == points || 0 == num_points) {
+		return NULL;
+	}
+	build_stats *stats = start_build_stats();
+	size_t dims = points[0]->dims;
+	sort_key *keys = morton_order(points, num_points);
+	unsigned long long *codes = malloc(num_points * sizeof(unsigned long long));
+	point_data *sorted = malloc(num_points * sizeof(point_data));
+	double *sorted_coords = malloc(num_points * dims * sizeof(double));
+	point_data **ordered = malloc(num_points * sizeof(point_data *));
+	if (NULL == codes || NULL == sorted || NULL == sorted_coords || NULL == ordered) {
+		fprintf(stderr, "Out of memory at %s: %d\n", __FILE__, __LINE__);
+		exit(OOM);
+	}
+	/* copy the points out in curve order, so that the build reads them where
+	 * it places them rather than all over the caller's memory */
+	long p;
+#ifdef _OPENMP
+#pragma omp parallel for if (num_points >= PAR_TASK_POINTS)
+#endif
+	for (p = 0; p < (long)num_points; p++) {
+		const point_data *point = points[keys[p].idx];
+		codes[p] = keys[p].code;
+		sorted[p] = *point;
+		sorted[p].coords = &sorted_coords[p * dims];
+		memcpy(sorted[p].coords, point->coords, dims * sizeof(double));
+		ordered[p] = &sorted[p];
+	}
+
+	node_arena arena;
+	arena.stride = sizeof(kdtree_node) + sizeof(point_data) + 
+		(3 * dims + 1) * sizeof(double);
+	arena.stats = stats;
+	char *blocks = malloc(num_points * arena.stride);
+	if (NULL == blocks) {
+		fprintf(stderr, "Out of memory at %s: %d\n", __FILE__, __LINE__);
+		exit(OOM);
+	}
+	size_t used_dims = (dims < MORTON_BITS) ? dims : MORTON_BITS;
+	kdtree_node *root = NULL;
+#ifdef _OPENMP
+#pragma omp parallel if (num_points >= PAR_TASK_POINTS)
+#pragma omp single
+#endif
+	root = fill_morton_r(codes, ordered, num_points, used_dims, 0, &arena, blocks);
+
+	/* hand the caller's array back in the order the tree was built from */
+	size_t i;
+	for (i = 0; i < num_points; i++) {
+		ordered[i] = points[keys[ordered[i] - sorted].idx];
+	}
+	memcpy(points, ordered, num_points * sizeof(point_data *));
+	free(ordered);
+	free(sorted_coords);
+	free(sorted);
+	free(codes);
+	free(keys);
+	return root;
+}
+
+/**
+ * Maps a double to an integer with the same order, so that doubles can be 
+ * radix sorted: the sign bit is flipped for positive numbers and every bit for
+ * negative ones.  Both zeros map to the same key.
+ * @param [in] x The double.  Must not be NaN.
+ * @return The key.
+ */
+static inline unsigned long long float_key(double x) {
+	unsigned long long bits;
+	if (0.0 == x) {
+		x = 0.0;
+	}
+	memcpy(&bits, &x, sizeof(bits));
+	return (bits >> 63) ? ~bits : (bits | (1ULL << 63));
+}
+
+/**
+ * The state of a presorted build.  Points are numbered by their rank along 
+ * the first axis, so that the points of a subtree have nearby numbers and 
+ * looking up their sides stays in cache.
+ * @param points The points, by number.
+ * @param dims The number of dimensions.
+ * @param order For each axis, the numbers of the points sorted along it.  
+ * Every subtree's points occupy the same range of each list.
+ * @param scratch Room for as many numbers as there are points.
+ * @param side For each point, which side of its current split it falls on.
+ * @param leaves Room for as many point pointers as there are points, for the
+ * subtrees handed to median selection.
+ * @param arena The layout of the nodes.
+ */
+typedef struct presort_state {
+	point_data **points;
+	size_t dims;
+	uint32_t **order;
+	uint32_t *scratch;
+	unsigned char *side;
+	point_data **leaves;
+	const node_arena *arena;
+} presort_state;
+
+/**
+ * Builds a subtree from presorted lists.  The median along the split axis is
+ * simply the middle of that axis' list, and every other list is split around
+ * it with a stable partition, which keeps each half sorted for the next level.
+ * @param [in] state The state of the build.
+ * @param [in] first Where the subtree's points start in each list.
+ * @param [in] num_points The number of points in the subtree.
+ * @param [in] depth The depth of the subtree's root.
+ * @param [in] block The first of the num_points blocks for this subtree.
+ * @return The root of the subtree.
+ */
+static kdtree_node * fill_presorted_r(const presort_state *state, size_t first, 
+		size_t num_points, size_t depth, char *block) {
+	size_t i, d;
+	if (0 == num_points) {
+		return NULL;
+	}
+	if (num_points <= PRESORT_LEAF_POINTS) {
+		point_data **leaves = &state->leaves[first];
+		const uint32_t *list = &state->order[0][first];
+		for (i = 0; i < num_points; i++) {
+			leaves[i] = state->points[list[i]];
+		}
+		return fill_tree_r(leaves, num_points, depth, NULL, state->arena, block);
+	}
+#if KDTREE_STATS_ENABLED
+	double start = stats_now();
+#endif
+
+	size_t axis = pick_axis(depth, state->dims);
+	size_t median = num_points / 2;
+	const uint32_t *sorted = &state->order[axis][first];
+	uint32_t median_num = sorted[median];
+	for (i = 0; i < num_points; i++) {
+		state->side[sorted[i]] = (i < median) ? 0 : (i == median) ? 2 : 1;
+	}
+	for (d = 0; d < state->dims; d++) {
+		if (d == axis) {
+			continue;
+		}
+		/* lower points are written behind the read position, the upper ones
+		 * are set aside and copied in after the median */
+		uint32_t *list = &state->order[d][first];
+		uint32_t *upper = &state->scratch[first];
+		size_t num_lower = 0;
+		size_t num_upper = 0;
+		for (i = 0; i < num_points; i++) {
+			uint32_t num = list[i];
+			unsigned char side = state->side[num];
+			if (0 == side) {
+				list[num_lower++] = num;
+			} else if (1 == side) {
+				upper[num_upper++] = num;
+			}
+		}
+		list[median] = median_num;
+		memcpy(&list[median + 1], upper, num_upper * sizeof(uint32_t));
+	}
+
+	kdtree_node *node = init_node(block, state->points[median_num], axis);
+#if KDTREE_STATS_ENABLED
+	note_level(state->arena->stats, depth, stats_now() - start);
+#endif
+
+	size_t right_sz = num_points - median - 1;
+	size_t stride = state->arena->stride;
+#ifdef _OPENMP
+#pragma omp task if (median >= PAR_TASK_POINTS)
+#endif
+	node->left = fill_presorted_r(state, first, median, depth + 1, block + stride);
+#ifdef _OPENMP
+#pragma omp task if (right_sz >= PAR_TASK_POINTS)
+#endif
+	node->right = fill_presorted_r(state, first + median + 1, right_sz, depth + 1,
+			block + (median + 1) * stride);
+#ifdef _OPENMP
+#pragma omp taskwait
+#endif
+	return node;
+}
+
+/**
+ * Builds up a tree by sorting the points once along each axis rather than 
+ * selecting a median at every node.  The sorts are radix sorts of the 
+ * coordinates mapped to integers, and each level splits the sorted lists
+ * stably, so no comparisons are repeated and the build takes O(dn log n) time 
+ * whatever the data; this beats median selection for up to about four 
+ * dimensions.  Small subtrees are finished by median selection.  It needs 
+ * about 4d + 21 bytes per point of extra memory, and 20 more while sorting.
+ * Points with equal coordinates are ordered by node number, as point_before
+ * orders them, and then by their position in points, so this builds the same
+ * tree as fill_tree unless two points share both coordinates and a number 
+ * and lie in memory out of the order given; even then the search results are
+ * the same.  The sorts and the subtrees are built in parallel when compiled 
+ * with OpenMP.
+ * @param [in] points The points_data used to build the tree.  The array is
+ * not reordered; the caller is free to dispose of it after the call.
+ * @param [in] num_points The number of points in the points_data array.  
+ * Larger sets than 32-bit numbers can count are built by fill_tree instead.
+ * @return A newly malloc'd KD tree node, or NULL if there are no points.
+ */
+extern kdtree_node * fill_tree_presorted(point_data **points, size_t num_points) {
+	if (NULL == points || 0 == num_points) {
+		return NULL;
+	}
+	size_t d;
+	long p;
+	presort_state state;
+	state.dims = points[0]->dims;
+	state.points = malloc(num_points * sizeof(point_data *));
+	if (NULL == state.points) {
+		fprintf(stderr, "Out of memory at %s: %d\n", __FILE__, __LINE__);
+		exit(OOM);
+	}
+	if (num_points > UINT32_MAX) {
+		memcpy(state.points, points, num_points * sizeof(point_data *));
+		kdtree_node *root = fill_tree(state.points, num_points);
+		free(state.points);
+		return root;
+	}
+
+	build_stats *stats = start_build_stats();
+	state.leaves = malloc(num_points * sizeof(point_data *));
+	state.order = malloc(state.dims * sizeof(uint32_t *));
+	state.scratch = malloc(num_points * sizeof(uint32_t));
+	state.side = malloc(num_points);
+	sort_key *keys = malloc(num_points * sizeof(sort_key));
+	if (NULL == state.leaves || NULL == state.order || NULL == state.scratch || 
+			NULL == state.side || NULL == keys) {
+		fprintf(stderr, "Out of memory at %s: %d\n", __FILE__, __LINE__);
+		exit(OOM);
+	}
+	/* each axis is sorted from the points in node number order, so the stable
+	 * sorts break ties as point_before does */
+	uint32_t *by_num = malloc(num_points * sizeof(uint32_t));
+	if (NULL == by_num) {
+		fprintf(stderr, "Out of memory at %s: %d\n", __FILE__, __LINE__);
+		exit(OOM);
+	}
+#ifdef _OPENMP
+#pragma omp parallel for if (num_points >= PAR_TASK_POINTS)
+#endif
+	for (p = 0; p < (long)num_points; p++) {
+		keys[p].code = (uint32_t)points[p]->num ^ 0x80000000u;
+		keys[p].idx = p;
+	}
+	radix_sort_keys(keys, num_points, 32);
+	for (p = 0; p < (long)num_points; p++) {
+		by_num[p] = (uint32_t)keys[p].idx;
+	}
+
+	/* the scratch list maps input positions to numbers until the sorts are 
+	 * done */
+	uint32_t *numbers = state.scratch;
+	for (d = 0; d < state.dims; d++) {
+		state.order[d] = malloc(num_points * sizeof(uint32_t));
+		if (NULL == state.order[d]) {
+			fprintf(stderr, "Out of memory at %s: %d\n", __FILE__, __LINE__);
+			exit(OOM);
+		}
+#ifdef _OPENMP
+#pragma omp parallel for if (num_points >= PAR_TASK_POINTS)
+#endif
+		for (p = 0; p < (long)num_points; p++) {
+			keys[p].code = float_key(points[by_num[p]]->coords[d]);
+			keys[p].idx = by_num[p];
+		}
+		radix_sort_keys(keys, num_points, 64);
+		for (p = 0; p < (long)num_points; p++) {
+			if (0 == d) {
+				state.points[p] = points[keys[p].idx];
+				numbers[keys[p].idx] = (uint32_t)p;
+				state.order[0][p] = (uint32_t)p;
+			} else {
+				state.order[d][p] = numbers[keys[p].idx];
+			}
+		}
+	}
+	free(by_num);
+	free(keys);
+
+	node_arena arena;
+	arena.stride = sizeof(kdtree_node) + sizeof(point_data) + 
+		state.dims * sizeof(double);
+	arena.stats = stats;
+	state.arena = &arena;
+	char *blocks = malloc(num_points * arena.stride);
+	if (NULL == blocks) {
+		fprintf(stderr, "Out of memory at %s: %d\n", __FILE__, __LINE__);
+		exit(OOM);
+	}
+	kdtree_node *root = NULL;
+#ifdef _OPENMP
+#pragma omp parallel if (num_points >= PAR_TASK_POINTS)
+#pragma omp single
+#endif
+	root = fill_presorted_r(&state, 0, num_points, 0, blocks);
+
+	for (d = 0; d < state.dims; d++) {
+		free(state.order[d]);
+	}
+	free(state.order);
+	free(state.scratch);
+	free(state.side);
+	free(state.leaves);
+	free(state.points);
+	return root;
+}
+
+/**
+ * Finds the number of levels of a tree.
+ * @param [in] node The root of the tree.
+ * @return The number of nodes on its longest root to leaf path.
+ */
+static size_t tree_height(const kdtree_node *node) {
+	if (NULL == node) {
+		return 0;
+	}
+	size_t left = tree_height(node->left);
+	size_t right = tree_height(node->right);
+	return 1 + ((left > right) ? left : right);
+}
+
+/**
+ * The state of a van Emde Boas layout pass.
+ * @param base The root block of the tree being laid out, which is the start
+ * of its arena.
+ * @param stride The size of a block.
+ * @param new_pos Receives the position in the new layout of the node in each
+ * block of the old one.
+ * @param count The number of nodes placed so far.
+ */
+typedef struct veb_state {
+	const char *base;
+	size_t stride;
+	size_t *new_pos;
+	size_t count;
+} veb_state;
+
+static void veb_bottom(veb_state *state, const kdtree_node *node, size_t depth, 
+		size_t height);
+
+/**
+ * Places the top levels of a subtree in van Emde Boas order: the top half of
+ * its levels first, recursively, and then each subtree hanging below them, 
+ * recursively, from left to right.
+ * @param [in] state The layout being built.
+ * @param [in] node The root of the subtree.
+ * @param [in] height The number of levels of the subtree to place.
+ */
+static void veb_place(veb_state *state, const kdtree_node *node, size_t height) {
+	if (NULL == node) {
+		return;
+	}
+	if (1 == height) {
+		size_t old_pos = (size_t)((const char *)node - state->base) / state->stride;
+		state->new_pos[old_pos] = state->count++;
+		return;
+	}
+	size_t top = height / 2;
+	veb_place(state, node, top);
+	veb_bottom(state, node, top, height - top);
+}
+
+/**
+ * Places the subtrees rooted a given number of levels below a node, from left
+ * to right.
+ * @param [in] state The layout being built.
+ * @param [in] node The node to look below.
+ * @param [in] depth How many levels below node the subtrees are rooted.
+ * @param [in] height The number of levels of each subtree to place.
+ */
+static void veb_bottom(veb_state *state, const kdtree_node *node, size_t depth, 
+		size_t height) {
+	if (NULL == node) {
+		return;
+	}
+	if (0 == depth) {
+		veb_place(state, node, height);
+		return;
+	}
+	veb_bottom(state, node->left, depth - 1, height);
+	veb_bottom(state, node->right, depth - 1, height);
+}
+
+/**
+ * Moves the nodes of a tree into van Emde Boas order.  The levels of the tree
+ * are split in half, the top half is laid out first and each subtree below it
+ * follows, each laid out the same way, so any path from the root crosses 
+ * about log n / log B blocks of B nodes whatever the size of a cache line or
+ * page.  Searches of trees much larger than the cache touch fewer lines and
+ * pages than they do in preorder; small trees gain nothing.  The search 
+ * results do not change.  It needs as much memory again as the tree while it
+ * runs, plus 8 bytes per node.
+ * @param [in] root The root of a tree built by any of the fill_tree functions
+ * but fill_forest's.  It is freed.
+ * @return The root of the tree in its new, newly malloc'd layout, or NULL if 
+ * root is NULL.  It is freed with free_tree like any other.
+ */
+extern kdtree_node * layout_tree_veb(kdtree_node *root) {
+	if (NULL == root) {
+		return NULL;
+	}
+	size_t num_points = tree_size(root);
+	veb_state state;
+	state.base = (const char *)root;
+	state.stride = node_block_size(root);
+	state.new_pos = malloc(num_points * sizeof(size_t));
+	char *blocks = malloc(num_points * state.stride);
+	if (NULL == state.new_pos || NULL == blocks) {
+		fprintf(stderr, "Out of memory at %s: %d\n", __FILE__, __LINE__);
+		exit(OOM);
+	}
+	state.count = 0;
+	veb_place(&state, root, tree_height(root));
+
+	long i;
+#ifdef _OPENMP
+#pragma omp parallel for if (num_points >= PAR_TASK_POINTS)
+#endif
+	for (i = 0; i < (long)num_points; i++) {
+		const kdtree_node *old = (const kdtree_node *)(state.base + i * state.stride);
+		kdtree_node *node = (kdtree_node *)(blocks + state.new_pos[i] * state.stride);
+		memcpy(node, old, state.stride);
+		node->data = (point_data *)(node + 1);
+		node->data->coords = (double *)(node->data + 1);
+		if (NULL != old->box) {
+			node->box = &node->data->coords[node->data->dims];
+		}
+		node->left = (NULL == old->left) ? NULL : (kdtree_node *)(blocks + 
+				state.new_pos[((const char *)old->left - state.base) / state.stride] * 
+				state.stride);
+		node->right = (NULL == old->right) ? NULL : (kdtree_node *)(blocks + 
+				state.new_pos[((const char *)old->right - state.base) / state.stride] * 
+				state.stride);
+	}
+	free(state.new_pos);
+	free_tree(root);
+	/* the root is always placed first, so it is the allocation */
+	return (kdtree_node *)blocks;
+}
+
+/**
+ * A step of an interleaved depth-first search.
+ * @param node The node to visit, or whose far branch to consider.
+ * @param post 0 to visit the node; 1 when its near branch is done, to compare
+ * the node itself and decide on its far branch.
+ */
+typedef struct search_frame {
+	const kdtree_node *node;
+	int post;
+} search_frame;
+
+/**
+ * One of the searches in flight in an interleaved batch.  It runs the same 
+ * depth-first search as nn_search with its recursion kept on an explicit
+ * stack, so that it can stop wherever it needs a node that is not yet cached.
+ * @param search The point being searched for.
+ * @param best_nums Receives the search's node numbers when it is done.
+ * @param nearest The current nearest neighbors.
+ * @param count The number of current nearest neighbors.
+ * @param stack The steps still to take, the next one last.
+ * @param depth The number of steps on the stack.
+ * @param capacity The number of steps stack can hold.
+ */
+typedef struct search_lane {
+	const point_data *search;
+	int *best_nums;
+	best_pair *nearest;
+	size_t count;
+	search_frame *stack;
+	size_t depth;
+	size_t capacity;
+} search_lane;
+
+/**
+ * Adds a step to a lane's stack, growing the storage as needed.  The node of
+ * a visit is prefetched: its block holds the node, its point_data and its 
+ * coordinates, so its first and last lines are all the visit reads.
+ * @param [in] lane The search to add to.
+ * @param [in] node The node of the step.
+ * @param [in] post Whether the step is the second half of a visit.
+ * @param [in] block_size The size of a node block.
+ */
+static void lane_push(search_lane *lane, const kdtree_node *node, int post, 
+		size_t block_size) {
+	if (lane->depth == lane->capacity) {
+		size_t capacity = (0 == lane->capacity) ? 64 : lane->capacity * 2;
+		search_frame *stack = realloc(lane->stack, capacity * sizeof(search_frame));
+		if (NULL == stack) {
+			fprintf(stderr, "Out of memory at %s: %d\n", __FILE__, __LINE__);
+			exit(OOM);
+		}
+		lane->stack = stack;
+		lane->capacity = capacity;
+	}
+	lane->stack[lane->depth].node = node;
+	lane->stack[lane->depth].post = post;
+	lane->depth++;
+	NOTE_DEPTH(lane->depth);
+	if (!post) {
+		PREFETCH(node);
+		PREFETCH((const char *)node + block_size - 1);
+	}
+}
+
+/**
+ * Starts a new search in a lane.
+ * @param [in] lane The lane, whose previous search is done.
+ * @param [in] root The root of the tree to search.
+ * @param [in] search The point to search for.
+ * @param [in] best_nums Receives the search's node numbers.
+ * @param [in] block_size The size of a node block.
+ */
+static void lane_start(search_lane *lane, const kdtree_node *root, 
+		const point_data *search, int best_nums[], size_t block_size) {
+	COUNT(searches);
+	lane->search = search;
+	lane->best_nums = best_nums;
+	lane->count = 0;
+	lane->depth = 0;
+	if (NULL != root) {
+		lane_push(lane, root, 0, block_size);
+	}
+}
+
+/**
+ * Tells whether a child lies far enough from its parent in memory to be worth
+ * prefetching and switching searches for.  Closer children, such as the left
+ * child of a preorder block, are likely to share a page and be fetched by the
+ * hardware already.
+ * @param [in] node The parent.
+ * @param [in] child The child.
+ * @return Nonzero if the child is INTERLEAVE_NEAR_BYTES or more away.
+ */
+static int is_distant(const kdtree_node *node, const kdtree_node *child) {
+	const char *a = (const char *)node;
+	const char *b = (const char *)child;
+	return (size_t)((a > b) ? a - b : b - a) >= INTERLEAVE_NEAR_BYTES;
+}
+
+/**
+ * Runs a lane's search until it needs a distant node, which it prefetches, or
+ * until it is done.  The steps are those of nn_search, in the same order, so
+ * the results are the same.
+ * @param [in] lane The search to run.
+ * @param [in] num_neighbors The maximum number of nearest neighbors.
+ * @param [in] block_size The size of a node block.
+ * @return 1 if the search has more to do, 0 if it is done and its results 
+ * are written.
+ */
+static int lane_step(search_lane *lane, size_t num_neighbors, size_t block_size) {
+	const point_data *search = lane->search;
+	while (lane->depth > 0) {
+		search_frame frame = lane->stack[--lane->depth];
+		const kdtree_node *node = frame.node;
+		size_t axis;
+		double diff;
+		if (frame.post) {
+			/* the near branch is done: compare the node, then maybe go far */
+			axis = node->data->curr_axis;
+			diff = split_coord(node, axis) - search->coords[axis];
+			const kdtree_node *far = (diff > 0) ? node->right : node->left;
+			if (node->data->num != search->num) {
+				lane->count = add_best(lane->nearest, lane->count, node, search, 
+						num_neighbors);
+			}
+			if (NULL == far) {
+				continue;
+			}
+			double largest = largest_dist(lane->nearest, lane->count, num_neighbors);
+			if (largest >= 0 && far_bound(far, search->coords, diff) >= largest) {
+				COUNT(far_pruned);
+				continue;
+			}
+			COUNT(far_descended);
+			if (is_distant(node, far)) {
+				lane_push(lane, far, 0, block_size);
+				return 1;
+			}
+			node = far;
+		}
+
+		/* visit down the near branches to a leaf or a distant node */
+		for (;;) {
+			COUNT(nodes_visited);
+			if (NULL == node->left && NULL == node->right) {
+				COUNT(leaves_visited);
+				if (node->data->num != search->num) {
+					lane->count = add_best(lane->nearest, lane->count, node, search, 
+							num_neighbors);
+				}
+				break;
+			}
+			lane_push(lane, node, 1, block_size);
+			axis = node->data->curr_axis;
+			diff = split_coord(node, axis) - search->coords[axis];
+			const kdtree_node *near = (diff > 0) ? node->left : node->right;
+			if (NULL == near) {
+				break;
+			}
+			if (is_distant(node, near)) {
+				lane_push(lane, near, 0, block_size);
+				return 1;
+			}
+			node = near;
+		}
+	}
+
+	size_t i;
+	for (i = 0; i < num_neighbors; i++) {
+		lane->best_nums[i] = (i < lane->count) ? lane->nearest[i].node_num : -1;
+	}
+	return 0;
+}
+
+/**
+ * Runs a run of a batch's searches INTERLEAVE_QUERIES at a time, taking one 
+ * step of each in turn.  Each step ends by prefetching the next node of its 
+ * search, so while one search waits on memory the others run, and trees far
+ * larger than the cache are searched at the speed of several misses at once
+ * rather than one.
+ * @param [in] root The root of the tree to search.
+ * @param [in] lanes INTERLEAVE_QUERIES lanes, each with room for num_neighbors
+ * candidates.
+ * @param [in] num_neighbors The maximum number of nearest neighbors.
+ * @param [in] searches The points of the batch.
+ * @param [in] keys The order to search them in.
+ * @param [in] first The position in keys of the first search of the run.
+ * @param [in] end The position in keys just past the last search of the run.
+ * @param [in] best_nums Receives num_neighbors node numbers per search, at 
+ * the search's position in searches.
+ */
+static void search_interleaved(const kdtree_node *root, search_lane lanes[],
+		size_t num_neighbors, point_data **searches, const sort_key *keys,
+		size_t first, size_t end, int best_nums[]) {
+	size_t block_size = (NULL == root) ? 0 : node_block_size(root);
+	size_t next = first;
+	size_t active = 0;
+	size_t l;
+	for (l = 0; l < INTERLEAVE_QUERIES && next < end; l++, next++) {
+		size_t idx = keys[next].idx;
+		lane_start(&lanes[l], root, searches[idx], &best_nums[idx * num_neighbors], 
+				block_size);
+		active++;
+	}
+	while (active > 0) {
+		for (l = 0; l < active; l++) {
+			while (!lane_step(&lanes[l], num_neighbors, block_size)) {
+				if (next < end) {
+					size_t idx = keys[next++].idx;
+					lane_start(&lanes[l], root, searches[idx], 
+							&best_nums[idx * num_neighbors], block_size);
+				} else {
+					/* keep the lanes in flight packed at the front */
+					search_lane done = lanes[l];
+					lanes[l] = lanes[--active];
+					lanes[active] = done;
+					if (l == active) {
+						break;
+					}
+				}
+			}
+		}
+	}
+}
+
+/**
+ * The searches of a packet.  The coordinates are stored lane by lane for each
+ * dimension, so the work at a node is the same few operations on every lane 
+ * and compiles to vector instructions.
+ * @param dims The number of dimensions.
+ * @param num_neighbors The maximum number of nearest neighbors.
+ * @param coords The search points: coordinate d of lane l is at 
+ * d * PACKET_QUERIES + l.
+ * @param nums The node numbers of the search points, never returned as their
+ * own neighbors.
+ * @param nearest The current nearest neighbors of each lane, num_neighbors 
+ * apiece.
+ * @param count The number of current nearest neighbors of each lane.
+ * @param bound The squared distance of each lane's num_neighbors-th nearest
+ * neighbor, or INFINITY while it has fewer.
+ */
+typedef struct packet_state {
+	size_t dims;
+	size_t num_neighbors;
+	double *coords;
+	int nums[PACKET_QUERIES];
+	best_pair *nearest;
+	size_t count[PACKET_QUERIES];
+	double bound[PACKET_QUERIES];
+} packet_state;
+
+/**
+ * Searches a subtree for the nearest neighbors of a packet's active lanes.
+ * Each node's distance and split comparison are computed for all the lanes at
+ * once.  The children are visited in the order most active lanes prefer, and
+ * each child only by the lanes that have it as their near branch or whose 
+ * bound still reaches across the split; the others are masked off.
+ * @param [in] state The searches of the packet.
+ * @param [in] node The root of the subtree.
+ * @param [in] active Nonzero for each lane that searches the subtree.
+ */
+static void packet_search(packet_state *state, const kdtree_node *node, 
+		const unsigned char active[PACKET_QUERIES]) {
+	double dist[PACKET_QUERIES];
+	double diff[PACKET_QUERIES];
+	unsigned char enter[PACKET_QUERIES];
+	const double *coords = node->data->coords;
+	size_t axis = node->data->curr_axis;
+	int num = node->data->num;
+	size_t l, d;
+#if KDTREE_STATS_ENABLED
+	size_t num_active = 0;
+	for (l = 0; l < PACKET_QUERIES; l++) {
+		num_active += active[l];
+	}
+	COUNT_N(nodes_visited, num_active);
+	COUNT_N(dist_evals, num_active);
+#endif
+
+	for (l = 0; l < PACKET_QUERIES; l++) {
+		dist[l] = 0.0;
+	}
+	for (d = 0; d < state->dims; d++) {
+		const double *lanes = &state->coords[d * PACKET_QUERIES];
+		double coord = coords[d];
+#ifdef _OPENMP
+#pragma omp simd
+#endif
+		for (l = 0; l < PACKET_QUERIES; l++) {
+			double delta = lanes[l] - coord;
+			dist[l] += delta * delta;
+		}
+	}
+	/* few lanes get closer than their bound, so insert those one by one */
+	for (l = 0; l < PACKET_QUERIES; l++) {
+		if (active[l] && dist[l] < state->bound[l] && num != state->nums[l]) {
+			size_t k = state->num_neighbors;
+			best_pair *nearest = &state->nearest[l * k];
+			state->count[l] = insert_best(nearest, state->count[l], num, dist[l], k);
+			if (k > 0 && state->count[l] >= k) {
+				state->bound[l] = nearest[k - 1].dist;
+			}
+		}
+	}
+	if (NULL == node->left && NULL == node->right) {
+		COUNT_N(leaves_visited, num_active);
+		return;
+	}
+
+	const double *lanes = &state->coords[axis * PACKET_QUERIES];
+	double split = split_coord(node, axis);
+	size_t left_votes = 0;
+	size_t votes = 0;
+#ifdef _OPENMP
+#pragma omp simd reduction(+:left_votes, votes)
+#endif
+	for (l = 0; l < PACKET_QUERIES; l++) {
+		/* as in nn_search, the left child is near when diff > 0 */
+		diff[l] = split - lanes[l];
+		left_votes += active[l] & (diff[l] > 0);
+		votes += active[l];
+	}
+	int left_first = (2 * left_votes >= votes);
+	const kdtree_node *first = left_first ? node->left : node->right;
+	const kdtree_node *second = left_first ? node->right : node->left;
+
+	/* lanes enter the first child if it is near or their bound crosses the
+	 * split, and the second child likewise once the first has tightened the 
+	 * bounds */
+	size_t entering = 0;
+	if (NULL != first) {
+#ifdef _OPENMP
+#pragma omp simd reduction(+:entering)
+#endif
+		for (l = 0; l < PACKET_QUERIES; l++) {
+			int near = ((diff[l] > 0) == left_first);
+			enter[l] = active[l] & (near | (diff[l] * diff[l] < state->bound[l]));
+			entering += enter[l];
+		}
+		if (entering > 0) {
+			packet_search(state, first, enter);
+		}
+	}
+	if (NULL != second) {
+		entering = 0;
+#ifdef _OPENMP
+#pragma omp simd reduction(+:entering)
+#endif
+		for (l = 0; l < PACKET_QUERIES; l++) {
+			int near = ((diff[l] > 0) != left_first);
+			enter[l] = active[l] & (near | (diff[l] * diff[l] < state->bound[l]));
+			entering += enter[l];
+		}
+		if (entering > 0) {
+			packet_search(state, second, enter);
+		}
+	}
+}
+
+/**
+ * Runs up to PACKET_QUERIES neighboring searches of a batch as one packet.
+ * @param [in] root The root of the tree to search.  Must not be NULL.
+ * @param [in] state Scratch space for the packet, with room for dims 
+ * coordinates and num_neighbors candidates per lane.
+ * @param [in] searches The points of the batch.
+ * @param [in] keys The order to search them in.
+ * @param [in] first The position in keys of the packet's first search.
+ * @param [in] size The number of searches in the packet.
+ * @param [in] best_nums Receives num_neighbors node numbers per search, at
+ * the search's position in searches.
+ */
+static void search_packet(const kdtree_node *root, packet_state *state, 
+		point_data **searches, const sort_key *keys, size_t first, size_t size,
+		int best_nums[]) {
+	unsigned char active[PACKET_QUERIES];
+	size_t l, d, i;
+	for (l = 0; l < PACKET_QUERIES; l++) {
+		/* idle lanes copy the first search so that they compute nothing odd */
+		const point_data *search = searches[keys[first + ((l < size) ? l : 0)].idx];
+		for (d = 0; d < state->dims; d++) {
+			state->coords[d * PACKET_QUERIES + l] = search->coords[d];
+		}
+		state->nums[l] = search->num;
+		state->count[l] = 0;
+		state->bound[l] = INFINITY;
+		active[l] = (l < size);
+	}
+	COUNT_N(searches, size);
+	packet_search(state, root, active);
+
+	size_t k = state->num_neighbors;
+	for (l = 0; l < size; l++) {
+		int *best = &best_nums[keys[first + l].idx * k];
+		for (i = 0; i < k; i++) {
+			best[i] = (i < state->count[l]) ? state->nearest[l * k + i].node_num : -1;
+		}
+	}
+}
+
+/** 
+ * Runs a nearest neighbor search for each of a batch of points.  The queries
+ * are visited along a Morton curve rather than in the order given, so that
+ * consecutive searches walk the same parts of the tree while they are still
+ * in cache; the results are written back in the original order.  Contiguous
+ * runs of the curve are searched in parallel when compiled with OpenMP.
+ * SEARCH_INTERLEAVED runs the depth-first searches several at a time on each
+ * thread, prefetching, which pays off for trees much larger than the cache.
+ * SEARCH_PACKET carries runs of PACKET_QUERIES neighboring searches through 
+ * the tree together, a node's work for all of them at once.
+ *
+ * @param [in] root The node to start the nearest neighbor searches at.
+ * @param [in] num_neighbors The maximum number of nearest neighbors.
+ * @param [in] searches The points for which the searches are being done.
+ * @param [in] num_searches The number of points in searches.
+ * @param [in] best_nums Receives num_searches * num_neighbors node numbers;
+ * row i holds the neighbors of searches[i], nearest first, and slots beyond 
+ * the number of points found are set to -1.
+ * @param [in] method The traversal to use for each search.
+ * @param [in] stats The counters of the searches are added to this.  May be
+ * NULL.
+ */
+extern void
+run_nn_search_batch(kdtree_node *root, 
+		size_t num_neighbors, 
+		point_data **searches,
+		size_t num_searches,
+		int best_nums[],
+		search_method method,
+		search_stats *stats) {
+	if (0 == num_searches) {
+		return;
+	}
+	sort_key *keys = morton_order(searches, num_searches);
+
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
+	{
+		/* each thread reuses one context for all of its searches */
+		query_context *ctx = new_query_context(num_neighbors, 0);
+		long i;
+		if (SEARCH_INTERLEAVED == method) {
+			search_lane lanes[INTERLEAVE_QUERIES];
+			size_t l;
+			for (l = 0; l < INTERLEAVE_QUERIES; l++) {
+				memset(&lanes[l], 0, sizeof(search_lane));
+				lanes[l].nearest = malloc((num_neighbors + 1) * sizeof(best_pair));
+				if (NULL == lanes[l].nearest) {
+					fprintf(stderr, "Out of memory at %s: %d\n", __FILE__, __LINE__);
+					exit(OOM);
+				}
+			}
+#if KDTREE_STATS_ENABLED
+			thread_stats = &ctx->stats;
+#endif
+			long num_runs = (long)((num_searches + INTERLEAVE_RUN - 1) / INTERLEAVE_RUN);
+#ifdef _OPENMP
+#pragma omp for schedule(static)
+#endif
+			for (i = 0; i < num_runs; i++) {
+				size_t end = (i + 1) * INTERLEAVE_RUN;
+				search_interleaved(root, lanes, num_neighbors, searches, keys, 
+						i * INTERLEAVE_RUN, (end < num_searches) ? end : num_searches, 
+						best_nums);
+			}
+#if KDTREE_STATS_ENABLED
+			thread_stats = NULL;
+#endif
+			for (l = 0; l < INTERLEAVE_QUERIES; l++) {
+				free(lanes[l].stack);
+				free(lanes[l].nearest);
+			}
+		} else if (SEARCH_PACKET == method && NULL != root) {
+			packet_state packet;
+			packet.dims = root->data->dims;
+			packet.num_neighbors = num_neighbors;
+			packet.coords = malloc((packet.dims + 1) * PACKET_QUERIES * sizeof(double));
+			packet.nearest = malloc((num_neighbors + 1) * PACKET_QUERIES * 
+					sizeof(best_pair));
+			if (NULL == packet.coords || NULL == packet.nearest) {
+				fprintf(stderr, "Out of memory at %s: %d\n", __FILE__, __LINE__);
+				exit(OOM);
+			}
+#if KDTREE_STATS_ENABLED
+			thread_stats = &ctx->stats;
+#endif
+			long num_packets = (long)((num_searches + PACKET_QUERIES - 1) / PACKET_QUERIES);
+#ifdef _OPENMP
+#pragma omp for schedule(static)
+#endif
+			for (i = 0; i < num_packets; i++) {
+				size_t first = i * PACKET_QUERIES;
+				size_t size = (num_searches - first < PACKET_QUERIES) ? 
+					num_searches - first : PACKET_QUERIES;
+				search_packet(root, &packet, searches, keys, first, size, best_nums);
+			}
+#if KDTREE_STATS_ENABLED
+			thread_stats = NULL;
+#endif
+			free(packet.nearest);
+			free(packet.coords);
+		} else {
+#ifdef _OPENMP
+#pragma omp for schedule(static)
+#endif
+			for (i = 0; i < (long)num_searches; i++) {
+				size_t idx = keys[i].idx;
+				search_context(&root, 1, ctx, num_neighbors, searches[idx], 
+						&best_nums[idx * num_neighbors], method, 0);
+			}
+		}
+		if (NULL != stats) {
+#ifdef _OPENMP
+#pragma omp critical
+#endif
+			add_search_stats(stats, &ctx->stats);
+		}
+		free_query_context(ctx);
+	}
+	free(keys);
+}
+
+/** 
+ * Initializes the nearest neighbor search point and starts a depth-first search.
+ *
+ * @param [in] root The node to start the nearest neighbor search at.
+ * @param [in] num_neighbors The maximum number of nearest neighbors.
+ * @param [in] search The point for which the nearest neighbor search is being
+ * done.
+ * @param [in] best_nums The nearest neighbors node numbers.  Will be filled in
+ * by this function.
+ */
+extern void
+run_nn_search(kdtree_node *root, 
+		size_t num_neighbors, 
+		point_data search,
+		int best_nums[]) {
+	run_nn_search_method(root, num_neighbors, search, best_nums, SEARCH_DFS);
+}
+
+/**
+ * An entry of an incremental search's priority queue: either a subtree still
+ * to be opened, keyed on a lower bound on the squared distance to any of its
+ * points, or a point found, keyed on its squared distance.
+ * @param node The root of the subtree, or the node holding the point.
+ * @param key The squared distance or its lower bound.
+ * @param point 1 for a point, 0 for a subtree.
+ */
+typedef struct iter_entry {
+	const kdtree_node *node;
+	double key;
+	int point;
+} iter_entry;
+
+/**
+ * The state of an incremental nearest neighbor search.  It is a best-first 
+ * traversal that keeps subtrees and points in one queue, so the points come
+ * off it in order of distance, and it stops as soon as one does.
+ * @param search The search point.  Its coordinates belong to the iterator.
+ * @param heap A binary min-heap of entries.
+ * @param count The number of entries in heap.
+ * @param capacity The number of entries heap can hold.
+ */
+struct neighbor_iter {
+	point_data search;
+	iter_entry *heap;
+	size_t count;
+	size_t capacity;
+};
+
+/**
+ * Orders the entries of an incremental search.  Points go before subtrees 
+ * with the same key, so they are handed out without opening more subtrees.
+ * @param [in] a The first entry.
+ * @param [in] b The second entry.
+ * @return Nonzero if a comes off the queue before b.
+ */
+static inline int entry_before(const iter_entry *a, const iter_entry *b) {
+	return a->key < b->key || (a->key == b->key && a->point > b->point);
+}
+
+/**
+ * Adds an entry to an incremental search's queue, growing the storage as 
+ * needed.
+ * @param [in] iter The search.
+ * @param [in] node The subtree or point node.
+ * @param [in] key Its key.
+ * @param [in] point 1 for a point, 0 for a subtree.
+ */
+static void iter_push(neighbor_iter *iter, const kdtree_node *node, double key, 
+		int point) {
+	if (iter->count == iter->capacity) {
+		size_t capacity = (0 == iter->capacity) ? QUEUE_START : iter->capacity * 2;
+		iter_entry *heap = realloc(iter->heap, capacity * sizeof(iter_entry));
+		if (NULL == heap) {
+			fprintf(stderr, "Out of memory at %s: %d\n", __FILE__, __LINE__);
+			exit(OOM);
+		}
+		iter->heap = heap;
+		iter->capacity = capacity;
+	}
+
+	iter_entry item;
+	item.node = node;
+	item.key = key;
+	item.point = point;
+	/* sift up */
+	size_t idx = iter->count++;
+	while (idx > 0) {
+		size_t parent = (idx - 1) / 2;
+		if (!entry_before(&item, &iter->heap[parent])) {
+			break;
+		}
+		iter->heap[idx] = iter->heap[parent];
+		idx = parent;
+	}
+	iter->heap[idx] = item;
+}
+
+/**
+ * Removes the first entry from an incremental search's queue.
+ * @param [in] iter The search.  Its queue must not be empty.
+ * @return The entry with the smallest key.
+ */
+static iter_entry iter_pop(neighbor_iter *iter) {
+	iter_entry top = iter->heap[0];
+	iter_entry last = iter->heap[--iter->count];
+
+	/* sift down */
+	size_t idx = 0;
+	size_t child;
+	while ((child = 2 * idx + 1) < iter->count) {
+		if (child + 1 < iter->count &&
+				entry_before(&iter->heap[child + 1], &iter->heap[child])) {
+			child++;
+		}
+		if (!entry_before(&iter->heap[child], &last)) {
+			break;
+		}
+		iter->heap[idx] = iter->heap[child];
+		idx = child;
+	}
+	if (iter->count > 0) {
+		iter->heap[idx] = last;
+	}
+	return top;
+}
+
+/**
+ * Starts an incremental nearest neighbor search, which hands out the points of
+ * a tree one at a time, nearest first, doing only the work each one needs.  
+ * Use it when the number of neighbors wanted is not known in advance.
+ * @param [in] root The root of the tree to search.  May be NULL.  The tree 
+ * must outlive the iterator.
+ * @param [in] search The search point.  Its coordinates are copied, so the 
+ * caller is free to dispose of them after the call.  A point whose node number
+ * is search->num is never handed out.
+ * @return A newly malloc'd iterator.  Release it with free_neighbor_iter.
+ */
+extern neighbor_iter * new_neighbor_iter(const kdtree_node *root, 
+		const point_data *search) {
+	neighbor_iter *iter = malloc(sizeof(neighbor_iter));
+	if (NULL == iter) {
+		fprintf(stderr, "Out of memory at %s: %d\n", __FILE__, __LINE__);
+		exit(OOM);
+	}
+	iter->search = *search;
+	/* one extra slot, so that zero sizes still get a valid pointer */
+	iter->search.coords = malloc((search->dims + 1) * sizeof(double));
+	if (NULL == iter->search.coords) {
+		fprintf(stderr, "Out of memory at %s: %d\n", __FILE__, __LINE__);
+		exit(OOM);
+	}
+	memcpy(iter->search.coords, search->coords, search->dims * sizeof(double));
+	iter->heap = NULL;
+	iter->count = 0;
+	iter->capacity = 0;
+	if (NULL != root) {
+		iter_push(iter, root, 0.0, 0);
+	}
+	return iter;
+}
+
+/**
+ * Finds the next nearest neighbor of an incremental search.  Subtrees are 
+ * opened from the queue until a point comes off it; since every subtree is 
+ * keyed on a lower bound for its points, no point left is any closer.
+ * @param [in] iter The search.
+ * @param [in] num Receives the node number of the neighbor.
+ * @param [in] dist Receives the squared distance of the neighbor.
+ * @return 1 if a neighbor was found, 0 if every point has been handed out.
+ */
+extern int next_neighbor(neighbor_iter *iter, int *num, double *dist) {
+	const point_data *search = &iter->search;
+	while (iter->count > 0) {
+		iter_entry entry = iter_pop(iter);
+		const kdtree_node *node = entry.node;
+		if (entry.point) {
+			*num = node->data->num;
+			*dist = entry.key;
+			return 1;
+		}
+
+		if (node->data->num != search->num) {
+			iter_push(iter, node, sqdist(node->data->coords, search->coords, 
+						search->dims), 1);
+		}
+		size_t axis = node->data->curr_axis;
+		double diff = split_coord(node, axis) - search->coords[axis];
+		const kdtree_node *near;
+		const kdtree_node *far;
+		if (diff > 0) {
+			near = node->left;
+			far = node->right;
+		} else {
+			near = node->right;
+			far = node->left;
+		}
+		/* the near side is no closer than the subtree; the far side is across
+		 * the split as well */
+		if (NULL != near) {
+			iter_push(iter, near, entry.key, 0);
+		}
+		if (NULL != far) {
+			double bound = far_bound(far, search->coords, diff);
+			iter_push(iter, far, (bound > entry.key) ? bound : entry.key, 0);
+		}
+	}
+	return 0;
+}
+
+/**
+ * Frees an iterator made by new_neighbor_iter.
+ * @param [in] iter The iterator to free.  May be NULL.
+ */
+extern void free_neighbor_iter(neighbor_iter *iter) {
+	if (NULL == iter) {
+		return;
+	}
+	free(iter->heap);
+	free(iter->search.coords);
+	free(iter);
+}
+
+/* Implicit trees */
+
+/**
+ * The points an implicit tree is built over, by their position in the 
+ * caller's arrays.
+ * @param coords The coordinates in double precision, dims per point, or NULL.
+ * @param coords_f32 The coordinates in single precision, used if coords is
+ * NULL.
+ * @param nums The node numbers of the points, or NULL if they are numbered by
+ * position.
+ * @param dims The number of dimensions of each point.
+ */
+typedef struct implicit_build {
+	const double *coords;
+	const float *coords_f32;
+	const int *nums;
+	size_t dims;
+} implicit_build;
+
+/**
+ * Orders two points of an implicit build along an axis as point_before orders
+ * the points of fill_tree_coords, which lie in memory by position.
+ * @param [in] build The points.
+ * @param [in] a The position of the first point.
+ * @param [in] b The position of the second point.
+ * @param [in] axis The coordinate to compare.
+ * @return 1 if a comes before b, 0 otherwise.
+ */
+static inline int position_before(const implicit_build *build, size_t a, 
+		size_t b, size_t axis) {
+	size_t dims = build->dims;
+	double x, y;
+	if (NULL != build->coords) {
+		x = build->coords[a * dims + axis];
+		y = build->coords[b * dims + axis];
+	} else {
+		x = build->coords_f32[a * dims + axis];
+		y = build->coords_f32[b * dims + axis];
+	}
+	int num_a = (NULL == build->nums) ? (int)a : build->nums[a];
+	int num_b = (NULL == build->nums) ? (int)b : build->nums[b];
+	return x < y || (x == y && (num_a < num_b || (num_a == num_b && a < b)));
+}
+
+/**
+ * Reorders positions as select_median reorders points, in position_before 
+ * order.
+ * @param [in] build The points.
+ * @param [in] order The positions to reorder.
+ * @param [in] num_points The number of positions.
+ * @param [in] median The rank to select.
+ * @param [in] axis The coordinate to select on.
+ */
+static void select_position(const implicit_build *build, size_t order[], 
+		size_t num_points, size_t median, size_t axis) {
+	long lo = 0;
+	long hi = (long)num_points - 1;
+	long m = (long)median;
+	while (hi > lo) {
+		size_t pivot = order[lo + (hi - lo) / 2];
+		long i = lo;
+		long j = hi;
+		while (i <= j) {
+			while (position_before(build, order[i], pivot, axis)) {
+				i++;
+			}
+			while (position_before(build, pivot, order[j], axis)) {
+				j--;
+			}
+			if (i <= j) {
+				size_t tmp = order[i];
+				order[i] = order[j];
+				order[j] = tmp;
+				i++;
+				j--;
+			}
+		}
+		if (m <= j) {
+			hi = j;
+		} else if (m >= i) {
+			lo = i;
+		} else {
+			break;
+		}
+	}
+}
+
+/**
+ * Lays out a subtree of an implicit tree: the median along the split axis 
+ * first, then the lower half and the upper half, each laid out the same way.
+ * The halves are the ones fill_tree_r makes, so the preorder is that of the 
+ * tree fill_tree_coords builds, without making its nodes.  Subtrees are laid
+ * out as OpenMP tasks when compiled with OpenMP.
+ * @param [in] build The points.
+ * @param [in] order The positions of the subtree's points.  Reordered into
+ * preorder.
+ * @param [in] num_points The number of points in the subtree.
+ * @param [in] depth The depth of the subtree's root.
+ */
+static void fill_implicit_r(const implicit_build *build, size_t order[], 
+		size_t num_points, size_t depth) {
+	if (num_points <= 1) {
+		return;
+	}
+	size_t median = num_points / 2;
+	select_position(build, order, num_points, median, pick_axis(depth, build->dims));
+	/* the lower half may sit in any order, so the median just swaps with the
+	 * first of it */
+	size_t tmp = order[0];
+	order[0] = order[median];
+	order[median] = tmp;
+
+	size_t right_sz = num_points - median - 1;
+#ifdef _OPENMP
+#pragma omp task if (median >= PAR_TASK_POINTS)
+#endif
+	fill_implicit_r(build, &order[1], median, depth + 1);
+#ifdef _OPENMP
+#pragma omp task if (right_sz >= PAR_TASK_POINTS)
+#endif
+	fill_implicit_r(build, &order[1 + median], right_sz, depth + 1);
+#ifdef _OPENMP
+#pragma omp taskwait
+#endif
+}
+
+/**
+ * Finds the preorder of the implicit tree over a set of points, which needs
+ * 8 bytes per point rather than a whole tree of nodes.
+ * @param [in] build The points.
+ * @param [in] num_points The number of points.
+ * @return A newly malloc'd array of the points' positions in preorder.
+ */
+static size_t * implicit_order(const implicit_build *build, size_t num_points) {
+	size_t *order = malloc((num_points + 1) * sizeof(size_t));
+	if (NULL == order) {
+		fprintf(stderr, "Out of memory at %s: %d\n", __FILE__, __LINE__);
+		exit(OOM);
+	}
+	size_t i;
+	for (i = 0; i < num_points; i++) {
+		order[i] = i;
+	}
+#ifdef _OPENMP
+#pragma omp parallel if (num_points >= PAR_TASK_POINTS)
+#pragma omp single
+#endif
+	fill_implicit_r(build, order, num_points, 0);
+	return order;
+}
+
+/* Packed trees */
+
+/**
+ * Builds a packed tree.  The points are split as fill_tree splits them, 
+ * selecting medians over their positions, and stored in preorder as 
+ * kdtree_f32 stores them, in double precision.
+ * @param [in] coords The coordinates, dims per point.  The tree copies them, so
+ * the caller is free to dispose of them after the call.
+ * @param [in] nums The node numbers of the points, or NULL to number the points
+ * by their index.
+ * @param [in] num_points The number of points.
+ * @param [in] dims The number of dimensions of each point.
+ * @return A newly malloc'd tree.  Release it with free_tree_packed.
+ */
+extern kdtree_packed * fill_tree_packed(const double coords[], const int nums[], 
+		size_t num_points, size_t dims) {
+	kdtree_packed *tree = malloc(sizeof(kdtree_packed));
+	if (NULL == tree) {
+		fprintf(stderr, "Out of memory at %s: %d\n", __FILE__, __LINE__);
+		exit(OOM);
+	}
+	tree->num_nodes = num_points;
+	tree->dims = dims;
+	tree->coords = malloc((num_points * dims + 1) * sizeof(double));
+	tree->nums = malloc((num_points + 1) * sizeof(int));
+	if (NULL == tree->coords || NULL == tree->nums) {
+		fprintf(stderr, "Out of memory at %s: %d\n", __FILE__, __LINE__);
+		exit(OOM);
+	}
+	implicit_build build = {coords, NULL, nums, dims};
+	size_t *order = implicit_order(&build, num_points);
+	long i;
+#ifdef _OPENMP
+#pragma omp parallel for if (num_points >= PAR_TASK_POINTS)
+#endif
+	for (i = 0; i < (long)num_points; i++) {
+		memcpy(&tree->coords[i * dims], &coords[order[i] * dims], dims * sizeof(double));
+		tree->nums[i] = (NULL == nums) ? (int)order[i] : nums[order[i]];
+	}
+	free(order);
+	return tree;
+}
+
+/**
+ * Frees a tree built by fill_tree_packed.
+ * @param [in] tree The tree to free.  May be NULL.
+ */
+extern void free_tree_packed(kdtree_packed *tree) {
+	if (NULL == tree) {
+		return;
+	}
+	free(tree->coords);
+	free(tree->nums);
+	free(tree);
+}
+
+/**
+ * Searches a packed tree for the nearest neighbors of a point.  Small 
+ * searches keep their candidates on the stack; larger ones allocate them.
+ * @param [in] tree The tree to search.
+ * @param [in] num_neighbors The maximum number of nearest neighbors.
+ * @param [in] search The coordinates of the search point, tree->dims long.
+ * @param [in] search_num The node number of the search point, which is never
+ * its own neighbor.
+ * @param [in] best_nums The nearest neighbors node numbers, nearest first.  
+ * Will be filled in by this function; slots beyond the number of points found 
+ * are set to -1.
+ */
+extern void run_nn_search_packed(const kdtree_packed *tree, size_t num_neighbors,
+		const double search[], int search_num, int best_nums[]) {
+	best_pair small_nearest[SMALL_NEIGHBORS];
+	best_pair *nearest = small_nearest;
+	if (num_neighbors > SMALL_NEIGHBORS) {
+		nearest = malloc(num_neighbors * sizeof(best_pair));
+		if (NULL == nearest) {
+			fprintf(stderr, "Out of memory at %s: %d\n", __FILE__, __LINE__);
+			exit(OOM);
+		}
+	}
+
+	size_t found = 0;
+	if (tree->num_nodes > 0 && num_neighbors > 0) {
+		dfs_state state;
+		memset(&state, 0, sizeof(dfs_state));
+		state.layout = LAYOUT_PACKED;
+		state.dims = tree->dims;
+		state.coords = tree->coords;
+		state.nums = tree->nums;
+		state.search = search;
+		state.search_num = search_num;
+		state.nearest = nearest;
+		state.num_neighbors = num_neighbors;
+		state.radius = -1.0;
+		found = dfs_search(&state, state.layout, NULL, 0, tree->num_nodes, 0, 0);
+	}
+	size_t i;
+	for (i = 0; i < num_neighbors; i++) {
+		best_nums[i] = (i < found) ? nearest[i].node_num : -1;
+	}
+
+	if (small_nearest != nearest) {
+		free(nearest);
+	}
+}
+
+/** 
+ * Runs a nearest neighbor search of a packed tree for each of a batch of 
+ * points, visiting them along a Morton curve and in parallel as 
+ * run_nn_search_batch does.
+ * @param [in] tree The tree to search.
+ * @param [in] num_neighbors The maximum number of nearest neighbors.
+ * @param [in] searches The points for which the searches are being done, 
+ * tree->dims coordinates each.
+ * @param [in] num_searches The number of points in searches.
+ * @param [in] best_nums Receives num_searches * num_neighbors node numbers;
+ * row i holds the neighbors of searches[i], nearest first, and slots beyond 
+ * the number of points found are set to -1.
+ */
+extern void run_nn_search_packed_batch(const kdtree_packed *tree, 
+		size_t num_neighbors, 
+		point_data **searches,
+		size_t num_searches,
+		int best_nums[]) {
+	if (0 == num_searches) {
+		return;
+	}
+	sort_key *keys = morton_order(searches, num_searches);
+	long i;
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+	for (i = 0; i < (long)num_searches; i++) {
+		size_t idx = keys[i].idx;
+		run_nn_search_packed(tree, num_neighbors, searches[idx]->coords, 
+				searches[idx]->num, &best_nums[idx * num_neighbors]);
+	}
+	free(keys);
+}
+
+/* Single precision trees */
+
+/**
+ * Builds a single precision tree.  The points are split as fill_tree splits
+ * them, selecting medians over their positions, and stored in preorder.
+ * @param [in] coords The coordinates, dims per point.  The tree copies them, so
+ * the caller is free to dispose of them after the call.
+ * @param [in] nums The node numbers of the points, or NULL to number the points
+ * by their index.
+ * @param [in] num_points The number of points.
+ * @param [in] dims The number of dimensions of each point.
+ * @return A newly malloc'd tree, which has no nodes if there are no points.  
+ * Release it with free_tree_f32.
+ */
+extern kdtree_f32 * fill_tree_f32(const float coords[], const int nums[], 
+		size_t num_points, size_t dims) {
+	kdtree_f32 *tree = malloc(sizeof(kdtree_f32));
+	if (NULL == tree) {
+		fprintf(stderr, "Out of memory at %s: %d\n", __FILE__, __LINE__);
+		exit(OOM);
+	}
+	implicit_build build = {NULL, coords, nums, dims};
+	size_t *order = implicit_order(&build, num_points);
+
+	tree->num_nodes = num_points;
+	tree->dims = dims;
+	tree->coords = malloc((num_points * dims + 1) * sizeof(float));
+	tree->nums = malloc((num_points + 1) * sizeof(int));
+	if (NULL == tree->coords || NULL == tree->nums) {
+		fprintf(stderr, "Out of memory at %s: %d\n", __FILE__, __LINE__);
+		exit(OOM);
+	}
+	long i;
+#ifdef _OPENMP
+#pragma omp parallel for if (num_points >= PAR_TASK_POINTS)
+#endif
+	for (i = 0; i < (long)num_points; i++) {
+		memcpy(&tree->coords[i * dims], &coords[order[i] * dims], dims * sizeof(float));
+		tree->nums[i] = (NULL == nums) ? (int)order[i] : nums[order[i]];
+	}
+	free(order);
+	return tree;
+}
+
+/**
+ * Frees a tree built by fill_tree_f32.
+ * @param [in] tree The tree to free.  May be NULL.
+ */
+extern void free_tree_f32(kdtree_f32 *tree) {
+	if (NULL == tree) {
+		return;
+	}
+	free(tree->coords);
+	free(tree->nums);
+	free(tree);
+}
+
+/**
+ * Searches a single precision tree for the nearest neighbors of a point.  
+ * Distances are computed in single precision, so neighbors at nearly the same
+ * distance may come out in the wrong order.  An exact search takes the 
+ * distance of the farthest candidate, recomputed in double precision, as a 
+ * bound that the true neighbors lie within, and searches the tree again 
+ * within it in double precision, so its results are those of a double 
+ * precision search of the points as stored.
+ * @param [in] tree The tree to search.
+ * @param [in] num_neighbors The maximum number of nearest neighbors.
+ * @param [in] search The coordinates of the search point, tree->dims long.
+ * @param [in] search_num The node number of the search point, which is never
+ * its own neighbor.
+ * @param [in] best_nums The nearest neighbors node numbers, nearest first.  
+ * Will be filled in by this function; slots beyond the number of points found 
+ * are set to -1.
+ * @param [in] exact Whether to search again in double precision.
+ */
+extern void run_nn_search_f32(const kdtree_f32 *tree, size_t num_neighbors,
+		const double search[], int search_num, int best_nums[], int exact) {
+	size_t dims = (NULL == tree) ? 0 : tree->dims;
+	best_pair small_nearest[SMALL_NEIGHBORS];
+	float small_search[SMALL_NEIGHBORS];
+	best_pair *nearest = small_nearest;
+	float *search_f32 = small_search;
+	if (num_neighbors > SMALL_NEIGHBORS) {
+		nearest = malloc(num_neighbors * sizeof(best_pair));
+	}
+	if (dims > SMALL_NEIGHBORS) {
+		search_f32 = malloc(dims * sizeof(float));
+	}
+	if (NULL == nearest || NULL == search_f32) {
+		fprintf(stderr, "Out of memory at %s: %d\n", __FILE__, __LINE__);
+		exit(OOM);
+	}
+
+	size_t found = 0;
+	size_t i, d;
+	dfs_state state;
+	memset(&state, 0, sizeof(dfs_state));
+	if (NULL != tree && tree->num_nodes > 0 && num_neighbors > 0) {
+		for (d = 0; d < dims; d++) {
+			search_f32[d] = (float)search[d];
+		}
+		state.layout = LAYOUT_F32;
+		state.dims = dims;
+		state.coords_f32 = tree->coords;
+		state.nums = tree->nums;
+		state.search = search;
+		state.search_f32 = search_f32;
+		state.search_num = search_num;
+		state.nearest = nearest;
+		state.num_neighbors = num_neighbors;
+		state.radius = -1.0;
+		found = dfs_search(&state, state.layout, NULL, 0, tree->num_nodes, 0, 0);
+	}
+
+	if (exact && found > 0) {
+		/* num_neighbors points lie within the farthest candidate's true 
+		 * distance, so the true neighbors do too; with fewer candidates every
+		 * point is one already */
+		double radius = INFINITY;
+		if (found == num_neighbors) {
+			radius = 0.0;
+			for (i = 0; i < found; i++) {
+				const float *coords = &tree->coords[(size_t)nearest[i].node_num * dims];
+				double dist = 0.0;
+				for (d = 0; d < dims; d++) {
+					double diff = (double)coords[d] - search[d];
+					dist += diff * diff;
+				}
+				if (dist > radius) {
+					radius = dist;
+				}
+			}
+		}
+		state.layout = LAYOUT_F32_WIDE;
+		state.radius = radius;
+		found = dfs_search(&state, state.layout, NULL, 0, tree->num_nodes, 0, 0);
+	}
+	for (i = 0; i < num_neighbors; i++) {
+		best_nums[i] = (i < found) ? tree->nums[nearest[i].node_num] : -1;
+	}
+
+	if (small_nearest != nearest) {
+		free(nearest);
+	}
+	if (small_search != search_f32) {
+		free(search_f32);
+	}
+}
+
+/* Quantized trees */
+
+/**
+ * Finds the cell of a quantized coordinate.  The build and the searches both
+ * go through here with the same box, so they agree on every cell exactly.
+ * @param [in] lo The lower edge of the box along the axis.
+ * @param [in] hi The upper edge of the box along the axis.
+ * @param [in] cell The cell.
+ * @param [in] cell_lo Receives the lower edge of the cell.
+ * @param [in] cell_hi Receives the upper edge of the cell.
+ */
+static inline void quant_cell(double lo, double hi, uint16_t cell, double *cell_lo, 
+		double *cell_hi) {
+	double width = (hi - lo) / QUANT_CELLS;
+	*cell_lo = lo + cell * width;
+	*cell_hi = (cell == UINT16_MAX) ? hi : lo + (cell + 1) * width;
+}
+
+/**
+ * Quantizes a coordinate within a box, so that its cell contains it.
+ * @param [in] lo The lower edge of the box along the axis.
+ * @param [in] hi The upper edge of the box along the axis.
+ * @param [in] x The coordinate.  Must lie within the box.
+ * @return The cell.
+ */
+static uint16_t quantize(double lo, double hi, double x) {
+	double scaled = (hi > lo) ? (x - lo) / (hi - lo) * QUANT_CELLS : 0.0;
+	uint16_t cell = (scaled <= 0) ? 0 : (scaled >= UINT16_MAX) ? UINT16_MAX : 
+		(uint16_t)scaled;
+	/* the division may round either way, so check against the edges the 
+	 * searches will see */
+	double cell_lo, cell_hi;
+	quant_cell(lo, hi, cell, &cell_lo, &cell_hi);
+	while (cell > 0 && x < cell_lo) {
+		quant_cell(lo, hi, --cell, &cell_lo, &cell_hi);
+	}
+	while (cell < UINT16_MAX && x > cell_hi) {
+		quant_cell(lo, hi, ++cell, &cell_lo, &cell_hi);
+	}
+	return cell;
+}
+
+/**
+ * Reads a coordinate of a point from a quantized tree's full precision 
+ * coordinates.
+ * @param [in] tree The tree.
+ * @param [in] idx The position of the point in the coordinates.
+ * @param [in] d The axis.
+ * @return The coordinate.
+ */
+static inline double q16_coord(const kdtree_q16 *tree, size_t idx, size_t d) {
+	size_t offset = idx * tree->dims + d;
+	return (NULL != tree->coords) ? tree->coords[offset] : tree->coords_f32[offset];
+}
+
+/**
+ * Quantizes a subtree's nodes within its box, splitting the box at each node 
+ * as the searches will.
+ * @param [in] tree The tree being filled in.
+ * @param [in] idx The position of the subtree's root.
+ * @param [in] size The number of nodes in the subtree.
+ * @param [in] depth The depth of the subtree's root.
+ * @param [in] lo The lower corner of the subtree's box.  Restored on return.
+ * @param [in] hi The upper corner of the subtree's box.  Restored on return.
+ */
+static void quantize_r(kdtree_q16 *tree, size_t idx, size_t size, size_t depth,
+		double lo[], double hi[]) {
+	size_t dims = tree->dims;
+	uint16_t *cells = &tree->cells[idx * dims];
+	size_t d;
+	for (d = 0; d < dims; d++) {
+		cells[d] = quantize(lo[d], hi[d], q16_coord(tree, tree->index[idx], d));
+	}
+	if (1 == size) {
+		return;
+	}
+
+	/* the lower half lies below the split cell's upper edge and the upper 
+	 * half above its lower edge */
+	size_t axis = pick_axis(depth, dims);
+	double cell_lo, cell_hi;
+	quant_cell(lo[axis], hi[axis], cells[axis], &cell_lo, &cell_hi);
+	size_t left_sz = size / 2;
+	size_t right_sz = size - left_sz - 1;
+	if (left_sz > 0) {
+		double saved = hi[axis];
+		hi[axis] = cell_hi;
+		quantize_r(tree, idx + 1, left_sz, depth + 1, lo, hi);
+		hi[axis] = saved;
+	}
+	if (right_sz > 0) {
+		double saved = lo[axis];
+		lo[axis] = cell_lo;
+		quantize_r(tree, idx + 1 + left_sz, right_sz, depth + 1, lo, hi);
+		lo[axis] = saved;
+	}
+}
+
+/**
+ * Builds a quantized tree over coordinates given in either precision.
+ * @param [in] coords The coordinates in double precision, or NULL.
+ * @param [in] coords_f32 The coordinates in single precision, used if coords
+ * is NULL.
+ * @param [in] num_points The number of points.
+ * @param [in] dims The number of dimensions of each point.
+ * @return A newly malloc'd tree, which has no nodes if there are no points, 
+ * or NULL if there are more than 32-bit positions can count.
+ */
+static kdtree_q16 * build_q16(const double coords[], const float coords_f32[], 
+		size_t num_points, size_t dims) {
+	if (num_points > INT_MAX) {
+		return NULL;
+	}
+	kdtree_q16 *tree = malloc(sizeof(kdtree_q16));
+	if (NULL == tree) {
+		fprintf(stderr, "Out of memory at %s: %d\n", __FILE__, __LINE__);
+		exit(OOM);
+	}
+	tree->num_nodes = num_points;
+	tree->dims = dims;
+	tree->coords = coords;
+	tree->coords_f32 = (NULL == coords) ? coords_f32 : NULL;
+	if (0 == num_points) {
+		/* an empty box and no nodes */
+		tree->lo = calloc(dims + 1, sizeof(double));
+		tree->hi = calloc(dims + 1, sizeof(double));
+		tree->cells = NULL;
+		tree->index = NULL;
+		if (NULL == tree->lo || NULL == tree->hi) {
+			fprintf(stderr, "Out of memory at %s: %d\n", __FILE__, __LINE__);
+			exit(OOM);
+		}
+		return tree;
+	}
+	implicit_build build = {coords, coords_f32, NULL, dims};
+	size_t *order = implicit_order(&build, num_points);
+
+	tree->lo = malloc(dims * sizeof(double));
+	tree->hi = malloc(dims * sizeof(double));
+	tree->cells = malloc(num_points * dims * sizeof(uint16_t));
+	tree->index = malloc(num_points * sizeof(uint32_t));
+	if (NULL == tree->lo || NULL == tree->hi || NULL == tree->cells || 
+			NULL == tree->index) {
+		fprintf(stderr, "Out of memory at %s: %d\n", __FILE__, __LINE__);
+		exit(OOM);
+	}
+	size_t i, d;
+	for (i = 0; i < num_points; i++) {
+		tree->index[i] = (uint32_t)order[i];
+	}
+	free(order);
+
+	for (d = 0; d < dims; d++) {
+		tree->lo[d] = tree->hi[d] = q16_coord(tree, 0, d);
+		for (i = 1; i < num_points; i++) {
+			double coord = q16_coord(tree, i, d);
+			if (coord < tree->lo[d]) {
+				tree->lo[d] = coord;
+			} else if (coord > tree->hi[d]) {
+				tree->hi[d] = coord;
+			}
+		}
+	}
+	double *lo = malloc(dims * sizeof(double));
+	double *hi = malloc(dims * sizeof(double));
+	if (NULL == lo || NULL == hi) {
+		fprintf(stderr, "Out of memory at %s: %d\n", __FILE__, __LINE__);
+		exit(OOM);
+	}
+	memcpy(lo, tree->lo, dims * sizeof(double));
+	memcpy(hi, tree->hi, dims * sizeof(double));
+	quantize_r(tree, 0, num_points, 0, lo, hi);
+	free(lo);
+	free(hi);
+	return tree;
+}
+
+/**
+ * Builds a tree whose nodes hold their coordinates quantized to 16 bits within
+ * the box of their subtree, which their ancestors' splits carve out of the 
+ * bounding box of all points.  Together with the position of each point, a 
+ * node takes 2 * dims + 4 bytes.  The full precision coordinates are not 
+ * copied: searches read the caller's array to rerank their final candidates,
+ * so it must outlive the tree.  The points are split as fill_tree splits them,
+ * selecting medians over their positions, so the build needs 8 bytes per 
+ * point besides the tree.
+ * @param [in] coords The coordinates, dims per point.
+ * @param [in] num_points The number of points; at most INT_MAX.
+ * @param [in] dims The number of dimensions of each point.
+ * @return A newly malloc'd tree, which has no nodes if there are no points,
+ * or NULL if there are too many.  Release it with free_tree_q16.  Searches 
+ * report points by their position in coords.
+ */
+extern kdtree_q16 * fill_tree_q16(const double coords[], size_t num_points, 
+		size_t dims) {
+	return build_q16(coords, NULL, num_points, dims);
+}
+
+/**
+ * Builds a quantized tree as fill_tree_q16 does over single precision 
+ * coordinates.
+ * @param [in] coords The coordinates, dims per point.  Must outlive the tree.
+ * @param [in] num_points The number of points; at most INT_MAX.
+ * @param [in] dims The number of dimensions of each point.
+ * @return A newly malloc'd tree, which has no nodes if there are no points,
+ * or NULL if there are too many.
+ */
+extern kdtree_q16 * fill_tree_q16_f32(const float coords[], size_t num_points, 
+		size_t dims) {
+	return build_q16(NULL, coords, num_points, dims);
+}
+
+/**
+ * Frees a tree built by fill_tree_q16 or fill_tree_q16_f32.  The coordinates
+ * it was built over are left alone.
+ * @param [in] tree The tree to free.  May be NULL.
+ */
+extern void free_tree_q16(kdtree_q16 *tree) {
+	if (NULL == tree) {
+		return;
+	}
+	free(tree->lo);
+	free(tree->hi);
+	free(tree->cells);
+	free(tree->index);
+	free(tree);
+}
+
+/**
+ * The state of a quantized search.
+ * @param tree The tree being searched.
+ * @param search The search point.
+ * @param search_num The position of the search point, which is never its own
+ * neighbor, or -1.
+ * @param num_neighbors The maximum number of nearest neighbors.
+ * @param upper The num_neighbors smallest upper bounds on the distance to the
+ * points seen so far; the last is a bound on the distance to the 
+ * num_neighbors-th nearest neighbor once the list is full.
+ * @param upper_count The number of upper bounds in the list.
+ * @param ctx The context whose candidates array holds the points that may be
+ * among the nearest neighbors, with the lower bounds on their distances.
+ * @param num_candidates The number of candidates.
+ */
+typedef struct q16_search {
+	const kdtree_q16 *tree;
+	const double *search;
+	int search_num;
+	size_t num_neighbors;
+	best_pair *upper;
+	size_t upper_count;
+	query_context *ctx;
+	size_t num_candidates;
+} q16_search;
+
+/**
+ * Searches a quantized subtree depth first.  Each node's cell bounds its 
+ * point's distance from below and above.  Points whose lower bound is below
+ * the num_neighbors-th smallest upper bound are kept as candidates, and 
+ * subtrees whose boxes are no closer are skipped; as in nn_search, points tied
+ * with the last neighbor may be left out.
+ * @param [in] state The state of the search.
+ * @param [in] idx The position of the subtree's root.
+ * @param [in] size The number of nodes in the subtree.
+ * @param [in] depth The depth of the subtree's root.
+ * @param [in] lo The lower corner of the subtree's box.  Restored on return.
+ * @param [in] hi The upper corner of the subtree's box.  Restored on return.
+ */
+static void nn_search_q16(q16_search *state, size_t idx, size_t size, size_t depth,
+		double lo[], double hi[]) {
+	const kdtree_q16 *tree = state->tree;
+	size_t dims = tree->dims;
+	const uint16_t *cells = &tree->cells[idx * dims];
+	const double *search = state->search;
+	double lower = 0.0;
+	double upper = 0.0;
+	size_t d;
+	for (d = 0; d < dims; d++) {
+		double cell_lo, cell_hi;
+		quant_cell(lo[d], hi[d], cells[d], &cell_lo, &cell_hi);
+		double below = cell_lo - search[d];
+		double above = search[d] - cell_hi;
+		double gap = (below > 0) ? below : (above > 0) ? above : 0.0;
+		double far = (-below > -above) ? -below : -above;
+		lower += gap * gap;
+		upper += far * far;
+	}
+
+	double bound = largest_dist(state->upper, state->upper_count, state->num_neighbors);
+	if ((bound < 0 || lower < bound) && (int)tree->index[idx] != state->search_num) {
+		state->upper_count = insert_best(state->upper, state->upper_count, (int)idx, 
+				upper, state->num_neighbors);
+		query_context *ctx = state->ctx;
+		if (state->num_candidates == ctx->candidates_capacity) {
+			size_t capacity = ctx->candidates_capacity * 2;
+			best_pair *candidates = realloc(ctx->candidates, capacity * sizeof(best_pair));
+			if (NULL == candidates) {
+				fprintf(stderr, "Out of memory at %s: %d\n", __FILE__, __LINE__);
+				exit(OOM);
+			}
+			ctx->candidates = candidates;
+			ctx->candidates_capacity = capacity;
+		}
+		best_pair candidate = {(int)idx, lower};
+		ctx->candidates[state->num_candidates++] = candidate;
+	}
+	if (1 == size) {
+		return;
+	}
+
+	size_t axis = pick_axis(depth, dims);
+	double cell_lo, cell_hi;
+	quant_cell(lo[axis], hi[axis], cells[axis], &cell_lo, &cell_hi);
+	size_t left_sz = size / 2;
+	size_t right_sz = size - left_sz - 1;
+	int left_first = search[axis] < (cell_lo + cell_hi) / 2;
+	int side;
+	for (side = 0; side < 2; side++) {
+		int left = (0 == side) == left_first;
+		size_t child_sz = left ? left_sz : right_sz;
+		if (0 == child_sz) {
+			continue;
+		}
+		double *edge = left ? &hi[axis] : &lo[axis];
+		double saved = *edge;
+		*edge = left ? cell_hi : cell_lo;
+		bound = largest_dist(state->upper, state->upper_count, state->num_neighbors);
+		if (bound < 0 || box_dist(search, lo, hi, dims) < bound) {
+			nn_search_q16(state, left ? idx + 1 : idx + 1 + left_sz, child_sz, 
+					depth + 1, lo, hi);
+		}
+		*edge = saved;
+	}
+}
+
+/**
+ * Searches a quantized tree for the nearest neighbors of a point.  The 
+ * traversal only looks at the quantized cells; the candidates it leaves are
+ * then reranked by their exact distances, read from the full precision 
+ * coordinates, so the result is exact.  The lists, the box and the candidates
+ * are kept in the context, so a search in steady state allocates nothing.
+ * @param [in] tree The tree to search.
+ * @param [in] ctx The scratch space of the search.  Must have room for 
+ * num_neighbors neighbors and tree->dims coordinates.
+ * @param [in] num_neighbors The maximum number of nearest neighbors.
+ * @param [in] search The coordinates of the search point, tree->dims long.
+ * @param [in] search_num The position of the search point, which is never its
+ * own neighbor, or -1.
+ * @param [in] best_nums The positions of the nearest neighbors, nearest first.  
+ * Will be filled in by this function; slots beyond the number of points found 
+ * are set to -1.
+ */
+extern void run_nn_search_q16(const kdtree_q16 *tree, query_context *ctx, 
+		size_t num_neighbors, const double search[], int search_num, 
+		int best_nums[]) {
+	size_t found = 0;
+	size_t i, d;
+	best_pair *nearest = ctx->nearest;
+	if (NULL != tree && tree->num_nodes > 0 && num_neighbors > 0) {
+		size_t dims = tree->dims;
+		q16_search state;
+		state.tree = tree;
+		state.search = search;
+		state.search_num = search_num;
+		state.num_neighbors = num_neighbors;
+		state.upper = ctx->upper;
+		state.upper_count = 0;
+		state.ctx = ctx;
+		state.num_candidates = 0;
+		double *lo = ctx->box;
+		double *hi = &lo[dims];
+		memcpy(lo, tree->lo, dims * sizeof(double));
+		memcpy(hi, tree->hi, dims * sizeof(double));
+		nn_search_q16(&state, 0, tree->num_nodes, 0, lo, hi);
+
+		/* rerank the candidates that can still beat the final bound */
+		double bound = largest_dist(state.upper, state.upper_count, num_neighbors);
+		for (i = 0; i < state.num_candidates; i++) {
+			if (bound >= 0 && ctx->candidates[i].dist > bound) {
+				continue;
+			}
+			size_t idx = tree->index[ctx->candidates[i].node_num];
+			double dist = 0.0;
+			for (d = 0; d < dims; d++) {
+				double diff = q16_coord(tree, idx, d) - search[d];
+				dist += diff * diff;
+			}
+			found = insert_best(nearest, found, (int)idx, dist, num_neighbors);
+		}
+	}
 	for (i = 0; i < num_neighbors; i++) {
-		best_nums[i] = nearest[i].node_num;
+		best_nums[i] = (i < found) ? nearest[i].node_num : -1;
 	}
 }
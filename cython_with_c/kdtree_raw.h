@@ -15,6 +15,19 @@
  */
 #include <stdio.h>
 #include <string.h>
+#include <stdint.h>
+
+/* Build with -DKDTREE_STATS to count what searches and builds do.  Otherwise
+   the counting is compiled out and the counters stay zero. */
+#ifdef KDTREE_STATS
+#define KDTREE_STATS_ENABLED 1
+#else
+#define KDTREE_STATS_ENABLED 0
+#endif
+
+/* The number of tree levels whose build time is recorded separately; deeper
+   levels are added to the last one. */
+#define STATS_LEVELS 64
 
 /* Structs */
 
@@ -40,21 +53,325 @@ typedef struct kdtree_node kdtree_node;
  * @param point_data The information regarding node's point in k-dimensional space.
  * @param left The node's left child.
  * @param right The node's right child.
+ * @param box In trees built along a Morton curve, the bounding box of the 
+ * node's subtree, its lower corner then its upper, followed by the coordinate
+ * the subtree is split at along the node's axis; NULL in other trees, which
+ * split at the node's own coordinate.
  */
 struct kdtree_node{
 	point_data *data;
 	kdtree_node *left;
   kdtree_node *right;
+	double *box;
 };
 
+/**
+ * A randomized kd-forest: several trees over the same points, each split on 
+ * randomly chosen high-variance axes.
+ * @param trees The roots of the trees.
+ * @param num_trees The number of trees.
+ */
+typedef struct kdtree_forest {
+	kdtree_node **trees;
+	size_t num_trees;
+} kdtree_forest;
+
+/**
+ * A kd tree packed into plain arrays for the fastest depth-first searches of
+ * points in few dimensions: 8 * dims + 4 bytes per point, against the 
+ * pointers and point_data of every kdtree_node.  Laid out as kdtree_f32 is, 
+ * in double precision.  Only depth-first searches are offered on it.
+ * @param num_nodes The number of nodes.
+ * @param dims The number of dimensions.
+ * @param coords The coordinates of the nodes, dims each, in preorder.
+ * @param nums The node numbers of the nodes, in preorder.
+ */
+typedef struct kdtree_packed {
+	size_t num_nodes;
+	size_t dims;
+	double *coords;
+	int *nums;
+} kdtree_packed;
+
+/**
+ * A kd tree stored in single precision, for data that has no more than float
+ * precision; it takes 4 * dims + 4 bytes per point, a fraction of a double 
+ * tree.  The points are split at the median on axes cycled by depth, as 
+ * fill_tree splits them, and stored in preorder, so each node's split axis 
+ * and children follow from its position and need not be stored: a subtree of 
+ * n nodes at i has its left subtree of n / 2 nodes at i + 1 and its right 
+ * subtree after that.
+ * @param num_nodes The number of nodes.
+ * @param dims The number of dimensions.
+ * @param coords The coordinates of the nodes, dims each, in preorder.
+ * @param nums The node numbers of the nodes, in preorder.
+ */
+typedef struct kdtree_f32 {
+	size_t num_nodes;
+	size_t dims;
+	float *coords;
+	int *nums;
+} kdtree_f32;
+
+/**
+ * A kd tree whose nodes hold their coordinates quantized to 16 bits within 
+ * the box of their subtree, for point clouds too large for even single 
+ * precision.  Laid out as kdtree_f32 is.  Searches bound distances from the
+ * quantized cells and rerank their final candidates from the full precision
+ * coordinates, which the tree refers to but does not own.
+ * @param num_nodes The number of nodes.
+ * @param dims The number of dimensions.
+ * @param lo The lower corner of the bounding box of all points.
+ * @param hi The upper corner of the bounding box of all points.
+ * @param cells The quantized coordinates of the nodes, dims each, in preorder.
+ * @param index The position in the full precision coordinates of each node's 
+ * point, in preorder.
+ * @param coords The full precision coordinates in double precision, or NULL.
+ * @param coords_f32 The full precision coordinates in single precision, if 
+ * coords is NULL.
+ */
+typedef struct kdtree_q16 {
+	size_t num_nodes;
+	size_t dims;
+	double *lo;
+	double *hi;
+	uint16_t *cells;
+	uint32_t *index;
+	const double *coords;
+	const float *coords_f32;
+} kdtree_q16;
+
+/**
+ * A growable list of (query, reference) point pairs found by a join.
+ * @param count The number of pairs.
+ * @param capacity The number of pairs the arrays can hold.
+ * @param query_nums The node number of each pair's query point.
+ * @param ref_nums The node number of each pair's reference point.
+ * @param dists The squared distance between each pair's points.
+ */
+typedef struct pair_list {
+	size_t count;
+	size_t capacity;
+	int *query_nums;
+	int *ref_nums;
+	double *dists;
+} pair_list;
+
+/**
+ * The traversal used by a nearest neighbor search.
+ * SEARCH_DFS recurses depth first, visiting the near branch before the far one.
+ * SEARCH_BBF expands branches best-bin-first from a priority queue keyed on
+ * their lower bound distance to the search point.
+ * SEARCH_INTERLEAVED is SEARCH_DFS with the searches of a batch interleaved 
+ * so that each one's cache misses overlap the others' work.  Single searches
+ * run as SEARCH_DFS.
+ * SEARCH_PACKET carries small groups of nearby searches of a batch through 
+ * the tree together, vectorizing the work at each node across them.  It 
+ * suits low-dimensional batches whose queries are close together; the results
+ * are exact, but neighbors at equal distances may come in another order than 
+ * SEARCH_DFS gives.  Single searches run as SEARCH_DFS.
+ */
+typedef enum search_method {
+	SEARCH_DFS = 0,
+	SEARCH_BBF = 1,
+	SEARCH_INTERLEAVED = 2,
+	SEARCH_PACKET = 3
+} search_method;
+
+/**
+ * Counters of what nearest neighbor searches did.  Only counted when built
+ * with KDTREE_STATS.
+ * @param searches The number of searches.
+ * @param nodes_visited The number of nodes the searches looked at.
+ * @param leaves_visited The number of those nodes that were leaves.
+ * @param dist_evals The number of distances computed to candidate points.
+ * @param far_pruned The number of far branches skipped by the bound.
+ * @param far_descended The number of far branches searched anyway.
+ * @param max_depth The deepest recursion of a depth-first search, or the
+ * longest branch queue of a best-bin-first search.
+ */
+typedef struct search_stats {
+	size_t searches;
+	size_t nodes_visited;
+	size_t leaves_visited;
+	size_t dist_evals;
+	size_t far_pruned;
+	size_t far_descended;
+	size_t max_depth;
+} search_stats;
+
+/**
+ * What building a tree cost, level by level.  Only measured when built with
+ * KDTREE_STATS.
+ * @param levels The number of levels in the tree.
+ * @param level_nodes The number of nodes made at each level.
+ * @param level_seconds The time spent splitting the points at each level.
+ */
+typedef struct build_stats {
+	size_t levels;
+	size_t level_nodes[STATS_LEVELS];
+	double level_seconds[STATS_LEVELS];
+} build_stats;
+
+/**
+ * Scratch space for nearest neighbor searches, so that a search in steady 
+ * state allocates nothing.  A context may be reused for any number of searches
+ * of up to max_neighbors neighbors, but only by one thread at a time; keep one
+ * per thread.  The depth-first traversal recurses on the call stack, which is
+ * bounded by the tree depth; the best-bin-first traversal keeps its branches
+ * in queue, which grows as needed and is kept for the next search.
+ * @param max_neighbors The largest number of neighbors a search may ask for.
+ * @param dims The number of coordinates coords can hold.
+ * @param coords Room for the coordinates of a search point.
+ * @param best_nums The node numbers found by the last search, max_neighbors 
+ * long.
+ * @param nearest The candidate list, max_neighbors long.
+ * @param upper The quantized searches' list of upper bounds, max_neighbors 
+ * long.
+ * @param box Room for the two corners of a box of dims coordinates.
+ * @param queue The best-bin-first branch queue.
+ * @param queue_capacity The number of branches queue can hold.
+ * @param candidates The quantized searches' candidates, which grow as needed
+ * and are kept for the next search.
+ * @param candidates_capacity The number of candidates candidates can hold.
+ * @param stats The counters of every search made with this context.
+ */
+typedef struct query_context {
+	size_t max_neighbors;
+	size_t dims;
+	double *coords;
+	int *best_nums;
+	struct best_pair *nearest;
+	struct best_pair *upper;
+	double *box;
+	struct branch *queue;
+	size_t queue_capacity;
+	struct best_pair *candidates;
+	size_t candidates_capacity;
+	search_stats stats;
+} query_context;
+
+/**
+ * The state of an incremental nearest neighbor search, which hands out a 
+ * tree's points one at a time in order of distance.  Made by 
+ * new_neighbor_iter.
+ */
+typedef struct neighbor_iter neighbor_iter;
+
 /* prototypes */
 extern void run_nn_search(kdtree_node *root, 
 		size_t num_neighbors, 
 		point_data pd, 
 		int best_nums[]);
 
+extern size_t tree_size(const kdtree_node *node);
+
+extern size_t knn_graph(kdtree_node *root, 
+		size_t num_neighbors,
+		int nums[],
+		int best_nums[],
+		double best_dists[]);
+
+extern size_t knn_join(kdtree_node *query_root,
+		kdtree_node *ref_root,
+		size_t num_neighbors,
+		int nums[],
+		int best_nums[],
+		double best_dists[]);
+
+extern pair_list * radius_join(kdtree_node *query_root,
+		kdtree_node *ref_root,
+		double sq_radius);
+
+extern void free_pair_list(pair_list *pairs);
+
+extern void run_nn_search_method(kdtree_node *root, 
+		size_t num_neighbors, 
+		point_data pd, 
+		int best_nums[],
+		search_method method);
+
+extern query_context * new_query_context(size_t max_neighbors, size_t dims);
+
+extern void free_query_context(query_context *ctx);
+
+extern void run_nn_search_context(kdtree_node *root, 
+		query_context *ctx,
+		size_t num_neighbors, 
+		const point_data *search, 
+		search_method method);
+
+extern void run_forest_search_context(kdtree_forest *forest, 
+		query_context *ctx,
+		size_t num_neighbors, 
+		const point_data *search, 
+		size_t max_checks);
+
+extern void run_nn_search_batch(kdtree_node *root, 
+		size_t num_neighbors, 
+		point_data **searches,
+		size_t num_searches,
+		int best_nums[],
+		search_method method,
+		search_stats *stats);
+
+extern neighbor_iter * new_neighbor_iter(const kdtree_node *root, 
+		const point_data *search);
+
+extern int next_neighbor(neighbor_iter *iter, int *num, double *dist);
+
+extern void free_neighbor_iter(neighbor_iter *iter);
+
 extern kdtree_node * fill_tree(point_data **points, size_t num_points);
+extern kdtree_node * fill_tree_coords(const double coords[], const int nums[], 
+		size_t num_points, size_t dims);
+extern kdtree_node * fill_tree_shape(const double coords[], const int nums[], 
+		const long left[], const long right[], size_t num_nodes, size_t dims);
+extern kdtree_node * fill_tree_morton(point_data **points, size_t num_points);
+extern kdtree_node * fill_tree_presorted(point_data **points, size_t num_points);
+extern kdtree_node * layout_tree_veb(kdtree_node *root);
 
 extern void free_tree(kdtree_node * node);
 
+extern kdtree_forest * fill_forest(point_data **points, size_t num_points, 
+		size_t num_trees, unsigned long seed);
+
+extern void free_forest(kdtree_forest *forest);
+
+extern void run_forest_search(kdtree_forest *forest, 
+		size_t num_neighbors, 
+		point_data search, 
+		int best_nums[],
+		size_t max_checks);
+
 extern double sqdist(double a[], double b[], size_t dims);
+
+extern void add_search_stats(search_stats *total, const search_stats *stats);
+
+extern void get_build_stats(build_stats *stats);
+
+extern kdtree_packed * fill_tree_packed(const double coords[], const int nums[], 
+		size_t num_points, size_t dims);
+extern void free_tree_packed(kdtree_packed *tree);
+extern void run_nn_search_packed(const kdtree_packed *tree, size_t num_neighbors,
+		const double search[], int search_num, int best_nums[]);
+extern void run_nn_search_packed_batch(const kdtree_packed *tree, 
+		size_t num_neighbors, 
+		point_data **searches,
+		size_t num_searches,
+		int best_nums[]);
+
+extern kdtree_f32 * fill_tree_f32(const float coords[], const int nums[], 
+		size_t num_points, size_t dims);
+extern void free_tree_f32(kdtree_f32 *tree);
+extern void run_nn_search_f32(const kdtree_f32 *tree, size_t num_neighbors,
+		const double search[], int search_num, int best_nums[], int exact);
+
+extern kdtree_q16 * fill_tree_q16(const double coords[], size_t num_points, 
+		size_t dims);
+extern kdtree_q16 * fill_tree_q16_f32(const float coords[], size_t num_points, 
+		size_t dims);
+extern void free_tree_q16(kdtree_q16 *tree);
+extern void run_nn_search_q16(const kdtree_q16 *tree, query_context *ctx, 
+		size_t num_neighbors, const double search[], int search_num, 
+		int best_nums[]);
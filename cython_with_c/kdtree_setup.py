@@ -1,13 +1,47 @@
+import os
+import shutil
+import tempfile
+from distutils.ccompiler import new_compiler
+from distutils.errors import CompileError, LinkError
+from distutils.sysconfig import customize_compiler
 from distutils.core import setup, Extension
 from Cython.Distutils import build_ext
 #from distutils.extension import Extension
 
+
+def openmp_flags():
+    """Returns ['-fopenmp'] if the compiler builds and links a small OpenMP
+    program, and [] otherwise, so compilers without OpenMP, such as Apple's
+    clang, still build the module, single threaded."""
+    tmp = tempfile.mkdtemp()
+    try:
+        source = os.path.join(tmp, 'omp.c')
+        with open(source, 'w') as f:
+            f.write('#include <omp.h>\n'
+                    'int main(void) { return omp_get_max_threads() > 0 ? 0 : 1; }\n')
+        compiler = new_compiler()
+        customize_compiler(compiler)
+        try:
+            objects = compiler.compile([source], output_dir=tmp,
+                                       extra_postargs=['-fopenmp'])
+            compiler.link_executable(objects, os.path.join(tmp, 'omp'),
+                                     extra_postargs=['-fopenmp'])
+        except (CompileError, LinkError):
+            return []
+        return ['-fopenmp']
+    finally:
+        shutil.rmtree(tmp)
+
 sourcefiles = ['kdtree.pyx', 'kdtree_raw.c']
 #sourcefiles = ['kdtree_raw.c']
+openmp = openmp_flags()
 
 setup(
   name="kdtree", version="1.0",
   cmdclass = {'build_ext': build_ext},
-  ext_modules = [Extension("kdtree", sourcefiles)]
+  ext_modules = [Extension("kdtree", sourcefiles,
+                           # the forest builds its trees in parallel
+                           extra_compile_args=openmp,
+                           extra_link_args=openmp)]
 )
 
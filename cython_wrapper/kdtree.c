@@ -1,4974 +0,0 @@
-/* Generated by Cython 0.12.1 on Sun Mar 27 00:47:25 2011 */
-
-#define PY_SSIZE_T_CLEAN
-#include "Python.h"
-#include "structmember.h"
-#ifndef Py_PYTHON_H
-    #error Python headers needed to compile C extensions, please install development version of Python.
-#else
-
-#ifndef PY_LONG_LONG
-  #define PY_LONG_LONG LONG_LONG
-#endif
-#ifndef DL_EXPORT
-  #define DL_EXPORT(t) t
-#endif
-#if PY_VERSION_HEX < 0x02040000
-  #define METH_COEXIST 0
-  #define PyDict_CheckExact(op) (Py_TYPE(op) == &PyDict_Type)
-  #define PyDict_Contains(d,o)   PySequence_Contains(d,o)
-#endif
-
-#if PY_VERSION_HEX < 0x02050000
-  typedef int Py_ssize_t;
-  #define PY_SSIZE_T_MAX INT_MAX
-  #define PY_SSIZE_T_MIN INT_MIN
-  #define PY_FORMAT_SIZE_T ""
-  #define PyInt_FromSsize_t(z) PyInt_FromLong(z)
-  #define PyInt_AsSsize_t(o)   PyInt_AsLong(o)
-  #define PyNumber_Index(o)    PyNumber_Int(o)
-  #define PyIndex_Check(o)     PyNumber_Check(o)
-  #define PyErr_WarnEx(category, message, stacklevel) PyErr_Warn(category, message)
-#endif
-
-#if PY_VERSION_HEX < 0x02060000
-  #define Py_REFCNT(ob) (((PyObject*)(ob))->ob_refcnt)
-  #define Py_TYPE(ob)   (((PyObject*)(ob))->ob_type)
-  #define Py_SIZE(ob)   (((PyVarObject*)(ob))->ob_size)
-  #define PyVarObject_HEAD_INIT(type, size) \
-          PyObject_HEAD_INIT(type) size,
-  #define PyType_Modified(t)
-
-  typedef struct {
-     void *buf;
-     PyObject *obj;
-     Py_ssize_t len;
-     Py_ssize_t itemsize;
-     int readonly;
-     int ndim;
-     char *format;
-     Py_ssize_t *shape;
-     Py_ssize_t *strides;
-     Py_ssize_t *suboffsets;
-     void *internal;
-  } Py_buffer;
-
-  #define PyBUF_SIMPLE 0
-  #define PyBUF_WRITABLE 0x0001
-  #define PyBUF_FORMAT 0x0004
-  #define PyBUF_ND 0x0008
-  #define PyBUF_STRIDES (0x0010 | PyBUF_ND)
-  #define PyBUF_C_CONTIGUOUS (0x0020 | PyBUF_STRIDES)
-  #define PyBUF_F_CONTIGUOUS (0x0040 | PyBUF_STRIDES)
-  #define PyBUF_ANY_CONTIGUOUS (0x0080 | PyBUF_STRIDES)
-  #define PyBUF_INDIRECT (0x0100 | PyBUF_STRIDES)
-
-#endif
-
-#if PY_MAJOR_VERSION < 3
-  #define __Pyx_BUILTIN_MODULE_NAME "__builtin__"
-#else
-  #define __Pyx_BUILTIN_MODULE_NAME "builtins"
-#endif
-
-#if PY_MAJOR_VERSION >= 3
-  #define Py_TPFLAGS_CHECKTYPES 0
-  #define Py_TPFLAGS_HAVE_INDEX 0
-#endif
-
-#if (PY_VERSION_HEX < 0x02060000) || (PY_MAJOR_VERSION >= 3)
-  #define Py_TPFLAGS_HAVE_NEWBUFFER 0
-#endif
-
-#if PY_MAJOR_VERSION >= 3
-  #define PyBaseString_Type            PyUnicode_Type
-  #define PyString_Type                PyUnicode_Type
-  #define PyString_CheckExact          PyUnicode_CheckExact
-#else
-  #define PyBytes_Type                 PyString_Type
-  #define PyBytes_CheckExact           PyString_CheckExact
-#endif
-
-#if PY_MAJOR_VERSION >= 3
-  #define PyInt_Type                   PyLong_Type
-  #define PyInt_Check(op)              PyLong_Check(op)
-  #define PyInt_CheckExact(op)         PyLong_CheckExact(op)
-  #define PyInt_FromString             PyLong_FromString
-  #define PyInt_FromUnicode            PyLong_FromUnicode
-  #define PyInt_FromLong               PyLong_FromLong
-  #define PyInt_FromSize_t             PyLong_FromSize_t
-  #define PyInt_FromSsize_t            PyLong_FromSsize_t
-  #define PyInt_AsLong                 PyLong_AsLong
-  #define PyInt_AS_LONG                PyLong_AS_LONG
-  #define PyInt_AsSsize_t              PyLong_AsSsize_t
-  #define PyInt_AsUnsignedLongMask     PyLong_AsUnsignedLongMask
-  #define PyInt_AsUnsignedLongLongMask PyLong_AsUnsignedLongLongMask
-  #define __Pyx_PyNumber_Divide(x,y)         PyNumber_TrueDivide(x,y)
-  #define __Pyx_PyNumber_InPlaceDivide(x,y)  PyNumber_InPlaceTrueDivide(x,y)
-#else
-  #define __Pyx_PyNumber_Divide(x,y)         PyNumber_Divide(x,y)
-  #define __Pyx_PyNumber_InPlaceDivide(x,y)  PyNumber_InPlaceDivide(x,y)
-
-#endif
-
-#if PY_MAJOR_VERSION >= 3
-  #define PyMethod_New(func, self, klass) PyInstanceMethod_New(func)
-#endif
-
-#if !defined(WIN32) && !defined(MS_WINDOWS)
-  #ifndef __stdcall
-    #define __stdcall
-  #endif
-  #ifndef __cdecl
-    #define __cdecl
-  #endif
-  #ifndef __fastcall
-    #define __fastcall
-  #endif
-#else
-  #define _USE_MATH_DEFINES
-#endif
-
-#if PY_VERSION_HEX < 0x02050000
-  #define __Pyx_GetAttrString(o,n)   PyObject_GetAttrString((o),((char *)(n)))
-  #define __Pyx_SetAttrString(o,n,a) PyObject_SetAttrString((o),((char *)(n)),(a))
-  #define __Pyx_DelAttrString(o,n)   PyObject_DelAttrString((o),((char *)(n)))
-#else
-  #define __Pyx_GetAttrString(o,n)   PyObject_GetAttrString((o),(n))
-  #define __Pyx_SetAttrString(o,n,a) PyObject_SetAttrString((o),(n),(a))
-  #define __Pyx_DelAttrString(o,n)   PyObject_DelAttrString((o),(n))
-#endif
-
-#if PY_VERSION_HEX < 0x02050000
-  #define __Pyx_NAMESTR(n) ((char *)(n))
-  #define __Pyx_DOCSTR(n)  ((char *)(n))
-#else
-  #define __Pyx_NAMESTR(n) (n)
-  #define __Pyx_DOCSTR(n)  (n)
-#endif
-#ifdef __cplusplus
-#define __PYX_EXTERN_C extern "C"
-#else
-#define __PYX_EXTERN_C extern
-#endif
-#include <math.h>
-#define __PYX_HAVE_API__kdtree
-#include "stdlib.h"
-
-#ifndef CYTHON_INLINE
-  #if defined(__GNUC__)
-    #define CYTHON_INLINE __inline__
-  #elif defined(_MSC_VER)
-    #define CYTHON_INLINE __inline
-  #else
-    #define CYTHON_INLINE 
-  #endif
-#endif
-
-typedef struct {PyObject **p; char *s; const long n; const char* encoding; const char is_unicode; const char is_str; const char intern; } __Pyx_StringTabEntry; /*proto*/
-
-
-/* Type Conversion Predeclarations */
-
-#if PY_MAJOR_VERSION < 3
-#define __Pyx_PyBytes_FromString          PyString_FromString
-#define __Pyx_PyBytes_FromStringAndSize   PyString_FromStringAndSize
-#define __Pyx_PyBytes_AsString            PyString_AsString
-#else
-#define __Pyx_PyBytes_FromString          PyBytes_FromString
-#define __Pyx_PyBytes_FromStringAndSize   PyBytes_FromStringAndSize
-#define __Pyx_PyBytes_AsString            PyBytes_AsString
-#endif
-
-#define __Pyx_PyBytes_FromUString(s)      __Pyx_PyBytes_FromString((char*)s)
-#define __Pyx_PyBytes_AsUString(s)        ((unsigned char*) __Pyx_PyBytes_AsString(s))
-
-#define __Pyx_PyBool_FromLong(b) ((b) ? (Py_INCREF(Py_True), Py_True) : (Py_INCREF(Py_False), Py_False))
-static CYTHON_INLINE int __Pyx_PyObject_IsTrue(PyObject*);
-static CYTHON_INLINE PyObject* __Pyx_PyNumber_Int(PyObject* x);
-
-#if !defined(T_PYSSIZET)
-#if PY_VERSION_HEX < 0x02050000
-#define T_PYSSIZET T_INT
-#elif !defined(T_LONGLONG)
-#define T_PYSSIZET \
-        ((sizeof(Py_ssize_t) == sizeof(int))  ? T_INT  : \
-        ((sizeof(Py_ssize_t) == sizeof(long)) ? T_LONG : -1))
-#else
-#define T_PYSSIZET \
-        ((sizeof(Py_ssize_t) == sizeof(int))          ? T_INT      : \
-        ((sizeof(Py_ssize_t) == sizeof(long))         ? T_LONG     : \
-        ((sizeof(Py_ssize_t) == sizeof(PY_LONG_LONG)) ? T_LONGLONG : -1)))
-#endif
-#endif
-
-
-#if !defined(T_ULONGLONG)
-#define __Pyx_T_UNSIGNED_INT(x) \
-        ((sizeof(x) == sizeof(unsigned char))  ? T_UBYTE : \
-        ((sizeof(x) == sizeof(unsigned short)) ? T_USHORT : \
-        ((sizeof(x) == sizeof(unsigned int))   ? T_UINT : \
-        ((sizeof(x) == sizeof(unsigned long))  ? T_ULONG : -1))))
-#else
-#define __Pyx_T_UNSIGNED_INT(x) \
-        ((sizeof(x) == sizeof(unsigned char))  ? T_UBYTE : \
-        ((sizeof(x) == sizeof(unsigned short)) ? T_USHORT : \
-        ((sizeof(x) == sizeof(unsigned int))   ? T_UINT : \
-        ((sizeof(x) == sizeof(unsigned long))  ? T_ULONG : \
-        ((sizeof(x) == sizeof(unsigned PY_LONG_LONG)) ? T_ULONGLONG : -1)))))
-#endif
-#if !defined(T_LONGLONG)
-#define __Pyx_T_SIGNED_INT(x) \
-        ((sizeof(x) == sizeof(char))  ? T_BYTE : \
-        ((sizeof(x) == sizeof(short)) ? T_SHORT : \
-        ((sizeof(x) == sizeof(int))   ? T_INT : \
-        ((sizeof(x) == sizeof(long))  ? T_LONG : -1))))
-#else
-#define __Pyx_T_SIGNED_INT(x) \
-        ((sizeof(x) == sizeof(char))  ? T_BYTE : \
-        ((sizeof(x) == sizeof(short)) ? T_SHORT : \
-        ((sizeof(x) == sizeof(int))   ? T_INT : \
-        ((sizeof(x) == sizeof(long))  ? T_LONG : \
-        ((sizeof(x) == sizeof(PY_LONG_LONG))   ? T_LONGLONG : -1)))))
-#endif
-
-#define __Pyx_T_FLOATING(x) \
-        ((sizeof(x) == sizeof(float)) ? T_FLOAT : \
-        ((sizeof(x) == sizeof(double)) ? T_DOUBLE : -1))
-
-#if !defined(T_SIZET)
-#if !defined(T_ULONGLONG)
-#define T_SIZET \
-        ((sizeof(size_t) == sizeof(unsigned int))  ? T_UINT  : \
-        ((sizeof(size_t) == sizeof(unsigned long)) ? T_ULONG : -1))
-#else
-#define T_SIZET \
-        ((sizeof(size_t) == sizeof(unsigned int))          ? T_UINT      : \
-        ((sizeof(size_t) == sizeof(unsigned long))         ? T_ULONG     : \
-        ((sizeof(size_t) == sizeof(unsigned PY_LONG_LONG)) ? T_ULONGLONG : -1)))
-#endif
-#endif
-
-static CYTHON_INLINE Py_ssize_t __Pyx_PyIndex_AsSsize_t(PyObject*);
-static CYTHON_INLINE PyObject * __Pyx_PyInt_FromSize_t(size_t);
-static CYTHON_INLINE size_t __Pyx_PyInt_AsSize_t(PyObject*);
-
-#define __pyx_PyFloat_AsDouble(x) (PyFloat_CheckExact(x) ? PyFloat_AS_DOUBLE(x) : PyFloat_AsDouble(x))
-
-
-#ifdef __GNUC__
-/* Test for GCC > 2.95 */
-#if __GNUC__ > 2 ||               (__GNUC__ == 2 && (__GNUC_MINOR__ > 95)) 
-#define likely(x)   __builtin_expect(!!(x), 1)
-#define unlikely(x) __builtin_expect(!!(x), 0)
-#else /* __GNUC__ > 2 ... */
-#define likely(x)   (x)
-#define unlikely(x) (x)
-#endif /* __GNUC__ > 2 ... */
-#else /* __GNUC__ */
-#define likely(x)   (x)
-#define unlikely(x) (x)
-#endif /* __GNUC__ */
-    
-static PyObject *__pyx_m;
-static PyObject *__pyx_b;
-static PyObject *__pyx_empty_tuple;
-static PyObject *__pyx_empty_bytes;
-static int __pyx_lineno;
-static int __pyx_clineno = 0;
-static const char * __pyx_cfilenm= __FILE__;
-static const char *__pyx_filename;
-static const char **__pyx_f;
-
-
-/* Type declarations */
-
-/* "/home/belisarius/github/py_kdtree/cython_wrapper/kdtree.pyx":27
- *   void* malloc(size_t size)
- * 
- * cdef struct best_pair:             # <<<<<<<<<<<<<<
- *   int node_num
- *   double dist
- */
-
-struct __pyx_t_6kdtree_best_pair {
-  int node_num;
-  double dist;
-};
-
-/* "/home/belisarius/github/py_kdtree/cython_wrapper/kdtree.pyx":33
- * # Note that taking the extra effort to make this a cdef class makes a 5x difference
- * # in runtime speed on 100k rows
- * cdef class PointData:             # <<<<<<<<<<<<<<
- *   """Representation of point data.  Exists so we can sort without lambda key,
- *   which Cython does not support."""
- */
-
-struct __pyx_obj_6kdtree_PointData {
-  PyObject_HEAD
-  int num;
-  size_t curr_axis;
-  PyObject *coords;
-  size_t dims;
-};
-
-/* "/home/belisarius/github/py_kdtree/cython_wrapper/kdtree.pyx":87
- *       self.coords = value
- * 
- * cdef class KDTreeNode:             # <<<<<<<<<<<<<<
- *   """A C extension class to the KDTree C code"""
- *   cdef PointData data
- */
-
-struct __pyx_obj_6kdtree_KDTreeNode {
-  PyObject_HEAD
-  struct __pyx_vtabstruct_6kdtree_KDTreeNode *__pyx_vtab;
-  struct __pyx_obj_6kdtree_PointData *data;
-  struct __pyx_obj_6kdtree_KDTreeNode *left;
-  struct __pyx_obj_6kdtree_KDTreeNode *right;
-};
-
-
-struct __pyx_vtabstruct_6kdtree_KDTreeNode {
-  PyObject *(*run_nn_search)(struct __pyx_obj_6kdtree_KDTreeNode *, struct __pyx_obj_6kdtree_PointData *, size_t, int __pyx_skip_dispatch);
-};
-static struct __pyx_vtabstruct_6kdtree_KDTreeNode *__pyx_vtabptr_6kdtree_KDTreeNode;
-
-#ifndef CYTHON_REFNANNY
-  #define CYTHON_REFNANNY 0
-#endif
-
-#if CYTHON_REFNANNY
-  typedef struct {
-    void (*INCREF)(void*, PyObject*, int);
-    void (*DECREF)(void*, PyObject*, int);
-    void (*GOTREF)(void*, PyObject*, int);
-    void (*GIVEREF)(void*, PyObject*, int);
-    void* (*SetupContext)(const char*, int, const char*);
-    void (*FinishContext)(void**);
-  } __Pyx_RefNannyAPIStruct;
-  static __Pyx_RefNannyAPIStruct *__Pyx_RefNanny = NULL;
-  static __Pyx_RefNannyAPIStruct * __Pyx_RefNannyImportAPI(const char *modname) {
-    PyObject *m = NULL, *p = NULL;
-    void *r = NULL;
-    m = PyImport_ImportModule((char *)modname);
-    if (!m) goto end;
-    p = PyObject_GetAttrString(m, (char *)"RefNannyAPI");
-    if (!p) goto end;
-    r = PyLong_AsVoidPtr(p);
-  end:
-    Py_XDECREF(p);
-    Py_XDECREF(m);
-    return (__Pyx_RefNannyAPIStruct *)r;
-  }
-  #define __Pyx_RefNannySetupContext(name)           void *__pyx_refnanny = __Pyx_RefNanny->SetupContext((name), __LINE__, __FILE__)
-  #define __Pyx_RefNannyFinishContext()           __Pyx_RefNanny->FinishContext(&__pyx_refnanny)
-  #define __Pyx_INCREF(r) __Pyx_RefNanny->INCREF(__pyx_refnanny, (PyObject *)(r), __LINE__)
-  #define __Pyx_DECREF(r) __Pyx_RefNanny->DECREF(__pyx_refnanny, (PyObject *)(r), __LINE__)
-  #define __Pyx_GOTREF(r) __Pyx_RefNanny->GOTREF(__pyx_refnanny, (PyObject *)(r), __LINE__)
-  #define __Pyx_GIVEREF(r) __Pyx_RefNanny->GIVEREF(__pyx_refnanny, (PyObject *)(r), __LINE__)
-  #define __Pyx_XDECREF(r) do { if((r) != NULL) {__Pyx_DECREF(r);} } while(0)
-#else
-  #define __Pyx_RefNannySetupContext(name)
-  #define __Pyx_RefNannyFinishContext()
-  #define __Pyx_INCREF(r) Py_INCREF(r)
-  #define __Pyx_DECREF(r) Py_DECREF(r)
-  #define __Pyx_GOTREF(r)
-  #define __Pyx_GIVEREF(r)
-  #define __Pyx_XDECREF(r) Py_XDECREF(r)
-#endif /* CYTHON_REFNANNY */
-#define __Pyx_XGIVEREF(r) do { if((r) != NULL) {__Pyx_GIVEREF(r);} } while(0)
-#define __Pyx_XGOTREF(r) do { if((r) != NULL) {__Pyx_GOTREF(r);} } while(0)
-
-static void __Pyx_RaiseDoubleKeywordsError(
-    const char* func_name, PyObject* kw_name); /*proto*/
-
-static void __Pyx_RaiseArgtupleInvalid(const char* func_name, int exact,
-    Py_ssize_t num_min, Py_ssize_t num_max, Py_ssize_t num_found); /*proto*/
-
-static int __Pyx_ParseOptionalKeywords(PyObject *kwds, PyObject **argnames[],     PyObject *kwds2, PyObject *values[], Py_ssize_t num_pos_args,     const char* function_name); /*proto*/
-
-static CYTHON_INLINE PyObject* __Pyx_PyObject_Append(PyObject* L, PyObject* x) {
-    if (likely(PyList_CheckExact(L))) {
-        if (PyList_Append(L, x) < 0) return NULL;
-        Py_INCREF(Py_None);
-        return Py_None; /* this is just to have an accurate signature */
-    }
-    else {
-        PyObject *r, *m;
-        m = __Pyx_GetAttrString(L, "append");
-        if (!m) return NULL;
-        r = PyObject_CallFunctionObjArgs(m, x, NULL);
-        Py_DECREF(m);
-        return r;
-    }
-}
-
-static CYTHON_INLINE void __Pyx_ErrRestore(PyObject *type, PyObject *value, PyObject *tb); /*proto*/
-static CYTHON_INLINE void __Pyx_ErrFetch(PyObject **type, PyObject **value, PyObject **tb); /*proto*/
-
-
-static CYTHON_INLINE PyObject *__Pyx_GetItemInt_Generic(PyObject *o, PyObject* j) {
-    PyObject *r;
-    if (!j) return NULL;
-    r = PyObject_GetItem(o, j);
-    Py_DECREF(j);
-    return r;
-}
-
-
-#define __Pyx_GetItemInt_List(o, i, size, to_py_func) ((size <= sizeof(Py_ssize_t)) ? \
-                                                    __Pyx_GetItemInt_List_Fast(o, i, size <= sizeof(long)) : \
-                                                    __Pyx_GetItemInt_Generic(o, to_py_func(i)))
-
-static CYTHON_INLINE PyObject *__Pyx_GetItemInt_List_Fast(PyObject *o, Py_ssize_t i, int fits_long) {
-    if (likely(o != Py_None)) {
-        if (likely((0 <= i) & (i < PyList_GET_SIZE(o)))) {
-            PyObject *r = PyList_GET_ITEM(o, i);
-            Py_INCREF(r);
-            return r;
-        }
-        else if ((-PyList_GET_SIZE(o) <= i) & (i < 0)) {
-            PyObject *r = PyList_GET_ITEM(o, PyList_GET_SIZE(o) + i);
-            Py_INCREF(r);
-            return r;
-        }
-    }
-    return __Pyx_GetItemInt_Generic(o, fits_long ? PyInt_FromLong(i) : PyLong_FromLongLong(i));
-}
-
-#define __Pyx_GetItemInt_Tuple(o, i, size, to_py_func) ((size <= sizeof(Py_ssize_t)) ? \
-                                                    __Pyx_GetItemInt_Tuple_Fast(o, i, size <= sizeof(long)) : \
-                                                    __Pyx_GetItemInt_Generic(o, to_py_func(i)))
-
-static CYTHON_INLINE PyObject *__Pyx_GetItemInt_Tuple_Fast(PyObject *o, Py_ssize_t i, int fits_long) {
-    if (likely(o != Py_None)) {
-        if (likely((0 <= i) & (i < PyTuple_GET_SIZE(o)))) {
-            PyObject *r = PyTuple_GET_ITEM(o, i);
-            Py_INCREF(r);
-            return r;
-        }
-        else if ((-PyTuple_GET_SIZE(o) <= i) & (i < 0)) {
-            PyObject *r = PyTuple_GET_ITEM(o, PyTuple_GET_SIZE(o) + i);
-            Py_INCREF(r);
-            return r;
-        }
-    }
-    return __Pyx_GetItemInt_Generic(o, fits_long ? PyInt_FromLong(i) : PyLong_FromLongLong(i));
-}
-
-
-#define __Pyx_GetItemInt(o, i, size, to_py_func) ((size <= sizeof(Py_ssize_t)) ? \
-                                                    __Pyx_GetItemInt_Fast(o, i, size <= sizeof(long)) : \
-                                                    __Pyx_GetItemInt_Generic(o, to_py_func(i)))
-
-static CYTHON_INLINE PyObject *__Pyx_GetItemInt_Fast(PyObject *o, Py_ssize_t i, int fits_long) {
-    PyObject *r;
-    if (PyList_CheckExact(o) && ((0 <= i) & (i < PyList_GET_SIZE(o)))) {
-        r = PyList_GET_ITEM(o, i);
-        Py_INCREF(r);
-    }
-    else if (PyTuple_CheckExact(o) && ((0 <= i) & (i < PyTuple_GET_SIZE(o)))) {
-        r = PyTuple_GET_ITEM(o, i);
-        Py_INCREF(r);
-    }
-    else if (Py_TYPE(o)->tp_as_sequence && Py_TYPE(o)->tp_as_sequence->sq_item && (likely(i >= 0))) {
-        r = PySequence_GetItem(o, i);
-    }
-    else {
-        r = __Pyx_GetItemInt_Generic(o, fits_long ? PyInt_FromLong(i) : PyLong_FromLongLong(i));
-    }
-    return r;
-}
-
-static CYTHON_INLINE int __Pyx_TypeTest(PyObject *obj, PyTypeObject *type); /*proto*/
-
-static CYTHON_INLINE Py_ssize_t __Pyx_div_Py_ssize_t(Py_ssize_t, Py_ssize_t); /* proto */
-
-static int __Pyx_ArgTypeTest(PyObject *obj, PyTypeObject *type, int none_allowed,
-    const char *name, int exact); /*proto*/
-
-static PyObject *__Pyx_Import(PyObject *name, PyObject *from_list); /*proto*/
-
-static PyObject *__Pyx_GetName(PyObject *dict, PyObject *name); /*proto*/
-
-static void __Pyx_Raise(PyObject *type, PyObject *value, PyObject *tb); /*proto*/
-
-static int __Pyx_Print(PyObject *, int); /*proto*/
-#if PY_MAJOR_VERSION >= 3
-static PyObject* __pyx_print = 0;
-static PyObject* __pyx_print_kwargs = 0;
-#endif
-
-static int __Pyx_PrintOne(PyObject *o); /*proto*/
-
-static CYTHON_INLINE unsigned char __Pyx_PyInt_AsUnsignedChar(PyObject *);
-
-static CYTHON_INLINE unsigned short __Pyx_PyInt_AsUnsignedShort(PyObject *);
-
-static CYTHON_INLINE unsigned int __Pyx_PyInt_AsUnsignedInt(PyObject *);
-
-static CYTHON_INLINE char __Pyx_PyInt_AsChar(PyObject *);
-
-static CYTHON_INLINE short __Pyx_PyInt_AsShort(PyObject *);
-
-static CYTHON_INLINE int __Pyx_PyInt_AsInt(PyObject *);
-
-static CYTHON_INLINE signed char __Pyx_PyInt_AsSignedChar(PyObject *);
-
-static CYTHON_INLINE signed short __Pyx_PyInt_AsSignedShort(PyObject *);
-
-static CYTHON_INLINE signed int __Pyx_PyInt_AsSignedInt(PyObject *);
-
-static CYTHON_INLINE unsigned long __Pyx_PyInt_AsUnsignedLong(PyObject *);
-
-static CYTHON_INLINE unsigned PY_LONG_LONG __Pyx_PyInt_AsUnsignedLongLong(PyObject *);
-
-static CYTHON_INLINE long __Pyx_PyInt_AsLong(PyObject *);
-
-static CYTHON_INLINE PY_LONG_LONG __Pyx_PyInt_AsLongLong(PyObject *);
-
-static CYTHON_INLINE signed long __Pyx_PyInt_AsSignedLong(PyObject *);
-
-static CYTHON_INLINE signed PY_LONG_LONG __Pyx_PyInt_AsSignedLongLong(PyObject *);
-
-static void __Pyx_WriteUnraisable(const char *name); /*proto*/
-
-static int __Pyx_SetVtable(PyObject *dict, void *vtable); /*proto*/
-
-static void __Pyx_AddTraceback(const char *funcname); /*proto*/
-
-static int __Pyx_InitStrings(__Pyx_StringTabEntry *t); /*proto*/
-/* Module declarations from kdtree */
-
-static PyTypeObject *__pyx_ptype_6kdtree_PointData = 0;
-static PyTypeObject *__pyx_ptype_6kdtree_KDTreeNode = 0;
-static PyObject *__pyx_f_6kdtree_print_preorder(struct __pyx_obj_6kdtree_KDTreeNode *, int __pyx_skip_dispatch); /*proto*/
-static struct __pyx_obj_6kdtree_KDTreeNode *__pyx_f_6kdtree_fill_tree_r(PyObject *, size_t); /*proto*/
-static struct __pyx_obj_6kdtree_KDTreeNode *__pyx_f_6kdtree_fill_tree(PyObject *, int __pyx_skip_dispatch); /*proto*/
-static size_t __pyx_f_6kdtree_pick_axis(size_t, size_t); /*proto*/
-static size_t __pyx_f_6kdtree_nn_search(struct __pyx_obj_6kdtree_KDTreeNode *, struct __pyx_obj_6kdtree_PointData *, struct __pyx_t_6kdtree_best_pair *, size_t, size_t, size_t); /*proto*/
-static CYTHON_INLINE double __pyx_f_6kdtree_sqdist(PyObject *, PyObject *, size_t); /*proto*/
-static size_t __pyx_f_6kdtree_add_best(struct __pyx_t_6kdtree_best_pair *, size_t, int, PyObject *, PyObject *, size_t, size_t); /*proto*/
-#define __Pyx_MODULE_NAME "kdtree"
-int __pyx_module_is_main_kdtree = 0;
-
-/* Implementation of kdtree */
-static PyObject *__pyx_builtin_MemoryError;
-static PyObject *__pyx_builtin_xrange;
-static char __pyx_k_1[] = "%d, %s";
-static char __pyx_k_2[] = "%d [%f,%f]";
-static char __pyx_k_3[] = "KDTreeNode.__init__ (line 93)";
-static char __pyx_k_4[] = "KDTreeNode.run_nn_search (line 111)";
-static char __pyx_k_5[] = "print_preorder (line 137)";
-static char __pyx_k_6[] = "fill_tree (line 169)";
-static char __pyx_k__d[] = "d";
-static char __pyx_k__num[] = "num";
-static char __pyx_k__data[] = "data";
-static char __pyx_k__dims[] = "dims";
-static char __pyx_k__dist[] = "dist";
-static char __pyx_k__left[] = "left";
-static char __pyx_k__sort[] = "sort";
-static char __pyx_k__array[] = "array";
-static char __pyx_k__range[] = "range";
-static char __pyx_k__right[] = "right";
-static char __pyx_k__coords[] = "coords";
-static char __pyx_k__number[] = "number";
-static char __pyx_k__search[] = "search";
-static char __pyx_k__xrange[] = "xrange";
-static char __pyx_k____init__[] = "__init__";
-static char __pyx_k____main__[] = "__main__";
-static char __pyx_k____test__[] = "__test__";
-static char __pyx_k__node_num[] = "node_num";
-static char __pyx_k__curr_axis[] = "curr_axis";
-static char __pyx_k__fill_tree[] = "fill_tree";
-static char __pyx_k__KDTreeNode[] = "KDTreeNode";
-static char __pyx_k__MemoryError[] = "MemoryError";
-static char __pyx_k__num_neighbors[] = "num_neighbors";
-static char __pyx_k__run_nn_search[] = "run_nn_search";
-static char __pyx_k__print_preorder[] = "print_preorder";
-static PyObject *__pyx_kp_s_1;
-static PyObject *__pyx_kp_s_2;
-static PyObject *__pyx_kp_u_3;
-static PyObject *__pyx_kp_u_4;
-static PyObject *__pyx_kp_u_5;
-static PyObject *__pyx_kp_u_6;
-static PyObject *__pyx_n_s__KDTreeNode;
-static PyObject *__pyx_n_s__MemoryError;
-static PyObject *__pyx_n_s____init__;
-static PyObject *__pyx_n_s____main__;
-static PyObject *__pyx_n_s____test__;
-static PyObject *__pyx_n_s__array;
-static PyObject *__pyx_n_s__coords;
-static PyObject *__pyx_n_s__curr_axis;
-static PyObject *__pyx_n_s__d;
-static PyObject *__pyx_n_s__data;
-static PyObject *__pyx_n_s__dims;
-static PyObject *__pyx_n_s__dist;
-static PyObject *__pyx_n_s__fill_tree;
-static PyObject *__pyx_n_s__left;
-static PyObject *__pyx_n_s__node_num;
-static PyObject *__pyx_n_s__num;
-static PyObject *__pyx_n_s__num_neighbors;
-static PyObject *__pyx_n_s__number;
-static PyObject *__pyx_n_s__print_preorder;
-static PyObject *__pyx_n_s__range;
-static PyObject *__pyx_n_s__right;
-static PyObject *__pyx_n_s__run_nn_search;
-static PyObject *__pyx_n_s__search;
-static PyObject *__pyx_n_s__sort;
-static PyObject *__pyx_n_s__xrange;
-static PyObject *__pyx_int_neg_1;
-
-/* "/home/belisarius/github/py_kdtree/cython_wrapper/kdtree.pyx":41
- *   cdef size_t dims
- * 
- *   def __cinit__(self, int num, coords):             # <<<<<<<<<<<<<<
- *     self.num = num
- *     self.coords = array.array('d', coords)
- */
-
-static int __pyx_pf_6kdtree_9PointData___cinit__(PyObject *__pyx_v_self, PyObject *__pyx_args, PyObject *__pyx_kwds); /*proto*/
-static int __pyx_pf_6kdtree_9PointData___cinit__(PyObject *__pyx_v_self, PyObject *__pyx_args, PyObject *__pyx_kwds) {
-  int __pyx_v_num;
-  PyObject *__pyx_v_coords = 0;
-  int __pyx_r;
-  PyObject *__pyx_t_1 = NULL;
-  PyObject *__pyx_t_2 = NULL;
-  PyObject *__pyx_t_3 = NULL;
-  Py_ssize_t __pyx_t_4;
-  static PyObject **__pyx_pyargnames[] = {&__pyx_n_s__num,&__pyx_n_s__coords,0};
-  __Pyx_RefNannySetupContext("__cinit__");
-  if (unlikely(__pyx_kwds)) {
-    Py_ssize_t kw_args = PyDict_Size(__pyx_kwds);
-    PyObject* values[2] = {0,0};
-    switch (PyTuple_GET_SIZE(__pyx_args)) {
-      case  2: values[1] = PyTuple_GET_ITEM(__pyx_args, 1);
-      case  1: values[0] = PyTuple_GET_ITEM(__pyx_args, 0);
-      case  0: break;
-      default: goto __pyx_L5_argtuple_error;
-    }
-    switch (PyTuple_GET_SIZE(__pyx_args)) {
-      case  0:
-      values[0] = PyDict_GetItem(__pyx_kwds, __pyx_n_s__num);
-      if (likely(values[0])) kw_args--;
-      else goto __pyx_L5_argtuple_error;
-      case  1:
-      values[1] = PyDict_GetItem(__pyx_kwds, __pyx_n_s__coords);
-      if (likely(values[1])) kw_args--;
-      else {
-        __Pyx_RaiseArgtupleInvalid("__cinit__", 1, 2, 2, 1); {__pyx_filename = __pyx_f[0]; __pyx_lineno = 41; __pyx_clineno = __LINE__; goto __pyx_L3_error;}
-      }
-    }
-    if (unlikely(kw_args > 0)) {
-      if (unlikely(__Pyx_ParseOptionalKeywords(__pyx_kwds, __pyx_pyargnames, 0, values, PyTuple_GET_SIZE(__pyx_args), "__cinit__") < 0)) {__pyx_filename = __pyx_f[0]; __pyx_lineno = 41; __pyx_clineno = __LINE__; goto __pyx_L3_error;}
-    }
-    __pyx_v_num = __Pyx_PyInt_AsInt(values[0]); if (unlikely((__pyx_v_num == (int)-1) && PyErr_Occurred())) {__pyx_filename = __pyx_f[0]; __pyx_lineno = 41; __pyx_clineno = __LINE__; goto __pyx_L3_error;}
-    __pyx_v_coords = values[1];
-  } else if (PyTuple_GET_SIZE(__pyx_args) != 2) {
-    goto __pyx_L5_argtuple_error;
-  } else {
-    __pyx_v_num = __Pyx_PyInt_AsInt(PyTuple_GET_ITEM(__pyx_args, 0)); if (unlikely((__pyx_v_num == (int)-1) && PyErr_Occurred())) {__pyx_filename = __pyx_f[0]; __pyx_lineno = 41; __pyx_clineno = __LINE__; goto __pyx_L3_error;}
-    __pyx_v_coords = PyTuple_GET_ITEM(__pyx_args, 1);
-  }
-  goto __pyx_L4_argument_unpacking_done;
-  __pyx_L5_argtuple_error:;
-  __Pyx_RaiseArgtupleInvalid("__cinit__", 1, 2, 2, PyTuple_GET_SIZE(__pyx_args)); {__pyx_filename = __pyx_f[0]; __pyx_lineno = 41; __pyx_clineno = __LINE__; goto __pyx_L3_error;}
-  __pyx_L3_error:;
-  __Pyx_AddTraceback("kdtree.PointData.__cinit__");
-  return -1;
-  __pyx_L4_argument_unpacking_done:;
-
-  /* "/home/belisarius/github/py_kdtree/cython_wrapper/kdtree.pyx":42
- * 
- *   def __cinit__(self, int num, coords):
- *     self.num = num             # <<<<<<<<<<<<<<
- *     self.coords = array.array('d', coords)
- *     self.curr_axis = 0
- */
-  ((struct __pyx_obj_6kdtree_PointData *)__pyx_v_self)->num = __pyx_v_num;
-
-  /* "/home/belisarius/github/py_kdtree/cython_wrapper/kdtree.pyx":43
- *   def __cinit__(self, int num, coords):
- *     self.num = num
- *     self.coords = array.array('d', coords)             # <<<<<<<<<<<<<<
- *     self.curr_axis = 0
- *     self.dims = len(coords)
- */
-  __pyx_t_1 = __Pyx_GetName(__pyx_m, __pyx_n_s__array); if (unlikely(!__pyx_t_1)) {__pyx_filename = __pyx_f[0]; __pyx_lineno = 43; __pyx_clineno = __LINE__; goto __pyx_L1_error;}
-  __Pyx_GOTREF(__pyx_t_1);
-  __pyx_t_2 = PyObject_GetAttr(__pyx_t_1, __pyx_n_s__array); if (unlikely(!__pyx_t_2)) {__pyx_filename = __pyx_f[0]; __pyx_lineno = 43; __pyx_clineno = __LINE__; goto __pyx_L1_error;}
-  __Pyx_GOTREF(__pyx_t_2);
-  __Pyx_DECREF(__pyx_t_1); __pyx_t_1 = 0;
-  __pyx_t_1 = PyTuple_New(2); if (unlikely(!__pyx_t_1)) {__pyx_filename = __pyx_f[0]; __pyx_lineno = 43; __pyx_clineno = __LINE__; goto __pyx_L1_error;}
-  __Pyx_GOTREF(__pyx_t_1);
-  __Pyx_INCREF(((PyObject *)__pyx_n_s__d));
-  PyTuple_SET_ITEM(__pyx_t_1, 0, ((PyObject *)__pyx_n_s__d));
-  __Pyx_GIVEREF(((PyObject *)__pyx_n_s__d));
-  __Pyx_INCREF(__pyx_v_coords);
-  PyTuple_SET_ITEM(__pyx_t_1, 1, __pyx_v_coords);
-  __Pyx_GIVEREF(__pyx_v_coords);
-  __pyx_t_3 = PyObject_Call(__pyx_t_2, __pyx_t_1, NULL); if (unlikely(!__pyx_t_3)) {__pyx_filename = __pyx_f[0]; __pyx_lineno = 43; __pyx_clineno = __LINE__; goto __pyx_L1_error;}
-  __Pyx_GOTREF(__pyx_t_3);
-  __Pyx_DECREF(__pyx_t_2); __pyx_t_2 = 0;
-  __Pyx_DECREF(__pyx_t_1); __pyx_t_1 = 0;
-  __Pyx_GIVEREF(__pyx_t_3);
-  __Pyx_GOTREF(((struct __pyx_obj_6kdtree_PointData *)__pyx_v_self)->coords);
-  __Pyx_DECREF(((struct __pyx_obj_6kdtree_PointData *)__pyx_v_self)->coords);
-  ((struct __pyx_obj_6kdtree_PointData *)__pyx_v_self)->coords = __pyx_t_3;
-  __pyx_t_3 = 0;
-
-  /* "/home/belisarius/github/py_kdtree/cython_wrapper/kdtree.pyx":44
- *     self.num = num
- *     self.coords = array.array('d', coords)
- *     self.curr_axis = 0             # <<<<<<<<<<<<<<
- *     self.dims = len(coords)
- * 
- */
-  ((struct __pyx_obj_6kdtree_PointData *)__pyx_v_self)->curr_axis = 0;
-
-  /* "/home/belisarius/github/py_kdtree/cython_wrapper/kdtree.pyx":45
- *     self.coords = array.array('d', coords)
- *     self.curr_axis = 0
- *     self.dims = len(coords)             # <<<<<<<<<<<<<<
- * 
- *   def __cmp__(self, PointData other):
- */
-  __pyx_t_4 = PyObject_Length(__pyx_v_coords); if (unlikely(__pyx_t_4 == -1)) {__pyx_filename = __pyx_f[0]; __pyx_lineno = 45; __pyx_clineno = __LINE__; goto __pyx_L1_error;}
-  ((struct __pyx_obj_6kdtree_PointData *)__pyx_v_self)->dims = __pyx_t_4;
-
-  __pyx_r = 0;
-  goto __pyx_L0;
-  __pyx_L1_error:;
-  __Pyx_XDECREF(__pyx_t_1);
-  __Pyx_XDECREF(__pyx_t_2);
-  __Pyx_XDECREF(__pyx_t_3);
-  __Pyx_AddTraceback("kdtree.PointData.__cinit__");
-  __pyx_r = -1;
-  __pyx_L0:;
-  __Pyx_RefNannyFinishContext();
-  return __pyx_r;
-}
-
-/* "/home/belisarius/github/py_kdtree/cython_wrapper/kdtree.pyx":47
- *     self.dims = len(coords)
- * 
- *   def __cmp__(self, PointData other):             # <<<<<<<<<<<<<<
- *     if other is None:
- *       return -1
- */
-
-static int __pyx_pf_6kdtree_9PointData___cmp__(PyObject *__pyx_v_self, PyObject *__pyx_v_other); /*proto*/
-static int __pyx_pf_6kdtree_9PointData___cmp__(PyObject *__pyx_v_self, PyObject *__pyx_v_other) {
-  PyObject *__pyx_v_axis;
-  double __pyx_v_s_coord;
-  double __pyx_v_o_coord;
-  int __pyx_r;
-  int __pyx_t_1;
-  PyObject *__pyx_t_2 = NULL;
-  double __pyx_t_3;
-  __Pyx_RefNannySetupContext("__cmp__");
-  __Pyx_INCREF((PyObject *)__pyx_v_self);
-  __Pyx_INCREF((PyObject *)__pyx_v_other);
-  __pyx_v_axis = Py_None; __Pyx_INCREF(Py_None);
-  if (unlikely(!__Pyx_ArgTypeTest(((PyObject *)__pyx_v_other), __pyx_ptype_6kdtree_PointData, 1, "other", 0))) {__pyx_filename = __pyx_f[0]; __pyx_lineno = 47; __pyx_clineno = __LINE__; goto __pyx_L1_error;}
-
-  /* "/home/belisarius/github/py_kdtree/cython_wrapper/kdtree.pyx":48
- * 
- *   def __cmp__(self, PointData other):
- *     if other is None:             # <<<<<<<<<<<<<<
- *       return -1
- *     axis = self.curr_axis
- */
-  __pyx_t_1 = (__pyx_v_other == Py_None);
-  if (__pyx_t_1) {
-
-    /* "/home/belisarius/github/py_kdtree/cython_wrapper/kdtree.pyx":49
- *   def __cmp__(self, PointData other):
- *     if other is None:
- *       return -1             # <<<<<<<<<<<<<<
- *     axis = self.curr_axis
- *     cdef double s_coord = self.coords[axis]
- */
-    __pyx_r = -1;
-    goto __pyx_L0;
-    goto __pyx_L5;
-  }
-  __pyx_L5:;
-
-  /* "/home/belisarius/github/py_kdtree/cython_wrapper/kdtree.pyx":50
- *     if other is None:
- *       return -1
- *     axis = self.curr_axis             # <<<<<<<<<<<<<<
- *     cdef double s_coord = self.coords[axis]
- *     cdef double o_coord = other.coords[axis]
- */
-  __pyx_t_2 = __Pyx_PyInt_FromSize_t(((struct __pyx_obj_6kdtree_PointData *)__pyx_v_self)->curr_axis); if (unlikely(!__pyx_t_2)) {__pyx_filename = __pyx_f[0]; __pyx_lineno = 50; __pyx_clineno = __LINE__; goto __pyx_L1_error;}
-  __Pyx_GOTREF(__pyx_t_2);
-  __Pyx_DECREF(__pyx_v_axis);
-  __pyx_v_axis = __pyx_t_2;
-  __pyx_t_2 = 0;
-
-  /* "/home/belisarius/github/py_kdtree/cython_wrapper/kdtree.pyx":51
- *       return -1
- *     axis = self.curr_axis
- *     cdef double s_coord = self.coords[axis]             # <<<<<<<<<<<<<<
- *     cdef double o_coord = other.coords[axis]
- *     if s_coord < o_coord:
- */
-  __pyx_t_2 = PyObject_GetItem(((struct __pyx_obj_6kdtree_PointData *)__pyx_v_self)->coords, __pyx_v_axis); if (!__pyx_t_2) {__pyx_filename = __pyx_f[0]; __pyx_lineno = 51; __pyx_clineno = __LINE__; goto __pyx_L1_error;}
-  __Pyx_GOTREF(__pyx_t_2);
-  __pyx_t_3 = __pyx_PyFloat_AsDouble(__pyx_t_2); if (unlikely((__pyx_t_3 == (double)-1) && PyErr_Occurred())) {__pyx_filename = __pyx_f[0]; __pyx_lineno = 51; __pyx_clineno = __LINE__; goto __pyx_L1_error;}
-  __Pyx_DECREF(__pyx_t_2); __pyx_t_2 = 0;
-  __pyx_v_s_coord = __pyx_t_3;
-
-  /* "/home/belisarius/github/py_kdtree/cython_wrapper/kdtree.pyx":52
- *     axis = self.curr_axis
- *     cdef double s_coord = self.coords[axis]
- *     cdef double o_coord = other.coords[axis]             # <<<<<<<<<<<<<<
- *     if s_coord < o_coord:
- *       return -1
- */
-  __pyx_t_2 = PyObject_GetItem(((struct __pyx_obj_6kdtree_PointData *)__pyx_v_other)->coords, __pyx_v_axis); if (!__pyx_t_2) {__pyx_filename = __pyx_f[0]; __pyx_lineno = 52; __pyx_clineno = __LINE__; goto __pyx_L1_error;}
-  __Pyx_GOTREF(__pyx_t_2);
-  __pyx_t_3 = __pyx_PyFloat_AsDouble(__pyx_t_2); if (unlikely((__pyx_t_3 == (double)-1) && PyErr_Occurred())) {__pyx_filename = __pyx_f[0]; __pyx_lineno = 52; __pyx_clineno = __LINE__; goto __pyx_L1_error;}
-  __Pyx_DECREF(__pyx_t_2); __pyx_t_2 = 0;
-  __pyx_v_o_coord = __pyx_t_3;
-
-  /* "/home/belisarius/github/py_kdtree/cython_wrapper/kdtree.pyx":53
- *     cdef double s_coord = self.coords[axis]
- *     cdef double o_coord = other.coords[axis]
- *     if s_coord < o_coord:             # <<<<<<<<<<<<<<
- *       return -1
- *     if s_coord > o_coord:
- */
-  __pyx_t_1 = (__pyx_v_s_coord < __pyx_v_o_coord);
-  if (__pyx_t_1) {
-
-    /* "/home/belisarius/github/py_kdtree/cython_wrapper/kdtree.pyx":54
- *     cdef double o_coord = other.coords[axis]
- *     if s_coord < o_coord:
- *       return -1             # <<<<<<<<<<<<<<
- *     if s_coord > o_coord:
- *       return 1
- */
-    __pyx_r = -1;
-    goto __pyx_L0;
-    goto __pyx_L6;
-  }
-  __pyx_L6:;
-
-  /* "/home/belisarius/github/py_kdtree/cython_wrapper/kdtree.pyx":55
- *     if s_coord < o_coord:
- *       return -1
- *     if s_coord > o_coord:             # <<<<<<<<<<<<<<
- *       return 1
- *     return 0
- */
-  __pyx_t_1 = (__pyx_v_s_coord > __pyx_v_o_coord);
-  if (__pyx_t_1) {
-
-    /* "/home/belisarius/github/py_kdtree/cython_wrapper/kdtree.pyx":56
- *       return -1
- *     if s_coord > o_coord:
- *       return 1             # <<<<<<<<<<<<<<
- *     return 0
- * 
- */
-    __pyx_r = 1;
-    goto __pyx_L0;
-    goto __pyx_L7;
-  }
-  __pyx_L7:;
-
-  /* "/home/belisarius/github/py_kdtree/cython_wrapper/kdtree.pyx":57
- *     if s_coord > o_coord:
- *       return 1
- *     return 0             # <<<<<<<<<<<<<<
- * 
- *   def __str__(self):
- */
-  __pyx_r = 0;
-  goto __pyx_L0;
-
-  __pyx_r = 0;
-  goto __pyx_L0;
-  __pyx_L1_error:;
-  __Pyx_XDECREF(__pyx_t_2);
-  __Pyx_AddTraceback("kdtree.PointData.__cmp__");
-  __pyx_r = -1;
-  __pyx_L0:;
-  __Pyx_DECREF(__pyx_v_axis);
-  __Pyx_DECREF((PyObject *)__pyx_v_self);
-  __Pyx_DECREF((PyObject *)__pyx_v_other);
-  __Pyx_RefNannyFinishContext();
-  return __pyx_r;
-}
-
-/* "/home/belisarius/github/py_kdtree/cython_wrapper/kdtree.pyx":59
- *     return 0
- * 
- *   def __str__(self):             # <<<<<<<<<<<<<<
- *     return "%d, %s" % (self.num, self.coords)
- * 
- */
-
-static PyObject *__pyx_pf_6kdtree_9PointData___str__(PyObject *__pyx_v_self); /*proto*/
-static PyObject *__pyx_pf_6kdtree_9PointData___str__(PyObject *__pyx_v_self) {
-  PyObject *__pyx_r = NULL;
-  PyObject *__pyx_t_1 = NULL;
-  PyObject *__pyx_t_2 = NULL;
-  __Pyx_RefNannySetupContext("__str__");
-
-  /* "/home/belisarius/github/py_kdtree/cython_wrapper/kdtree.pyx":60
- * 
- *   def __str__(self):
- *     return "%d, %s" % (self.num, self.coords)             # <<<<<<<<<<<<<<
- * 
- *   def __repr__(self):
- */
-  __Pyx_XDECREF(__pyx_r);
-  __pyx_t_1 = PyInt_FromLong(((struct __pyx_obj_6kdtree_PointData *)__pyx_v_self)->num); if (unlikely(!__pyx_t_1)) {__pyx_filename = __pyx_f[0]; __pyx_lineno = 60; __pyx_clineno = __LINE__; goto __pyx_L1_error;}
-  __Pyx_GOTREF(__pyx_t_1);
-  __pyx_t_2 = PyTuple_New(2); if (unlikely(!__pyx_t_2)) {__pyx_filename = __pyx_f[0]; __pyx_lineno = 60; __pyx_clineno = __LINE__; goto __pyx_L1_error;}
-  __Pyx_GOTREF(__pyx_t_2);
-  PyTuple_SET_ITEM(__pyx_t_2, 0, __pyx_t_1);
-  __Pyx_GIVEREF(__pyx_t_1);
-  __Pyx_INCREF(((struct __pyx_obj_6kdtree_PointData *)__pyx_v_self)->coords);
-  PyTuple_SET_ITEM(__pyx_t_2, 1, ((struct __pyx_obj_6kdtree_PointData *)__pyx_v_self)->coords);
-  __Pyx_GIVEREF(((struct __pyx_obj_6kdtree_PointData *)__pyx_v_self)->coords);
-  __pyx_t_1 = 0;
-  __pyx_t_1 = PyNumber_Remainder(((PyObject *)__pyx_kp_s_1), __pyx_t_2); if (unlikely(!__pyx_t_1)) {__pyx_filename = __pyx_f[0]; __pyx_lineno = 60; __pyx_clineno = __LINE__; goto __pyx_L1_error;}
-  __Pyx_GOTREF(__pyx_t_1);
-  __Pyx_DECREF(__pyx_t_2); __pyx_t_2 = 0;
-  __pyx_r = __pyx_t_1;
-  __pyx_t_1 = 0;
-  goto __pyx_L0;
-
-  __pyx_r = Py_None; __Pyx_INCREF(Py_None);
-  goto __pyx_L0;
-  __pyx_L1_error:;
-  __Pyx_XDECREF(__pyx_t_1);
-  __Pyx_XDECREF(__pyx_t_2);
-  __Pyx_AddTraceback("kdtree.PointData.__str__");
-  __pyx_r = NULL;
-  __pyx_L0:;
-  __Pyx_XGIVEREF(__pyx_r);
-  __Pyx_RefNannyFinishContext();
-  return __pyx_r;
-}
-
-/* "/home/belisarius/github/py_kdtree/cython_wrapper/kdtree.pyx":62
- *     return "%d, %s" % (self.num, self.coords)
- * 
- *   def __repr__(self):             # <<<<<<<<<<<<<<
- *     return "%d, %s" % (self.num, self.coords)
- * 
- */
-
-static PyObject *__pyx_pf_6kdtree_9PointData___repr__(PyObject *__pyx_v_self); /*proto*/
-static PyObject *__pyx_pf_6kdtree_9PointData___repr__(PyObject *__pyx_v_self) {
-  PyObject *__pyx_r = NULL;
-  PyObject *__pyx_t_1 = NULL;
-  PyObject *__pyx_t_2 = NULL;
-  __Pyx_RefNannySetupContext("__repr__");
-
-  /* "/home/belisarius/github/py_kdtree/cython_wrapper/kdtree.pyx":63
- * 
- *   def __repr__(self):
- *     return "%d, %s" % (self.num, self.coords)             # <<<<<<<<<<<<<<
- * 
- *   property dims:
- */
-  __Pyx_XDECREF(__pyx_r);
-  __pyx_t_1 = PyInt_FromLong(((struct __pyx_obj_6kdtree_PointData *)__pyx_v_self)->num); if (unlikely(!__pyx_t_1)) {__pyx_filename = __pyx_f[0]; __pyx_lineno = 63; __pyx_clineno = __LINE__; goto __pyx_L1_error;}
-  __Pyx_GOTREF(__pyx_t_1);
-  __pyx_t_2 = PyTuple_New(2); if (unlikely(!__pyx_t_2)) {__pyx_filename = __pyx_f[0]; __pyx_lineno = 63; __pyx_clineno = __LINE__; goto __pyx_L1_error;}
-  __Pyx_GOTREF(__pyx_t_2);
-  PyTuple_SET_ITEM(__pyx_t_2, 0, __pyx_t_1);
-  __Pyx_GIVEREF(__pyx_t_1);
-  __Pyx_INCREF(((struct __pyx_obj_6kdtree_PointData *)__pyx_v_self)->coords);
-  PyTuple_SET_ITEM(__pyx_t_2, 1, ((struct __pyx_obj_6kdtree_PointData *)__pyx_v_self)->coords);
-  __Pyx_GIVEREF(((struct __pyx_obj_6kdtree_PointData *)__pyx_v_self)->coords);
-  __pyx_t_1 = 0;
-  __pyx_t_1 = PyNumber_Remainder(((PyObject *)__pyx_kp_s_1), __pyx_t_2); if (unlikely(!__pyx_t_1)) {__pyx_filename = __pyx_f[0]; __pyx_lineno = 63; __pyx_clineno = __LINE__; goto __pyx_L1_error;}
-  __Pyx_GOTREF(__pyx_t_1);
-  __Pyx_DECREF(__pyx_t_2); __pyx_t_2 = 0;
-  __pyx_r = __pyx_t_1;
-  __pyx_t_1 = 0;
-  goto __pyx_L0;
-
-  __pyx_r = Py_None; __Pyx_INCREF(Py_None);
-  goto __pyx_L0;
-  __pyx_L1_error:;
-  __Pyx_XDECREF(__pyx_t_1);
-  __Pyx_XDECREF(__pyx_t_2);
-  __Pyx_AddTraceback("kdtree.PointData.__repr__");
-  __pyx_r = NULL;
-  __pyx_L0:;
-  __Pyx_XGIVEREF(__pyx_r);
-  __Pyx_RefNannyFinishContext();
-  return __pyx_r;
-}
-
-/* "/home/belisarius/github/py_kdtree/cython_wrapper/kdtree.pyx":66
- * 
- *   property dims:
- *     def __get__(self):             # <<<<<<<<<<<<<<
- *       return self.dims
- * 
- */
-
-static PyObject *__pyx_pf_6kdtree_9PointData_4dims___get__(PyObject *__pyx_v_self); /*proto*/
-static PyObject *__pyx_pf_6kdtree_9PointData_4dims___get__(PyObject *__pyx_v_self) {
-  PyObject *__pyx_r = NULL;
-  PyObject *__pyx_t_1 = NULL;
-  __Pyx_RefNannySetupContext("__get__");
-
-  /* "/home/belisarius/github/py_kdtree/cython_wrapper/kdtree.pyx":67
- *   property dims:
- *     def __get__(self):
- *       return self.dims             # <<<<<<<<<<<<<<
- * 
- *   property num:
- */
-  __Pyx_XDECREF(__pyx_r);
-  __pyx_t_1 = __Pyx_PyInt_FromSize_t(((struct __pyx_obj_6kdtree_PointData *)__pyx_v_self)->dims); if (unlikely(!__pyx_t_1)) {__pyx_filename = __pyx_f[0]; __pyx_lineno = 67; __pyx_clineno = __LINE__; goto __pyx_L1_error;}
-  __Pyx_GOTREF(__pyx_t_1);
-  __pyx_r = __pyx_t_1;
-  __pyx_t_1 = 0;
-  goto __pyx_L0;
-
-  __pyx_r = Py_None; __Pyx_INCREF(Py_None);
-  goto __pyx_L0;
-  __pyx_L1_error:;
-  __Pyx_XDECREF(__pyx_t_1);
-  __Pyx_AddTraceback("kdtree.PointData.dims.__get__");
-  __pyx_r = NULL;
-  __pyx_L0:;
-  __Pyx_XGIVEREF(__pyx_r);
-  __Pyx_RefNannyFinishContext();
-  return __pyx_r;
-}
-
-/* "/home/belisarius/github/py_kdtree/cython_wrapper/kdtree.pyx":70
- * 
- *   property num:
- *     def __get__(self):             # <<<<<<<<<<<<<<
- *       return self.num
- *     def __set__(self, int value):
- */
-
-static PyObject *__pyx_pf_6kdtree_9PointData_3num___get__(PyObject *__pyx_v_self); /*proto*/
-static PyObject *__pyx_pf_6kdtree_9PointData_3num___get__(PyObject *__pyx_v_self) {
-  PyObject *__pyx_r = NULL;
-  PyObject *__pyx_t_1 = NULL;
-  __Pyx_RefNannySetupContext("__get__");
-
-  /* "/home/belisarius/github/py_kdtree/cython_wrapper/kdtree.pyx":71
- *   property num:
- *     def __get__(self):
- *       return self.num             # <<<<<<<<<<<<<<
- *     def __set__(self, int value):
- *       self.num = value
- */
-  __Pyx_XDECREF(__pyx_r);
-  __pyx_t_1 = PyInt_FromLong(((struct __pyx_obj_6kdtree_PointData *)__pyx_v_self)->num); if (unlikely(!__pyx_t_1)) {__pyx_filename = __pyx_f[0]; __pyx_lineno = 71; __pyx_clineno = __LINE__; goto __pyx_L1_error;}
-  __Pyx_GOTREF(__pyx_t_1);
-  __pyx_r = __pyx_t_1;
-  __pyx_t_1 = 0;
-  goto __pyx_L0;
-
-  __pyx_r = Py_None; __Pyx_INCREF(Py_None);
-  goto __pyx_L0;
-  __pyx_L1_error:;
-  __Pyx_XDECREF(__pyx_t_1);
-  __Pyx_AddTraceback("kdtree.PointData.num.__get__");
-  __pyx_r = NULL;
-  __pyx_L0:;
-  __Pyx_XGIVEREF(__pyx_r);
-  __Pyx_RefNannyFinishContext();
-  return __pyx_r;
-}
-
-/* "/home/belisarius/github/py_kdtree/cython_wrapper/kdtree.pyx":72
- *     def __get__(self):
- *       return self.num
- *     def __set__(self, int value):             # <<<<<<<<<<<<<<
- *       self.num = value
- * 
- */
-
-static int __pyx_pf_6kdtree_9PointData_3num___set__(PyObject *__pyx_v_self, PyObject *__pyx_arg_value); /*proto*/
-static int __pyx_pf_6kdtree_9PointData_3num___set__(PyObject *__pyx_v_self, PyObject *__pyx_arg_value) {
-  int __pyx_v_value;
-  int __pyx_r;
-  __Pyx_RefNannySetupContext("__set__");
-  assert(__pyx_arg_value); {
-    __pyx_v_value = __Pyx_PyInt_AsInt(__pyx_arg_value); if (unlikely((__pyx_v_value == (int)-1) && PyErr_Occurred())) {__pyx_filename = __pyx_f[0]; __pyx_lineno = 72; __pyx_clineno = __LINE__; goto __pyx_L3_error;}
-  }
-  goto __pyx_L4_argument_unpacking_done;
-  __pyx_L3_error:;
-  __Pyx_AddTraceback("kdtree.PointData.num.__set__");
-  return -1;
-  __pyx_L4_argument_unpacking_done:;
-
-  /* "/home/belisarius/github/py_kdtree/cython_wrapper/kdtree.pyx":73
- *       return self.num
- *     def __set__(self, int value):
- *       self.num = value             # <<<<<<<<<<<<<<
- * 
- *   property curr_axis:
- */
-  ((struct __pyx_obj_6kdtree_PointData *)__pyx_v_self)->num = __pyx_v_value;
-
-  __pyx_r = 0;
-  __Pyx_RefNannyFinishContext();
-  return __pyx_r;
-}
-
-/* "/home/belisarius/github/py_kdtree/cython_wrapper/kdtree.pyx":76
- * 
- *   property curr_axis:
- *     def __get__(self):             # <<<<<<<<<<<<<<
- *       return self.curr_axis
- *     def __set__(self, size_t value):
- */
-
-static PyObject *__pyx_pf_6kdtree_9PointData_9curr_axis___get__(PyObject *__pyx_v_self); /*proto*/
-static PyObject *__pyx_pf_6kdtree_9PointData_9curr_axis___get__(PyObject *__pyx_v_self) {
-  PyObject *__pyx_r = NULL;
-  PyObject *__pyx_t_1 = NULL;
-  __Pyx_RefNannySetupContext("__get__");
-
-  /* "/home/belisarius/github/py_kdtree/cython_wrapper/kdtree.pyx":77
- *   property curr_axis:
- *     def __get__(self):
- *       return self.curr_axis             # <<<<<<<<<<<<<<
- *     def __set__(self, size_t value):
- *       self.curr_axis = value
- */
-  __Pyx_XDECREF(__pyx_r);
-  __pyx_t_1 = __Pyx_PyInt_FromSize_t(((struct __pyx_obj_6kdtree_PointData *)__pyx_v_self)->curr_axis); if (unlikely(!__pyx_t_1)) {__pyx_filename = __pyx_f[0]; __pyx_lineno = 77; __pyx_clineno = __LINE__; goto __pyx_L1_error;}
-  __Pyx_GOTREF(__pyx_t_1);
-  __pyx_r = __pyx_t_1;
-  __pyx_t_1 = 0;
-  goto __pyx_L0;
-
-  __pyx_r = Py_None; __Pyx_INCREF(Py_None);
-  goto __pyx_L0;
-  __pyx_L1_error:;
-  __Pyx_XDECREF(__pyx_t_1);
-  __Pyx_AddTraceback("kdtree.PointData.curr_axis.__get__");
-  __pyx_r = NULL;
-  __pyx_L0:;
-  __Pyx_XGIVEREF(__pyx_r);
-  __Pyx_RefNannyFinishContext();
-  return __pyx_r;
-}
-
-/* "/home/belisarius/github/py_kdtree/cython_wrapper/kdtree.pyx":78
- *     def __get__(self):
- *       return self.curr_axis
- *     def __set__(self, size_t value):             # <<<<<<<<<<<<<<
- *       self.curr_axis = value
- * 
- */
-
-static int __pyx_pf_6kdtree_9PointData_9curr_axis___set__(PyObject *__pyx_v_self, PyObject *__pyx_arg_value); /*proto*/
-static int __pyx_pf_6kdtree_9PointData_9curr_axis___set__(PyObject *__pyx_v_self, PyObject *__pyx_arg_value) {
-  size_t __pyx_v_value;
-  int __pyx_r;
-  __Pyx_RefNannySetupContext("__set__");
-  assert(__pyx_arg_value); {
-    __pyx_v_value = __Pyx_PyInt_AsSize_t(__pyx_arg_value); if (unlikely((__pyx_v_value == (size_t)-1) && PyErr_Occurred())) {__pyx_filename = __pyx_f[0]; __pyx_lineno = 78; __pyx_clineno = __LINE__; goto __pyx_L3_error;}
-  }
-  goto __pyx_L4_argument_unpacking_done;
-  __pyx_L3_error:;
-  __Pyx_AddTraceback("kdtree.PointData.curr_axis.__set__");
-  return -1;
-  __pyx_L4_argument_unpacking_done:;
-
-  /* "/home/belisarius/github/py_kdtree/cython_wrapper/kdtree.pyx":79
- *       return self.curr_axis
- *     def __set__(self, size_t value):
- *       self.curr_axis = value             # <<<<<<<<<<<<<<
- * 
- *   property coords:
- */
-  ((struct __pyx_obj_6kdtree_PointData *)__pyx_v_self)->curr_axis = __pyx_v_value;
-
-  __pyx_r = 0;
-  __Pyx_RefNannyFinishContext();
-  return __pyx_r;
-}
-
-/* "/home/belisarius/github/py_kdtree/cython_wrapper/kdtree.pyx":82
- * 
- *   property coords:
- *     def __get__(self):             # <<<<<<<<<<<<<<
- *       return self.coords
- *     def __set__(self, object value):
- */
-
-static PyObject *__pyx_pf_6kdtree_9PointData_6coords___get__(PyObject *__pyx_v_self); /*proto*/
-static PyObject *__pyx_pf_6kdtree_9PointData_6coords___get__(PyObject *__pyx_v_self) {
-  PyObject *__pyx_r = NULL;
-  __Pyx_RefNannySetupContext("__get__");
-
-  /* "/home/belisarius/github/py_kdtree/cython_wrapper/kdtree.pyx":83
- *   property coords:
- *     def __get__(self):
- *       return self.coords             # <<<<<<<<<<<<<<
- *     def __set__(self, object value):
- *       self.coords = value
- */
-  __Pyx_XDECREF(__pyx_r);
-  __Pyx_INCREF(((struct __pyx_obj_6kdtree_PointData *)__pyx_v_self)->coords);
-  __pyx_r = ((struct __pyx_obj_6kdtree_PointData *)__pyx_v_self)->coords;
-  goto __pyx_L0;
-
-  __pyx_r = Py_None; __Pyx_INCREF(Py_None);
-  __pyx_L0:;
-  __Pyx_XGIVEREF(__pyx_r);
-  __Pyx_RefNannyFinishContext();
-  return __pyx_r;
-}
-
-/* "/home/belisarius/github/py_kdtree/cython_wrapper/kdtree.pyx":84
- *     def __get__(self):
- *       return self.coords
- *     def __set__(self, object value):             # <<<<<<<<<<<<<<
- *       self.coords = value
- * 
- */
-
-static int __pyx_pf_6kdtree_9PointData_6coords___set__(PyObject *__pyx_v_self, PyObject *__pyx_v_value); /*proto*/
-static int __pyx_pf_6kdtree_9PointData_6coords___set__(PyObject *__pyx_v_self, PyObject *__pyx_v_value) {
-  int __pyx_r;
-  __Pyx_RefNannySetupContext("__set__");
-
-  /* "/home/belisarius/github/py_kdtree/cython_wrapper/kdtree.pyx":85
- *       return self.coords
- *     def __set__(self, object value):
- *       self.coords = value             # <<<<<<<<<<<<<<
- * 
- * cdef class KDTreeNode:
- */
-  __Pyx_INCREF(__pyx_v_value);
-  __Pyx_GIVEREF(__pyx_v_value);
-  __Pyx_GOTREF(((struct __pyx_obj_6kdtree_PointData *)__pyx_v_self)->coords);
-  __Pyx_DECREF(((struct __pyx_obj_6kdtree_PointData *)__pyx_v_self)->coords);
-  ((struct __pyx_obj_6kdtree_PointData *)__pyx_v_self)->coords = __pyx_v_value;
-
-  __pyx_r = 0;
-  __Pyx_RefNannyFinishContext();
-  return __pyx_r;
-}
-
-/* "/home/belisarius/github/py_kdtree/cython_wrapper/kdtree.pyx":93
- *   cdef KDTreeNode right
- * 
- *   def __init__(self, int number, coords):             # <<<<<<<<<<<<<<
- *     """Initializer to pass in the number of the node and its coordinates"""
- *     self.data = PointData(number, array.array('d', coords))
- */
-
-static int __pyx_pf_6kdtree_10KDTreeNode___init__(PyObject *__pyx_v_self, PyObject *__pyx_args, PyObject *__pyx_kwds); /*proto*/
-static char __pyx_doc_6kdtree_10KDTreeNode___init__[] = "Initializer to pass in the number of the node and its coordinates";
-static int __pyx_pf_6kdtree_10KDTreeNode___init__(PyObject *__pyx_v_self, PyObject *__pyx_args, PyObject *__pyx_kwds) {
-  int __pyx_v_number;
-  PyObject *__pyx_v_coords = 0;
-  int __pyx_r;
-  PyObject *__pyx_t_1 = NULL;
-  PyObject *__pyx_t_2 = NULL;
-  PyObject *__pyx_t_3 = NULL;
-  PyObject *__pyx_t_4 = NULL;
-  static PyObject **__pyx_pyargnames[] = {&__pyx_n_s__number,&__pyx_n_s__coords,0};
-  __Pyx_RefNannySetupContext("__init__");
-  if (unlikely(__pyx_kwds)) {
-    Py_ssize_t kw_args = PyDict_Size(__pyx_kwds);
-    PyObject* values[2] = {0,0};
-    switch (PyTuple_GET_SIZE(__pyx_args)) {
-      case  2: values[1] = PyTuple_GET_ITEM(__pyx_args, 1);
-      case  1: values[0] = PyTuple_GET_ITEM(__pyx_args, 0);
-      case  0: break;
-      default: goto __pyx_L5_argtuple_error;
-    }
-    switch (PyTuple_GET_SIZE(__pyx_args)) {
-      case  0:
-      values[0] = PyDict_GetItem(__pyx_kwds, __pyx_n_s__number);
-      if (likely(values[0])) kw_args--;
-      else goto __pyx_L5_argtuple_error;
-      case  1:
-      values[1] = PyDict_GetItem(__pyx_kwds, __pyx_n_s__coords);
-      if (likely(values[1])) kw_args--;
-      else {
-        __Pyx_RaiseArgtupleInvalid("__init__", 1, 2, 2, 1); {__pyx_filename = __pyx_f[0]; __pyx_lineno = 93; __pyx_clineno = __LINE__; goto __pyx_L3_error;}
-      }
-    }
-    if (unlikely(kw_args > 0)) {
-      if (unlikely(__Pyx_ParseOptionalKeywords(__pyx_kwds, __pyx_pyargnames, 0, values, PyTuple_GET_SIZE(__pyx_args), "__init__") < 0)) {__pyx_filename = __pyx_f[0]; __pyx_lineno = 93; __pyx_clineno = __LINE__; goto __pyx_L3_error;}
-    }
-    __pyx_v_number = __Pyx_PyInt_AsInt(values[0]); if (unlikely((__pyx_v_number == (int)-1) && PyErr_Occurred())) {__pyx_filename = __pyx_f[0]; __pyx_lineno = 93; __pyx_clineno = __LINE__; goto __pyx_L3_error;}
-    __pyx_v_coords = values[1];
-  } else if (PyTuple_GET_SIZE(__pyx_args) != 2) {
-    goto __pyx_L5_argtuple_error;
-  } else {
-    __pyx_v_number = __Pyx_PyInt_AsInt(PyTuple_GET_ITEM(__pyx_args, 0)); if (unlikely((__pyx_v_number == (int)-1) && PyErr_Occurred())) {__pyx_filename = __pyx_f[0]; __pyx_lineno = 93; __pyx_clineno = __LINE__; goto __pyx_L3_error;}
-    __pyx_v_coords = PyTuple_GET_ITEM(__pyx_args, 1);
-  }
-  goto __pyx_L4_argument_unpacking_done;
-  __pyx_L5_argtuple_error:;
-  __Pyx_RaiseArgtupleInvalid("__init__", 1, 2, 2, PyTuple_GET_SIZE(__pyx_args)); {__pyx_filename = __pyx_f[0]; __pyx_lineno = 93; __pyx_clineno = __LINE__; goto __pyx_L3_error;}
-  __pyx_L3_error:;
-  __Pyx_AddTraceback("kdtree.KDTreeNode.__init__");
-  return -1;
-  __pyx_L4_argument_unpacking_done:;
-
-  /* "/home/belisarius/github/py_kdtree/cython_wrapper/kdtree.pyx":95
- *   def __init__(self, int number, coords):
- *     """Initializer to pass in the number of the node and its coordinates"""
- *     self.data = PointData(number, array.array('d', coords))             # <<<<<<<<<<<<<<
- *     self.left = None
- *     self.right = None
- */
-  __pyx_t_1 = PyInt_FromLong(__pyx_v_number); if (unlikely(!__pyx_t_1)) {__pyx_filename = __pyx_f[0]; __pyx_lineno = 95; __pyx_clineno = __LINE__; goto __pyx_L1_error;}
-  __Pyx_GOTREF(__pyx_t_1);
-  __pyx_t_2 = __Pyx_GetName(__pyx_m, __pyx_n_s__array); if (unlikely(!__pyx_t_2)) {__pyx_filename = __pyx_f[0]; __pyx_lineno = 95; __pyx_clineno = __LINE__; goto __pyx_L1_error;}
-  __Pyx_GOTREF(__pyx_t_2);
-  __pyx_t_3 = PyObject_GetAttr(__pyx_t_2, __pyx_n_s__array); if (unlikely(!__pyx_t_3)) {__pyx_filename = __pyx_f[0]; __pyx_lineno = 95; __pyx_clineno = __LINE__; goto __pyx_L1_error;}
-  __Pyx_GOTREF(__pyx_t_3);
-  __Pyx_DECREF(__pyx_t_2); __pyx_t_2 = 0;
-  __pyx_t_2 = PyTuple_New(2); if (unlikely(!__pyx_t_2)) {__pyx_filename = __pyx_f[0]; __pyx_lineno = 95; __pyx_clineno = __LINE__; goto __pyx_L1_error;}
-  __Pyx_GOTREF(__pyx_t_2);
-  __Pyx_INCREF(((PyObject *)__pyx_n_s__d));
-  PyTuple_SET_ITEM(__pyx_t_2, 0, ((PyObject *)__pyx_n_s__d));
-  __Pyx_GIVEREF(((PyObject *)__pyx_n_s__d));
-  __Pyx_INCREF(__pyx_v_coords);
-  PyTuple_SET_ITEM(__pyx_t_2, 1, __pyx_v_coords);
-  __Pyx_GIVEREF(__pyx_v_coords);
-  __pyx_t_4 = PyObject_Call(__pyx_t_3, __pyx_t_2, NULL); if (unlikely(!__pyx_t_4)) {__pyx_filename = __pyx_f[0]; __pyx_lineno = 95; __pyx_clineno = __LINE__; goto __pyx_L1_error;}
-  __Pyx_GOTREF(__pyx_t_4);
-  __Pyx_DECREF(__pyx_t_3); __pyx_t_3 = 0;
-  __Pyx_DECREF(__pyx_t_2); __pyx_t_2 = 0;
-  __pyx_t_2 = PyTuple_New(2); if (unlikely(!__pyx_t_2)) {__pyx_filename = __pyx_f[0]; __pyx_lineno = 95; __pyx_clineno = __LINE__; goto __pyx_L1_error;}
-  __Pyx_GOTREF(__pyx_t_2);
-  PyTuple_SET_ITEM(__pyx_t_2, 0, __pyx_t_1);
-  __Pyx_GIVEREF(__pyx_t_1);
-  PyTuple_SET_ITEM(__pyx_t_2, 1, __pyx_t_4);
-  __Pyx_GIVEREF(__pyx_t_4);
-  __pyx_t_1 = 0;
-  __pyx_t_4 = 0;
-  __pyx_t_4 = PyObject_Call(((PyObject *)((PyObject*)__pyx_ptype_6kdtree_PointData)), __pyx_t_2, NULL); if (unlikely(!__pyx_t_4)) {__pyx_filename = __pyx_f[0]; __pyx_lineno = 95; __pyx_clineno = __LINE__; goto __pyx_L1_error;}
-  __Pyx_GOTREF(__pyx_t_4);
-  __Pyx_DECREF(__pyx_t_2); __pyx_t_2 = 0;
-  __Pyx_GIVEREF(__pyx_t_4);
-  __Pyx_GOTREF(((struct __pyx_obj_6kdtree_KDTreeNode *)__pyx_v_self)->data);
-  __Pyx_DECREF(((PyObject *)((struct __pyx_obj_6kdtree_KDTreeNode *)__pyx_v_self)->data));
-  ((struct __pyx_obj_6kdtree_KDTreeNode *)__pyx_v_self)->data = ((struct __pyx_obj_6kdtree_PointData *)__pyx_t_4);
-  __pyx_t_4 = 0;
-
-  /* "/home/belisarius/github/py_kdtree/cython_wrapper/kdtree.pyx":96
- *     """Initializer to pass in the number of the node and its coordinates"""
- *     self.data = PointData(number, array.array('d', coords))
- *     self.left = None             # <<<<<<<<<<<<<<
- *     self.right = None
- * 
- */
-  __Pyx_INCREF(Py_None);
-  __Pyx_GIVEREF(Py_None);
-  __Pyx_GOTREF(((struct __pyx_obj_6kdtree_KDTreeNode *)__pyx_v_self)->left);
-  __Pyx_DECREF(((PyObject *)((struct __pyx_obj_6kdtree_KDTreeNode *)__pyx_v_self)->left));
-  ((struct __pyx_obj_6kdtree_KDTreeNode *)__pyx_v_self)->left = ((struct __pyx_obj_6kdtree_KDTreeNode *)Py_None);
-
-  /* "/home/belisarius/github/py_kdtree/cython_wrapper/kdtree.pyx":97
- *     self.data = PointData(number, array.array('d', coords))
- *     self.left = None
- *     self.right = None             # <<<<<<<<<<<<<<
- * 
- *   property num:
- */
-  __Pyx_INCREF(Py_None);
-  __Pyx_GIVEREF(Py_None);
-  __Pyx_GOTREF(((struct __pyx_obj_6kdtree_KDTreeNode *)__pyx_v_self)->right);
-  __Pyx_DECREF(((PyObject *)((struct __pyx_obj_6kdtree_KDTreeNode *)__pyx_v_self)->right));
-  ((struct __pyx_obj_6kdtree_KDTreeNode *)__pyx_v_self)->right = ((struct __pyx_obj_6kdtree_KDTreeNode *)Py_None);
-
-  __pyx_r = 0;
-  goto __pyx_L0;
-  __pyx_L1_error:;
-  __Pyx_XDECREF(__pyx_t_1);
-  __Pyx_XDECREF(__pyx_t_2);
-  __Pyx_XDECREF(__pyx_t_3);
-  __Pyx_XDECREF(__pyx_t_4);
-  __Pyx_AddTraceback("kdtree.KDTreeNode.__init__");
-  __pyx_r = -1;
-  __pyx_L0:;
-  __Pyx_RefNannyFinishContext();
-  return __pyx_r;
-}
-
-/* "/home/belisarius/github/py_kdtree/cython_wrapper/kdtree.pyx":100
- * 
- *   property num:
- *     def __get__(self):             # <<<<<<<<<<<<<<
- *       return self.data.num
- * 
- */
-
-static PyObject *__pyx_pf_6kdtree_10KDTreeNode_3num___get__(PyObject *__pyx_v_self); /*proto*/
-static PyObject *__pyx_pf_6kdtree_10KDTreeNode_3num___get__(PyObject *__pyx_v_self) {
-  PyObject *__pyx_r = NULL;
-  PyObject *__pyx_t_1 = NULL;
-  __Pyx_RefNannySetupContext("__get__");
-
-  /* "/home/belisarius/github/py_kdtree/cython_wrapper/kdtree.pyx":101
- *   property num:
- *     def __get__(self):
- *       return self.data.num             # <<<<<<<<<<<<<<
- * 
- *   property left:
- */
-  __Pyx_XDECREF(__pyx_r);
-  __pyx_t_1 = PyInt_FromLong(((struct __pyx_obj_6kdtree_KDTreeNode *)__pyx_v_self)->data->num); if (unlikely(!__pyx_t_1)) {__pyx_filename = __pyx_f[0]; __pyx_lineno = 101; __pyx_clineno = __LINE__; goto __pyx_L1_error;}
-  __Pyx_GOTREF(__pyx_t_1);
-  __pyx_r = __pyx_t_1;
-  __pyx_t_1 = 0;
-  goto __pyx_L0;
-
-  __pyx_r = Py_None; __Pyx_INCREF(Py_None);
-  goto __pyx_L0;
-  __pyx_L1_error:;
-  __Pyx_XDECREF(__pyx_t_1);
-  __Pyx_AddTraceback("kdtree.KDTreeNode.num.__get__");
-  __pyx_r = NULL;
-  __pyx_L0:;
-  __Pyx_XGIVEREF(__pyx_r);
-  __Pyx_RefNannyFinishContext();
-  return __pyx_r;
-}
-
-/* "/home/belisarius/github/py_kdtree/cython_wrapper/kdtree.pyx":104
- * 
- *   property left:
- *     def __get__(self):             # <<<<<<<<<<<<<<
- *       return self.left
- * 
- */
-
-static PyObject *__pyx_pf_6kdtree_10KDTreeNode_4left___get__(PyObject *__pyx_v_self); /*proto*/
-static PyObject *__pyx_pf_6kdtree_10KDTreeNode_4left___get__(PyObject *__pyx_v_self) {
-  PyObject *__pyx_r = NULL;
-  __Pyx_RefNannySetupContext("__get__");
-
-  /* "/home/belisarius/github/py_kdtree/cython_wrapper/kdtree.pyx":105
- *   property left:
- *     def __get__(self):
- *       return self.left             # <<<<<<<<<<<<<<
- * 
- *   property right:
- */
-  __Pyx_XDECREF(__pyx_r);
-  __Pyx_INCREF(((PyObject *)((struct __pyx_obj_6kdtree_KDTreeNode *)__pyx_v_self)->left));
-  __pyx_r = ((PyObject *)((struct __pyx_obj_6kdtree_KDTreeNode *)__pyx_v_self)->left);
-  goto __pyx_L0;
-
-  __pyx_r = Py_None; __Pyx_INCREF(Py_None);
-  __pyx_L0:;
-  __Pyx_XGIVEREF(__pyx_r);
-  __Pyx_RefNannyFinishContext();
-  return __pyx_r;
-}
-
-/* "/home/belisarius/github/py_kdtree/cython_wrapper/kdtree.pyx":108
- * 
- *   property right:
- *     def __get__(self):             # <<<<<<<<<<<<<<
- *       return self.right
- * 
- */
-
-static PyObject *__pyx_pf_6kdtree_10KDTreeNode_5right___get__(PyObject *__pyx_v_self); /*proto*/
-static PyObject *__pyx_pf_6kdtree_10KDTreeNode_5right___get__(PyObject *__pyx_v_self) {
-  PyObject *__pyx_r = NULL;
-  __Pyx_RefNannySetupContext("__get__");
-
-  /* "/home/belisarius/github/py_kdtree/cython_wrapper/kdtree.pyx":109
- *   property right:
- *     def __get__(self):
- *       return self.right             # <<<<<<<<<<<<<<
- * 
- *   cpdef run_nn_search(self, PointData search, size_t num_neighbors):
- */
-  __Pyx_XDECREF(__pyx_r);
-  __Pyx_INCREF(((PyObject *)((struct __pyx_obj_6kdtree_KDTreeNode *)__pyx_v_self)->right));
-  __pyx_r = ((PyObject *)((struct __pyx_obj_6kdtree_KDTreeNode *)__pyx_v_self)->right);
-  goto __pyx_L0;
-
-  __pyx_r = Py_None; __Pyx_INCREF(Py_None);
-  __pyx_L0:;
-  __Pyx_XGIVEREF(__pyx_r);
-  __Pyx_RefNannyFinishContext();
-  return __pyx_r;
-}
-
-/* "/home/belisarius/github/py_kdtree/cython_wrapper/kdtree.pyx":111
- *       return self.right
- * 
- *   cpdef run_nn_search(self, PointData search, size_t num_neighbors):             # <<<<<<<<<<<<<<
- *     """Runs a nearest neighbor search on the given point, which is defined
- *     by the PointData search param."""
- */
-
-static PyObject *__pyx_pf_6kdtree_10KDTreeNode_run_nn_search(PyObject *__pyx_v_self, PyObject *__pyx_args, PyObject *__pyx_kwds); /*proto*/
-static  PyObject *__pyx_f_6kdtree_10KDTreeNode_run_nn_search(struct __pyx_obj_6kdtree_KDTreeNode *__pyx_v_self, struct __pyx_obj_6kdtree_PointData *__pyx_v_search, size_t __pyx_v_num_neighbors, int __pyx_skip_dispatch) {
-  PyObject *__pyx_v_search_coords;
-  size_t __pyx_v_search_len;
-  struct __pyx_t_6kdtree_best_pair *__pyx_v_nearest;
-  size_t __pyx_v_i;
-  PyObject *__pyx_v_output;
-  PyObject *__pyx_r = NULL;
-  PyObject *__pyx_t_1 = NULL;
-  PyObject *__pyx_t_2 = NULL;
-  PyObject *__pyx_t_3 = NULL;
-  Py_ssize_t __pyx_t_4;
-  int __pyx_t_5;
-  size_t __pyx_t_6;
-  size_t __pyx_t_7;
-  __Pyx_RefNannySetupContext("run_nn_search");
-  __Pyx_INCREF((PyObject *)__pyx_v_self);
-  __Pyx_INCREF((PyObject *)__pyx_v_search);
-  __pyx_v_search_coords = Py_None; __Pyx_INCREF(Py_None);
-  __pyx_v_output = Py_None; __Pyx_INCREF(Py_None);
-  /* Check if called by wrapper */
-  if (unlikely(__pyx_skip_dispatch)) ;
-  /* Check if overriden in Python */
-  else if (unlikely(Py_TYPE(((PyObject *)__pyx_v_self))->tp_dictoffset != 0)) {
-    __pyx_t_1 = PyObject_GetAttr(((PyObject *)__pyx_v_self), __pyx_n_s__run_nn_search); if (unlikely(!__pyx_t_1)) {__pyx_filename = __pyx_f[0]; __pyx_lineno = 111; __pyx_clineno = __LINE__; goto __pyx_L1_error;}
-    __Pyx_GOTREF(__pyx_t_1);
-    if (!PyCFunction_Check(__pyx_t_1) || (PyCFunction_GET_FUNCTION(__pyx_t_1) != (void *)&__pyx_pf_6kdtree_10KDTreeNode_run_nn_search)) {
-      __Pyx_XDECREF(__pyx_r);
-      __pyx_t_2 = __Pyx_PyInt_FromSize_t(__pyx_v_num_neighbors); if (unlikely(!__pyx_t_2)) {__pyx_filename = __pyx_f[0]; __pyx_lineno = 111; __pyx_clineno = __LINE__; goto __pyx_L1_error;}
-      __Pyx_GOTREF(__pyx_t_2);
-      __pyx_t_3 = PyTuple_New(2); if (unlikely(!__pyx_t_3)) {__pyx_filename = __pyx_f[0]; __pyx_lineno = 111; __pyx_clineno = __LINE__; goto __pyx_L1_error;}
-      __Pyx_GOTREF(__pyx_t_3);
-      __Pyx_INCREF(((PyObject *)__pyx_v_search));
-      PyTuple_SET_ITEM(__pyx_t_3, 0, ((PyObject *)__pyx_v_search));
-      __Pyx_GIVEREF(((PyObject *)__pyx_v_search));
-      PyTuple_SET_ITEM(__pyx_t_3, 1, __pyx_t_2);
-      __Pyx_GIVEREF(__pyx_t_2);
-      __pyx_t_2 = 0;
-      __pyx_t_2 = PyObject_Call(__pyx_t_1, __pyx_t_3, NULL); if (unlikely(!__pyx_t_2)) {__pyx_filename = __pyx_f[0]; __pyx_lineno = 111; __pyx_clineno = __LINE__; goto __pyx_L1_error;}
-      __Pyx_GOTREF(__pyx_t_2);
-      __Pyx_DECREF(__pyx_t_3); __pyx_t_3 = 0;
-      __pyx_r = __pyx_t_2;
-      __pyx_t_2 = 0;
-      __Pyx_DECREF(__pyx_t_1); __pyx_t_1 = 0;
-      goto __pyx_L0;
-    }
-    __Pyx_DECREF(__pyx_t_1); __pyx_t_1 = 0;
-  }
-
-  /* "/home/belisarius/github/py_kdtree/cython_wrapper/kdtree.pyx":115
- *     by the PointData search param."""
- * 
- *     search_coords = search.coords             # <<<<<<<<<<<<<<
- *     cdef size_t search_len = len(search_coords)
- * 
- */
-  __Pyx_INCREF(__pyx_v_search->coords);
-  __Pyx_DECREF(__pyx_v_search_coords);
-  __pyx_v_search_coords = __pyx_v_search->coords;
-
-  /* "/home/belisarius/github/py_kdtree/cython_wrapper/kdtree.pyx":116
- * 
- *     search_coords = search.coords
- *     cdef size_t search_len = len(search_coords)             # <<<<<<<<<<<<<<
- * 
- *     # cdef best_pair[num_neighbors] won't work; Cython complains about wanting
- */
-  __pyx_t_4 = PyObject_Length(__pyx_v_search_coords); if (unlikely(__pyx_t_4 == -1)) {__pyx_filename = __pyx_f[0]; __pyx_lineno = 116; __pyx_clineno = __LINE__; goto __pyx_L1_error;}
-  __pyx_v_search_len = __pyx_t_4;
-
-  /* "/home/belisarius/github/py_kdtree/cython_wrapper/kdtree.pyx":120
- *     # cdef best_pair[num_neighbors] won't work; Cython complains about wanting
- *     # constants for allocation, so we need to dynamically allocate it
- *     cdef best_pair *nearest = <best_pair *>malloc(num_neighbors * sizeof(best_pair))             # <<<<<<<<<<<<<<
- *     if not nearest:
- *       raise MemoryError()
- */
-  __pyx_v_nearest = ((struct __pyx_t_6kdtree_best_pair *)malloc((__pyx_v_num_neighbors * (sizeof(struct __pyx_t_6kdtree_best_pair)))));
-
-  /* "/home/belisarius/github/py_kdtree/cython_wrapper/kdtree.pyx":121
- *     # constants for allocation, so we need to dynamically allocate it
- *     cdef best_pair *nearest = <best_pair *>malloc(num_neighbors * sizeof(best_pair))
- *     if not nearest:             # <<<<<<<<<<<<<<
- *       raise MemoryError()
- * 
- */
-  __pyx_t_5 = (!(__pyx_v_nearest != 0));
-  if (__pyx_t_5) {
-
-    /* "/home/belisarius/github/py_kdtree/cython_wrapper/kdtree.pyx":122
- *     cdef best_pair *nearest = <best_pair *>malloc(num_neighbors * sizeof(best_pair))
- *     if not nearest:
- *       raise MemoryError()             # <<<<<<<<<<<<<<
- * 
- *     cdef size_t i
- */
-    __pyx_t_1 = PyObject_Call(__pyx_builtin_MemoryError, ((PyObject *)__pyx_empty_tuple), NULL); if (unlikely(!__pyx_t_1)) {__pyx_filename = __pyx_f[0]; __pyx_lineno = 122; __pyx_clineno = __LINE__; goto __pyx_L1_error;}
-    __Pyx_GOTREF(__pyx_t_1);
-    __Pyx_Raise(__pyx_t_1, 0, 0);
-    __Pyx_DECREF(__pyx_t_1); __pyx_t_1 = 0;
-    {__pyx_filename = __pyx_f[0]; __pyx_lineno = 122; __pyx_clineno = __LINE__; goto __pyx_L1_error;}
-    goto __pyx_L3;
-  }
-  __pyx_L3:;
-
-  /* "/home/belisarius/github/py_kdtree/cython_wrapper/kdtree.pyx":125
- * 
- *     cdef size_t i
- *     try:             # <<<<<<<<<<<<<<
- *       nn_search(self, search, nearest, 0, num_neighbors, 0)
- *       output = []
- */
-  /*try:*/ {
-
-    /* "/home/belisarius/github/py_kdtree/cython_wrapper/kdtree.pyx":126
- *     cdef size_t i
- *     try:
- *       nn_search(self, search, nearest, 0, num_neighbors, 0)             # <<<<<<<<<<<<<<
- *       output = []
- *       for i in xrange(num_neighbors):
- */
-    __pyx_t_6 = __pyx_f_6kdtree_nn_search(__pyx_v_self, __pyx_v_search, __pyx_v_nearest, 0, __pyx_v_num_neighbors, 0); if (unlikely(__pyx_t_6 == -2 && PyErr_Occurred())) {__pyx_filename = __pyx_f[0]; __pyx_lineno = 126; __pyx_clineno = __LINE__; goto __pyx_L5;}
-
-    /* "/home/belisarius/github/py_kdtree/cython_wrapper/kdtree.pyx":127
- *     try:
- *       nn_search(self, search, nearest, 0, num_neighbors, 0)
- *       output = []             # <<<<<<<<<<<<<<
- *       for i in xrange(num_neighbors):
- *         output.append(nearest[i].node_num)
- */
-    __pyx_t_1 = PyList_New(0); if (unlikely(!__pyx_t_1)) {__pyx_filename = __pyx_f[0]; __pyx_lineno = 127; __pyx_clineno = __LINE__; goto __pyx_L5;}
-    __Pyx_GOTREF(((PyObject *)__pyx_t_1));
-    __Pyx_DECREF(__pyx_v_output);
-    __pyx_v_output = ((PyObject *)__pyx_t_1);
-    __pyx_t_1 = 0;
-
-    /* "/home/belisarius/github/py_kdtree/cython_wrapper/kdtree.pyx":128
- *       nn_search(self, search, nearest, 0, num_neighbors, 0)
- *       output = []
- *       for i in xrange(num_neighbors):             # <<<<<<<<<<<<<<
- *         output.append(nearest[i].node_num)
- * 
- */
-    __pyx_t_6 = __pyx_v_num_neighbors;
-    for (__pyx_t_7 = 0; __pyx_t_7 < __pyx_t_6; __pyx_t_7+=1) {
-      __pyx_v_i = __pyx_t_7;
-
-      /* "/home/belisarius/github/py_kdtree/cython_wrapper/kdtree.pyx":129
- *       output = []
- *       for i in xrange(num_neighbors):
- *         output.append(nearest[i].node_num)             # <<<<<<<<<<<<<<
- * 
- *       return output
- */
-      __pyx_t_1 = PyInt_FromLong((__pyx_v_nearest[__pyx_v_i]).node_num); if (unlikely(!__pyx_t_1)) {__pyx_filename = __pyx_f[0]; __pyx_lineno = 129; __pyx_clineno = __LINE__; goto __pyx_L5;}
-      __Pyx_GOTREF(__pyx_t_1);
-      __pyx_t_2 = __Pyx_PyObject_Append(__pyx_v_output, __pyx_t_1); if (unlikely(!__pyx_t_2)) {__pyx_filename = __pyx_f[0]; __pyx_lineno = 129; __pyx_clineno = __LINE__; goto __pyx_L5;}
-      __Pyx_GOTREF(__pyx_t_2);
-      __Pyx_DECREF(__pyx_t_1); __pyx_t_1 = 0;
-      __Pyx_DECREF(__pyx_t_2); __pyx_t_2 = 0;
-    }
-
-    /* "/home/belisarius/github/py_kdtree/cython_wrapper/kdtree.pyx":131
- *         output.append(nearest[i].node_num)
- * 
- *       return output             # <<<<<<<<<<<<<<
- *     finally:
- *       if NULL != nearest:
- */
-    __Pyx_XDECREF(__pyx_r);
-    __Pyx_INCREF(__pyx_v_output);
-    __pyx_r = __pyx_v_output;
-    goto __pyx_L4;
-  }
-  /*finally:*/ {
-    int __pyx_why;
-    PyObject *__pyx_exc_type, *__pyx_exc_value, *__pyx_exc_tb;
-    int __pyx_exc_lineno;
-    __pyx_exc_type = 0; __pyx_exc_value = 0; __pyx_exc_tb = 0; __pyx_exc_lineno = 0;
-    __pyx_why = 0; goto __pyx_L6;
-    __pyx_L4: __pyx_exc_type = 0; __pyx_exc_value = 0; __pyx_exc_tb = 0; __pyx_exc_lineno = 0;
-    __pyx_why = 3; goto __pyx_L6;
-    __pyx_L5: {
-      __pyx_why = 4;
-      __Pyx_XDECREF(__pyx_t_3); __pyx_t_3 = 0;
-      __Pyx_XDECREF(__pyx_t_1); __pyx_t_1 = 0;
-      __Pyx_XDECREF(__pyx_t_2); __pyx_t_2 = 0;
-      __Pyx_ErrFetch(&__pyx_exc_type, &__pyx_exc_value, &__pyx_exc_tb);
-      __pyx_exc_lineno = __pyx_lineno;
-      goto __pyx_L6;
-    }
-    __pyx_L6:;
-
-    /* "/home/belisarius/github/py_kdtree/cython_wrapper/kdtree.pyx":133
- *       return output
- *     finally:
- *       if NULL != nearest:             # <<<<<<<<<<<<<<
- *         free(nearest)
- *         nearest = NULL
- */
-    __pyx_t_5 = (NULL != __pyx_v_nearest);
-    if (__pyx_t_5) {
-
-      /* "/home/belisarius/github/py_kdtree/cython_wrapper/kdtree.pyx":134
- *     finally:
- *       if NULL != nearest:
- *         free(nearest)             # <<<<<<<<<<<<<<
- *         nearest = NULL
- * 
- */
-      free(__pyx_v_nearest);
-
-      /* "/home/belisarius/github/py_kdtree/cython_wrapper/kdtree.pyx":135
- *       if NULL != nearest:
- *         free(nearest)
- *         nearest = NULL             # <<<<<<<<<<<<<<
- * 
- * cpdef print_preorder(KDTreeNode node):
- */
-      __pyx_v_nearest = NULL;
-      goto __pyx_L10;
-    }
-    __pyx_L10:;
-    switch (__pyx_why) {
-      case 3: goto __pyx_L0;
-      case 4: {
-        __Pyx_ErrRestore(__pyx_exc_type, __pyx_exc_value, __pyx_exc_tb);
-        __pyx_lineno = __pyx_exc_lineno;
-        __pyx_exc_type = 0;
-        __pyx_exc_value = 0;
-        __pyx_exc_tb = 0;
-        goto __pyx_L1_error;
-      }
-    }
-  }
-
-  __pyx_r = Py_None; __Pyx_INCREF(Py_None);
-  goto __pyx_L0;
-  __pyx_L1_error:;
-  __Pyx_XDECREF(__pyx_t_1);
-  __Pyx_XDECREF(__pyx_t_2);
-  __Pyx_XDECREF(__pyx_t_3);
-  __Pyx_AddTraceback("kdtree.KDTreeNode.run_nn_search");
-  __pyx_r = 0;
-  __pyx_L0:;
-  __Pyx_DECREF(__pyx_v_search_coords);
-  __Pyx_DECREF(__pyx_v_output);
-  __Pyx_DECREF((PyObject *)__pyx_v_self);
-  __Pyx_DECREF((PyObject *)__pyx_v_search);
-  __Pyx_XGIVEREF(__pyx_r);
-  __Pyx_RefNannyFinishContext();
-  return __pyx_r;
-}
-
-/* "/home/belisarius/github/py_kdtree/cython_wrapper/kdtree.pyx":111
- *       return self.right
- * 
- *   cpdef run_nn_search(self, PointData search, size_t num_neighbors):             # <<<<<<<<<<<<<<
- *     """Runs a nearest neighbor search on the given point, which is defined
- *     by the PointData search param."""
- */
-
-static PyObject *__pyx_pf_6kdtree_10KDTreeNode_run_nn_search(PyObject *__pyx_v_self, PyObject *__pyx_args, PyObject *__pyx_kwds); /*proto*/
-static char __pyx_doc_6kdtree_10KDTreeNode_run_nn_search[] = "Runs a nearest neighbor search on the given point, which is defined\n    by the PointData search param.";
-static PyObject *__pyx_pf_6kdtree_10KDTreeNode_run_nn_search(PyObject *__pyx_v_self, PyObject *__pyx_args, PyObject *__pyx_kwds) {
-  struct __pyx_obj_6kdtree_PointData *__pyx_v_search = 0;
-  size_t __pyx_v_num_neighbors;
-  PyObject *__pyx_r = NULL;
-  PyObject *__pyx_t_1 = NULL;
-  static PyObject **__pyx_pyargnames[] = {&__pyx_n_s__search,&__pyx_n_s__num_neighbors,0};
-  __Pyx_RefNannySetupContext("run_nn_search");
-  if (unlikely(__pyx_kwds)) {
-    Py_ssize_t kw_args = PyDict_Size(__pyx_kwds);
-    PyObject* values[2] = {0,0};
-    switch (PyTuple_GET_SIZE(__pyx_args)) {
-      case  2: values[1] = PyTuple_GET_ITEM(__pyx_args, 1);
-      case  1: values[0] = PyTuple_GET_ITEM(__pyx_args, 0);
-      case  0: break;
-      default: goto __pyx_L5_argtuple_error;
-    }
-    switch (PyTuple_GET_SIZE(__pyx_args)) {
-      case  0:
-      values[0] = PyDict_GetItem(__pyx_kwds, __pyx_n_s__search);
-      if (likely(values[0])) kw_args--;
-      else goto __pyx_L5_argtuple_error;
-      case  1:
-      values[1] = PyDict_GetItem(__pyx_kwds, __pyx_n_s__num_neighbors);
-      if (likely(values[1])) kw_args--;
-      else {
-        __Pyx_RaiseArgtupleInvalid("run_nn_search", 1, 2, 2, 1); {__pyx_filename = __pyx_f[0]; __pyx_lineno = 111; __pyx_clineno = __LINE__; goto __pyx_L3_error;}
-      }
-    }
-    if (unlikely(kw_args > 0)) {
-      if (unlikely(__Pyx_ParseOptionalKeywords(__pyx_kwds, __pyx_pyargnames, 0, values, PyTuple_GET_SIZE(__pyx_args), "run_nn_search") < 0)) {__pyx_filename = __pyx_f[0]; __pyx_lineno = 111; __pyx_clineno = __LINE__; goto __pyx_L3_error;}
-    }
-    __pyx_v_search = ((struct __pyx_obj_6kdtree_PointData *)values[0]);
-    __pyx_v_num_neighbors = __Pyx_PyInt_AsSize_t(values[1]); if (unlikely((__pyx_v_num_neighbors == (size_t)-1) && PyErr_Occurred())) {__pyx_filename = __pyx_f[0]; __pyx_lineno = 111; __pyx_clineno = __LINE__; goto __pyx_L3_error;}
-  } else if (PyTuple_GET_SIZE(__pyx_args) != 2) {
-    goto __pyx_L5_argtuple_error;
-  } else {
-    __pyx_v_search = ((struct __pyx_obj_6kdtree_PointData *)PyTuple_GET_ITEM(__pyx_args, 0));
-    __pyx_v_num_neighbors = __Pyx_PyInt_AsSize_t(PyTuple_GET_ITEM(__pyx_args, 1)); if (unlikely((__pyx_v_num_neighbors == (size_t)-1) && PyErr_Occurred())) {__pyx_filename = __pyx_f[0]; __pyx_lineno = 111; __pyx_clineno = __LINE__; goto __pyx_L3_error;}
-  }
-  goto __pyx_L4_argument_unpacking_done;
-  __pyx_L5_argtuple_error:;
-  __Pyx_RaiseArgtupleInvalid("run_nn_search", 1, 2, 2, PyTuple_GET_SIZE(__pyx_args)); {__pyx_filename = __pyx_f[0]; __pyx_lineno = 111; __pyx_clineno = __LINE__; goto __pyx_L3_error;}
-  __pyx_L3_error:;
-  __Pyx_AddTraceback("kdtree.KDTreeNode.run_nn_search");
-  return NULL;
-  __pyx_L4_argument_unpacking_done:;
-  if (unlikely(!__Pyx_ArgTypeTest(((PyObject *)__pyx_v_search), __pyx_ptype_6kdtree_PointData, 1, "search", 0))) {__pyx_filename = __pyx_f[0]; __pyx_lineno = 111; __pyx_clineno = __LINE__; goto __pyx_L1_error;}
-  __Pyx_XDECREF(__pyx_r);
-  __pyx_t_1 = ((struct __pyx_vtabstruct_6kdtree_KDTreeNode *)((struct __pyx_obj_6kdtree_KDTreeNode *)__pyx_v_self)->__pyx_vtab)->run_nn_search(((struct __pyx_obj_6kdtree_KDTreeNode *)__pyx_v_self), __pyx_v_search, __pyx_v_num_neighbors, 1); if (unlikely(!__pyx_t_1)) {__pyx_filename = __pyx_f[0]; __pyx_lineno = 111; __pyx_clineno = __LINE__; goto __pyx_L1_error;}
-  __Pyx_GOTREF(__pyx_t_1);
-  __pyx_r = __pyx_t_1;
-  __pyx_t_1 = 0;
-  goto __pyx_L0;
-
-  __pyx_r = Py_None; __Pyx_INCREF(Py_None);
-  goto __pyx_L0;
-  __pyx_L1_error:;
-  __Pyx_XDECREF(__pyx_t_1);
-  __Pyx_AddTraceback("kdtree.KDTreeNode.run_nn_search");
-  __pyx_r = NULL;
-  __pyx_L0:;
-  __Pyx_XGIVEREF(__pyx_r);
-  __Pyx_RefNannyFinishContext();
-  return __pyx_r;
-}
-
-/* "/home/belisarius/github/py_kdtree/cython_wrapper/kdtree.pyx":137
- *         nearest = NULL
- * 
- * cpdef print_preorder(KDTreeNode node):             # <<<<<<<<<<<<<<
- *   """Print the nodes of the tree in pre-order fashion."""
- *   if node is None:
- */
-
-static PyObject *__pyx_pf_6kdtree_print_preorder(PyObject *__pyx_self, PyObject *__pyx_v_node); /*proto*/
-static  PyObject *__pyx_f_6kdtree_print_preorder(struct __pyx_obj_6kdtree_KDTreeNode *__pyx_v_node, int __pyx_skip_dispatch) {
-  PyObject *__pyx_r = NULL;
-  int __pyx_t_1;
-  PyObject *__pyx_t_2 = NULL;
-  PyObject *__pyx_t_3 = NULL;
-  PyObject *__pyx_t_4 = NULL;
-  PyObject *__pyx_t_5 = NULL;
-  __Pyx_RefNannySetupContext("print_preorder");
-  __Pyx_INCREF((PyObject *)__pyx_v_node);
-
-  /* "/home/belisarius/github/py_kdtree/cython_wrapper/kdtree.pyx":139
- * cpdef print_preorder(KDTreeNode node):
- *   """Print the nodes of the tree in pre-order fashion."""
- *   if node is None:             # <<<<<<<<<<<<<<
- *     return
- *   print "%d [%f,%f]" % (node.num, node.data.coords[0], node.data.coords[1])
- */
-  __pyx_t_1 = (((PyObject *)__pyx_v_node) == Py_None);
-  if (__pyx_t_1) {
-
-    /* "/home/belisarius/github/py_kdtree/cython_wrapper/kdtree.pyx":140
- *   """Print the nodes of the tree in pre-order fashion."""
- *   if node is None:
- *     return             # <<<<<<<<<<<<<<
- *   print "%d [%f,%f]" % (node.num, node.data.coords[0], node.data.coords[1])
- *   print_preorder(node.left)
- */
-    __Pyx_XDECREF(__pyx_r);
-    __pyx_r = Py_None; __Pyx_INCREF(Py_None);
-    goto __pyx_L0;
-    goto __pyx_L3;
-  }
-  __pyx_L3:;
-
-  /* "/home/belisarius/github/py_kdtree/cython_wrapper/kdtree.pyx":141
- *   if node is None:
- *     return
- *   print "%d [%f,%f]" % (node.num, node.data.coords[0], node.data.coords[1])             # <<<<<<<<<<<<<<
- *   print_preorder(node.left)
- *   print_preorder(node.right)
- */
-  __pyx_t_2 = PyObject_GetAttr(((PyObject *)__pyx_v_node), __pyx_n_s__num); if (unlikely(!__pyx_t_2)) {__pyx_filename = __pyx_f[0]; __pyx_lineno = 141; __pyx_clineno = __LINE__; goto __pyx_L1_error;}
-  __Pyx_GOTREF(__pyx_t_2);
-  __pyx_t_3 = __Pyx_GetItemInt(__pyx_v_node->data->coords, 0, sizeof(long), PyInt_FromLong); if (!__pyx_t_3) {__pyx_filename = __pyx_f[0]; __pyx_lineno = 141; __pyx_clineno = __LINE__; goto __pyx_L1_error;}
-  __Pyx_GOTREF(__pyx_t_3);
-  __pyx_t_4 = __Pyx_GetItemInt(__pyx_v_node->data->coords, 1, sizeof(long), PyInt_FromLong); if (!__pyx_t_4) {__pyx_filename = __pyx_f[0]; __pyx_lineno = 141; __pyx_clineno = __LINE__; goto __pyx_L1_error;}
-  __Pyx_GOTREF(__pyx_t_4);
-  __pyx_t_5 = PyTuple_New(3); if (unlikely(!__pyx_t_5)) {__pyx_filename = __pyx_f[0]; __pyx_lineno = 141; __pyx_clineno = __LINE__; goto __pyx_L1_error;}
-  __Pyx_GOTREF(__pyx_t_5);
-  PyTuple_SET_ITEM(__pyx_t_5, 0, __pyx_t_2);
-  __Pyx_GIVEREF(__pyx_t_2);
-  PyTuple_SET_ITEM(__pyx_t_5, 1, __pyx_t_3);
-  __Pyx_GIVEREF(__pyx_t_3);
-  PyTuple_SET_ITEM(__pyx_t_5, 2, __pyx_t_4);
-  __Pyx_GIVEREF(__pyx_t_4);
-  __pyx_t_2 = 0;
-  __pyx_t_3 = 0;
-  __pyx_t_4 = 0;
-  __pyx_t_4 = PyNumber_Remainder(((PyObject *)__pyx_kp_s_2), __pyx_t_5); if (unlikely(!__pyx_t_4)) {__pyx_filename = __pyx_f[0]; __pyx_lineno = 141; __pyx_clineno = __LINE__; goto __pyx_L1_error;}
-  __Pyx_GOTREF(__pyx_t_4);
-  __Pyx_DECREF(__pyx_t_5); __pyx_t_5 = 0;
-  if (__Pyx_PrintOne(__pyx_t_4) < 0) {__pyx_filename = __pyx_f[0]; __pyx_lineno = 141; __pyx_clineno = __LINE__; goto __pyx_L1_error;}
-  __Pyx_DECREF(__pyx_t_4); __pyx_t_4 = 0;
-
-  /* "/home/belisarius/github/py_kdtree/cython_wrapper/kdtree.pyx":142
- *     return
- *   print "%d [%f,%f]" % (node.num, node.data.coords[0], node.data.coords[1])
- *   print_preorder(node.left)             # <<<<<<<<<<<<<<
- *   print_preorder(node.right)
- * 
- */
-  __pyx_t_4 = __pyx_f_6kdtree_print_preorder(__pyx_v_node->left, 0); if (unlikely(!__pyx_t_4)) {__pyx_filename = __pyx_f[0]; __pyx_lineno = 142; __pyx_clineno = __LINE__; goto __pyx_L1_error;}
-  __Pyx_GOTREF(__pyx_t_4);
-  __Pyx_DECREF(__pyx_t_4); __pyx_t_4 = 0;
-
-  /* "/home/belisarius/github/py_kdtree/cython_wrapper/kdtree.pyx":143
- *   print "%d [%f,%f]" % (node.num, node.data.coords[0], node.data.coords[1])
- *   print_preorder(node.left)
- *   print_preorder(node.right)             # <<<<<<<<<<<<<<
- * 
- * cdef KDTreeNode fill_tree_r(pointList, size_t depth):
- */
-  __pyx_t_4 = __pyx_f_6kdtree_print_preorder(__pyx_v_node->right, 0); if (unlikely(!__pyx_t_4)) {__pyx_filename = __pyx_f[0]; __pyx_lineno = 143; __pyx_clineno = __LINE__; goto __pyx_L1_error;}
-  __Pyx_GOTREF(__pyx_t_4);
-  __Pyx_DECREF(__pyx_t_4); __pyx_t_4 = 0;
-
-  __pyx_r = Py_None; __Pyx_INCREF(Py_None);
-  goto __pyx_L0;
-  __pyx_L1_error:;
-  __Pyx_XDECREF(__pyx_t_2);
-  __Pyx_XDECREF(__pyx_t_3);
-  __Pyx_XDECREF(__pyx_t_4);
-  __Pyx_XDECREF(__pyx_t_5);
-  __Pyx_AddTraceback("kdtree.print_preorder");
-  __pyx_r = 0;
-  __pyx_L0:;
-  __Pyx_DECREF((PyObject *)__pyx_v_node);
-  __Pyx_XGIVEREF(__pyx_r);
-  __Pyx_RefNannyFinishContext();
-  return __pyx_r;
-}
-
-/* "/home/belisarius/github/py_kdtree/cython_wrapper/kdtree.pyx":137
- *         nearest = NULL
- * 
- * cpdef print_preorder(KDTreeNode node):             # <<<<<<<<<<<<<<
- *   """Print the nodes of the tree in pre-order fashion."""
- *   if node is None:
- */
-
-static PyObject *__pyx_pf_6kdtree_print_preorder(PyObject *__pyx_self, PyObject *__pyx_v_node); /*proto*/
-static char __pyx_doc_6kdtree_print_preorder[] = "Print the nodes of the tree in pre-order fashion.";
-static PyObject *__pyx_pf_6kdtree_print_preorder(PyObject *__pyx_self, PyObject *__pyx_v_node) {
-  PyObject *__pyx_r = NULL;
-  PyObject *__pyx_t_1 = NULL;
-  __Pyx_RefNannySetupContext("print_preorder");
-  __pyx_self = __pyx_self;
-  if (unlikely(!__Pyx_ArgTypeTest(((PyObject *)__pyx_v_node), __pyx_ptype_6kdtree_KDTreeNode, 1, "node", 0))) {__pyx_filename = __pyx_f[0]; __pyx_lineno = 137; __pyx_clineno = __LINE__; goto __pyx_L1_error;}
-  __Pyx_XDECREF(__pyx_r);
-  __pyx_t_1 = __pyx_f_6kdtree_print_preorder(((struct __pyx_obj_6kdtree_KDTreeNode *)__pyx_v_node), 0); if (unlikely(!__pyx_t_1)) {__pyx_filename = __pyx_f[0]; __pyx_lineno = 137; __pyx_clineno = __LINE__; goto __pyx_L1_error;}
-  __Pyx_GOTREF(__pyx_t_1);
-  __pyx_r = __pyx_t_1;
-  __pyx_t_1 = 0;
-  goto __pyx_L0;
-
-  __pyx_r = Py_None; __Pyx_INCREF(Py_None);
-  goto __pyx_L0;
-  __pyx_L1_error:;
-  __Pyx_XDECREF(__pyx_t_1);
-  __Pyx_AddTraceback("kdtree.print_preorder");
-  __pyx_r = NULL;
-  __pyx_L0:;
-  __Pyx_XGIVEREF(__pyx_r);
-  __Pyx_RefNannyFinishContext();
-  return __pyx_r;
-}
-
-/* "/home/belisarius/github/py_kdtree/cython_wrapper/kdtree.pyx":145
- *   print_preorder(node.right)
- * 
- * cdef KDTreeNode fill_tree_r(pointList, size_t depth):             # <<<<<<<<<<<<<<
- *   """Constructs a KD-tree and returns the root node.  pointList is a list of PointData elements."""
- *   if not pointList:
- */
-
-static  struct __pyx_obj_6kdtree_KDTreeNode *__pyx_f_6kdtree_fill_tree_r(PyObject *__pyx_v_pointList, size_t __pyx_v_depth) {
-  size_t __pyx_v_dims;
-  size_t __pyx_v_axis;
-  struct __pyx_obj_6kdtree_PointData *__pyx_v_p;
-  size_t __pyx_v_median;
-  PyObject *__pyx_v_pl_median;
-  int __pyx_v_next_depth;
-  struct __pyx_obj_6kdtree_KDTreeNode *__pyx_v_node = 0;
-  struct __pyx_obj_6kdtree_KDTreeNode *__pyx_r = NULL;
-  int __pyx_t_1;
-  int __pyx_t_2;
-  PyObject *__pyx_t_3 = NULL;
-  PyObject *__pyx_t_4 = NULL;
-  size_t __pyx_t_5;
-  Py_ssize_t __pyx_t_6;
-  PyObject *__pyx_t_7 = NULL;
-  __Pyx_RefNannySetupContext("fill_tree_r");
-  __Pyx_INCREF(__pyx_v_pointList);
-  __pyx_v_p = ((struct __pyx_obj_6kdtree_PointData *)Py_None); __Pyx_INCREF(Py_None);
-  __pyx_v_pl_median = Py_None; __Pyx_INCREF(Py_None);
-
-  /* "/home/belisarius/github/py_kdtree/cython_wrapper/kdtree.pyx":147
- * cdef KDTreeNode fill_tree_r(pointList, size_t depth):
- *   """Constructs a KD-tree and returns the root node.  pointList is a list of PointData elements."""
- *   if not pointList:             # <<<<<<<<<<<<<<
- *     # TODO would using a null sentinel node make all of this run faster?
- *     return None
- */
-  __pyx_t_1 = __Pyx_PyObject_IsTrue(__pyx_v_pointList); if (unlikely(__pyx_t_1 < 0)) {__pyx_filename = __pyx_f[0]; __pyx_lineno = 147; __pyx_clineno = __LINE__; goto __pyx_L1_error;}
-  __pyx_t_2 = (!__pyx_t_1);
-  if (__pyx_t_2) {
-
-    /* "/home/belisarius/github/py_kdtree/cython_wrapper/kdtree.pyx":149
- *   if not pointList:
- *     # TODO would using a null sentinel node make all of this run faster?
- *     return None             # <<<<<<<<<<<<<<
- * 
- *   cdef size_t dims = pointList[0].dims # assumes all points have the same dimension
- */
-    __Pyx_XDECREF(((PyObject *)__pyx_r));
-    __Pyx_INCREF(Py_None);
-    __pyx_r = ((struct __pyx_obj_6kdtree_KDTreeNode *)Py_None);
-    goto __pyx_L0;
-    goto __pyx_L3;
-  }
-  __pyx_L3:;
-
-  /* "/home/belisarius/github/py_kdtree/cython_wrapper/kdtree.pyx":151
- *     return None
- * 
- *   cdef size_t dims = pointList[0].dims # assumes all points have the same dimension             # <<<<<<<<<<<<<<
- *   cdef size_t axis = pick_axis(depth, dims)
- *   cdef PointData p
- */
-  __pyx_t_3 = __Pyx_GetItemInt(__pyx_v_pointList, 0, sizeof(long), PyInt_FromLong); if (!__pyx_t_3) {__pyx_filename = __pyx_f[0]; __pyx_lineno = 151; __pyx_clineno = __LINE__; goto __pyx_L1_error;}
-  __Pyx_GOTREF(__pyx_t_3);
-  __pyx_t_4 = PyObject_GetAttr(__pyx_t_3, __pyx_n_s__dims); if (unlikely(!__pyx_t_4)) {__pyx_filename = __pyx_f[0]; __pyx_lineno = 151; __pyx_clineno = __LINE__; goto __pyx_L1_error;}
-  __Pyx_GOTREF(__pyx_t_4);
-  __Pyx_DECREF(__pyx_t_3); __pyx_t_3 = 0;
-  __pyx_t_5 = __Pyx_PyInt_AsSize_t(__pyx_t_4); if (unlikely((__pyx_t_5 == (size_t)-1) && PyErr_Occurred())) {__pyx_filename = __pyx_f[0]; __pyx_lineno = 151; __pyx_clineno = __LINE__; goto __pyx_L1_error;}
-  __Pyx_DECREF(__pyx_t_4); __pyx_t_4 = 0;
-  __pyx_v_dims = __pyx_t_5;
-
-  /* "/home/belisarius/github/py_kdtree/cython_wrapper/kdtree.pyx":152
- * 
- *   cdef size_t dims = pointList[0].dims # assumes all points have the same dimension
- *   cdef size_t axis = pick_axis(depth, dims)             # <<<<<<<<<<<<<<
- *   cdef PointData p
- *   for p in pointList:
- */
-  __pyx_v_axis = __pyx_f_6kdtree_pick_axis(__pyx_v_depth, __pyx_v_dims);
-
-  /* "/home/belisarius/github/py_kdtree/cython_wrapper/kdtree.pyx":154
- *   cdef size_t axis = pick_axis(depth, dims)
- *   cdef PointData p
- *   for p in pointList:             # <<<<<<<<<<<<<<
- *     p.curr_axis = axis
- * 
- */
-  if (PyList_CheckExact(__pyx_v_pointList) || PyTuple_CheckExact(__pyx_v_pointList)) {
-    __pyx_t_6 = 0; __pyx_t_4 = __pyx_v_pointList; __Pyx_INCREF(__pyx_t_4);
-  } else {
-    __pyx_t_6 = -1; __pyx_t_4 = PyObject_GetIter(__pyx_v_pointList); if (unlikely(!__pyx_t_4)) {__pyx_filename = __pyx_f[0]; __pyx_lineno = 154; __pyx_clineno = __LINE__; goto __pyx_L1_error;}
-    __Pyx_GOTREF(__pyx_t_4);
-  }
-  for (;;) {
-    if (likely(PyList_CheckExact(__pyx_t_4))) {
-      if (__pyx_t_6 >= PyList_GET_SIZE(__pyx_t_4)) break;
-      __pyx_t_3 = PyList_GET_ITEM(__pyx_t_4, __pyx_t_6); __Pyx_INCREF(__pyx_t_3); __pyx_t_6++;
-    } else if (likely(PyTuple_CheckExact(__pyx_t_4))) {
-      if (__pyx_t_6 >= PyTuple_GET_SIZE(__pyx_t_4)) break;
-      __pyx_t_3 = PyTuple_GET_ITEM(__pyx_t_4, __pyx_t_6); __Pyx_INCREF(__pyx_t_3); __pyx_t_6++;
-    } else {
-      __pyx_t_3 = PyIter_Next(__pyx_t_4);
-      if (!__pyx_t_3) {
-        if (unlikely(PyErr_Occurred())) {__pyx_filename = __pyx_f[0]; __pyx_lineno = 154; __pyx_clineno = __LINE__; goto __pyx_L1_error;}
-        break;
-      }
-      __Pyx_GOTREF(__pyx_t_3);
-    }
-    if (!(likely(((__pyx_t_3) == Py_None) || likely(__Pyx_TypeTest(__pyx_t_3, __pyx_ptype_6kdtree_PointData))))) {__pyx_filename = __pyx_f[0]; __pyx_lineno = 154; __pyx_clineno = __LINE__; goto __pyx_L1_error;}
-    __Pyx_DECREF(((PyObject *)__pyx_v_p));
-    __pyx_v_p = ((struct __pyx_obj_6kdtree_PointData *)__pyx_t_3);
-    __pyx_t_3 = 0;
-
-    /* "/home/belisarius/github/py_kdtree/cython_wrapper/kdtree.pyx":155
- *   cdef PointData p
- *   for p in pointList:
- *     p.curr_axis = axis             # <<<<<<<<<<<<<<
- * 
- *   # Sort point list and choose median as pivot element
- */
-    __pyx_v_p->curr_axis = __pyx_v_axis;
-  }
-  __Pyx_DECREF(__pyx_t_4); __pyx_t_4 = 0;
-
-  /* "/home/belisarius/github/py_kdtree/cython_wrapper/kdtree.pyx":158
- * 
- *   # Sort point list and choose median as pivot element
- *   pointList.sort()             # <<<<<<<<<<<<<<
- * 
- *   cdef size_t median = len(pointList) / 2
- */
-  __pyx_t_4 = PyObject_GetAttr(__pyx_v_pointList, __pyx_n_s__sort); if (unlikely(!__pyx_t_4)) {__pyx_filename = __pyx_f[0]; __pyx_lineno = 158; __pyx_clineno = __LINE__; goto __pyx_L1_error;}
-  __Pyx_GOTREF(__pyx_t_4);
-  __pyx_t_3 = PyObject_Call(__pyx_t_4, ((PyObject *)__pyx_empty_tuple), NULL); if (unlikely(!__pyx_t_3)) {__pyx_filename = __pyx_f[0]; __pyx_lineno = 158; __pyx_clineno = __LINE__; goto __pyx_L1_error;}
-  __Pyx_GOTREF(__pyx_t_3);
-  __Pyx_DECREF(__pyx_t_4); __pyx_t_4 = 0;
-  __Pyx_DECREF(__pyx_t_3); __pyx_t_3 = 0;
-
-  /* "/home/belisarius/github/py_kdtree/cython_wrapper/kdtree.pyx":160
- *   pointList.sort()
- * 
- *   cdef size_t median = len(pointList) / 2             # <<<<<<<<<<<<<<
- * 
- *   pl_median = pointList[median]
- */
-  __pyx_t_6 = PyObject_Length(__pyx_v_pointList); if (unlikely(__pyx_t_6 == -1)) {__pyx_filename = __pyx_f[0]; __pyx_lineno = 160; __pyx_clineno = __LINE__; goto __pyx_L1_error;}
-  __pyx_v_median = __Pyx_div_Py_ssize_t(__pyx_t_6, 2);
-
-  /* "/home/belisarius/github/py_kdtree/cython_wrapper/kdtree.pyx":162
- *   cdef size_t median = len(pointList) / 2
- * 
- *   pl_median = pointList[median]             # <<<<<<<<<<<<<<
- *   cdef int next_depth = depth + 1
- *   cdef KDTreeNode node = KDTreeNode(pl_median.num, pl_median.coords)
- */
-  __pyx_t_3 = __Pyx_GetItemInt(__pyx_v_pointList, __pyx_v_median, sizeof(size_t)+1, __Pyx_PyInt_FromSize_t); if (!__pyx_t_3) {__pyx_filename = __pyx_f[0]; __pyx_lineno = 162; __pyx_clineno = __LINE__; goto __pyx_L1_error;}
-  __Pyx_GOTREF(__pyx_t_3);
-  __Pyx_DECREF(__pyx_v_pl_median);
-  __pyx_v_pl_median = __pyx_t_3;
-  __pyx_t_3 = 0;
-
-  /* "/home/belisarius/github/py_kdtree/cython_wrapper/kdtree.pyx":163
- * 
- *   pl_median = pointList[median]
- *   cdef int next_depth = depth + 1             # <<<<<<<<<<<<<<
- *   cdef KDTreeNode node = KDTreeNode(pl_median.num, pl_median.coords)
- *   node.left = fill_tree_r(pointList[0:median], next_depth)
- */
-  __pyx_v_next_depth = (__pyx_v_depth + 1);
-
-  /* "/home/belisarius/github/py_kdtree/cython_wrapper/kdtree.pyx":164
- *   pl_median = pointList[median]
- *   cdef int next_depth = depth + 1
- *   cdef KDTreeNode node = KDTreeNode(pl_median.num, pl_median.coords)             # <<<<<<<<<<<<<<
- *   node.left = fill_tree_r(pointList[0:median], next_depth)
- *   node.right = fill_tree_r(pointList[median + 1:], next_depth)
- */
-  __pyx_t_3 = PyObject_GetAttr(__pyx_v_pl_median, __pyx_n_s__num); if (unlikely(!__pyx_t_3)) {__pyx_filename = __pyx_f[0]; __pyx_lineno = 164; __pyx_clineno = __LINE__; goto __pyx_L1_error;}
-  __Pyx_GOTREF(__pyx_t_3);
-  __pyx_t_4 = PyObject_GetAttr(__pyx_v_pl_median, __pyx_n_s__coords); if (unlikely(!__pyx_t_4)) {__pyx_filename = __pyx_f[0]; __pyx_lineno = 164; __pyx_clineno = __LINE__; goto __pyx_L1_error;}
-  __Pyx_GOTREF(__pyx_t_4);
-  __pyx_t_7 = PyTuple_New(2); if (unlikely(!__pyx_t_7)) {__pyx_filename = __pyx_f[0]; __pyx_lineno = 164; __pyx_clineno = __LINE__; goto __pyx_L1_error;}
-  __Pyx_GOTREF(__pyx_t_7);
-  PyTuple_SET_ITEM(__pyx_t_7, 0, __pyx_t_3);
-  __Pyx_GIVEREF(__pyx_t_3);
-  PyTuple_SET_ITEM(__pyx_t_7, 1, __pyx_t_4);
-  __Pyx_GIVEREF(__pyx_t_4);
-  __pyx_t_3 = 0;
-  __pyx_t_4 = 0;
-  __pyx_t_4 = PyObject_Call(((PyObject *)((PyObject*)__pyx_ptype_6kdtree_KDTreeNode)), __pyx_t_7, NULL); if (unlikely(!__pyx_t_4)) {__pyx_filename = __pyx_f[0]; __pyx_lineno = 164; __pyx_clineno = __LINE__; goto __pyx_L1_error;}
-  __Pyx_GOTREF(__pyx_t_4);
-  __Pyx_DECREF(__pyx_t_7); __pyx_t_7 = 0;
-  __pyx_v_node = ((struct __pyx_obj_6kdtree_KDTreeNode *)__pyx_t_4);
-  __pyx_t_4 = 0;
-
-  /* "/home/belisarius/github/py_kdtree/cython_wrapper/kdtree.pyx":165
- *   cdef int next_depth = depth + 1
- *   cdef KDTreeNode node = KDTreeNode(pl_median.num, pl_median.coords)
- *   node.left = fill_tree_r(pointList[0:median], next_depth)             # <<<<<<<<<<<<<<
- *   node.right = fill_tree_r(pointList[median + 1:], next_depth)
- *   return node
- */
-  __pyx_t_4 = PySequence_GetSlice(__pyx_v_pointList, 0, __pyx_v_median); if (unlikely(!__pyx_t_4)) {__pyx_filename = __pyx_f[0]; __pyx_lineno = 165; __pyx_clineno = __LINE__; goto __pyx_L1_error;}
-  __Pyx_GOTREF(__pyx_t_4);
-  __pyx_t_7 = ((PyObject *)__pyx_f_6kdtree_fill_tree_r(__pyx_t_4, __pyx_v_next_depth)); if (unlikely(!__pyx_t_7)) {__pyx_filename = __pyx_f[0]; __pyx_lineno = 165; __pyx_clineno = __LINE__; goto __pyx_L1_error;}
-  __Pyx_GOTREF(__pyx_t_7);
-  __Pyx_DECREF(__pyx_t_4); __pyx_t_4 = 0;
-  __Pyx_GIVEREF(__pyx_t_7);
-  __Pyx_GOTREF(__pyx_v_node->left);
-  __Pyx_DECREF(((PyObject *)__pyx_v_node->left));
-  __pyx_v_node->left = ((struct __pyx_obj_6kdtree_KDTreeNode *)__pyx_t_7);
-  __pyx_t_7 = 0;
-
-  /* "/home/belisarius/github/py_kdtree/cython_wrapper/kdtree.pyx":166
- *   cdef KDTreeNode node = KDTreeNode(pl_median.num, pl_median.coords)
- *   node.left = fill_tree_r(pointList[0:median], next_depth)
- *   node.right = fill_tree_r(pointList[median + 1:], next_depth)             # <<<<<<<<<<<<<<
- *   return node
- * 
- */
-  __pyx_t_7 = PySequence_GetSlice(__pyx_v_pointList, (__pyx_v_median + 1), PY_SSIZE_T_MAX); if (unlikely(!__pyx_t_7)) {__pyx_filename = __pyx_f[0]; __pyx_lineno = 166; __pyx_clineno = __LINE__; goto __pyx_L1_error;}
-  __Pyx_GOTREF(__pyx_t_7);
-  __pyx_t_4 = ((PyObject *)__pyx_f_6kdtree_fill_tree_r(__pyx_t_7, __pyx_v_next_depth)); if (unlikely(!__pyx_t_4)) {__pyx_filename = __pyx_f[0]; __pyx_lineno = 166; __pyx_clineno = __LINE__; goto __pyx_L1_error;}
-  __Pyx_GOTREF(__pyx_t_4);
-  __Pyx_DECREF(__pyx_t_7); __pyx_t_7 = 0;
-  __Pyx_GIVEREF(__pyx_t_4);
-  __Pyx_GOTREF(__pyx_v_node->right);
-  __Pyx_DECREF(((PyObject *)__pyx_v_node->right));
-  __pyx_v_node->right = ((struct __pyx_obj_6kdtree_KDTreeNode *)__pyx_t_4);
-  __pyx_t_4 = 0;
-
-  /* "/home/belisarius/github/py_kdtree/cython_wrapper/kdtree.pyx":167
- *   node.left = fill_tree_r(pointList[0:median], next_depth)
- *   node.right = fill_tree_r(pointList[median + 1:], next_depth)
- *   return node             # <<<<<<<<<<<<<<
- * 
- * cpdef KDTreeNode fill_tree(pointList):
- */
-  __Pyx_XDECREF(((PyObject *)__pyx_r));
-  __Pyx_INCREF(((PyObject *)__pyx_v_node));
-  __pyx_r = __pyx_v_node;
-  goto __pyx_L0;
-
-  __pyx_r = ((struct __pyx_obj_6kdtree_KDTreeNode *)Py_None); __Pyx_INCREF(Py_None);
-  goto __pyx_L0;
-  __pyx_L1_error:;
-  __Pyx_XDECREF(__pyx_t_3);
-  __Pyx_XDECREF(__pyx_t_4);
-  __Pyx_XDECREF(__pyx_t_7);
-  __Pyx_AddTraceback("kdtree.fill_tree_r");
-  __pyx_r = 0;
-  __pyx_L0:;
-  __Pyx_DECREF((PyObject *)__pyx_v_p);
-  __Pyx_DECREF(__pyx_v_pl_median);
-  __Pyx_XDECREF((PyObject *)__pyx_v_node);
-  __Pyx_DECREF(__pyx_v_pointList);
-  __Pyx_XGIVEREF((PyObject *)__pyx_r);
-  __Pyx_RefNannyFinishContext();
-  return __pyx_r;
-}
-
-/* "/home/belisarius/github/py_kdtree/cython_wrapper/kdtree.pyx":169
- *   return node
- * 
- * cpdef KDTreeNode fill_tree(pointList):             # <<<<<<<<<<<<<<
- *   """Constructs a KD-tree and returns the root node.  pointList is a list of PointData elements."""
- *   return fill_tree_r(pointList, 0)
- */
-
-static PyObject *__pyx_pf_6kdtree_fill_tree(PyObject *__pyx_self, PyObject *__pyx_v_pointList); /*proto*/
-static  struct __pyx_obj_6kdtree_KDTreeNode *__pyx_f_6kdtree_fill_tree(PyObject *__pyx_v_pointList, int __pyx_skip_dispatch) {
-  struct __pyx_obj_6kdtree_KDTreeNode *__pyx_r = NULL;
-  PyObject *__pyx_t_1 = NULL;
-  __Pyx_RefNannySetupContext("fill_tree");
-
-  /* "/home/belisarius/github/py_kdtree/cython_wrapper/kdtree.pyx":171
- * cpdef KDTreeNode fill_tree(pointList):
- *   """Constructs a KD-tree and returns the root node.  pointList is a list of PointData elements."""
- *   return fill_tree_r(pointList, 0)             # <<<<<<<<<<<<<<
- * 
- * cdef size_t pick_axis(size_t depth, size_t dims):
- */
-  __Pyx_XDECREF(((PyObject *)__pyx_r));
-  __pyx_t_1 = ((PyObject *)__pyx_f_6kdtree_fill_tree_r(__pyx_v_pointList, 0)); if (unlikely(!__pyx_t_1)) {__pyx_filename = __pyx_f[0]; __pyx_lineno = 171; __pyx_clineno = __LINE__; goto __pyx_L1_error;}
-  __Pyx_GOTREF(__pyx_t_1);
-  __pyx_r = ((struct __pyx_obj_6kdtree_KDTreeNode *)__pyx_t_1);
-  __pyx_t_1 = 0;
-  goto __pyx_L0;
-
-  __pyx_r = ((struct __pyx_obj_6kdtree_KDTreeNode *)Py_None); __Pyx_INCREF(Py_None);
-  goto __pyx_L0;
-  __pyx_L1_error:;
-  __Pyx_XDECREF(__pyx_t_1);
-  __Pyx_AddTraceback("kdtree.fill_tree");
-  __pyx_r = 0;
-  __pyx_L0:;
-  __Pyx_XGIVEREF((PyObject *)__pyx_r);
-  __Pyx_RefNannyFinishContext();
-  return __pyx_r;
-}
-
-/* "/home/belisarius/github/py_kdtree/cython_wrapper/kdtree.pyx":169
- *   return node
- * 
- * cpdef KDTreeNode fill_tree(pointList):             # <<<<<<<<<<<<<<
- *   """Constructs a KD-tree and returns the root node.  pointList is a list of PointData elements."""
- *   return fill_tree_r(pointList, 0)
- */
-
-static PyObject *__pyx_pf_6kdtree_fill_tree(PyObject *__pyx_self, PyObject *__pyx_v_pointList); /*proto*/
-static char __pyx_doc_6kdtree_fill_tree[] = "Constructs a KD-tree and returns the root node.  pointList is a list of PointData elements.";
-static PyObject *__pyx_pf_6kdtree_fill_tree(PyObject *__pyx_self, PyObject *__pyx_v_pointList) {
-  PyObject *__pyx_r = NULL;
-  PyObject *__pyx_t_1 = NULL;
-  __Pyx_RefNannySetupContext("fill_tree");
-  __pyx_self = __pyx_self;
-  __Pyx_XDECREF(__pyx_r);
-  __pyx_t_1 = ((PyObject *)__pyx_f_6kdtree_fill_tree(__pyx_v_pointList, 0)); if (unlikely(!__pyx_t_1)) {__pyx_filename = __pyx_f[0]; __pyx_lineno = 169; __pyx_clineno = __LINE__; goto __pyx_L1_error;}
-  __Pyx_GOTREF(__pyx_t_1);
-  __pyx_r = __pyx_t_1;
-  __pyx_t_1 = 0;
-  goto __pyx_L0;
-
-  __pyx_r = Py_None; __Pyx_INCREF(Py_None);
-  goto __pyx_L0;
-  __pyx_L1_error:;
-  __Pyx_XDECREF(__pyx_t_1);
-  __Pyx_AddTraceback("kdtree.fill_tree");
-  __pyx_r = NULL;
-  __pyx_L0:;
-  __Pyx_XGIVEREF(__pyx_r);
-  __Pyx_RefNannyFinishContext();
-  return __pyx_r;
-}
-
-/* "/home/belisarius/github/py_kdtree/cython_wrapper/kdtree.pyx":173
- *   return fill_tree_r(pointList, 0)
- * 
- * cdef size_t pick_axis(size_t depth, size_t dims):             # <<<<<<<<<<<<<<
- *   """Choose the axis to use based on the current depth and the number of dimensions.
- *   This is useful when building the tree and search for nearest neighbors.
- */
-
-static  size_t __pyx_f_6kdtree_pick_axis(size_t __pyx_v_depth, size_t __pyx_v_dims) {
-  size_t __pyx_r;
-  __Pyx_RefNannySetupContext("pick_axis");
-
-  /* "/home/belisarius/github/py_kdtree/cython_wrapper/kdtree.pyx":180
- *   @return The axis to use.
- *   """
- *   return depth % dims             # <<<<<<<<<<<<<<
- * 
- * # Searches for nearest neighbor of point using node as the root.
- */
-  if (unlikely(__pyx_v_dims == 0)) {
-    PyErr_Format(PyExc_ZeroDivisionError, "integer division or modulo by zero");
-    {__pyx_filename = __pyx_f[0]; __pyx_lineno = 180; __pyx_clineno = __LINE__; goto __pyx_L1_error;}
-  }
-  __pyx_r = (__pyx_v_depth % __pyx_v_dims);
-  goto __pyx_L0;
-
-  __pyx_r = 0;
-  goto __pyx_L0;
-  __pyx_L1_error:;
-  __Pyx_WriteUnraisable("kdtree.pick_axis");
-  __pyx_r = 0;
-  __pyx_L0:;
-  __Pyx_RefNannyFinishContext();
-  return __pyx_r;
-}
-
-/* "/home/belisarius/github/py_kdtree/cython_wrapper/kdtree.pyx":183
- * 
- * # Searches for nearest neighbor of point using node as the root.
- * cdef size_t nn_search(KDTreeNode node, PointData search, best_pair nearest[], \             # <<<<<<<<<<<<<<
- *                    size_t best_count, size_t num_neighbors, size_t depth) except? -2:
- *   """Runs a nearest neighbor search on the given point, which is defined
- */
-
-static  size_t __pyx_f_6kdtree_nn_search(struct __pyx_obj_6kdtree_KDTreeNode *__pyx_v_node, struct __pyx_obj_6kdtree_PointData *__pyx_v_search, struct __pyx_t_6kdtree_best_pair *__pyx_v_nearest, size_t __pyx_v_best_count, size_t __pyx_v_num_neighbors, size_t __pyx_v_depth) {
-  size_t __pyx_v_dims;
-  size_t __pyx_v_axis;
-  int __pyx_v_node_num;
-  int __pyx_v_search_num;
-  PyObject *__pyx_v_ncoords;
-  PyObject *__pyx_v_scoords;
-  double __pyx_v_neighbor_coord;
-  double __pyx_v_search_coord;
-  PyObject *__pyx_v_near;
-  PyObject *__pyx_v_far;
-  size_t __pyx_v_next_depth;
-  double __pyx_v_largest;
-  double __pyx_v_diff;
-  double __pyx_v_sq_diff;
-  size_t __pyx_v_search_other;
-  size_t __pyx_r;
-  int __pyx_t_1;
-  PyObject *__pyx_t_2 = NULL;
-  int __pyx_t_3;
-  double __pyx_t_4;
-  int __pyx_t_5;
-  int __pyx_t_6;
-  size_t __pyx_t_7;
-  __Pyx_RefNannySetupContext("nn_search");
-  __Pyx_INCREF((PyObject *)__pyx_v_node);
-  __Pyx_INCREF((PyObject *)__pyx_v_search);
-  __pyx_v_ncoords = Py_None; __Pyx_INCREF(Py_None);
-  __pyx_v_scoords = Py_None; __Pyx_INCREF(Py_None);
-  __pyx_v_near = Py_None; __Pyx_INCREF(Py_None);
-  __pyx_v_far = Py_None; __Pyx_INCREF(Py_None);
-
-  /* "/home/belisarius/github/py_kdtree/cython_wrapper/kdtree.pyx":187
- *   """Runs a nearest neighbor search on the given point, which is defined
- *   by the point number 'search_num' and search coordinates 'search'."""
- *   if node is None:             # <<<<<<<<<<<<<<
- *     return best_count
- * 
- */
-  __pyx_t_1 = (((PyObject *)__pyx_v_node) == Py_None);
-  if (__pyx_t_1) {
-
-    /* "/home/belisarius/github/py_kdtree/cython_wrapper/kdtree.pyx":188
- *   by the point number 'search_num' and search coordinates 'search'."""
- *   if node is None:
- *     return best_count             # <<<<<<<<<<<<<<
- * 
- *   cdef size_t dims = search.dims
- */
-    __pyx_r = __pyx_v_best_count;
-    goto __pyx_L0;
-    goto __pyx_L3;
-  }
-  __pyx_L3:;
-
-  /* "/home/belisarius/github/py_kdtree/cython_wrapper/kdtree.pyx":190
- *     return best_count
- * 
- *   cdef size_t dims = search.dims             # <<<<<<<<<<<<<<
- *   cdef size_t axis = pick_axis(depth, dims)
- *   cdef int node_num = node.num
- */
-  __pyx_v_dims = __pyx_v_search->dims;
-
-  /* "/home/belisarius/github/py_kdtree/cython_wrapper/kdtree.pyx":191
- * 
- *   cdef size_t dims = search.dims
- *   cdef size_t axis = pick_axis(depth, dims)             # <<<<<<<<<<<<<<
- *   cdef int node_num = node.num
- *   cdef int search_num = search.num
- */
-  __pyx_v_axis = __pyx_f_6kdtree_pick_axis(__pyx_v_depth, __pyx_v_dims);
-
-  /* "/home/belisarius/github/py_kdtree/cython_wrapper/kdtree.pyx":192
- *   cdef size_t dims = search.dims
- *   cdef size_t axis = pick_axis(depth, dims)
- *   cdef int node_num = node.num             # <<<<<<<<<<<<<<
- *   cdef int search_num = search.num
- * 
- */
-  __pyx_t_2 = PyObject_GetAttr(((PyObject *)__pyx_v_node), __pyx_n_s__num); if (unlikely(!__pyx_t_2)) {__pyx_filename = __pyx_f[0]; __pyx_lineno = 192; __pyx_clineno = __LINE__; goto __pyx_L1_error;}
-  __Pyx_GOTREF(__pyx_t_2);
-  __pyx_t_3 = __Pyx_PyInt_AsInt(__pyx_t_2); if (unlikely((__pyx_t_3 == (int)-1) && PyErr_Occurred())) {__pyx_filename = __pyx_f[0]; __pyx_lineno = 192; __pyx_clineno = __LINE__; goto __pyx_L1_error;}
-  __Pyx_DECREF(__pyx_t_2); __pyx_t_2 = 0;
-  __pyx_v_node_num = __pyx_t_3;
-
-  /* "/home/belisarius/github/py_kdtree/cython_wrapper/kdtree.pyx":193
- *   cdef size_t axis = pick_axis(depth, dims)
- *   cdef int node_num = node.num
- *   cdef int search_num = search.num             # <<<<<<<<<<<<<<
- * 
- *   ncoords = node.data.coords
- */
-  __pyx_v_search_num = __pyx_v_search->num;
-
-  /* "/home/belisarius/github/py_kdtree/cython_wrapper/kdtree.pyx":195
- *   cdef int search_num = search.num
- * 
- *   ncoords = node.data.coords             # <<<<<<<<<<<<<<
- *   scoords = search.coords
- *   cdef double neighbor_coord = ncoords[axis]
- */
-  __Pyx_INCREF(__pyx_v_node->data->coords);
-  __Pyx_DECREF(__pyx_v_ncoords);
-  __pyx_v_ncoords = __pyx_v_node->data->coords;
-
-  /* "/home/belisarius/github/py_kdtree/cython_wrapper/kdtree.pyx":196
- * 
- *   ncoords = node.data.coords
- *   scoords = search.coords             # <<<<<<<<<<<<<<
- *   cdef double neighbor_coord = ncoords[axis]
- *   cdef double search_coord = scoords[axis]
- */
-  __Pyx_INCREF(__pyx_v_search->coords);
-  __Pyx_DECREF(__pyx_v_scoords);
-  __pyx_v_scoords = __pyx_v_search->coords;
-
-  /* "/home/belisarius/github/py_kdtree/cython_wrapper/kdtree.pyx":197
- *   ncoords = node.data.coords
- *   scoords = search.coords
- *   cdef double neighbor_coord = ncoords[axis]             # <<<<<<<<<<<<<<
- *   cdef double search_coord = scoords[axis]
- * 
- */
-  __pyx_t_2 = __Pyx_GetItemInt(__pyx_v_ncoords, __pyx_v_axis, sizeof(size_t)+1, __Pyx_PyInt_FromSize_t); if (!__pyx_t_2) {__pyx_filename = __pyx_f[0]; __pyx_lineno = 197; __pyx_clineno = __LINE__; goto __pyx_L1_error;}
-  __Pyx_GOTREF(__pyx_t_2);
-  __pyx_t_4 = __pyx_PyFloat_AsDouble(__pyx_t_2); if (unlikely((__pyx_t_4 == (double)-1) && PyErr_Occurred())) {__pyx_filename = __pyx_f[0]; __pyx_lineno = 197; __pyx_clineno = __LINE__; goto __pyx_L1_error;}
-  __Pyx_DECREF(__pyx_t_2); __pyx_t_2 = 0;
-  __pyx_v_neighbor_coord = __pyx_t_4;
-
-  /* "/home/belisarius/github/py_kdtree/cython_wrapper/kdtree.pyx":198
- *   scoords = search.coords
- *   cdef double neighbor_coord = ncoords[axis]
- *   cdef double search_coord = scoords[axis]             # <<<<<<<<<<<<<<
- * 
- *   if node.left is None and node.right is None:
- */
-  __pyx_t_2 = __Pyx_GetItemInt(__pyx_v_scoords, __pyx_v_axis, sizeof(size_t)+1, __Pyx_PyInt_FromSize_t); if (!__pyx_t_2) {__pyx_filename = __pyx_f[0]; __pyx_lineno = 198; __pyx_clineno = __LINE__; goto __pyx_L1_error;}
-  __Pyx_GOTREF(__pyx_t_2);
-  __pyx_t_4 = __pyx_PyFloat_AsDouble(__pyx_t_2); if (unlikely((__pyx_t_4 == (double)-1) && PyErr_Occurred())) {__pyx_filename = __pyx_f[0]; __pyx_lineno = 198; __pyx_clineno = __LINE__; goto __pyx_L1_error;}
-  __Pyx_DECREF(__pyx_t_2); __pyx_t_2 = 0;
-  __pyx_v_search_coord = __pyx_t_4;
-
-  /* "/home/belisarius/github/py_kdtree/cython_wrapper/kdtree.pyx":200
- *   cdef double search_coord = scoords[axis]
- * 
- *   if node.left is None and node.right is None:             # <<<<<<<<<<<<<<
- *     if node_num != search_num:
- *       best_count = add_best(nearest, best_count, node_num, ncoords, scoords, dims, num_neighbors)
- */
-  __pyx_t_1 = (((PyObject *)__pyx_v_node->left) == Py_None);
-  if (__pyx_t_1) {
-    __pyx_t_5 = (((PyObject *)__pyx_v_node->right) == Py_None);
-    __pyx_t_6 = __pyx_t_5;
-  } else {
-    __pyx_t_6 = __pyx_t_1;
-  }
-  if (__pyx_t_6) {
-
-    /* "/home/belisarius/github/py_kdtree/cython_wrapper/kdtree.pyx":201
- * 
- *   if node.left is None and node.right is None:
- *     if node_num != search_num:             # <<<<<<<<<<<<<<
- *       best_count = add_best(nearest, best_count, node_num, ncoords, scoords, dims, num_neighbors)
- *     return best_count
- */
-    __pyx_t_6 = (__pyx_v_node_num != __pyx_v_search_num);
-    if (__pyx_t_6) {
-
-      /* "/home/belisarius/github/py_kdtree/cython_wrapper/kdtree.pyx":202
- *   if node.left is None and node.right is None:
- *     if node_num != search_num:
- *       best_count = add_best(nearest, best_count, node_num, ncoords, scoords, dims, num_neighbors)             # <<<<<<<<<<<<<<
- *     return best_count
- * 
- */
-      __pyx_t_7 = __pyx_f_6kdtree_add_best(__pyx_v_nearest, __pyx_v_best_count, __pyx_v_node_num, __pyx_v_ncoords, __pyx_v_scoords, __pyx_v_dims, __pyx_v_num_neighbors); if (unlikely(__pyx_t_7 == -2 && PyErr_Occurred())) {__pyx_filename = __pyx_f[0]; __pyx_lineno = 202; __pyx_clineno = __LINE__; goto __pyx_L1_error;}
-      __pyx_v_best_count = __pyx_t_7;
-      goto __pyx_L5;
-    }
-    __pyx_L5:;
-
-    /* "/home/belisarius/github/py_kdtree/cython_wrapper/kdtree.pyx":203
- *     if node_num != search_num:
- *       best_count = add_best(nearest, best_count, node_num, ncoords, scoords, dims, num_neighbors)
- *     return best_count             # <<<<<<<<<<<<<<
- * 
- * 
- */
-    __pyx_r = __pyx_v_best_count;
-    goto __pyx_L0;
-    goto __pyx_L4;
-  }
-  __pyx_L4:;
-
-  /* "/home/belisarius/github/py_kdtree/cython_wrapper/kdtree.pyx":208
- *   # compare query point and current node along the axis to see which tree is
- *   # far and which is near
- *   if search_coord < neighbor_coord:             # <<<<<<<<<<<<<<
- *     near = node.left
- *     far = node.right
- */
-  __pyx_t_6 = (__pyx_v_search_coord < __pyx_v_neighbor_coord);
-  if (__pyx_t_6) {
-
-    /* "/home/belisarius/github/py_kdtree/cython_wrapper/kdtree.pyx":209
- *   # far and which is near
- *   if search_coord < neighbor_coord:
- *     near = node.left             # <<<<<<<<<<<<<<
- *     far = node.right
- *   else:
- */
-    __Pyx_INCREF(((PyObject *)__pyx_v_node->left));
-    __Pyx_DECREF(__pyx_v_near);
-    __pyx_v_near = ((PyObject *)__pyx_v_node->left);
-
-    /* "/home/belisarius/github/py_kdtree/cython_wrapper/kdtree.pyx":210
- *   if search_coord < neighbor_coord:
- *     near = node.left
- *     far = node.right             # <<<<<<<<<<<<<<
- *   else:
- *     near = node.right
- */
-    __Pyx_INCREF(((PyObject *)__pyx_v_node->right));
-    __Pyx_DECREF(__pyx_v_far);
-    __pyx_v_far = ((PyObject *)__pyx_v_node->right);
-    goto __pyx_L6;
-  }
-  /*else*/ {
-
-    /* "/home/belisarius/github/py_kdtree/cython_wrapper/kdtree.pyx":212
- *     far = node.right
- *   else:
- *     near = node.right             # <<<<<<<<<<<<<<
- *     far = node.left
- * 
- */
-    __Pyx_INCREF(((PyObject *)__pyx_v_node->right));
-    __Pyx_DECREF(__pyx_v_near);
-    __pyx_v_near = ((PyObject *)__pyx_v_node->right);
-
-    /* "/home/belisarius/github/py_kdtree/cython_wrapper/kdtree.pyx":213
- *   else:
- *     near = node.right
- *     far = node.left             # <<<<<<<<<<<<<<
- * 
- *   cdef size_t next_depth = depth + 1
- */
-    __Pyx_INCREF(((PyObject *)__pyx_v_node->left));
-    __Pyx_DECREF(__pyx_v_far);
-    __pyx_v_far = ((PyObject *)__pyx_v_node->left);
-  }
-  __pyx_L6:;
-
-  /* "/home/belisarius/github/py_kdtree/cython_wrapper/kdtree.pyx":215
- *     far = node.left
- * 
- *   cdef size_t next_depth = depth + 1             # <<<<<<<<<<<<<<
- *   # search the near branch
- *   if near is not None:
- */
-  __pyx_v_next_depth = (__pyx_v_depth + 1);
-
-  /* "/home/belisarius/github/py_kdtree/cython_wrapper/kdtree.pyx":217
- *   cdef size_t next_depth = depth + 1
- *   # search the near branch
- *   if near is not None:             # <<<<<<<<<<<<<<
- *     best_count = nn_search(near, search, nearest, best_count, num_neighbors, next_depth)
- * 
- */
-  __pyx_t_6 = (__pyx_v_near != Py_None);
-  if (__pyx_t_6) {
-
-    /* "/home/belisarius/github/py_kdtree/cython_wrapper/kdtree.pyx":218
- *   # search the near branch
- *   if near is not None:
- *     best_count = nn_search(near, search, nearest, best_count, num_neighbors, next_depth)             # <<<<<<<<<<<<<<
- * 
- *   # If the current node is closer overall than the current best
- */
-    if (!(likely(((__pyx_v_near) == Py_None) || likely(__Pyx_TypeTest(__pyx_v_near, __pyx_ptype_6kdtree_KDTreeNode))))) {__pyx_filename = __pyx_f[0]; __pyx_lineno = 218; __pyx_clineno = __LINE__; goto __pyx_L1_error;}
-    __pyx_t_7 = __pyx_f_6kdtree_nn_search(((struct __pyx_obj_6kdtree_KDTreeNode *)__pyx_v_near), __pyx_v_search, __pyx_v_nearest, __pyx_v_best_count, __pyx_v_num_neighbors, __pyx_v_next_depth); if (unlikely(__pyx_t_7 == -2 && PyErr_Occurred())) {__pyx_filename = __pyx_f[0]; __pyx_lineno = 218; __pyx_clineno = __LINE__; goto __pyx_L1_error;}
-    __pyx_v_best_count = __pyx_t_7;
-    goto __pyx_L7;
-  }
-  __pyx_L7:;
-
-  /* "/home/belisarius/github/py_kdtree/cython_wrapper/kdtree.pyx":221
- * 
- *   # If the current node is closer overall than the current best
- *   if node_num != search_num:             # <<<<<<<<<<<<<<
- *     best_count = add_best(nearest, best_count, node_num, ncoords, scoords, dims, num_neighbors)
- * 
- */
-  __pyx_t_6 = (__pyx_v_node_num != __pyx_v_search_num);
-  if (__pyx_t_6) {
-
-    /* "/home/belisarius/github/py_kdtree/cython_wrapper/kdtree.pyx":222
- *   # If the current node is closer overall than the current best
- *   if node_num != search_num:
- *     best_count = add_best(nearest, best_count, node_num, ncoords, scoords, dims, num_neighbors)             # <<<<<<<<<<<<<<
- * 
- *   cdef double largest = -1.0
- */
-    __pyx_t_7 = __pyx_f_6kdtree_add_best(__pyx_v_nearest, __pyx_v_best_count, __pyx_v_node_num, __pyx_v_ncoords, __pyx_v_scoords, __pyx_v_dims, __pyx_v_num_neighbors); if (unlikely(__pyx_t_7 == -2 && PyErr_Occurred())) {__pyx_filename = __pyx_f[0]; __pyx_lineno = 222; __pyx_clineno = __LINE__; goto __pyx_L1_error;}
-    __pyx_v_best_count = __pyx_t_7;
-    goto __pyx_L8;
-  }
-  __pyx_L8:;
-
-  /* "/home/belisarius/github/py_kdtree/cython_wrapper/kdtree.pyx":224
- *     best_count = add_best(nearest, best_count, node_num, ncoords, scoords, dims, num_neighbors)
- * 
- *   cdef double largest = -1.0             # <<<<<<<<<<<<<<
- *   if best_count > 0:
- *     largest = nearest[best_count - 1].dist
- */
-  __pyx_v_largest = (-1.0);
-
-  /* "/home/belisarius/github/py_kdtree/cython_wrapper/kdtree.pyx":225
- * 
- *   cdef double largest = -1.0
- *   if best_count > 0:             # <<<<<<<<<<<<<<
- *     largest = nearest[best_count - 1].dist
- * 
- */
-  __pyx_t_6 = (__pyx_v_best_count > 0);
-  if (__pyx_t_6) {
-
-    /* "/home/belisarius/github/py_kdtree/cython_wrapper/kdtree.pyx":226
- *   cdef double largest = -1.0
- *   if best_count > 0:
- *     largest = nearest[best_count - 1].dist             # <<<<<<<<<<<<<<
- * 
- *   cdef double diff
- */
-    __pyx_v_largest = (__pyx_v_nearest[(__pyx_v_best_count - 1)]).dist;
-    goto __pyx_L9;
-  }
-  __pyx_L9:;
-
-  /* "/home/belisarius/github/py_kdtree/cython_wrapper/kdtree.pyx":232
- *   # maybe search the away branch
- *   cdef size_t search_other
- *   if far is not None:             # <<<<<<<<<<<<<<
- *     search_other = 0
- *     if largest < 0:
- */
-  __pyx_t_6 = (__pyx_v_far != Py_None);
-  if (__pyx_t_6) {
-
-    /* "/home/belisarius/github/py_kdtree/cython_wrapper/kdtree.pyx":233
- *   cdef size_t search_other
- *   if far is not None:
- *     search_other = 0             # <<<<<<<<<<<<<<
- *     if largest < 0:
- *       search_other = 1
- */
-    __pyx_v_search_other = 0;
-
-    /* "/home/belisarius/github/py_kdtree/cython_wrapper/kdtree.pyx":234
- *   if far is not None:
- *     search_other = 0
- *     if largest < 0:             # <<<<<<<<<<<<<<
- *       search_other = 1
- *     else:
- */
-    __pyx_t_6 = (__pyx_v_largest < 0);
-    if (__pyx_t_6) {
-
-      /* "/home/belisarius/github/py_kdtree/cython_wrapper/kdtree.pyx":235
- *     search_other = 0
- *     if largest < 0:
- *       search_other = 1             # <<<<<<<<<<<<<<
- *     else:
- *       diff = neighbor_coord - search_coord
- */
-      __pyx_v_search_other = 1;
-      goto __pyx_L11;
-    }
-    /*else*/ {
-
-      /* "/home/belisarius/github/py_kdtree/cython_wrapper/kdtree.pyx":237
- *       search_other = 1
- *     else:
- *       diff = neighbor_coord - search_coord             # <<<<<<<<<<<<<<
- *       sq_diff = diff * diff
- *       if sq_diff < largest:
- */
-      __pyx_v_diff = (__pyx_v_neighbor_coord - __pyx_v_search_coord);
-
-      /* "/home/belisarius/github/py_kdtree/cython_wrapper/kdtree.pyx":238
- *     else:
- *       diff = neighbor_coord - search_coord
- *       sq_diff = diff * diff             # <<<<<<<<<<<<<<
- *       if sq_diff < largest:
- *         search_other = 1
- */
-      __pyx_v_sq_diff = (__pyx_v_diff * __pyx_v_diff);
-
-      /* "/home/belisarius/github/py_kdtree/cython_wrapper/kdtree.pyx":239
- *       diff = neighbor_coord - search_coord
- *       sq_diff = diff * diff
- *       if sq_diff < largest:             # <<<<<<<<<<<<<<
- *         search_other = 1
- *     if 1 == search_other:
- */
-      __pyx_t_6 = (__pyx_v_sq_diff < __pyx_v_largest);
-      if (__pyx_t_6) {
-
-        /* "/home/belisarius/github/py_kdtree/cython_wrapper/kdtree.pyx":240
- *       sq_diff = diff * diff
- *       if sq_diff < largest:
- *         search_other = 1             # <<<<<<<<<<<<<<
- *     if 1 == search_other:
- *       best_count = nn_search(far, search, nearest, best_count, num_neighbors, next_depth)
- */
-        __pyx_v_search_other = 1;
-        goto __pyx_L12;
-      }
-      __pyx_L12:;
-    }
-    __pyx_L11:;
-
-    /* "/home/belisarius/github/py_kdtree/cython_wrapper/kdtree.pyx":241
- *       if sq_diff < largest:
- *         search_other = 1
- *     if 1 == search_other:             # <<<<<<<<<<<<<<
- *       best_count = nn_search(far, search, nearest, best_count, num_neighbors, next_depth)
- *   return best_count
- */
-    __pyx_t_6 = (1 == __pyx_v_search_other);
-    if (__pyx_t_6) {
-
-      /* "/home/belisarius/github/py_kdtree/cython_wrapper/kdtree.pyx":242
- *         search_other = 1
- *     if 1 == search_other:
- *       best_count = nn_search(far, search, nearest, best_count, num_neighbors, next_depth)             # <<<<<<<<<<<<<<
- *   return best_count
- * 
- */
-      if (!(likely(((__pyx_v_far) == Py_None) || likely(__Pyx_TypeTest(__pyx_v_far, __pyx_ptype_6kdtree_KDTreeNode))))) {__pyx_filename = __pyx_f[0]; __pyx_lineno = 242; __pyx_clineno = __LINE__; goto __pyx_L1_error;}
-      __pyx_t_7 = __pyx_f_6kdtree_nn_search(((struct __pyx_obj_6kdtree_KDTreeNode *)__pyx_v_far), __pyx_v_search, __pyx_v_nearest, __pyx_v_best_count, __pyx_v_num_neighbors, __pyx_v_next_depth); if (unlikely(__pyx_t_7 == -2 && PyErr_Occurred())) {__pyx_filename = __pyx_f[0]; __pyx_lineno = 242; __pyx_clineno = __LINE__; goto __pyx_L1_error;}
-      __pyx_v_best_count = __pyx_t_7;
-      goto __pyx_L13;
-    }
-    __pyx_L13:;
-    goto __pyx_L10;
-  }
-  __pyx_L10:;
-
-  /* "/home/belisarius/github/py_kdtree/cython_wrapper/kdtree.pyx":243
- *     if 1 == search_other:
- *       best_count = nn_search(far, search, nearest, best_count, num_neighbors, next_depth)
- *   return best_count             # <<<<<<<<<<<<<<
- * 
- * cdef inline double sqdist(a, b, size_t dims) except? -2:
- */
-  __pyx_r = __pyx_v_best_count;
-  goto __pyx_L0;
-
-  __pyx_r = 0;
-  goto __pyx_L0;
-  __pyx_L1_error:;
-  __Pyx_XDECREF(__pyx_t_2);
-  __Pyx_AddTraceback("kdtree.nn_search");
-  __pyx_r = -2;
-  __pyx_L0:;
-  __Pyx_DECREF(__pyx_v_ncoords);
-  __Pyx_DECREF(__pyx_v_scoords);
-  __Pyx_DECREF(__pyx_v_near);
-  __Pyx_DECREF(__pyx_v_far);
-  __Pyx_DECREF((PyObject *)__pyx_v_node);
-  __Pyx_DECREF((PyObject *)__pyx_v_search);
-  __Pyx_RefNannyFinishContext();
-  return __pyx_r;
-}
-
-/* "/home/belisarius/github/py_kdtree/cython_wrapper/kdtree.pyx":245
- *   return best_count
- * 
- * cdef inline double sqdist(a, b, size_t dims) except? -2:             # <<<<<<<<<<<<<<
- *   """Calculates Euclidean distance between a and b"""
- * 
- */
-
-static CYTHON_INLINE double __pyx_f_6kdtree_sqdist(PyObject *__pyx_v_a, PyObject *__pyx_v_b, size_t __pyx_v_dims) {
-  size_t __pyx_v_k;
-  double __pyx_v_dist;
-  double __pyx_v_diff;
-  double __pyx_r;
-  size_t __pyx_t_1;
-  size_t __pyx_t_2;
-  PyObject *__pyx_t_3 = NULL;
-  PyObject *__pyx_t_4 = NULL;
-  PyObject *__pyx_t_5 = NULL;
-  double __pyx_t_6;
-  __Pyx_RefNannySetupContext("sqdist");
-  __Pyx_INCREF(__pyx_v_a);
-  __Pyx_INCREF(__pyx_v_b);
-
-  /* "/home/belisarius/github/py_kdtree/cython_wrapper/kdtree.pyx":249
- * 
- *   cdef size_t k
- *   cdef double dist = 0.0             # <<<<<<<<<<<<<<
- *   cdef double diff
- *   for k in xrange(dims):
- */
-  __pyx_v_dist = 0.0;
-
-  /* "/home/belisarius/github/py_kdtree/cython_wrapper/kdtree.pyx":251
- *   cdef double dist = 0.0
- *   cdef double diff
- *   for k in xrange(dims):             # <<<<<<<<<<<<<<
- *     diff = a[k] - b[k]
- *     dist = dist + (diff * diff)
- */
-  __pyx_t_1 = __pyx_v_dims;
-  for (__pyx_t_2 = 0; __pyx_t_2 < __pyx_t_1; __pyx_t_2+=1) {
-    __pyx_v_k = __pyx_t_2;
-
-    /* "/home/belisarius/github/py_kdtree/cython_wrapper/kdtree.pyx":252
- *   cdef double diff
- *   for k in xrange(dims):
- *     diff = a[k] - b[k]             # <<<<<<<<<<<<<<
- *     dist = dist + (diff * diff)
- *   return dist
- */
-    __pyx_t_3 = __Pyx_GetItemInt(__pyx_v_a, __pyx_v_k, sizeof(size_t)+1, __Pyx_PyInt_FromSize_t); if (!__pyx_t_3) {__pyx_filename = __pyx_f[0]; __pyx_lineno = 252; __pyx_clineno = __LINE__; goto __pyx_L1_error;}
-    __Pyx_GOTREF(__pyx_t_3);
-    __pyx_t_4 = __Pyx_GetItemInt(__pyx_v_b, __pyx_v_k, sizeof(size_t)+1, __Pyx_PyInt_FromSize_t); if (!__pyx_t_4) {__pyx_filename = __pyx_f[0]; __pyx_lineno = 252; __pyx_clineno = __LINE__; goto __pyx_L1_error;}
-    __Pyx_GOTREF(__pyx_t_4);
-    __pyx_t_5 = PyNumber_Subtract(__pyx_t_3, __pyx_t_4); if (unlikely(!__pyx_t_5)) {__pyx_filename = __pyx_f[0]; __pyx_lineno = 252; __pyx_clineno = __LINE__; goto __pyx_L1_error;}
-    __Pyx_GOTREF(__pyx_t_5);
-    __Pyx_DECREF(__pyx_t_3); __pyx_t_3 = 0;
-    __Pyx_DECREF(__pyx_t_4); __pyx_t_4 = 0;
-    __pyx_t_6 = __pyx_PyFloat_AsDouble(__pyx_t_5); if (unlikely((__pyx_t_6 == (double)-1) && PyErr_Occurred())) {__pyx_filename = __pyx_f[0]; __pyx_lineno = 252; __pyx_clineno = __LINE__; goto __pyx_L1_error;}
-    __Pyx_DECREF(__pyx_t_5); __pyx_t_5 = 0;
-    __pyx_v_diff = __pyx_t_6;
-
-    /* "/home/belisarius/github/py_kdtree/cython_wrapper/kdtree.pyx":253
- *   for k in xrange(dims):
- *     diff = a[k] - b[k]
- *     dist = dist + (diff * diff)             # <<<<<<<<<<<<<<
- *   return dist
- * 
- */
-    __pyx_v_dist = (__pyx_v_dist + (__pyx_v_diff * __pyx_v_diff));
-  }
-
-  /* "/home/belisarius/github/py_kdtree/cython_wrapper/kdtree.pyx":254
- *     diff = a[k] - b[k]
- *     dist = dist + (diff * diff)
- *   return dist             # <<<<<<<<<<<<<<
- * 
- * cdef size_t add_best(best_pair nearest[], size_t best_count, int node_num, coords, \
- */
-  __pyx_r = __pyx_v_dist;
-  goto __pyx_L0;
-
-  __pyx_r = 0;
-  goto __pyx_L0;
-  __pyx_L1_error:;
-  __Pyx_XDECREF(__pyx_t_3);
-  __Pyx_XDECREF(__pyx_t_4);
-  __Pyx_XDECREF(__pyx_t_5);
-  __Pyx_AddTraceback("kdtree.sqdist");
-  __pyx_r = -2;
-  __pyx_L0:;
-  __Pyx_DECREF(__pyx_v_a);
-  __Pyx_DECREF(__pyx_v_b);
-  __Pyx_RefNannyFinishContext();
-  return __pyx_r;
-}
-
-/* "/home/belisarius/github/py_kdtree/cython_wrapper/kdtree.pyx":256
- *   return dist
- * 
- * cdef size_t add_best(best_pair nearest[], size_t best_count, int node_num, coords, \             # <<<<<<<<<<<<<<
- *                      search_coords, size_t dims, size_t num_neighbors) except? -2:
- *   """
- */
-
-static  size_t __pyx_f_6kdtree_add_best(struct __pyx_t_6kdtree_best_pair *__pyx_v_nearest, size_t __pyx_v_best_count, int __pyx_v_node_num, PyObject *__pyx_v_coords, PyObject *__pyx_v_search_coords, size_t __pyx_v_dims, size_t __pyx_v_num_neighbors) {
-  double __pyx_v_sd;
-  struct __pyx_t_6kdtree_best_pair __pyx_v_candidate;
-  size_t __pyx_v_last_idx;
-  size_t __pyx_v_idx;
-  size_t __pyx_v_x;
-  struct __pyx_t_6kdtree_best_pair __pyx_v_pair;
-  size_t __pyx_r;
-  double __pyx_t_1;
-  struct __pyx_t_6kdtree_best_pair __pyx_t_2;
-  int __pyx_t_3;
-  size_t __pyx_t_4;
-  size_t __pyx_t_5;
-  Py_ssize_t __pyx_t_6;
-  PyObject *__pyx_t_7 = NULL;
-  PyObject *__pyx_t_8 = NULL;
-  PyObject *__pyx_t_9 = NULL;
-  size_t __pyx_t_10;
-  __Pyx_RefNannySetupContext("add_best");
-  __Pyx_INCREF(__pyx_v_coords);
-  __Pyx_INCREF(__pyx_v_search_coords);
-
-  /* "/home/belisarius/github/py_kdtree/cython_wrapper/kdtree.pyx":268
- *   # equal to the searched-for point
- * 
- *   cdef double sd = sqdist(coords, search_coords, dims)             # <<<<<<<<<<<<<<
- * 
- *   cdef best_pair candidate = best_pair(node_num, sd)
- */
-  __pyx_t_1 = __pyx_f_6kdtree_sqdist(__pyx_v_coords, __pyx_v_search_coords, __pyx_v_dims); if (unlikely(__pyx_t_1 == -2 && PyErr_Occurred())) {__pyx_filename = __pyx_f[0]; __pyx_lineno = 268; __pyx_clineno = __LINE__; goto __pyx_L1_error;}
-  __pyx_v_sd = __pyx_t_1;
-
-  /* "/home/belisarius/github/py_kdtree/cython_wrapper/kdtree.pyx":270
- *   cdef double sd = sqdist(coords, search_coords, dims)
- * 
- *   cdef best_pair candidate = best_pair(node_num, sd)             # <<<<<<<<<<<<<<
- *   # search through linearly to maintain sorted order
- *   cdef size_t last_idx
- */
-  __pyx_t_2.node_num = __pyx_v_node_num;
-  __pyx_t_2.dist = __pyx_v_sd;
-  __pyx_v_candidate = __pyx_t_2;
-
-  /* "/home/belisarius/github/py_kdtree/cython_wrapper/kdtree.pyx":273
- *   # search through linearly to maintain sorted order
- *   cdef size_t last_idx
- *   if best_count < num_neighbors:             # <<<<<<<<<<<<<<
- *     last_idx = best_count
- *   else:
- */
-  __pyx_t_3 = (__pyx_v_best_count < __pyx_v_num_neighbors);
-  if (__pyx_t_3) {
-
-    /* "/home/belisarius/github/py_kdtree/cython_wrapper/kdtree.pyx":274
- *   cdef size_t last_idx
- *   if best_count < num_neighbors:
- *     last_idx = best_count             # <<<<<<<<<<<<<<
- *   else:
- *     last_idx = best_count - 1
- */
-    __pyx_v_last_idx = __pyx_v_best_count;
-    goto __pyx_L3;
-  }
-  /*else*/ {
-
-    /* "/home/belisarius/github/py_kdtree/cython_wrapper/kdtree.pyx":276
- *     last_idx = best_count
- *   else:
- *     last_idx = best_count - 1             # <<<<<<<<<<<<<<
- * 
- *   cdef size_t idx, x
- */
-    __pyx_v_last_idx = (__pyx_v_best_count - 1);
-  }
-  __pyx_L3:;
-
-  /* "/home/belisarius/github/py_kdtree/cython_wrapper/kdtree.pyx":280
- *   cdef size_t idx, x
- *   cdef best_pair pair
- *   for idx in xrange(best_count):             # <<<<<<<<<<<<<<
- *     pair = nearest[idx]
- *     if pair.dist > sd:
- */
-  __pyx_t_4 = __pyx_v_best_count;
-  for (__pyx_t_5 = 0; __pyx_t_5 < __pyx_t_4; __pyx_t_5+=1) {
-    __pyx_v_idx = __pyx_t_5;
-
-    /* "/home/belisarius/github/py_kdtree/cython_wrapper/kdtree.pyx":281
- *   cdef best_pair pair
- *   for idx in xrange(best_count):
- *     pair = nearest[idx]             # <<<<<<<<<<<<<<
- *     if pair.dist > sd:
- *       # push elements down
- */
-    __pyx_v_pair = (__pyx_v_nearest[__pyx_v_idx]);
-
-    /* "/home/belisarius/github/py_kdtree/cython_wrapper/kdtree.pyx":282
- *   for idx in xrange(best_count):
- *     pair = nearest[idx]
- *     if pair.dist > sd:             # <<<<<<<<<<<<<<
- *       # push elements down
- *       for x in xrange(last_idx, idx, -1):
- */
-    __pyx_t_3 = (__pyx_v_pair.dist > __pyx_v_sd);
-    if (__pyx_t_3) {
-
-      /* "/home/belisarius/github/py_kdtree/cython_wrapper/kdtree.pyx":284
- *     if pair.dist > sd:
- *       # push elements down
- *       for x in xrange(last_idx, idx, -1):             # <<<<<<<<<<<<<<
- *         nearest[x] = nearest[x - 1]
- *       nearest[idx] = candidate
- */
-      __pyx_t_7 = __Pyx_PyInt_FromSize_t(__pyx_v_last_idx); if (unlikely(!__pyx_t_7)) {__pyx_filename = __pyx_f[0]; __pyx_lineno = 284; __pyx_clineno = __LINE__; goto __pyx_L1_error;}
-      __Pyx_GOTREF(__pyx_t_7);
-      __pyx_t_8 = __Pyx_PyInt_FromSize_t(__pyx_v_idx); if (unlikely(!__pyx_t_8)) {__pyx_filename = __pyx_f[0]; __pyx_lineno = 284; __pyx_clineno = __LINE__; goto __pyx_L1_error;}
-      __Pyx_GOTREF(__pyx_t_8);
-      __pyx_t_9 = PyTuple_New(3); if (unlikely(!__pyx_t_9)) {__pyx_filename = __pyx_f[0]; __pyx_lineno = 284; __pyx_clineno = __LINE__; goto __pyx_L1_error;}
-      __Pyx_GOTREF(__pyx_t_9);
-      PyTuple_SET_ITEM(__pyx_t_9, 0, __pyx_t_7);
-      __Pyx_GIVEREF(__pyx_t_7);
-      PyTuple_SET_ITEM(__pyx_t_9, 1, __pyx_t_8);
-      __Pyx_GIVEREF(__pyx_t_8);
-      __Pyx_INCREF(__pyx_int_neg_1);
-      PyTuple_SET_ITEM(__pyx_t_9, 2, __pyx_int_neg_1);
-      __Pyx_GIVEREF(__pyx_int_neg_1);
-      __pyx_t_7 = 0;
-      __pyx_t_8 = 0;
-      __pyx_t_8 = PyObject_Call(__pyx_builtin_xrange, __pyx_t_9, NULL); if (unlikely(!__pyx_t_8)) {__pyx_filename = __pyx_f[0]; __pyx_lineno = 284; __pyx_clineno = __LINE__; goto __pyx_L1_error;}
-      __Pyx_GOTREF(__pyx_t_8);
-      __Pyx_DECREF(__pyx_t_9); __pyx_t_9 = 0;
-      if (PyList_CheckExact(__pyx_t_8) || PyTuple_CheckExact(__pyx_t_8)) {
-        __pyx_t_6 = 0; __pyx_t_9 = __pyx_t_8; __Pyx_INCREF(__pyx_t_9);
-      } else {
-        __pyx_t_6 = -1; __pyx_t_9 = PyObject_GetIter(__pyx_t_8); if (unlikely(!__pyx_t_9)) {__pyx_filename = __pyx_f[0]; __pyx_lineno = 284; __pyx_clineno = __LINE__; goto __pyx_L1_error;}
-        __Pyx_GOTREF(__pyx_t_9);
-      }
-      __Pyx_DECREF(__pyx_t_8); __pyx_t_8 = 0;
-      for (;;) {
-        if (likely(PyList_CheckExact(__pyx_t_9))) {
-          if (__pyx_t_6 >= PyList_GET_SIZE(__pyx_t_9)) break;
-          __pyx_t_8 = PyList_GET_ITEM(__pyx_t_9, __pyx_t_6); __Pyx_INCREF(__pyx_t_8); __pyx_t_6++;
-        } else if (likely(PyTuple_CheckExact(__pyx_t_9))) {
-          if (__pyx_t_6 >= PyTuple_GET_SIZE(__pyx_t_9)) break;
-          __pyx_t_8 = PyTuple_GET_ITEM(__pyx_t_9, __pyx_t_6); __Pyx_INCREF(__pyx_t_8); __pyx_t_6++;
-        } else {
-          __pyx_t_8 = PyIter_Next(__pyx_t_9);
-          if (!__pyx_t_8) {
-            if (unlikely(PyErr_Occurred())) {__pyx_filename = __pyx_f[0]; __pyx_lineno = 284; __pyx_clineno = __LINE__; goto __pyx_L1_error;}
-            break;
-          }
-          __Pyx_GOTREF(__pyx_t_8);
-        }
-        __pyx_t_10 = __Pyx_PyInt_AsSize_t(__pyx_t_8); if (unlikely((__pyx_t_10 == (size_t)-1) && PyErr_Occurred())) {__pyx_filename = __pyx_f[0]; __pyx_lineno = 284; __pyx_clineno = __LINE__; goto __pyx_L1_error;}
-        __Pyx_DECREF(__pyx_t_8); __pyx_t_8 = 0;
-        __pyx_v_x = __pyx_t_10;
-
-        /* "/home/belisarius/github/py_kdtree/cython_wrapper/kdtree.pyx":285
- *       # push elements down
- *       for x in xrange(last_idx, idx, -1):
- *         nearest[x] = nearest[x - 1]             # <<<<<<<<<<<<<<
- *       nearest[idx] = candidate
- *       return last_idx + 1
- */
-        (__pyx_v_nearest[__pyx_v_x]) = (__pyx_v_nearest[(__pyx_v_x - 1)]);
-      }
-      __Pyx_DECREF(__pyx_t_9); __pyx_t_9 = 0;
-
-      /* "/home/belisarius/github/py_kdtree/cython_wrapper/kdtree.pyx":286
- *       for x in xrange(last_idx, idx, -1):
- *         nearest[x] = nearest[x - 1]
- *       nearest[idx] = candidate             # <<<<<<<<<<<<<<
- *       return last_idx + 1
- *   if best_count < num_neighbors:
- */
-      (__pyx_v_nearest[__pyx_v_idx]) = __pyx_v_candidate;
-
-      /* "/home/belisarius/github/py_kdtree/cython_wrapper/kdtree.pyx":287
- *         nearest[x] = nearest[x - 1]
- *       nearest[idx] = candidate
- *       return last_idx + 1             # <<<<<<<<<<<<<<
- *   if best_count < num_neighbors:
- *     # didn't find an insert spot, so insert at the end
- */
-      __pyx_r = (__pyx_v_last_idx + 1);
-      goto __pyx_L0;
-      goto __pyx_L6;
-    }
-    __pyx_L6:;
-  }
-
-  /* "/home/belisarius/github/py_kdtree/cython_wrapper/kdtree.pyx":288
- *       nearest[idx] = candidate
- *       return last_idx + 1
- *   if best_count < num_neighbors:             # <<<<<<<<<<<<<<
- *     # didn't find an insert spot, so insert at the end
- *     nearest[best_count] = candidate
- */
-  __pyx_t_3 = (__pyx_v_best_count < __pyx_v_num_neighbors);
-  if (__pyx_t_3) {
-
-    /* "/home/belisarius/github/py_kdtree/cython_wrapper/kdtree.pyx":290
- *   if best_count < num_neighbors:
- *     # didn't find an insert spot, so insert at the end
- *     nearest[best_count] = candidate             # <<<<<<<<<<<<<<
- *     return best_count + 1
- *   return best_count
- */
-    (__pyx_v_nearest[__pyx_v_best_count]) = __pyx_v_candidate;
-
-    /* "/home/belisarius/github/py_kdtree/cython_wrapper/kdtree.pyx":291
- *     # didn't find an insert spot, so insert at the end
- *     nearest[best_count] = candidate
- *     return best_count + 1             # <<<<<<<<<<<<<<
- *   return best_count
- */
-    __pyx_r = (__pyx_v_best_count + 1);
-    goto __pyx_L0;
-    goto __pyx_L9;
-  }
-  __pyx_L9:;
-
-  /* "/home/belisarius/github/py_kdtree/cython_wrapper/kdtree.pyx":292
- *     nearest[best_count] = candidate
- *     return best_count + 1
- *   return best_count             # <<<<<<<<<<<<<<
- */
-  __pyx_r = __pyx_v_best_count;
-  goto __pyx_L0;
-
-  __pyx_r = 0;
-  goto __pyx_L0;
-  __pyx_L1_error:;
-  __Pyx_XDECREF(__pyx_t_7);
-  __Pyx_XDECREF(__pyx_t_8);
-  __Pyx_XDECREF(__pyx_t_9);
-  __Pyx_AddTraceback("kdtree.add_best");
-  __pyx_r = -2;
-  __pyx_L0:;
-  __Pyx_DECREF(__pyx_v_coords);
-  __Pyx_DECREF(__pyx_v_search_coords);
-  __Pyx_RefNannyFinishContext();
-  return __pyx_r;
-}
-
-static PyObject *__pyx_tp_new_6kdtree_PointData(PyTypeObject *t, PyObject *a, PyObject *k) {
-  struct __pyx_obj_6kdtree_PointData *p;
-  PyObject *o = (*t->tp_alloc)(t, 0);
-  if (!o) return 0;
-  p = ((struct __pyx_obj_6kdtree_PointData *)o);
-  p->coords = Py_None; Py_INCREF(Py_None);
-  if (__pyx_pf_6kdtree_9PointData___cinit__(o, a, k) < 0) {
-    Py_DECREF(o); o = 0;
-  }
-  return o;
-}
-
-static void __pyx_tp_dealloc_6kdtree_PointData(PyObject *o) {
-  struct __pyx_obj_6kdtree_PointData *p = (struct __pyx_obj_6kdtree_PointData *)o;
-  Py_XDECREF(p->coords);
-  (*Py_TYPE(o)->tp_free)(o);
-}
-
-static int __pyx_tp_traverse_6kdtree_PointData(PyObject *o, visitproc v, void *a) {
-  int e;
-  struct __pyx_obj_6kdtree_PointData *p = (struct __pyx_obj_6kdtree_PointData *)o;
-  if (p->coords) {
-    e = (*v)(p->coords, a); if (e) return e;
-  }
-  return 0;
-}
-
-static int __pyx_tp_clear_6kdtree_PointData(PyObject *o) {
-  struct __pyx_obj_6kdtree_PointData *p = (struct __pyx_obj_6kdtree_PointData *)o;
-  PyObject* tmp;
-  tmp = ((PyObject*)p->coords);
-  p->coords = Py_None; Py_INCREF(Py_None);
-  Py_XDECREF(tmp);
-  return 0;
-}
-
-static PyObject *__pyx_getprop_6kdtree_9PointData_dims(PyObject *o, void *x) {
-  return __pyx_pf_6kdtree_9PointData_4dims___get__(o);
-}
-
-static PyObject *__pyx_getprop_6kdtree_9PointData_num(PyObject *o, void *x) {
-  return __pyx_pf_6kdtree_9PointData_3num___get__(o);
-}
-
-static int __pyx_setprop_6kdtree_9PointData_num(PyObject *o, PyObject *v, void *x) {
-  if (v) {
-    return __pyx_pf_6kdtree_9PointData_3num___set__(o, v);
-  }
-  else {
-    PyErr_SetString(PyExc_NotImplementedError, "__del__");
-    return -1;
-  }
-}
-
-static PyObject *__pyx_getprop_6kdtree_9PointData_curr_axis(PyObject *o, void *x) {
-  return __pyx_pf_6kdtree_9PointData_9curr_axis___get__(o);
-}
-
-static int __pyx_setprop_6kdtree_9PointData_curr_axis(PyObject *o, PyObject *v, void *x) {
-  if (v) {
-    return __pyx_pf_6kdtree_9PointData_9curr_axis___set__(o, v);
-  }
-  else {
-    PyErr_SetString(PyExc_NotImplementedError, "__del__");
-    return -1;
-  }
-}
-
-static PyObject *__pyx_getprop_6kdtree_9PointData_coords(PyObject *o, void *x) {
-  return __pyx_pf_6kdtree_9PointData_6coords___get__(o);
-}
-
-static int __pyx_setprop_6kdtree_9PointData_coords(PyObject *o, PyObject *v, void *x) {
-  if (v) {
-    return __pyx_pf_6kdtree_9PointData_6coords___set__(o, v);
-  }
-  else {
-    PyErr_SetString(PyExc_NotImplementedError, "__del__");
-    return -1;
-  }
-}
-
-static struct PyMethodDef __pyx_methods_6kdtree_PointData[] = {
-  {__Pyx_NAMESTR("__str__"), (PyCFunction)__pyx_pf_6kdtree_9PointData___str__, METH_NOARGS|METH_COEXIST, __Pyx_DOCSTR(0)},
-  {__Pyx_NAMESTR("__repr__"), (PyCFunction)__pyx_pf_6kdtree_9PointData___repr__, METH_NOARGS|METH_COEXIST, __Pyx_DOCSTR(0)},
-  {0, 0, 0, 0}
-};
-
-static struct PyGetSetDef __pyx_getsets_6kdtree_PointData[] = {
-  {(char *)"dims", __pyx_getprop_6kdtree_9PointData_dims, 0, 0, 0},
-  {(char *)"num", __pyx_getprop_6kdtree_9PointData_num, __pyx_setprop_6kdtree_9PointData_num, 0, 0},
-  {(char *)"curr_axis", __pyx_getprop_6kdtree_9PointData_curr_axis, __pyx_setprop_6kdtree_9PointData_curr_axis, 0, 0},
-  {(char *)"coords", __pyx_getprop_6kdtree_9PointData_coords, __pyx_setprop_6kdtree_9PointData_coords, 0, 0},
-  {0, 0, 0, 0, 0}
-};
-
-static PyNumberMethods __pyx_tp_as_number_PointData = {
-  0, /*nb_add*/
-  0, /*nb_subtract*/
-  0, /*nb_multiply*/
-  #if PY_MAJOR_VERSION < 3
-  0, /*nb_divide*/
-  #endif
-  0, /*nb_remainder*/
-  0, /*nb_divmod*/
-  0, /*nb_power*/
-  0, /*nb_negative*/
-  0, /*nb_positive*/
-  0, /*nb_absolute*/
-  0, /*nb_nonzero*/
-  0, /*nb_invert*/
-  0, /*nb_lshift*/
-  0, /*nb_rshift*/
-  0, /*nb_and*/
-  0, /*nb_xor*/
-  0, /*nb_or*/
-  #if PY_MAJOR_VERSION < 3
-  0, /*nb_coerce*/
-  #endif
-  0, /*nb_int*/
-  #if PY_MAJOR_VERSION >= 3
-  0, /*reserved*/
-  #else
-  0, /*nb_long*/
-  #endif
-  0, /*nb_float*/
-  #if PY_MAJOR_VERSION < 3
-  0, /*nb_oct*/
-  #endif
-  #if PY_MAJOR_VERSION < 3
-  0, /*nb_hex*/
-  #endif
-  0, /*nb_inplace_add*/
-  0, /*nb_inplace_subtract*/
-  0, /*nb_inplace_multiply*/
-  #if PY_MAJOR_VERSION < 3
-  0, /*nb_inplace_divide*/
-  #endif
-  0, /*nb_inplace_remainder*/
-  0, /*nb_inplace_power*/
-  0, /*nb_inplace_lshift*/
-  0, /*nb_inplace_rshift*/
-  0, /*nb_inplace_and*/
-  0, /*nb_inplace_xor*/
-  0, /*nb_inplace_or*/
-  0, /*nb_floor_divide*/
-  0, /*nb_true_divide*/
-  0, /*nb_inplace_floor_divide*/
-  0, /*nb_inplace_true_divide*/
-  #if (PY_MAJOR_VERSION >= 3) || (Py_TPFLAGS_DEFAULT & Py_TPFLAGS_HAVE_INDEX)
-  0, /*nb_index*/
-  #endif
-};
-
-static PySequenceMethods __pyx_tp_as_sequence_PointData = {
-  0, /*sq_length*/
-  0, /*sq_concat*/
-  0, /*sq_repeat*/
-  0, /*sq_item*/
-  0, /*sq_slice*/
-  0, /*sq_ass_item*/
-  0, /*sq_ass_slice*/
-  0, /*sq_contains*/
-  0, /*sq_inplace_concat*/
-  0, /*sq_inplace_repeat*/
-};
-
-static PyMappingMethods __pyx_tp_as_mapping_PointData = {
-  0, /*mp_length*/
-  0, /*mp_subscript*/
-  0, /*mp_ass_subscript*/
-};
-
-static PyBufferProcs __pyx_tp_as_buffer_PointData = {
-  #if PY_MAJOR_VERSION < 3
-  0, /*bf_getreadbuffer*/
-  #endif
-  #if PY_MAJOR_VERSION < 3
-  0, /*bf_getwritebuffer*/
-  #endif
-  #if PY_MAJOR_VERSION < 3
-  0, /*bf_getsegcount*/
-  #endif
-  #if PY_MAJOR_VERSION < 3
-  0, /*bf_getcharbuffer*/
-  #endif
-  #if PY_VERSION_HEX >= 0x02060000
-  0, /*bf_getbuffer*/
-  #endif
-  #if PY_VERSION_HEX >= 0x02060000
-  0, /*bf_releasebuffer*/
-  #endif
-};
-
-PyTypeObject __pyx_type_6kdtree_PointData = {
-  PyVarObject_HEAD_INIT(0, 0)
-  __Pyx_NAMESTR("kdtree.PointData"), /*tp_name*/
-  sizeof(struct __pyx_obj_6kdtree_PointData), /*tp_basicsize*/
-  0, /*tp_itemsize*/
-  __pyx_tp_dealloc_6kdtree_PointData, /*tp_dealloc*/
-  0, /*tp_print*/
-  0, /*tp_getattr*/
-  0, /*tp_setattr*/
-  __pyx_pf_6kdtree_9PointData___cmp__, /*tp_compare*/
-  __pyx_pf_6kdtree_9PointData___repr__, /*tp_repr*/
-  &__pyx_tp_as_number_PointData, /*tp_as_number*/
-  &__pyx_tp_as_sequence_PointData, /*tp_as_sequence*/
-  &__pyx_tp_as_mapping_PointData, /*tp_as_mapping*/
-  0, /*tp_hash*/
-  0, /*tp_call*/
-  __pyx_pf_6kdtree_9PointData___str__, /*tp_str*/
-  0, /*tp_getattro*/
-  0, /*tp_setattro*/
-  &__pyx_tp_as_buffer_PointData, /*tp_as_buffer*/
-  Py_TPFLAGS_DEFAULT|Py_TPFLAGS_CHECKTYPES|Py_TPFLAGS_BASETYPE|Py_TPFLAGS_HAVE_NEWBUFFER|Py_TPFLAGS_HAVE_GC, /*tp_flags*/
-  __Pyx_DOCSTR("Representation of point data.  Exists so we can sort without lambda key, \n  which Cython does not support."), /*tp_doc*/
-  __pyx_tp_traverse_6kdtree_PointData, /*tp_traverse*/
-  __pyx_tp_clear_6kdtree_PointData, /*tp_clear*/
-  0, /*tp_richcompare*/
-  0, /*tp_weaklistoffset*/
-  0, /*tp_iter*/
-  0, /*tp_iternext*/
-  __pyx_methods_6kdtree_PointData, /*tp_methods*/
-  0, /*tp_members*/
-  __pyx_getsets_6kdtree_PointData, /*tp_getset*/
-  0, /*tp_base*/
-  0, /*tp_dict*/
-  0, /*tp_descr_get*/
-  0, /*tp_descr_set*/
-  0, /*tp_dictoffset*/
-  0, /*tp_init*/
-  0, /*tp_alloc*/
-  __pyx_tp_new_6kdtree_PointData, /*tp_new*/
-  0, /*tp_free*/
-  0, /*tp_is_gc*/
-  0, /*tp_bases*/
-  0, /*tp_mro*/
-  0, /*tp_cache*/
-  0, /*tp_subclasses*/
-  0, /*tp_weaklist*/
-  0, /*tp_del*/
-  #if PY_VERSION_HEX >= 0x02060000
-  0, /*tp_version_tag*/
-  #endif
-};
-static struct __pyx_vtabstruct_6kdtree_KDTreeNode __pyx_vtable_6kdtree_KDTreeNode;
-
-static PyObject *__pyx_tp_new_6kdtree_KDTreeNode(PyTypeObject *t, PyObject *a, PyObject *k) {
-  struct __pyx_obj_6kdtree_KDTreeNode *p;
-  PyObject *o = (*t->tp_alloc)(t, 0);
-  if (!o) return 0;
-  p = ((struct __pyx_obj_6kdtree_KDTreeNode *)o);
-  p->__pyx_vtab = __pyx_vtabptr_6kdtree_KDTreeNode;
-  p->data = ((struct __pyx_obj_6kdtree_PointData *)Py_None); Py_INCREF(Py_None);
-  p->left = ((struct __pyx_obj_6kdtree_KDTreeNode *)Py_None); Py_INCREF(Py_None);
-  p->right = ((struct __pyx_obj_6kdtree_KDTreeNode *)Py_None); Py_INCREF(Py_None);
-  return o;
-}
-
-static void __pyx_tp_dealloc_6kdtree_KDTreeNode(PyObject *o) {
-  struct __pyx_obj_6kdtree_KDTreeNode *p = (struct __pyx_obj_6kdtree_KDTreeNode *)o;
-  Py_XDECREF(((PyObject *)p->data));
-  Py_XDECREF(((PyObject *)p->left));
-  Py_XDECREF(((PyObject *)p->right));
-  (*Py_TYPE(o)->tp_free)(o);
-}
-
-static int __pyx_tp_traverse_6kdtree_KDTreeNode(PyObject *o, visitproc v, void *a) {
-  int e;
-  struct __pyx_obj_6kdtree_KDTreeNode *p = (struct __pyx_obj_6kdtree_KDTreeNode *)o;
-  if (p->data) {
-    e = (*v)(((PyObject*)p->data), a); if (e) return e;
-  }
-  if (p->left) {
-    e = (*v)(((PyObject*)p->left), a); if (e) return e;
-  }
-  if (p->right) {
-    e = (*v)(((PyObject*)p->right), a); if (e) return e;
-  }
-  return 0;
-}
-
-static int __pyx_tp_clear_6kdtree_KDTreeNode(PyObject *o) {
-  struct __pyx_obj_6kdtree_KDTreeNode *p = (struct __pyx_obj_6kdtree_KDTreeNode *)o;
-  PyObject* tmp;
-  tmp = ((PyObject*)p->data);
-  p->data = ((struct __pyx_obj_6kdtree_PointData *)Py_None); Py_INCREF(Py_None);
-  Py_XDECREF(tmp);
-  tmp = ((PyObject*)p->left);
-  p->left = ((struct __pyx_obj_6kdtree_KDTreeNode *)Py_None); Py_INCREF(Py_None);
-  Py_XDECREF(tmp);
-  tmp = ((PyObject*)p->right);
-  p->right = ((struct __pyx_obj_6kdtree_KDTreeNode *)Py_None); Py_INCREF(Py_None);
-  Py_XDECREF(tmp);
-  return 0;
-}
-
-static PyObject *__pyx_getprop_6kdtree_10KDTreeNode_num(PyObject *o, void *x) {
-  return __pyx_pf_6kdtree_10KDTreeNode_3num___get__(o);
-}
-
-static PyObject *__pyx_getprop_6kdtree_10KDTreeNode_left(PyObject *o, void *x) {
-  return __pyx_pf_6kdtree_10KDTreeNode_4left___get__(o);
-}
-
-static PyObject *__pyx_getprop_6kdtree_10KDTreeNode_right(PyObject *o, void *x) {
-  return __pyx_pf_6kdtree_10KDTreeNode_5right___get__(o);
-}
-
-static struct PyMethodDef __pyx_methods_6kdtree_KDTreeNode[] = {
-  {__Pyx_NAMESTR("run_nn_search"), (PyCFunction)__pyx_pf_6kdtree_10KDTreeNode_run_nn_search, METH_VARARGS|METH_KEYWORDS, __Pyx_DOCSTR(__pyx_doc_6kdtree_10KDTreeNode_run_nn_search)},
-  {0, 0, 0, 0}
-};
-
-static struct PyGetSetDef __pyx_getsets_6kdtree_KDTreeNode[] = {
-  {(char *)"num", __pyx_getprop_6kdtree_10KDTreeNode_num, 0, 0, 0},
-  {(char *)"left", __pyx_getprop_6kdtree_10KDTreeNode_left, 0, 0, 0},
-  {(char *)"right", __pyx_getprop_6kdtree_10KDTreeNode_right, 0, 0, 0},
-  {0, 0, 0, 0, 0}
-};
-
-static PyNumberMethods __pyx_tp_as_number_KDTreeNode = {
-  0, /*nb_add*/
-  0, /*nb_subtract*/
-  0, /*nb_multiply*/
-  #if PY_MAJOR_VERSION < 3
-  0, /*nb_divide*/
-  #endif
-  0, /*nb_remainder*/
-  0, /*nb_divmod*/
-  0, /*nb_power*/
-  0, /*nb_negative*/
-  0, /*nb_positive*/
-  0, /*nb_absolute*/
-  0, /*nb_nonzero*/
-  0, /*nb_invert*/
-  0, /*nb_lshift*/
-  0, /*nb_rshift*/
-  0, /*nb_and*/
-  0, /*nb_xor*/
-  0, /*nb_or*/
-  #if PY_MAJOR_VERSION < 3
-  0, /*nb_coerce*/
-  #endif
-  0, /*nb_int*/
-  #if PY_MAJOR_VERSION >= 3
-  0, /*reserved*/
-  #else
-  0, /*nb_long*/
-  #endif
-  0, /*nb_float*/
-  #if PY_MAJOR_VERSION < 3
-  0, /*nb_oct*/
-  #endif
-  #if PY_MAJOR_VERSION < 3
-  0, /*nb_hex*/
-  #endif
-  0, /*nb_inplace_add*/
-  0, /*nb_inplace_subtract*/
-  0, /*nb_inplace_multiply*/
-  #if PY_MAJOR_VERSION < 3
-  0, /*nb_inplace_divide*/
-  #endif
-  0, /*nb_inplace_remainder*/
-  0, /*nb_inplace_power*/
-  0, /*nb_inplace_lshift*/
-  0, /*nb_inplace_rshift*/
-  0, /*nb_inplace_and*/
-  0, /*nb_inplace_xor*/
-  0, /*nb_inplace_or*/
-  0, /*nb_floor_divide*/
-  0, /*nb_true_divide*/
-  0, /*nb_inplace_floor_divide*/
-  0, /*nb_inplace_true_divide*/
-  #if (PY_MAJOR_VERSION >= 3) || (Py_TPFLAGS_DEFAULT & Py_TPFLAGS_HAVE_INDEX)
-  0, /*nb_index*/
-  #endif
-};
-
-static PySequenceMethods __pyx_tp_as_sequence_KDTreeNode = {
-  0, /*sq_length*/
-  0, /*sq_concat*/
-  0, /*sq_repeat*/
-  0, /*sq_item*/
-  0, /*sq_slice*/
-  0, /*sq_ass_item*/
-  0, /*sq_ass_slice*/
-  0, /*sq_contains*/
-  0, /*sq_inplace_concat*/
-  0, /*sq_inplace_repeat*/
-};
-
-static PyMappingMethods __pyx_tp_as_mapping_KDTreeNode = {
-  0, /*mp_length*/
-  0, /*mp_subscript*/
-  0, /*mp_ass_subscript*/
-};
-
-static PyBufferProcs __pyx_tp_as_buffer_KDTreeNode = {
-  #if PY_MAJOR_VERSION < 3
-  0, /*bf_getreadbuffer*/
-  #endif
-  #if PY_MAJOR_VERSION < 3
-  0, /*bf_getwritebuffer*/
-  #endif
-  #if PY_MAJOR_VERSION < 3
-  0, /*bf_getsegcount*/
-  #endif
-  #if PY_MAJOR_VERSION < 3
-  0, /*bf_getcharbuffer*/
-  #endif
-  #if PY_VERSION_HEX >= 0x02060000
-  0, /*bf_getbuffer*/
-  #endif
-  #if PY_VERSION_HEX >= 0x02060000
-  0, /*bf_releasebuffer*/
-  #endif
-};
-
-PyTypeObject __pyx_type_6kdtree_KDTreeNode = {
-  PyVarObject_HEAD_INIT(0, 0)
-  __Pyx_NAMESTR("kdtree.KDTreeNode"), /*tp_name*/
-  sizeof(struct __pyx_obj_6kdtree_KDTreeNode), /*tp_basicsize*/
-  0, /*tp_itemsize*/
-  __pyx_tp_dealloc_6kdtree_KDTreeNode, /*tp_dealloc*/
-  0, /*tp_print*/
-  0, /*tp_getattr*/
-  0, /*tp_setattr*/
-  0, /*tp_compare*/
-  0, /*tp_repr*/
-  &__pyx_tp_as_number_KDTreeNode, /*tp_as_number*/
-  &__pyx_tp_as_sequence_KDTreeNode, /*tp_as_sequence*/
-  &__pyx_tp_as_mapping_KDTreeNode, /*tp_as_mapping*/
-  0, /*tp_hash*/
-  0, /*tp_call*/
-  0, /*tp_str*/
-  0, /*tp_getattro*/
-  0, /*tp_setattro*/
-  &__pyx_tp_as_buffer_KDTreeNode, /*tp_as_buffer*/
-  Py_TPFLAGS_DEFAULT|Py_TPFLAGS_CHECKTYPES|Py_TPFLAGS_BASETYPE|Py_TPFLAGS_HAVE_NEWBUFFER|Py_TPFLAGS_HAVE_GC, /*tp_flags*/
-  __Pyx_DOCSTR("A C extension class to the KDTree C code"), /*tp_doc*/
-  __pyx_tp_traverse_6kdtree_KDTreeNode, /*tp_traverse*/
-  __pyx_tp_clear_6kdtree_KDTreeNode, /*tp_clear*/
-  0, /*tp_richcompare*/
-  0, /*tp_weaklistoffset*/
-  0, /*tp_iter*/
-  0, /*tp_iternext*/
-  __pyx_methods_6kdtree_KDTreeNode, /*tp_methods*/
-  0, /*tp_members*/
-  __pyx_getsets_6kdtree_KDTreeNode, /*tp_getset*/
-  0, /*tp_base*/
-  0, /*tp_dict*/
-  0, /*tp_descr_get*/
-  0, /*tp_descr_set*/
-  0, /*tp_dictoffset*/
-  __pyx_pf_6kdtree_10KDTreeNode___init__, /*tp_init*/
-  0, /*tp_alloc*/
-  __pyx_tp_new_6kdtree_KDTreeNode, /*tp_new*/
-  0, /*tp_free*/
-  0, /*tp_is_gc*/
-  0, /*tp_bases*/
-  0, /*tp_mro*/
-  0, /*tp_cache*/
-  0, /*tp_subclasses*/
-  0, /*tp_weaklist*/
-  0, /*tp_del*/
-  #if PY_VERSION_HEX >= 0x02060000
-  0, /*tp_version_tag*/
-  #endif
-};
-
-static struct PyMethodDef __pyx_methods[] = {
-  {__Pyx_NAMESTR("print_preorder"), (PyCFunction)__pyx_pf_6kdtree_print_preorder, METH_O, __Pyx_DOCSTR(__pyx_doc_6kdtree_print_preorder)},
-  {__Pyx_NAMESTR("fill_tree"), (PyCFunction)__pyx_pf_6kdtree_fill_tree, METH_O, __Pyx_DOCSTR(__pyx_doc_6kdtree_fill_tree)},
-  {0, 0, 0, 0}
-};
-
-static void __pyx_init_filenames(void); /*proto*/
-
-#if PY_MAJOR_VERSION >= 3
-static struct PyModuleDef __pyx_moduledef = {
-    PyModuleDef_HEAD_INIT,
-    __Pyx_NAMESTR("kdtree"),
-    0, /* m_doc */
-    -1, /* m_size */
-    __pyx_methods /* m_methods */,
-    NULL, /* m_reload */
-    NULL, /* m_traverse */
-    NULL, /* m_clear */
-    NULL /* m_free */
-};
-#endif
-
-static __Pyx_StringTabEntry __pyx_string_tab[] = {
-  {&__pyx_kp_s_1, __pyx_k_1, sizeof(__pyx_k_1), 0, 0, 1, 0},
-  {&__pyx_kp_s_2, __pyx_k_2, sizeof(__pyx_k_2), 0, 0, 1, 0},
-  {&__pyx_kp_u_3, __pyx_k_3, sizeof(__pyx_k_3), 0, 1, 0, 0},
-  {&__pyx_kp_u_4, __pyx_k_4, sizeof(__pyx_k_4), 0, 1, 0, 0},
-  {&__pyx_kp_u_5, __pyx_k_5, sizeof(__pyx_k_5), 0, 1, 0, 0},
-  {&__pyx_kp_u_6, __pyx_k_6, sizeof(__pyx_k_6), 0, 1, 0, 0},
-  {&__pyx_n_s__KDTreeNode, __pyx_k__KDTreeNode, sizeof(__pyx_k__KDTreeNode), 0, 0, 1, 1},
-  {&__pyx_n_s__MemoryError, __pyx_k__MemoryError, sizeof(__pyx_k__MemoryError), 0, 0, 1, 1},
-  {&__pyx_n_s____init__, __pyx_k____init__, sizeof(__pyx_k____init__), 0, 0, 1, 1},
-  {&__pyx_n_s____main__, __pyx_k____main__, sizeof(__pyx_k____main__), 0, 0, 1, 1},
-  {&__pyx_n_s____test__, __pyx_k____test__, sizeof(__pyx_k____test__), 0, 0, 1, 1},
-  {&__pyx_n_s__array, __pyx_k__array, sizeof(__pyx_k__array), 0, 0, 1, 1},
-  {&__pyx_n_s__coords, __pyx_k__coords, sizeof(__pyx_k__coords), 0, 0, 1, 1},
-  {&__pyx_n_s__curr_axis, __pyx_k__curr_axis, sizeof(__pyx_k__curr_axis), 0, 0, 1, 1},
-  {&__pyx_n_s__d, __pyx_k__d, sizeof(__pyx_k__d), 0, 0, 1, 1},
-  {&__pyx_n_s__data, __pyx_k__data, sizeof(__pyx_k__data), 0, 0, 1, 1},
-  {&__pyx_n_s__dims, __pyx_k__dims, sizeof(__pyx_k__dims), 0, 0, 1, 1},
-  {&__pyx_n_s__dist, __pyx_k__dist, sizeof(__pyx_k__dist), 0, 0, 1, 1},
-  {&__pyx_n_s__fill_tree, __pyx_k__fill_tree, sizeof(__pyx_k__fill_tree), 0, 0, 1, 1},
-  {&__pyx_n_s__left, __pyx_k__left, sizeof(__pyx_k__left), 0, 0, 1, 1},
-  {&__pyx_n_s__node_num, __pyx_k__node_num, sizeof(__pyx_k__node_num), 0, 0, 1, 1},
-  {&__pyx_n_s__num, __pyx_k__num, sizeof(__pyx_k__num), 0, 0, 1, 1},
-  {&__pyx_n_s__num_neighbors, __pyx_k__num_neighbors, sizeof(__pyx_k__num_neighbors), 0, 0, 1, 1},
-  {&__pyx_n_s__number, __pyx_k__number, sizeof(__pyx_k__number), 0, 0, 1, 1},
-  {&__pyx_n_s__print_preorder, __pyx_k__print_preorder, sizeof(__pyx_k__print_preorder), 0, 0, 1, 1},
-  {&__pyx_n_s__range, __pyx_k__range, sizeof(__pyx_k__range), 0, 0, 1, 1},
-  {&__pyx_n_s__right, __pyx_k__right, sizeof(__pyx_k__right), 0, 0, 1, 1},
-  {&__pyx_n_s__run_nn_search, __pyx_k__run_nn_search, sizeof(__pyx_k__run_nn_search), 0, 0, 1, 1},
-  {&__pyx_n_s__search, __pyx_k__search, sizeof(__pyx_k__search), 0, 0, 1, 1},
-  {&__pyx_n_s__sort, __pyx_k__sort, sizeof(__pyx_k__sort), 0, 0, 1, 1},
-  {&__pyx_n_s__xrange, __pyx_k__xrange, sizeof(__pyx_k__xrange), 0, 0, 1, 1},
-  {0, 0, 0, 0, 0, 0, 0}
-};
-static int __Pyx_InitCachedBuiltins(void) {
-  __pyx_builtin_MemoryError = __Pyx_GetName(__pyx_b, __pyx_n_s__MemoryError); if (!__pyx_builtin_MemoryError) {__pyx_filename = __pyx_f[0]; __pyx_lineno = 122; __pyx_clineno = __LINE__; goto __pyx_L1_error;}
-  #if PY_MAJOR_VERSION >= 3
-  __pyx_builtin_xrange = __Pyx_GetName(__pyx_b, __pyx_n_s__range); if (!__pyx_builtin_xrange) {__pyx_filename = __pyx_f[0]; __pyx_lineno = 128; __pyx_clineno = __LINE__; goto __pyx_L1_error;}
-  #else
-  __pyx_builtin_xrange = __Pyx_GetName(__pyx_b, __pyx_n_s__xrange); if (!__pyx_builtin_xrange) {__pyx_filename = __pyx_f[0]; __pyx_lineno = 128; __pyx_clineno = __LINE__; goto __pyx_L1_error;}
-  #endif
-  return 0;
-  __pyx_L1_error:;
-  return -1;
-}
-
-static int __Pyx_InitGlobals(void) {
-  if (__Pyx_InitStrings(__pyx_string_tab) < 0) {__pyx_filename = __pyx_f[0]; __pyx_lineno = 1; __pyx_clineno = __LINE__; goto __pyx_L1_error;};
-  __pyx_int_neg_1 = PyInt_FromLong(-1); if (unlikely(!__pyx_int_neg_1)) {__pyx_filename = __pyx_f[0]; __pyx_lineno = 1; __pyx_clineno = __LINE__; goto __pyx_L1_error;};
-  return 0;
-  __pyx_L1_error:;
-  return -1;
-}
-
-#if PY_MAJOR_VERSION < 3
-PyMODINIT_FUNC initkdtree(void); /*proto*/
-PyMODINIT_FUNC initkdtree(void)
-#else
-PyMODINIT_FUNC PyInit_kdtree(void); /*proto*/
-PyMODINIT_FUNC PyInit_kdtree(void)
-#endif
-{
-  PyObject *__pyx_t_1 = NULL;
-  PyObject *__pyx_t_2 = NULL;
-  PyObject *__pyx_t_3 = NULL;
-  #if CYTHON_REFNANNY
-  void* __pyx_refnanny = NULL;
-  __Pyx_RefNanny = __Pyx_RefNannyImportAPI("refnanny");
-  if (!__Pyx_RefNanny) {
-      PyErr_Clear();
-      __Pyx_RefNanny = __Pyx_RefNannyImportAPI("Cython.Runtime.refnanny");
-      if (!__Pyx_RefNanny)
-          Py_FatalError("failed to import 'refnanny' module");
-  }
-  __pyx_refnanny = __Pyx_RefNanny->SetupContext("PyMODINIT_FUNC PyInit_kdtree(void)", __LINE__, __FILE__);
-  #endif
-  __pyx_init_filenames();
-  __pyx_empty_tuple = PyTuple_New(0); if (unlikely(!__pyx_empty_tuple)) {__pyx_filename = __pyx_f[0]; __pyx_lineno = 1; __pyx_clineno = __LINE__; goto __pyx_L1_error;}
-  #if PY_MAJOR_VERSION < 3
-  __pyx_empty_bytes = PyString_FromStringAndSize("", 0); if (unlikely(!__pyx_empty_bytes)) {__pyx_filename = __pyx_f[0]; __pyx_lineno = 1; __pyx_clineno = __LINE__; goto __pyx_L1_error;}
-  #else
-  __pyx_empty_bytes = PyBytes_FromStringAndSize("", 0); if (unlikely(!__pyx_empty_bytes)) {__pyx_filename = __pyx_f[0]; __pyx_lineno = 1; __pyx_clineno = __LINE__; goto __pyx_L1_error;}
-  #endif
-  /*--- Library function declarations ---*/
-  /*--- Threads initialization code ---*/
-  #if defined(__PYX_FORCE_INIT_THREADS) && __PYX_FORCE_INIT_THREADS
-  #ifdef WITH_THREAD /* Python build with threading support? */
-  PyEval_InitThreads();
-  #endif
-  #endif
-  /*--- Module creation code ---*/
-  #if PY_MAJOR_VERSION < 3
-  __pyx_m = Py_InitModule4(__Pyx_NAMESTR("kdtree"), __pyx_methods, 0, 0, PYTHON_API_VERSION);
-  #else
-  __pyx_m = PyModule_Create(&__pyx_moduledef);
-  #endif
-  if (!__pyx_m) {__pyx_filename = __pyx_f[0]; __pyx_lineno = 1; __pyx_clineno = __LINE__; goto __pyx_L1_error;};
-  #if PY_MAJOR_VERSION < 3
-  Py_INCREF(__pyx_m);
-  #endif
-  __pyx_b = PyImport_AddModule(__Pyx_NAMESTR(__Pyx_BUILTIN_MODULE_NAME));
-  if (!__pyx_b) {__pyx_filename = __pyx_f[0]; __pyx_lineno = 1; __pyx_clineno = __LINE__; goto __pyx_L1_error;};
-  if (__Pyx_SetAttrString(__pyx_m, "__builtins__", __pyx_b) < 0) {__pyx_filename = __pyx_f[0]; __pyx_lineno = 1; __pyx_clineno = __LINE__; goto __pyx_L1_error;};
-  /*--- Initialize various global constants etc. ---*/
-  if (unlikely(__Pyx_InitGlobals() < 0)) {__pyx_filename = __pyx_f[0]; __pyx_lineno = 1; __pyx_clineno = __LINE__; goto __pyx_L1_error;}
-  if (__pyx_module_is_main_kdtree) {
-    if (__Pyx_SetAttrString(__pyx_m, "__name__", __pyx_n_s____main__) < 0) {__pyx_filename = __pyx_f[0]; __pyx_lineno = 1; __pyx_clineno = __LINE__; goto __pyx_L1_error;};
-  }
-  /*--- Builtin init code ---*/
-  if (unlikely(__Pyx_InitCachedBuiltins() < 0)) {__pyx_filename = __pyx_f[0]; __pyx_lineno = 1; __pyx_clineno = __LINE__; goto __pyx_L1_error;}
-  /*--- Global init code ---*/
-  /*--- Function export code ---*/
-  /*--- Type init code ---*/
-  if (PyType_Ready(&__pyx_type_6kdtree_PointData) < 0) {__pyx_filename = __pyx_f[0]; __pyx_lineno = 33; __pyx_clineno = __LINE__; goto __pyx_L1_error;}
-  if (__Pyx_SetAttrString(__pyx_m, "PointData", (PyObject *)&__pyx_type_6kdtree_PointData) < 0) {__pyx_filename = __pyx_f[0]; __pyx_lineno = 33; __pyx_clineno = __LINE__; goto __pyx_L1_error;}
-  __pyx_ptype_6kdtree_PointData = &__pyx_type_6kdtree_PointData;
-  __pyx_vtabptr_6kdtree_KDTreeNode = &__pyx_vtable_6kdtree_KDTreeNode;
-  #if PY_MAJOR_VERSION >= 3
-  __pyx_vtable_6kdtree_KDTreeNode.run_nn_search = (PyObject *(*)(struct __pyx_obj_6kdtree_KDTreeNode *, struct __pyx_obj_6kdtree_PointData *, size_t, int __pyx_skip_dispatch))__pyx_f_6kdtree_10KDTreeNode_run_nn_search;
-  #else
-  *(void(**)(void))&__pyx_vtable_6kdtree_KDTreeNode.run_nn_search = (void(*)(void))__pyx_f_6kdtree_10KDTreeNode_run_nn_search;
-  #endif
-  if (PyType_Ready(&__pyx_type_6kdtree_KDTreeNode) < 0) {__pyx_filename = __pyx_f[0]; __pyx_lineno = 87; __pyx_clineno = __LINE__; goto __pyx_L1_error;}
-  if (__Pyx_SetVtable(__pyx_type_6kdtree_KDTreeNode.tp_dict, __pyx_vtabptr_6kdtree_KDTreeNode) < 0) {__pyx_filename = __pyx_f[0]; __pyx_lineno = 87; __pyx_clineno = __LINE__; goto __pyx_L1_error;}
-  if (__Pyx_SetAttrString(__pyx_m, "KDTreeNode", (PyObject *)&__pyx_type_6kdtree_KDTreeNode) < 0) {__pyx_filename = __pyx_f[0]; __pyx_lineno = 87; __pyx_clineno = __LINE__; goto __pyx_L1_error;}
-  __pyx_ptype_6kdtree_KDTreeNode = &__pyx_type_6kdtree_KDTreeNode;
-  /*--- Type import code ---*/
-  /*--- Function import code ---*/
-  /*--- Execution code ---*/
-
-  /* "/home/belisarius/github/py_kdtree/cython_wrapper/kdtree.pyx":21
- * # and
- * # http://en.wikipedia.org/wiki/Kd-tree
- * import array             # <<<<<<<<<<<<<<
- * 
- * cdef extern from "stdlib.h":
- */
-  __pyx_t_1 = __Pyx_Import(((PyObject *)__pyx_n_s__array), 0); if (unlikely(!__pyx_t_1)) {__pyx_filename = __pyx_f[0]; __pyx_lineno = 21; __pyx_clineno = __LINE__; goto __pyx_L1_error;}
-  __Pyx_GOTREF(__pyx_t_1);
-  if (PyObject_SetAttr(__pyx_m, __pyx_n_s__array, __pyx_t_1) < 0) {__pyx_filename = __pyx_f[0]; __pyx_lineno = 21; __pyx_clineno = __LINE__; goto __pyx_L1_error;}
-  __Pyx_DECREF(__pyx_t_1); __pyx_t_1 = 0;
-
-  /* "/home/belisarius/github/py_kdtree/cython_wrapper/kdtree.pyx":1
- * #!/usr/bin/python             # <<<<<<<<<<<<<<
- * 
- * # Copyright 2011 Chris M Bouzek
- */
-  __pyx_t_1 = PyDict_New(); if (unlikely(!__pyx_t_1)) {__pyx_filename = __pyx_f[0]; __pyx_lineno = 1; __pyx_clineno = __LINE__; goto __pyx_L1_error;}
-  __Pyx_GOTREF(((PyObject *)__pyx_t_1));
-  __pyx_t_2 = PyObject_GetAttr(__pyx_m, __pyx_n_s__KDTreeNode); if (unlikely(!__pyx_t_2)) {__pyx_filename = __pyx_f[0]; __pyx_lineno = 1; __pyx_clineno = __LINE__; goto __pyx_L1_error;}
-  __Pyx_GOTREF(__pyx_t_2);
-  __pyx_t_3 = PyObject_GetAttr(__pyx_t_2, __pyx_n_s____init__); if (unlikely(!__pyx_t_3)) {__pyx_filename = __pyx_f[0]; __pyx_lineno = 1; __pyx_clineno = __LINE__; goto __pyx_L1_error;}
-  __Pyx_GOTREF(__pyx_t_3);
-  __Pyx_DECREF(__pyx_t_2); __pyx_t_2 = 0;
-  __pyx_t_2 = __Pyx_GetAttrString(__pyx_t_3, "__doc__");
-  __Pyx_GOTREF(__pyx_t_2);
-  __Pyx_DECREF(__pyx_t_3); __pyx_t_3 = 0;
-  if (PyDict_SetItem(__pyx_t_1, ((PyObject *)__pyx_kp_u_3), __pyx_t_2) < 0) {__pyx_filename = __pyx_f[0]; __pyx_lineno = 1; __pyx_clineno = __LINE__; goto __pyx_L1_error;}
-  __Pyx_DECREF(__pyx_t_2); __pyx_t_2 = 0;
-  __pyx_t_2 = PyObject_GetAttr(__pyx_m, __pyx_n_s__KDTreeNode); if (unlikely(!__pyx_t_2)) {__pyx_filename = __pyx_f[0]; __pyx_lineno = 1; __pyx_clineno = __LINE__; goto __pyx_L1_error;}
-  __Pyx_GOTREF(__pyx_t_2);
-  __pyx_t_3 = PyObject_GetAttr(__pyx_t_2, __pyx_n_s__run_nn_search); if (unlikely(!__pyx_t_3)) {__pyx_filename = __pyx_f[0]; __pyx_lineno = 1; __pyx_clineno = __LINE__; goto __pyx_L1_error;}
-  __Pyx_GOTREF(__pyx_t_3);
-  __Pyx_DECREF(__pyx_t_2); __pyx_t_2 = 0;
-  __pyx_t_2 = __Pyx_GetAttrString(__pyx_t_3, "__doc__");
-  __Pyx_GOTREF(__pyx_t_2);
-  __Pyx_DECREF(__pyx_t_3); __pyx_t_3 = 0;
-  if (PyDict_SetItem(__pyx_t_1, ((PyObject *)__pyx_kp_u_4), __pyx_t_2) < 0) {__pyx_filename = __pyx_f[0]; __pyx_lineno = 1; __pyx_clineno = __LINE__; goto __pyx_L1_error;}
-  __Pyx_DECREF(__pyx_t_2); __pyx_t_2 = 0;
-  __pyx_t_2 = PyObject_GetAttr(__pyx_m, __pyx_n_s__print_preorder); if (unlikely(!__pyx_t_2)) {__pyx_filename = __pyx_f[0]; __pyx_lineno = 1; __pyx_clineno = __LINE__; goto __pyx_L1_error;}
-  __Pyx_GOTREF(__pyx_t_2);
-  __pyx_t_3 = __Pyx_GetAttrString(__pyx_t_2, "__doc__");
-  __Pyx_GOTREF(__pyx_t_3);
-  __Pyx_DECREF(__pyx_t_2); __pyx_t_2 = 0;
-  if (PyDict_SetItem(__pyx_t_1, ((PyObject *)__pyx_kp_u_5), __pyx_t_3) < 0) {__pyx_filename = __pyx_f[0]; __pyx_lineno = 1; __pyx_clineno = __LINE__; goto __pyx_L1_error;}
-  __Pyx_DECREF(__pyx_t_3); __pyx_t_3 = 0;
-  __pyx_t_3 = PyObject_GetAttr(__pyx_m, __pyx_n_s__fill_tree); if (unlikely(!__pyx_t_3)) {__pyx_filename = __pyx_f[0]; __pyx_lineno = 1; __pyx_clineno = __LINE__; goto __pyx_L1_error;}
-  __Pyx_GOTREF(__pyx_t_3);
-  __pyx_t_2 = __Pyx_GetAttrString(__pyx_t_3, "__doc__");
-  __Pyx_GOTREF(__pyx_t_2);
-  __Pyx_DECREF(__pyx_t_3); __pyx_t_3 = 0;
-  if (PyDict_SetItem(__pyx_t_1, ((PyObject *)__pyx_kp_u_6), __pyx_t_2) < 0) {__pyx_filename = __pyx_f[0]; __pyx_lineno = 1; __pyx_clineno = __LINE__; goto __pyx_L1_error;}
-  __Pyx_DECREF(__pyx_t_2); __pyx_t_2 = 0;
-  if (PyObject_SetAttr(__pyx_m, __pyx_n_s____test__, ((PyObject *)__pyx_t_1)) < 0) {__pyx_filename = __pyx_f[0]; __pyx_lineno = 1; __pyx_clineno = __LINE__; goto __pyx_L1_error;}
-  __Pyx_DECREF(((PyObject *)__pyx_t_1)); __pyx_t_1 = 0;
-  goto __pyx_L0;
-  __pyx_L1_error:;
-  __Pyx_XDECREF(__pyx_t_1);
-  __Pyx_XDECREF(__pyx_t_2);
-  __Pyx_XDECREF(__pyx_t_3);
-  if (__pyx_m) {
-    __Pyx_AddTraceback("init kdtree");
-    Py_DECREF(__pyx_m); __pyx_m = 0;
-  } else if (!PyErr_Occurred()) {
-    PyErr_SetString(PyExc_ImportError, "init kdtree");
-  }
-  __pyx_L0:;
-  __Pyx_RefNannyFinishContext();
-  #if PY_MAJOR_VERSION < 3
-  return;
-  #else
-  return __pyx_m;
-  #endif
-}
-
-static const char *__pyx_filenames[] = {
-  "kdtree.pyx",
-};
-
-/* Runtime support code */
-
-static void __pyx_init_filenames(void) {
-  __pyx_f = __pyx_filenames;
-}
-
-static void __Pyx_RaiseDoubleKeywordsError(
-    const char* func_name,
-    PyObject* kw_name)
-{
-    PyErr_Format(PyExc_TypeError,
-        #if PY_MAJOR_VERSION >= 3
-        "%s() got multiple values for keyword argument '%U'", func_name, kw_name);
-        #else
-        "%s() got multiple values for keyword argument '%s'", func_name,
-        PyString_AS_STRING(kw_name));
-        #endif
-}
-
-static void __Pyx_RaiseArgtupleInvalid(
-    const char* func_name,
-    int exact,
-    Py_ssize_t num_min,
-    Py_ssize_t num_max,
-    Py_ssize_t num_found)
-{
-    Py_ssize_t num_expected;
-    const char *number, *more_or_less;
-
-    if (num_found < num_min) {
-        num_expected = num_min;
-        more_or_less = "at least";
-    } else {
-        num_expected = num_max;
-        more_or_less = "at most";
-    }
-    if (exact) {
-        more_or_less = "exactly";
-    }
-    number = (num_expected == 1) ? "" : "s";
-    PyErr_Format(PyExc_TypeError,
-        #if PY_VERSION_HEX < 0x02050000
-            "%s() takes %s %d positional argument%s (%d given)",
-        #else
-            "%s() takes %s %zd positional argument%s (%zd given)",
-        #endif
-        func_name, more_or_less, num_expected, number, num_found);
-}
-
-static int __Pyx_ParseOptionalKeywords(
-    PyObject *kwds,
-    PyObject **argnames[],
-    PyObject *kwds2,
-    PyObject *values[],
-    Py_ssize_t num_pos_args,
-    const char* function_name)
-{
-    PyObject *key = 0, *value = 0;
-    Py_ssize_t pos = 0;
-    PyObject*** name;
-    PyObject*** first_kw_arg = argnames + num_pos_args;
-
-    while (PyDict_Next(kwds, &pos, &key, &value)) {
-        name = first_kw_arg;
-        while (*name && (**name != key)) name++;
-        if (*name) {
-            values[name-argnames] = value;
-        } else {
-            #if PY_MAJOR_VERSION < 3
-            if (unlikely(!PyString_CheckExact(key)) && unlikely(!PyString_Check(key))) {
-            #else
-            if (unlikely(!PyUnicode_CheckExact(key)) && unlikely(!PyUnicode_Check(key))) {
-            #endif
-                goto invalid_keyword_type;
-            } else {
-                for (name = first_kw_arg; *name; name++) {
-                    #if PY_MAJOR_VERSION >= 3
-                    if (PyUnicode_GET_SIZE(**name) == PyUnicode_GET_SIZE(key) &&
-                        PyUnicode_Compare(**name, key) == 0) break;
-                    #else
-                    if (PyString_GET_SIZE(**name) == PyString_GET_SIZE(key) &&
-                        _PyString_Eq(**name, key)) break;
-                    #endif
-                }
-                if (*name) {
-                    values[name-argnames] = value;
-                } else {
-                    /* unexpected keyword found */
-                    for (name=argnames; name != first_kw_arg; name++) {
-                        if (**name == key) goto arg_passed_twice;
-                        #if PY_MAJOR_VERSION >= 3
-                        if (PyUnicode_GET_SIZE(**name) == PyUnicode_GET_SIZE(key) &&
-                            PyUnicode_Compare(**name, key) == 0) goto arg_passed_twice;
-                        #else
-                        if (PyString_GET_SIZE(**name) == PyString_GET_SIZE(key) &&
-                            _PyString_Eq(**name, key)) goto arg_passed_twice;
-                        #endif
-                    }
-                    if (kwds2) {
-                        if (unlikely(PyDict_SetItem(kwds2, key, value))) goto bad;
-                    } else {
-                        goto invalid_keyword;
-                    }
-                }
-            }
-        }
-    }
-    return 0;
-arg_passed_twice:
-    __Pyx_RaiseDoubleKeywordsError(function_name, **name);
-    goto bad;
-invalid_keyword_type:
-    PyErr_Format(PyExc_TypeError,
-        "%s() keywords must be strings", function_name);
-    goto bad;
-invalid_keyword:
-    PyErr_Format(PyExc_TypeError,
-    #if PY_MAJOR_VERSION < 3
-        "%s() got an unexpected keyword argument '%s'",
-        function_name, PyString_AsString(key));
-    #else
-        "%s() got an unexpected keyword argument '%U'",
-        function_name, key);
-    #endif
-bad:
-    return -1;
-}
-
-static CYTHON_INLINE void __Pyx_ErrRestore(PyObject *type, PyObject *value, PyObject *tb) {
-    PyObject *tmp_type, *tmp_value, *tmp_tb;
-    PyThreadState *tstate = PyThreadState_GET();
-
-    tmp_type = tstate->curexc_type;
-    tmp_value = tstate->curexc_value;
-    tmp_tb = tstate->curexc_traceback;
-    tstate->curexc_type = type;
-    tstate->curexc_value = value;
-    tstate->curexc_traceback = tb;
-    Py_XDECREF(tmp_type);
-    Py_XDECREF(tmp_value);
-    Py_XDECREF(tmp_tb);
-}
-
-static CYTHON_INLINE void __Pyx_ErrFetch(PyObject **type, PyObject **value, PyObject **tb) {
-    PyThreadState *tstate = PyThreadState_GET();
-    *type = tstate->curexc_type;
-    *value = tstate->curexc_value;
-    *tb = tstate->curexc_traceback;
-
-    tstate->curexc_type = 0;
-    tstate->curexc_value = 0;
-    tstate->curexc_traceback = 0;
-}
-
-
-
-static CYTHON_INLINE int __Pyx_TypeTest(PyObject *obj, PyTypeObject *type) {
-    if (unlikely(!type)) {
-        PyErr_Format(PyExc_SystemError, "Missing type object");
-        return 0;
-    }
-    if (likely(PyObject_TypeCheck(obj, type)))
-        return 1;
-    PyErr_Format(PyExc_TypeError, "Cannot convert %.200s to %.200s",
-                 Py_TYPE(obj)->tp_name, type->tp_name);
-    return 0;
-}
-
-static CYTHON_INLINE Py_ssize_t __Pyx_div_Py_ssize_t(Py_ssize_t a, Py_ssize_t b) {
-    Py_ssize_t q = a / b;
-    Py_ssize_t r = a - q*b;
-    q -= ((r != 0) & ((r ^ b) < 0));
-    return q;
-}
-
-static int __Pyx_ArgTypeTest(PyObject *obj, PyTypeObject *type, int none_allowed,
-    const char *name, int exact)
-{
-    if (!type) {
-        PyErr_Format(PyExc_SystemError, "Missing type object");
-        return 0;
-    }
-    if (none_allowed && obj == Py_None) return 1;
-    else if (exact) {
-        if (Py_TYPE(obj) == type) return 1;
-    }
-    else {
-        if (PyObject_TypeCheck(obj, type)) return 1;
-    }
-    PyErr_Format(PyExc_TypeError,
-        "Argument '%s' has incorrect type (expected %s, got %s)",
-        name, type->tp_name, Py_TYPE(obj)->tp_name);
-    return 0;
-}
-
-static PyObject *__Pyx_Import(PyObject *name, PyObject *from_list) {
-    PyObject *__import__ = 0;
-    PyObject *empty_list = 0;
-    PyObject *module = 0;
-    PyObject *global_dict = 0;
-    PyObject *empty_dict = 0;
-    PyObject *list;
-    __import__ = __Pyx_GetAttrString(__pyx_b, "__import__");
-    if (!__import__)
-        goto bad;
-    if (from_list)
-        list = from_list;
-    else {
-        empty_list = PyList_New(0);
-        if (!empty_list)
-            goto bad;
-        list = empty_list;
-    }
-    global_dict = PyModule_GetDict(__pyx_m);
-    if (!global_dict)
-        goto bad;
-    empty_dict = PyDict_New();
-    if (!empty_dict)
-        goto bad;
-    module = PyObject_CallFunctionObjArgs(__import__,
-        name, global_dict, empty_dict, list, NULL);
-bad:
-    Py_XDECREF(empty_list);
-    Py_XDECREF(__import__);
-    Py_XDECREF(empty_dict);
-    return module;
-}
-
-static PyObject *__Pyx_GetName(PyObject *dict, PyObject *name) {
-    PyObject *result;
-    result = PyObject_GetAttr(dict, name);
-    if (!result)
-        PyErr_SetObject(PyExc_NameError, name);
-    return result;
-}
-
-#if PY_MAJOR_VERSION < 3
-static void __Pyx_Raise(PyObject *type, PyObject *value, PyObject *tb) {
-    Py_XINCREF(type);
-    Py_XINCREF(value);
-    Py_XINCREF(tb);
-    /* First, check the traceback argument, replacing None with NULL. */
-    if (tb == Py_None) {
-        Py_DECREF(tb);
-        tb = 0;
-    }
-    else if (tb != NULL && !PyTraceBack_Check(tb)) {
-        PyErr_SetString(PyExc_TypeError,
-            "raise: arg 3 must be a traceback or None");
-        goto raise_error;
-    }
-    /* Next, replace a missing value with None */
-    if (value == NULL) {
-        value = Py_None;
-        Py_INCREF(value);
-    }
-    #if PY_VERSION_HEX < 0x02050000
-    if (!PyClass_Check(type))
-    #else
-    if (!PyType_Check(type))
-    #endif
-    {
-        /* Raising an instance.  The value should be a dummy. */
-        if (value != Py_None) {
-            PyErr_SetString(PyExc_TypeError,
-                "instance exception may not have a separate value");
-            goto raise_error;
-        }
-        /* Normalize to raise <class>, <instance> */
-        Py_DECREF(value);
-        value = type;
-        #if PY_VERSION_HEX < 0x02050000
-            if (PyInstance_Check(type)) {
-                type = (PyObject*) ((PyInstanceObject*)type)->in_class;
-                Py_INCREF(type);
-            }
-            else {
-                type = 0;
-                PyErr_SetString(PyExc_TypeError,
-                    "raise: exception must be an old-style class or instance");
-                goto raise_error;
-            }
-        #else
-            type = (PyObject*) Py_TYPE(type);
-            Py_INCREF(type);
-            if (!PyType_IsSubtype((PyTypeObject *)type, (PyTypeObject *)PyExc_BaseException)) {
-                PyErr_SetString(PyExc_TypeError,
-                    "raise: exception class must be a subclass of BaseException");
-                goto raise_error;
-            }
-        #endif
-    }
-
-    __Pyx_ErrRestore(type, value, tb);
-    return;
-raise_error:
-    Py_XDECREF(value);
-    Py_XDECREF(type);
-    Py_XDECREF(tb);
-    return;
-}
-
-#else /* Python 3+ */
-
-static void __Pyx_Raise(PyObject *type, PyObject *value, PyObject *tb) {
-    if (tb == Py_None) {
-        tb = 0;
-    } else if (tb && !PyTraceBack_Check(tb)) {
-        PyErr_SetString(PyExc_TypeError,
-            "raise: arg 3 must be a traceback or None");
-        goto bad;
-    }
-    if (value == Py_None)
-        value = 0;
-
-    if (PyExceptionInstance_Check(type)) {
-        if (value) {
-            PyErr_SetString(PyExc_TypeError,
-                "instance exception may not have a separate value");
-            goto bad;
-        }
-        value = type;
-        type = (PyObject*) Py_TYPE(value);
-    } else if (!PyExceptionClass_Check(type)) {
-        PyErr_SetString(PyExc_TypeError,
-            "raise: exception class must be a subclass of BaseException");
-        goto bad;
-    }
-
-    PyErr_SetObject(type, value);
-
-    if (tb) {
-        PyThreadState *tstate = PyThreadState_GET();
-        PyObject* tmp_tb = tstate->curexc_traceback;
-        if (tb != tmp_tb) {
-            Py_INCREF(tb);
-            tstate->curexc_traceback = tb;
-            Py_XDECREF(tmp_tb);
-        }
-    }
-
-bad:
-    return;
-}
-#endif
-
-#if PY_MAJOR_VERSION < 3
-static PyObject *__Pyx_GetStdout(void) {
-    PyObject *f = PySys_GetObject((char *)"stdout");
-    if (!f) {
-        PyErr_SetString(PyExc_RuntimeError, "lost sys.stdout");
-    }
-    return f;
-}
-
-static int __Pyx_Print(PyObject *arg_tuple, int newline) {
-    PyObject *f;
-    PyObject* v;
-    int i;
-
-    if (!(f = __Pyx_GetStdout()))
-        return -1;
-    for (i=0; i < PyTuple_GET_SIZE(arg_tuple); i++) {
-        if (PyFile_SoftSpace(f, 1)) {
-            if (PyFile_WriteString(" ", f) < 0)
-                return -1;
-        }
-        v = PyTuple_GET_ITEM(arg_tuple, i);
-        if (PyFile_WriteObject(v, f, Py_PRINT_RAW) < 0)
-            return -1;
-        if (PyString_Check(v)) {
-            char *s = PyString_AsString(v);
-            Py_ssize_t len = PyString_Size(v);
-            if (len > 0 &&
-                isspace(Py_CHARMASK(s[len-1])) &&
-                s[len-1] != ' ')
-                    PyFile_SoftSpace(f, 0);
-        }
-    }
-    if (newline) {
-        if (PyFile_WriteString("\n", f) < 0)
-            return -1;
-        PyFile_SoftSpace(f, 0);
-    }
-    return 0;
-}
-
-#else /* Python 3 has a print function */
-
-static int __Pyx_Print(PyObject *arg_tuple, int newline) {
-    PyObject* kwargs = 0;
-    PyObject* result = 0;
-    PyObject* end_string;
-    if (!__pyx_print) {
-        __pyx_print = __Pyx_GetAttrString(__pyx_b, "print");
-        if (!__pyx_print)
-            return -1;
-    }
-    if (!newline) {
-        if (!__pyx_print_kwargs) {
-            __pyx_print_kwargs = PyDict_New();
-            if (!__pyx_print_kwargs)
-                return -1;
-            end_string = PyUnicode_FromStringAndSize(" ", 1);
-            if (!end_string)
-                return -1;
-            if (PyDict_SetItemString(__pyx_print_kwargs, "end", end_string) < 0) {
-                Py_DECREF(end_string);
-                return -1;
-            }
-            Py_DECREF(end_string);
-        }
-        kwargs = __pyx_print_kwargs;
-    }
-    result = PyObject_Call(__pyx_print, arg_tuple, kwargs);
-    if (!result)
-        return -1;
-    Py_DECREF(result);
-    return 0;
-}
-
-#endif
-
-#if PY_MAJOR_VERSION < 3
-
-static int __Pyx_PrintOne(PyObject *o) {
-    PyObject *f;
-    if (!(f = __Pyx_GetStdout()))
-        return -1;
-    if (PyFile_SoftSpace(f, 0)) {
-        if (PyFile_WriteString(" ", f) < 0)
-            return -1;
-    }
-    if (PyFile_WriteObject(o, f, Py_PRINT_RAW) < 0)
-        return -1;
-    if (PyFile_WriteString("\n", f) < 0)
-        return -1;
-    return 0;
-    /* the line below is just to avoid compiler
-     * compiler warnings about unused functions */
-    return __Pyx_Print(NULL, 0);
-}
-
-#else /* Python 3 has a print function */
-
-static int __Pyx_PrintOne(PyObject *o) {
-    int res;
-    PyObject* arg_tuple = PyTuple_New(1);
-    if (unlikely(!arg_tuple))
-        return -1;
-    Py_INCREF(o);
-    PyTuple_SET_ITEM(arg_tuple, 0, o);
-    res = __Pyx_Print(arg_tuple, 1);
-    Py_DECREF(arg_tuple);
-    return res;
-}
-
-#endif
-
-static CYTHON_INLINE unsigned char __Pyx_PyInt_AsUnsignedChar(PyObject* x) {
-    const unsigned char neg_one = (unsigned char)-1, const_zero = 0;
-    const int is_unsigned = neg_one > const_zero;
-    if (sizeof(unsigned char) < sizeof(long)) {
-        long val = __Pyx_PyInt_AsLong(x);
-        if (unlikely(val != (long)(unsigned char)val)) {
-            if (!unlikely(val == -1 && PyErr_Occurred())) {
-                PyErr_SetString(PyExc_OverflowError,
-                    (is_unsigned && unlikely(val < 0)) ?
-                    "can't convert negative value to unsigned char" :
-                    "value too large to convert to unsigned char");
-            }
-            return (unsigned char)-1;
-        }
-        return (unsigned char)val;
-    }
-    return (unsigned char)__Pyx_PyInt_AsUnsignedLong(x);
-}
-
-static CYTHON_INLINE unsigned short __Pyx_PyInt_AsUnsignedShort(PyObject* x) {
-    const unsigned short neg_one = (unsigned short)-1, const_zero = 0;
-    const int is_unsigned = neg_one > const_zero;
-    if (sizeof(unsigned short) < sizeof(long)) {
-        long val = __Pyx_PyInt_AsLong(x);
-        if (unlikely(val != (long)(unsigned short)val)) {
-            if (!unlikely(val == -1 && PyErr_Occurred())) {
-                PyErr_SetString(PyExc_OverflowError,
-                    (is_unsigned && unlikely(val < 0)) ?
-                    "can't convert negative value to unsigned short" :
-                    "value too large to convert to unsigned short");
-            }
-            return (unsigned short)-1;
-        }
-        return (unsigned short)val;
-    }
-    return (unsigned short)__Pyx_PyInt_AsUnsignedLong(x);
-}
-
-static CYTHON_INLINE unsigned int __Pyx_PyInt_AsUnsignedInt(PyObject* x) {
-    const unsigned int neg_one = (unsigned int)-1, const_zero = 0;
-    const int is_unsigned = neg_one > const_zero;
-    if (sizeof(unsigned int) < sizeof(long)) {
-        long val = __Pyx_PyInt_AsLong(x);
-        if (unlikely(val != (long)(unsigned int)val)) {
-            if (!unlikely(val == -1 && PyErr_Occurred())) {
-                PyErr_SetString(PyExc_OverflowError,
-                    (is_unsigned && unlikely(val < 0)) ?
-                    "can't convert negative value to unsigned int" :
-                    "value too large to convert to unsigned int");
-            }
-            return (unsigned int)-1;
-        }
-        return (unsigned int)val;
-    }
-    return (unsigned int)__Pyx_PyInt_AsUnsignedLong(x);
-}
-
-static CYTHON_INLINE char __Pyx_PyInt_AsChar(PyObject* x) {
-    const char neg_one = (char)-1, const_zero = 0;
-    const int is_unsigned = neg_one > const_zero;
-    if (sizeof(char) < sizeof(long)) {
-        long val = __Pyx_PyInt_AsLong(x);
-        if (unlikely(val != (long)(char)val)) {
-            if (!unlikely(val == -1 && PyErr_Occurred())) {
-                PyErr_SetString(PyExc_OverflowError,
-                    (is_unsigned && unlikely(val < 0)) ?
-                    "can't convert negative value to char" :
-                    "value too large to convert to char");
-            }
-            return (char)-1;
-        }
-        return (char)val;
-    }
-    return (char)__Pyx_PyInt_AsLong(x);
-}
-
-static CYTHON_INLINE short __Pyx_PyInt_AsShort(PyObject* x) {
-    const short neg_one = (short)-1, const_zero = 0;
-    const int is_unsigned = neg_one > const_zero;
-    if (sizeof(short) < sizeof(long)) {
-        long val = __Pyx_PyInt_AsLong(x);
-        if (unlikely(val != (long)(short)val)) {
-            if (!unlikely(val == -1 && PyErr_Occurred())) {
-                PyErr_SetString(PyExc_OverflowError,
-                    (is_unsigned && unlikely(val < 0)) ?
-                    "can't convert negative value to short" :
-                    "value too large to convert to short");
-            }
-            return (short)-1;
-        }
-        return (short)val;
-    }
-    return (short)__Pyx_PyInt_AsLong(x);
-}
-
-static CYTHON_INLINE int __Pyx_PyInt_AsInt(PyObject* x) {
-    const int neg_one = (int)-1, const_zero = 0;
-    const int is_unsigned = neg_one > const_zero;
-    if (sizeof(int) < sizeof(long)) {
-        long val = __Pyx_PyInt_AsLong(x);
-        if (unlikely(val != (long)(int)val)) {
-            if (!unlikely(val == -1 && PyErr_Occurred())) {
-                PyErr_SetString(PyExc_OverflowError,
-                    (is_unsigned && unlikely(val < 0)) ?
-                    "can't convert negative value to int" :
-                    "value too large to convert to int");
-            }
-            return (int)-1;
-        }
-        return (int)val;
-    }
-    return (int)__Pyx_PyInt_AsLong(x);
-}
-
-static CYTHON_INLINE signed char __Pyx_PyInt_AsSignedChar(PyObject* x) {
-    const signed char neg_one = (signed char)-1, const_zero = 0;
-    const int is_unsigned = neg_one > const_zero;
-    if (sizeof(signed char) < sizeof(long)) {
-        long val = __Pyx_PyInt_AsLong(x);
-        if (unlikely(val != (long)(signed char)val)) {
-            if (!unlikely(val == -1 && PyErr_Occurred())) {
-                PyErr_SetString(PyExc_OverflowError,
-                    (is_unsigned && unlikely(val < 0)) ?
-                    "can't convert negative value to signed char" :
-                    "value too large to convert to signed char");
-            }
-            return (signed char)-1;
-        }
-        return (signed char)val;
-    }
-    return (signed char)__Pyx_PyInt_AsSignedLong(x);
-}
-
-static CYTHON_INLINE signed short __Pyx_PyInt_AsSignedShort(PyObject* x) {
-    const signed short neg_one = (signed short)-1, const_zero = 0;
-    const int is_unsigned = neg_one > const_zero;
-    if (sizeof(signed short) < sizeof(long)) {
-        long val = __Pyx_PyInt_AsLong(x);
-        if (unlikely(val != (long)(signed short)val)) {
-            if (!unlikely(val == -1 && PyErr_Occurred())) {
-                PyErr_SetString(PyExc_OverflowError,
-                    (is_unsigned && unlikely(val < 0)) ?
-                    "can't convert negative value to signed short" :
-                    "value too large to convert to signed short");
-            }
-            return (signed short)-1;
-        }
-        return (signed short)val;
-    }
-    return (signed short)__Pyx_PyInt_AsSignedLong(x);
-}
-
-static CYTHON_INLINE signed int __Pyx_PyInt_AsSignedInt(PyObject* x) {
-    const signed int neg_one = (signed int)-1, const_zero = 0;
-    const int is_unsigned = neg_one > const_zero;
-    if (sizeof(signed int) < sizeof(long)) {
-        long val = __Pyx_PyInt_AsLong(x);
-        if (unlikely(val != (long)(signed int)val)) {
-            if (!unlikely(val == -1 && PyErr_Occurred())) {
-                PyErr_SetString(PyExc_OverflowError,
-                    (is_unsigned && unlikely(val < 0)) ?
-                    "can't convert negative value to signed int" :
-                    "value too large to convert to signed int");
-            }
-            return (signed int)-1;
-        }
-        return (signed int)val;
-    }
-    return (signed int)__Pyx_PyInt_AsSignedLong(x);
-}
-
-static CYTHON_INLINE unsigned long __Pyx_PyInt_AsUnsignedLong(PyObject* x) {
-    const unsigned long neg_one = (unsigned long)-1, const_zero = 0;
-    const int is_unsigned = neg_one > const_zero;
-#if PY_VERSION_HEX < 0x03000000
-    if (likely(PyInt_Check(x))) {
-        long val = PyInt_AS_LONG(x);
-        if (is_unsigned && unlikely(val < 0)) {
-            PyErr_SetString(PyExc_OverflowError,
-                            "can't convert negative value to unsigned long");
-            return (unsigned long)-1;
-        }
-        return (unsigned long)val;
-    } else
-#endif
-    if (likely(PyLong_Check(x))) {
-        if (is_unsigned) {
-            if (unlikely(Py_SIZE(x) < 0)) {
-                PyErr_SetString(PyExc_OverflowError,
-                                "can't convert negative value to unsigned long");
-                return (unsigned long)-1;
-            }
-            return PyLong_AsUnsignedLong(x);
-        } else {
-            return PyLong_AsLong(x);
-        }
-    } else {
-        unsigned long val;
-        PyObject *tmp = __Pyx_PyNumber_Int(x);
-        if (!tmp) return (unsigned long)-1;
-        val = __Pyx_PyInt_AsUnsignedLong(tmp);
-        Py_DECREF(tmp);
-        return val;
-    }
-}
-
-static CYTHON_INLINE unsigned PY_LONG_LONG __Pyx_PyInt_AsUnsignedLongLong(PyObject* x) {
-    const unsigned PY_LONG_LONG neg_one = (unsigned PY_LONG_LONG)-1, const_zero = 0;
-    const int is_unsigned = neg_one > const_zero;
-#if PY_VERSION_HEX < 0x03000000
-    if (likely(PyInt_Check(x))) {
-        long val = PyInt_AS_LONG(x);
-        if (is_unsigned && unlikely(val < 0)) {
-            PyErr_SetString(PyExc_OverflowError,
-                            "can't convert negative value to unsigned PY_LONG_LONG");
-            return (unsigned PY_LONG_LONG)-1;
-        }
-        return (unsigned PY_LONG_LONG)val;
-    } else
-#endif
-    if (likely(PyLong_Check(x))) {
-        if (is_unsigned) {
-            if (unlikely(Py_SIZE(x) < 0)) {
-                PyErr_SetString(PyExc_OverflowError,
-                                "can't convert negative value to unsigned PY_LONG_LONG");
-                return (unsigned PY_LONG_LONG)-1;
-            }
-            return PyLong_AsUnsignedLongLong(x);
-        } else {
-            return PyLong_AsLongLong(x);
-        }
-    } else {
-        unsigned PY_LONG_LONG val;
-        PyObject *tmp = __Pyx_PyNumber_Int(x);
-        if (!tmp) return (unsigned PY_LONG_LONG)-1;
-        val = __Pyx_PyInt_AsUnsignedLongLong(tmp);
-        Py_DECREF(tmp);
-        return val;
-    }
-}
-
-static CYTHON_INLINE long __Pyx_PyInt_AsLong(PyObject* x) {
-    const long neg_one = (long)-1, const_zero = 0;
-    const int is_unsigned = neg_one > const_zero;
-#if PY_VERSION_HEX < 0x03000000
-    if (likely(PyInt_Check(x))) {
-        long val = PyInt_AS_LONG(x);
-        if (is_unsigned && unlikely(val < 0)) {
-            PyErr_SetString(PyExc_OverflowError,
-                            "can't convert negative value to long");
-            return (long)-1;
-        }
-        return (long)val;
-    } else
-#endif
-    if (likely(PyLong_Check(x))) {
-        if (is_unsigned) {
-            if (unlikely(Py_SIZE(x) < 0)) {
-                PyErr_SetString(PyExc_OverflowError,
-                                "can't convert negative value to long");
-                return (long)-1;
-            }
-            return PyLong_AsUnsignedLong(x);
-        } else {
-            return PyLong_AsLong(x);
-        }
-    } else {
-        long val;
-        PyObject *tmp = __Pyx_PyNumber_Int(x);
-        if (!tmp) return (long)-1;
-        val = __Pyx_PyInt_AsLong(tmp);
-        Py_DECREF(tmp);
-        return val;
-    }
-}
-
-static CYTHON_INLINE PY_LONG_LONG __Pyx_PyInt_AsLongLong(PyObject* x) {
-    const PY_LONG_LONG neg_one = (PY_LONG_LONG)-1, const_zero = 0;
-    const int is_unsigned = neg_one > const_zero;
-#if PY_VERSION_HEX < 0x03000000
-    if (likely(PyInt_Check(x))) {
-        long val = PyInt_AS_LONG(x);
-        if (is_unsigned && unlikely(val < 0)) {
-            PyErr_SetString(PyExc_OverflowError,
-                            "can't convert negative value to PY_LONG_LONG");
-            return (PY_LONG_LONG)-1;
-        }
-        return (PY_LONG_LONG)val;
-    } else
-#endif
-    if (likely(PyLong_Check(x))) {
-        if (is_unsigned) {
-            if (unlikely(Py_SIZE(x) < 0)) {
-                PyErr_SetString(PyExc_OverflowError,
-                                "can't convert negative value to PY_LONG_LONG");
-                return (PY_LONG_LONG)-1;
-            }
-            return PyLong_AsUnsignedLongLong(x);
-        } else {
-            return PyLong_AsLongLong(x);
-        }
-    } else {
-        PY_LONG_LONG val;
-        PyObject *tmp = __Pyx_PyNumber_Int(x);
-        if (!tmp) return (PY_LONG_LONG)-1;
-        val = __Pyx_PyInt_AsLongLong(tmp);
-        Py_DECREF(tmp);
-        return val;
-    }
-}
-
-static CYTHON_INLINE signed long __Pyx_PyInt_AsSignedLong(PyObject* x) {
-    const signed long neg_one = (signed long)-1, const_zero = 0;
-    const int is_unsigned = neg_one > const_zero;
-#if PY_VERSION_HEX < 0x03000000
-    if (likely(PyInt_Check(x))) {
-        long val = PyInt_AS_LONG(x);
-        if (is_unsigned && unlikely(val < 0)) {
-            PyErr_SetString(PyExc_OverflowError,
-                            "can't convert negative value to signed long");
-            return (signed long)-1;
-        }
-        return (signed long)val;
-    } else
-#endif
-    if (likely(PyLong_Check(x))) {
-        if (is_unsigned) {
-            if (unlikely(Py_SIZE(x) < 0)) {
-                PyErr_SetString(PyExc_OverflowError,
-                                "can't convert negative value to signed long");
-                return (signed long)-1;
-            }
-            return PyLong_AsUnsignedLong(x);
-        } else {
-            return PyLong_AsLong(x);
-        }
-    } else {
-        signed long val;
-        PyObject *tmp = __Pyx_PyNumber_Int(x);
-        if (!tmp) return (signed long)-1;
-        val = __Pyx_PyInt_AsSignedLong(tmp);
-        Py_DECREF(tmp);
-        return val;
-    }
-}
-
-static CYTHON_INLINE signed PY_LONG_LONG __Pyx_PyInt_AsSignedLongLong(PyObject* x) {
-    const signed PY_LONG_LONG neg_one = (signed PY_LONG_LONG)-1, const_zero = 0;
-    const int is_unsigned = neg_one > const_zero;
-#if PY_VERSION_HEX < 0x03000000
-    if (likely(PyInt_Check(x))) {
-        long val = PyInt_AS_LONG(x);
-        if (is_unsigned && unlikely(val < 0)) {
-            PyErr_SetString(PyExc_OverflowError,
-                            "can't convert negative value to signed PY_LONG_LONG");
-            return (signed PY_LONG_LONG)-1;
-        }
-        return (signed PY_LONG_LONG)val;
-    } else
-#endif
-    if (likely(PyLong_Check(x))) {
-        if (is_unsigned) {
-            if (unlikely(Py_SIZE(x) < 0)) {
-                PyErr_SetString(PyExc_OverflowError,
-                                "can't convert negative value to signed PY_LONG_LONG");
-                return (signed PY_LONG_LONG)-1;
-            }
-            return PyLong_AsUnsignedLongLong(x);
-        } else {
-            return PyLong_AsLongLong(x);
-        }
-    } else {
-        signed PY_LONG_LONG val;
-        PyObject *tmp = __Pyx_PyNumber_Int(x);
-        if (!tmp) return (signed PY_LONG_LONG)-1;
-        val = __Pyx_PyInt_AsSignedLongLong(tmp);
-        Py_DECREF(tmp);
-        return val;
-    }
-}
-
-static void __Pyx_WriteUnraisable(const char *name) {
-    PyObject *old_exc, *old_val, *old_tb;
-    PyObject *ctx;
-    __Pyx_ErrFetch(&old_exc, &old_val, &old_tb);
-    #if PY_MAJOR_VERSION < 3
-    ctx = PyString_FromString(name);
-    #else
-    ctx = PyUnicode_FromString(name);
-    #endif
-    __Pyx_ErrRestore(old_exc, old_val, old_tb);
-    if (!ctx) {
-        PyErr_WriteUnraisable(Py_None);
-    } else {
-        PyErr_WriteUnraisable(ctx);
-        Py_DECREF(ctx);
-    }
-}
-
-static int __Pyx_SetVtable(PyObject *dict, void *vtable) {
-#if PY_VERSION_HEX < 0x03010000
-    PyObject *ob = PyCObject_FromVoidPtr(vtable, 0);
-#else
-    PyObject *ob = PyCapsule_New(vtable, 0, 0);
-#endif
-    if (!ob)
-        goto bad;
-    if (PyDict_SetItemString(dict, "__pyx_vtable__", ob) < 0)
-        goto bad;
-    Py_DECREF(ob);
-    return 0;
-bad:
-    Py_XDECREF(ob);
-    return -1;
-}
-
-#include "compile.h"
-#include "frameobject.h"
-#include "traceback.h"
-
-static void __Pyx_AddTraceback(const char *funcname) {
-    PyObject *py_srcfile = 0;
-    PyObject *py_funcname = 0;
-    PyObject *py_globals = 0;
-    PyCodeObject *py_code = 0;
-    PyFrameObject *py_frame = 0;
-
-    #if PY_MAJOR_VERSION < 3
-    py_srcfile = PyString_FromString(__pyx_filename);
-    #else
-    py_srcfile = PyUnicode_FromString(__pyx_filename);
-    #endif
-    if (!py_srcfile) goto bad;
-    if (__pyx_clineno) {
-        #if PY_MAJOR_VERSION < 3
-        py_funcname = PyString_FromFormat( "%s (%s:%d)", funcname, __pyx_cfilenm, __pyx_clineno);
-        #else
-        py_funcname = PyUnicode_FromFormat( "%s (%s:%d)", funcname, __pyx_cfilenm, __pyx_clineno);
-        #endif
-    }
-    else {
-        #if PY_MAJOR_VERSION < 3
-        py_funcname = PyString_FromString(funcname);
-        #else
-        py_funcname = PyUnicode_FromString(funcname);
-        #endif
-    }
-    if (!py_funcname) goto bad;
-    py_globals = PyModule_GetDict(__pyx_m);
-    if (!py_globals) goto bad;
-    py_code = PyCode_New(
-        0,            /*int argcount,*/
-        #if PY_MAJOR_VERSION >= 3
-        0,            /*int kwonlyargcount,*/
-        #endif
-        0,            /*int nlocals,*/
-        0,            /*int stacksize,*/
-        0,            /*int flags,*/
-        __pyx_empty_bytes, /*PyObject *code,*/
-        __pyx_empty_tuple,  /*PyObject *consts,*/
-        __pyx_empty_tuple,  /*PyObject *names,*/
-        __pyx_empty_tuple,  /*PyObject *varnames,*/
-        __pyx_empty_tuple,  /*PyObject *freevars,*/
-        __pyx_empty_tuple,  /*PyObject *cellvars,*/
-        py_srcfile,   /*PyObject *filename,*/
-        py_funcname,  /*PyObject *name,*/
-        __pyx_lineno,   /*int firstlineno,*/
-        __pyx_empty_bytes  /*PyObject *lnotab*/
-    );
-    if (!py_code) goto bad;
-    py_frame = PyFrame_New(
-        PyThreadState_GET(), /*PyThreadState *tstate,*/
-        py_code,             /*PyCodeObject *code,*/
-        py_globals,          /*PyObject *globals,*/
-        0                    /*PyObject *locals*/
-    );
-    if (!py_frame) goto bad;
-    py_frame->f_lineno = __pyx_lineno;
-    PyTraceBack_Here(py_frame);
-bad:
-    Py_XDECREF(py_srcfile);
-    Py_XDECREF(py_funcname);
-    Py_XDECREF(py_code);
-    Py_XDECREF(py_frame);
-}
-
-static int __Pyx_InitStrings(__Pyx_StringTabEntry *t) {
-    while (t->p) {
-        #if PY_MAJOR_VERSION < 3
-        if (t->is_unicode) {
-            *t->p = PyUnicode_DecodeUTF8(t->s, t->n - 1, NULL);
-        } else if (t->intern) {
-            *t->p = PyString_InternFromString(t->s);
-        } else {
-            *t->p = PyString_FromStringAndSize(t->s, t->n - 1);
-        }
-        #else  /* Python 3+ has unicode identifiers */
-        if (t->is_unicode | t->is_str) {
-            if (t->intern) {
-                *t->p = PyUnicode_InternFromString(t->s);
-            } else if (t->encoding) {
-                *t->p = PyUnicode_Decode(t->s, t->n - 1, t->encoding, NULL);
-            } else {
-                *t->p = PyUnicode_FromStringAndSize(t->s, t->n - 1);
-            }
-        } else {
-            *t->p = PyBytes_FromStringAndSize(t->s, t->n - 1);
-        }
-        #endif
-        if (!*t->p)
-            return -1;
-        ++t;
-    }
-    return 0;
-}
-
-/* Type Conversion Functions */
-
-static CYTHON_INLINE int __Pyx_PyObject_IsTrue(PyObject* x) {
-   if (x == Py_True) return 1;
-   else if ((x == Py_False) | (x == Py_None)) return 0;
-   else return PyObject_IsTrue(x);
-}
-
-static CYTHON_INLINE PyObject* __Pyx_PyNumber_Int(PyObject* x) {
-  PyNumberMethods *m;
-  const char *name = NULL;
-  PyObject *res = NULL;
-#if PY_VERSION_HEX < 0x03000000
-  if (PyInt_Check(x) || PyLong_Check(x))
-#else
-  if (PyLong_Check(x))
-#endif
-    return Py_INCREF(x), x;
-  m = Py_TYPE(x)->tp_as_number;
-#if PY_VERSION_HEX < 0x03000000
-  if (m && m->nb_int) {
-    name = "int";
-    res = PyNumber_Int(x);
-  }
-  else if (m && m->nb_long) {
-    name = "long";
-    res = PyNumber_Long(x);
-  }
-#else
-  if (m && m->nb_int) {
-    name = "int";
-    res = PyNumber_Long(x);
-  }
-#endif
-  if (res) {
-#if PY_VERSION_HEX < 0x03000000
-    if (!PyInt_Check(res) && !PyLong_Check(res)) {
-#else
-    if (!PyLong_Check(res)) {
-#endif
-      PyErr_Format(PyExc_TypeError,
-                   "__%s__ returned non-%s (type %.200s)",
-                   name, name, Py_TYPE(res)->tp_name);
-      Py_DECREF(res);
-      return NULL;
-    }
-  }
-  else if (!PyErr_Occurred()) {
-    PyErr_SetString(PyExc_TypeError,
-                    "an integer is required");
-  }
-  return res;
-}
-
-static CYTHON_INLINE Py_ssize_t __Pyx_PyIndex_AsSsize_t(PyObject* b) {
-  Py_ssize_t ival;
-  PyObject* x = PyNumber_Index(b);
-  if (!x) return -1;
-  ival = PyInt_AsSsize_t(x);
-  Py_DECREF(x);
-  return ival;
-}
-
-static CYTHON_INLINE PyObject * __Pyx_PyInt_FromSize_t(size_t ival) {
-#if PY_VERSION_HEX < 0x02050000
-   if (ival <= LONG_MAX)
-       return PyInt_FromLong((long)ival);
-   else {
-       unsigned char *bytes = (unsigned char *) &ival;
-       int one = 1; int little = (int)*(unsigned char*)&one;
-       return _PyLong_FromByteArray(bytes, sizeof(size_t), little, 0);
-   }
-#else
-   return PyInt_FromSize_t(ival);
-#endif
-}
-
-static CYTHON_INLINE size_t __Pyx_PyInt_AsSize_t(PyObject* x) {
-   unsigned PY_LONG_LONG val = __Pyx_PyInt_AsUnsignedLongLong(x);
-   if (unlikely(val == (unsigned PY_LONG_LONG)-1 && PyErr_Occurred())) {
-       return (size_t)-1;
-   } else if (unlikely(val != (unsigned PY_LONG_LONG)(size_t)val)) {
-       PyErr_SetString(PyExc_OverflowError,
-                       "value too large to convert to size_t");
-       return (size_t)-1;
-   }
-   return (size_t)val;
-}
-
-
-#endif /* Py_PYTHON_H */
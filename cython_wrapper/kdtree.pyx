@@ -18,16 +18,31 @@
 # http://code.google.com/p/python-kdtree/
 # and
 # http://en.wikipedia.org/wiki/Kd-tree
+#
+# This module builds and searches its trees in Cython alone, to show how; it
+# does not use the C core in cython_with_c that the other bindings share.
+from cpython cimport array
 import array
+cimport cython
+from cython.view cimport array as cvarray
 
 cdef extern from "stdlib.h":
   void free(void* ptr)
   void* malloc(size_t size)
 
+cdef extern from "string.h":
+  void *memcpy(void *dest, void *src, size_t n) nogil
+
 cdef struct best_pair:
   int node_num
   double dist
 
+cdef struct pool_node:
+  int num
+  # indices of the children in the pool, -1 for none
+  int left
+  int right
+
 # Note that taking the extra effort to make this a cdef class makes a 5x difference
 # in runtime speed on 100k rows
 cdef class PointData:
@@ -142,35 +157,72 @@ cpdef print_preorder(KDTreeNode node):
   print_preorder(node.left)
   print_preorder(node.right)
 
-cdef KDTreeNode fill_tree_r(pointList, size_t depth):
-  """Constructs a KD-tree and returns the root node.  pointList is a list of PointData elements."""
-  if not pointList:
+cdef KDTreeNode fill_tree_r(pointList, size_t *order, size_t num_points, \
+                            const double *points, size_t dims, size_t depth):
+  """Constructs a KD-tree over the points order[0, num_points) and returns the root
+  node.  points holds the coordinates of pointList, dims per point, so the median
+  is found by partitioning order in C; only the nodes become Python objects."""
+  if 0 == num_points:
     # TODO would using a null sentinel node make all of this run faster?
     return None
 
-  cdef size_t dims = pointList[0].dims # assumes all points have the same dimension
   cdef size_t axis = pick_axis(depth, dims)
-  cdef PointData p
-  for p in pointList:
-    p.curr_axis = axis
-
-  # Sort point list and choose median as pivot element
-  pointList.sort()
+  cdef size_t median = num_points / 2
+  select_median(order, num_points, median, points, dims, axis)
 
-  cdef size_t median = len(pointList) / 2
-
-  pl_median = pointList[median]
-  cdef int next_depth = depth + 1
+  cdef PointData pl_median = pointList[order[median]]
+  cdef size_t next_depth = depth + 1
   cdef KDTreeNode node = KDTreeNode(pl_median.num, pl_median.coords)
-  node.left = fill_tree_r(pointList[0:median], next_depth)
-  node.right = fill_tree_r(pointList[median + 1:], next_depth)
+  node.left = fill_tree_r(pointList, order, median, points, dims, next_depth)
+  node.right = fill_tree_r(pointList, &order[median + 1], num_points - median - 1,
+                           points, dims, next_depth)
   return node
 
 cpdef KDTreeNode fill_tree(pointList):
   """Constructs a KD-tree and returns the root node.  pointList is a list of PointData elements."""
-  return fill_tree_r(pointList, 0)
+  cdef size_t num_points = len(pointList)
+  if 0 == num_points:
+    return None
+
+  cdef size_t dims = pointList[0].dims # assumes all points have the same dimension
+  cdef double *points = <double *>malloc(num_points * dims * sizeof(double))
+  cdef size_t *order = <size_t *>malloc(num_points * sizeof(size_t))
+  cdef size_t i
+  try:
+    if NULL == points or NULL == order:
+      raise MemoryError()
+    points_from_list(pointList, points, NULL, dims)
+    for i in range(num_points):
+      order[i] = i
+    return fill_tree_r(pointList, order, num_points, points, dims, 0)
+  finally:
+    free(order)
+    free(points)
+
+cdef int points_from_list(pointList, double *points, int *nums, size_t dims) except -1:
+  """Copies the coordinates of a list of PointData elements into points, dims per
+  point, and their numbers into nums unless it is NULL.  Coordinates held in an
+  array.array('d'), as PointData makes them, are read straight from its memory;
+  any other sequence is read item by item."""
+  cdef size_t i, d
+  cdef PointData p
+  cdef array.array coords
+  for i in range(len(pointList)):
+    p = pointList[i]
+    if p.dims != dims or len(p.coords) != dims:
+      raise ValueError("all points must have %d dimensions" % dims)
+    if NULL != nums:
+      nums[i] = p.num
+    if isinstance(p.coords, array.array) and 'd' == p.coords.typecode:
+      coords = p.coords
+      for d in range(dims):
+        points[i * dims + d] = coords.data.as_doubles[d]
+    else:
+      for d in range(dims):
+        points[i * dims + d] = p.coords[d]
+  return 0
 
-cdef size_t pick_axis(size_t depth, size_t dims):
+cdef inline size_t pick_axis(size_t depth, size_t dims) noexcept nogil:
   """Choose the axis to use based on the current depth and the number of dimensions.
   This is useful when building the tree and search for nearest neighbors.
   @param [in] depth The current depth in the tree.
@@ -221,8 +273,9 @@ cdef size_t nn_search(KDTreeNode node, PointData search, best_pair nearest[], \
   if node_num != search_num:
     best_count = add_best(nearest, best_count, node_num, ncoords, scoords, dims, num_neighbors)
 
+  # nothing may be pruned until the list holds num_neighbors nodes
   cdef double largest = -1.0
-  if best_count > 0:
+  if best_count >= num_neighbors:
     largest = nearest[best_count - 1].dist
 
   cdef double diff
@@ -266,8 +319,19 @@ cdef size_t add_best(best_pair nearest[], size_t best_count, int node_num, coord
   # equal to the searched-for point
 
   cdef double sd = sqdist(coords, search_coords, dims)
+  return insert_best(nearest, best_count, node_num, sd, num_neighbors)
+
+cdef inline size_t insert_best(best_pair nearest[], size_t best_count, int node_num, \
+                               double sd, size_t num_neighbors) noexcept nogil:
+  """
+  Insert node_num at squared distance sd into the sorted list of best nodes if it
+  is closer to the searched-for node than any current nodes.
 
-  cdef best_pair candidate = best_pair(node_num, sd)
+  Returns: The count of elements in the best_pair list
+  """
+  cdef best_pair candidate
+  candidate.node_num = node_num
+  candidate.dist = sd
   # search through linearly to maintain sorted order
   cdef size_t last_idx
   if best_count < num_neighbors:
@@ -290,3 +354,232 @@ cdef size_t add_best(best_pair nearest[], size_t best_count, int node_num, coord
     nearest[best_count] = candidate
     return best_count + 1
   return best_count
+
+cdef class KDTreePool:
+  """A KD-tree stored as a pool of C structs in preorder instead of a graph of
+  KDTreeNode objects.  The coordinates of node i are row i of a typed memoryview,
+  so building and searching run without the GIL and touch no Python objects."""
+  cdef pool_node *nodes
+  cdef double[:, ::1] coords
+  cdef size_t num_nodes
+  cdef size_t dims
+
+  def __cinit__(self, const double[:, ::1] points, const int[::1] nums=None):
+    """Builds the tree from an n x dims buffer of points.
+    @param [in] points The point coordinates, one point per row.
+    @param [in] nums The node numbers of the points; the row indices if None.
+    """
+    cdef size_t num_points = points.shape[0]
+    cdef size_t dims = points.shape[1]
+    if nums is not None and <size_t>nums.shape[0] != num_points:
+      raise ValueError("nums must have one number per point")
+    if 0 == dims:
+      raise ValueError("points must have at least one dimension")
+
+    self.dims = dims
+    self.num_nodes = 0
+    self.coords = cvarray(shape=(max(num_points, 1), dims), itemsize=sizeof(double),
+                          format="d")
+    self.nodes = <pool_node *>malloc(max(num_points, 1) * sizeof(pool_node))
+    cdef size_t *order = <size_t *>malloc(max(num_points, 1) * sizeof(size_t))
+    if NULL == self.nodes or NULL == order:
+      free(order)
+      raise MemoryError()
+
+    cdef size_t i
+    cdef const int *nums_ptr = NULL
+    if nums is not None and num_points > 0:
+      nums_ptr = &nums[0]
+    try:
+      if num_points > 0:
+        for i in range(num_points):
+          order[i] = i
+        with nogil:
+          fill_pool_r(order, num_points, &points[0, 0], nums_ptr, dims, 0,
+                      self.nodes, &self.coords[0, 0], &self.num_nodes)
+    finally:
+      free(order)
+
+  def __dealloc__(self):
+    if NULL != self.nodes:
+      free(self.nodes)
+      self.nodes = NULL
+
+  def __len__(self):
+    return self.num_nodes
+
+  property dims:
+    def __get__(self):
+      return self.dims
+
+  def run_nn_search(self, PointData search, size_t num_neighbors):
+    """Runs a nearest neighbor search on the given point, which is defined
+    by the PointData search param.  Missing neighbors are reported as -1."""
+    if search.dims != self.dims:
+      raise ValueError("search must have %d dimensions" % self.dims)
+    cdef double *search_coords = <double *>malloc(self.dims * sizeof(double))
+    cdef best_pair *nearest = <best_pair *>malloc(max(num_neighbors, 1) * sizeof(best_pair))
+
+    cdef size_t i
+    cdef size_t best_count = 0
+    try:
+      if NULL == search_coords or NULL == nearest:
+        raise MemoryError()
+      points_from_list([search], search_coords, NULL, self.dims)
+      with nogil:
+        best_count = self.search(search.num, search_coords, nearest, num_neighbors)
+      output = []
+      for i in range(num_neighbors):
+        output.append(nearest[i].node_num if i < best_count else -1)
+      return output
+    finally:
+      free(nearest)
+      free(search_coords)
+
+  @cython.boundscheck(False)
+  @cython.wraparound(False)
+  def run_nn_search_batch(self, const double[:, ::1] searches, size_t num_neighbors,
+                          int[:, ::1] out):
+    """Runs a nearest neighbor search for each row of searches without holding
+    the GIL, writing the node numbers into the matching row of out.  The search
+    points are not excluded from the results.
+    @param [in] searches The points to search for, one per row.
+    @param [in] num_neighbors The number of neighbors to find for each point.
+    @param [out] out Receives num_neighbors node numbers per point, -1 padded.
+    """
+    cdef size_t num_searches = searches.shape[0]
+    if <size_t>searches.shape[1] != self.dims:
+      raise ValueError("searches must have %d columns" % self.dims)
+    if <size_t>out.shape[0] < num_searches or <size_t>out.shape[1] < num_neighbors:
+      raise ValueError("out must be at least %d x %d" % (num_searches, num_neighbors))
+    cdef best_pair *nearest = <best_pair *>malloc(max(num_neighbors, 1) * sizeof(best_pair))
+    if not nearest:
+      raise MemoryError()
+
+    cdef size_t q, i, best_count
+    with nogil:
+      for q in range(num_searches):
+        best_count = self.search(-1, &searches[q, 0], nearest, num_neighbors)
+        for i in range(num_neighbors):
+          out[q, i] = nearest[i].node_num if i < best_count else -1
+    free(nearest)
+
+  @cython.boundscheck(False)
+  @cython.wraparound(False)
+  cdef size_t search(self, int search_num, const double *search, best_pair nearest[],
+                     size_t num_neighbors) noexcept nogil:
+    if 0 == self.num_nodes or 0 == num_neighbors:
+      return 0
+    return pool_search(self.nodes, &self.coords[0, 0], self.dims, 0, search_num,
+                       search, nearest, 0, num_neighbors, 0)
+
+cdef inline double sqdist_c(const double *a, const double *b, size_t dims) noexcept nogil:
+  """Calculates squared Euclidean distance between a and b"""
+  cdef size_t k
+  cdef double dist = 0.0
+  cdef double diff
+  for k in range(dims):
+    diff = a[k] - b[k]
+    dist = dist + (diff * diff)
+  return dist
+
+cdef void select_median(size_t *order, size_t num_points, size_t median,
+                        const double *points, size_t dims, size_t axis) noexcept nogil:
+  """Reorders order so the point of rank median along axis sits at order[median],
+  with no larger value before it and no smaller one after it."""
+  cdef Py_ssize_t lo = 0
+  cdef Py_ssize_t hi = num_points - 1
+  cdef Py_ssize_t i, j
+  cdef Py_ssize_t m = median
+  cdef double pivot
+  cdef size_t tmp
+  while hi > lo:
+    pivot = points[order[lo + (hi - lo) / 2] * dims + axis]
+    i = lo
+    j = hi
+    while i <= j:
+      while points[order[i] * dims + axis] < pivot:
+        i += 1
+      while points[order[j] * dims + axis] > pivot:
+        j -= 1
+      if i <= j:
+        tmp = order[i]
+        order[i] = order[j]
+        order[j] = tmp
+        i += 1
+        j -= 1
+    if m <= j:
+      hi = j
+    elif m >= i:
+      lo = i
+    else:
+      break
+
+cdef int fill_pool_r(size_t *order, size_t num_points, const double *points,
+                     const int *nums, size_t dims, size_t depth, pool_node *nodes,
+                     double *coords, size_t *count) noexcept nogil:
+  """Builds the subtree over the points order[0, num_points) into the pool in
+  preorder, splitting on the median like fill_tree.  Returns the index of the
+  subtree's root, or -1 if there are no points."""
+  if 0 == num_points:
+    return -1
+  cdef size_t axis = pick_axis(depth, dims)
+  cdef size_t median = num_points / 2
+  select_median(order, num_points, median, points, dims, axis)
+
+  cdef size_t idx = count[0]
+  count[0] += 1
+  cdef size_t point_idx = order[median]
+  nodes[idx].num = nums[point_idx] if NULL != nums else <int>point_idx
+  memcpy(&coords[idx * dims], &points[point_idx * dims], dims * sizeof(double))
+  nodes[idx].left = fill_pool_r(order, median, points, nums, dims, depth + 1,
+                                nodes, coords, count)
+  nodes[idx].right = fill_pool_r(&order[median + 1], num_points - median - 1, points,
+                                 nums, dims, depth + 1, nodes, coords, count)
+  return <int>idx
+
+cdef size_t pool_search(const pool_node *nodes, const double *coords, size_t dims,
+                        int idx, int search_num, const double *search,
+                        best_pair nearest[], size_t best_count, size_t num_neighbors,
+                        size_t depth) noexcept nogil:
+  """Searches for the nearest neighbors of search in the pooled subtree rooted at
+  idx.  Returns the count of elements in the best_pair list."""
+  cdef const pool_node *node = &nodes[idx]
+  cdef const double *ncoords = &coords[idx * dims]
+  cdef size_t axis = pick_axis(depth, dims)
+  cdef int near, far
+  if search[axis] < ncoords[axis]:
+    near = node.left
+    far = node.right
+  else:
+    near = node.right
+    far = node.left
+
+  if -1 != near:
+    best_count = pool_search(nodes, coords, dims, near, search_num, search, nearest,
+                             best_count, num_neighbors, depth + 1)
+
+  if node.num != search_num:
+    best_count = insert_best(nearest, best_count, node.num,
+                             sqdist_c(ncoords, search, dims), num_neighbors)
+
+  # maybe search the away branch
+  cdef double diff
+  if -1 != far:
+    diff = ncoords[axis] - search[axis]
+    if best_count < num_neighbors or diff * diff < nearest[best_count - 1].dist:
+      best_count = pool_search(nodes, coords, dims, far, search_num, search, nearest,
+                               best_count, num_neighbors, depth + 1)
+  return best_count
+
+cpdef KDTreePool fill_pool(pointList):
+  """Constructs a pooled KD-tree from a list of PointData elements."""
+  cdef size_t num_points = len(pointList)
+  cdef size_t dims = pointList[0].dims if num_points > 0 else 1
+  cdef double[:, ::1] points = cvarray(shape=(max(num_points, 1), dims),
+                                       itemsize=sizeof(double), format="d")
+  cdef int[::1] nums = cvarray(shape=(max(num_points, 1),), itemsize=sizeof(int),
+                               format="i")
+  if num_points > 0:
+    points_from_list(pointList, &points[0, 0], &nums[0], dims)
+  return KDTreePool(points[:num_points], nums[:num_points])
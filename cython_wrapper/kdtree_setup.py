@@ -1,4 +1,7 @@
 from distutils.core import setup, Extension
-setup(name="kdtree", version="1.0",
-      ext_modules=[Extension("kdtree", ["kdtree.c"])])
+from Cython.Distutils import build_ext
 
+# the node pool uses typed memoryviews; Cython generates kdtree.c from the .pyx
+setup(name="kdtree", version="1.0",
+      cmdclass = {'build_ext': build_ext},
+      ext_modules=[Extension("kdtree", ["kdtree.pyx"])])
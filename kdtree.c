@@ -13,25 +13,63 @@
  * You should have received a copy of the GNU Lesser General Public License
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
+#define PY_SSIZE_T_CLEAN
 #include <Python.h>
 #include "structmember.h"
+/* the shared C core, from cython_with_c */
+#include "kdtree_raw.h"
 
+/* The default number of neighbors */
 #define LIMIT 3
+/* Coordinates held inside the node itself; longer points are allocated */
+#define INLINE_DIMS 2
+/* The largest k and number of dimensions searched without a heap allocation */
+#define SMALL_K 16
+#define SMALL_DIMS 16
 
 /* Structs */
 
+/* All nodes in one tree must have the same number of dimensions.  A node 
+   searched as a root keeps a copy of its subtree in the shared C core's 
+   layout, which the core searches; the copy is made again when any node has 
+   changed since (see tree_generation), and costs about as much memory as the 
+   subtree's coordinates. */
 typedef struct {
     PyObject_HEAD
     PyObject *left;
     PyObject *right;
-		double coords[2];
+		double *coords;
+		double inline_coords[INLINE_DIMS];
+		int dims;
     int number;
+		kdtree_node *compiled;
+		unsigned long compiled_generation;
+		int gathering;
 } KDTreeNode;
 
-struct best_pair {
-	int node_num;
-	double dist;
-};
+/* A tree built by build(), held by the shared C core rather than as 
+   KDTreeNode objects, in its packed layout */
+typedef struct {
+	PyObject_HEAD
+	kdtree_packed *tree;
+	Py_ssize_t num_nodes;
+	int dims;
+} KDTree;
+
+/* The points read by build(), before they are arranged into a tree */
+typedef struct {
+	double *coords;
+	int *numbers;
+	Py_ssize_t num_points;
+	int dims;
+} PointSet;
+
+/* array.array, looked up once when the module is loaded */
+static PyObject *array_type = NULL;
+
+/* Bumped whenever any KDTreeNode's number, coords or children change, which 
+   makes every compiled copy of a subtree stale */
+static unsigned long tree_generation = 1;
 
 /* prototypes */
 
@@ -48,7 +86,7 @@ static int
 KDTreeNode_setleft(KDTreeNode *self, PyObject *value, void *closure);
 
 static PyObject *
-KDTreeNode_run_nn_search(KDTreeNode *self, PyObject *args);
+KDTreeNode_run_nn_search(KDTreeNode *self, PyObject *args, PyObject *kwds);
 
 static int
 KDTreeNode_setcoords(KDTreeNode *self, PyObject *value, void *closure);
@@ -56,175 +94,173 @@ KDTreeNode_setcoords(KDTreeNode *self, PyObject *value, void *closure);
 static PyObject *
 KDTreeNode_getcoords(KDTreeNode *self, void *closure);
 
+static PyObject *
+KDTreeNode_getnumber(KDTreeNode *self, void *closure);
+
+static int
+KDTreeNode_setnumber(KDTreeNode *self, PyObject *value, void *closure);
+
+static PyObject *
+KDTree_run_nn_search(KDTree *self, PyObject *args, PyObject *kwds);
+
+static PyObject *
+KDTree_run_nn_search_batch(KDTree *self, PyObject *args, PyObject *kwds);
+
 /* Utility functions */
 
-/* Determine the largest element in the best neighbors array*/
-static double largest_dist(struct best_pair best[], int count) {
-	double largest = -1;
-	if (count > 0) {
-		largest = best[count - 1].dist;
+/* Checks that a buffer format describes native values of the given 
+   struct module type code, such as "d" or "i". */
+static int is_native_format(const char *format, const char *code) {
+	if (NULL == format) {
+		return 0;
+	}
+	if ('@' == format[0] || '=' == format[0]) {
+		format++;
+#ifdef WORDS_BIGENDIAN
+	} else if ('>' == format[0] || '!' == format[0]) {
+#else
+	} else if ('<' == format[0]) {
+#endif
+		format++;
 	}
-	return largest;
+	return 0 == strcmp(format, code);
 }
 
-/*
- * Choose the next axis to use based on the current axis.
- */
-static int pick_axis(int axis) {
-  /* search the near branch */
-  int next_axis;
-	if (1 == axis) {
-		next_axis = 0;
-	} else {
-		next_axis = 1;
-	}
-	return next_axis;
-}
-
-static double sqdist(double ax, double bx, double ay, double by) {
-	double diffx = ax - bx;
-	double diffy = ay - by;
-	return (diffx * diffx) + (diffy * diffy);
-}
-
-/*static void fill_tree(double points[][], int num_points, int axis) {
-	int median = num_points / 2;
-	int num_points_next = num_points - median;
-  int next_axis = pick_axis(axis);
-	KDTreeNode* node;
-	node->left = kd_tree(points[0:median], next_axis);
-	node->left = kd_tree(points[median + 1:], next_axis);
-	return node;
-}*/
-
-/* Functions directly related to KD-tree functionality */
-
-/* Adds the point to the list of best nodes if it is closer than the current best
-   list. */
-static int add_best(
-		int count, 
-		double nodepoint[], 
-		int node_num, 
-		double point[], 
-		struct best_pair best[]) {
-	/*(count, nodepoint, node_num, point, point_num, best)*/
-  /* due to the constraints of the problem, we need to check each node
-     before assigning it as the final best choice to ensure it is not
-     equal to the searched-for point
-	*/
-
-	double sd = sqdist(nodepoint[0], point[0], nodepoint[1], point[1]);
-	int last_idx;
-	if (count < LIMIT) {
-		last_idx = count;
-	} else {
-		last_idx = count - 1;
-	}
-
-	int idx;
-	struct best_pair candidate;
-	candidate.node_num = node_num;
-	candidate.dist = sd;
-
-	struct best_pair pair;
-	/* search through linearly to maintain sorted order */
-	for (idx = 0; idx < count; idx++) {
-		pair = best[idx];
-		if (pair.dist > sd) {
-			/* push elements down */
-			int x;
-			/*free(best[last_idx]);*/
-			for (x = last_idx; x > idx; x--) {
-				best[x] = best[x - 1];
-			}
-			/* TODO does this need to be allocated on the heap? */
-			best[idx] = candidate;
-			return last_idx + 1;
-		}
-	}
+/* Frees the arrays of a PointSet. */
+static void free_point_set(PointSet *points) {
+	PyMem_Free(points->coords);
+	PyMem_Free(points->numbers);
+	points->coords = NULL;
+	points->numbers = NULL;
+}
 
-	if (count < LIMIT) {
-		/* didn't find an insert spot, so insert at the end */
-		best[last_idx] = candidate;
-		return last_idx + 1;
+/* Allocates the arrays of a PointSet for num_points points.  Returns -1 with 
+   an exception set on failure. */
+static int alloc_point_set(PointSet *points, Py_ssize_t num_points, int dims) {
+	Py_ssize_t n = num_points > 0 ? num_points : 1;
+	points->num_points = num_points;
+	points->dims = dims;
+	points->coords = PyMem_New(double, n * dims);
+	points->numbers = PyMem_New(int, n);
+	if (!points->coords || !points->numbers) {
+		free_point_set(points);
+		PyErr_NoMemory();
+		return -1;
 	}
-  return count;
+	return 0;
 }
 
-/* Searches for nearest neighbor of point using node as the root. */
-static int nn_search(
-		KDTreeNode *node, 
-		int point_num,
-		double search_x,
-		double search_y,
-		struct best_pair best[], 
-		int count, 
-		int axis) {
-  if (Py_None == (PyObject *)node) {
-    return count;
+/* Reads the points for build() from an object supporting the buffer protocol:
+   contiguous doubles, either n x dims or flat x, y pairs.  The node numbers are 
+   the row indices.  Returns -1 with an exception set on failure. */
+static int
+points_from_buffer(PyObject *obj, PointSet *points) {
+	Py_buffer view;
+	if (0 != PyObject_GetBuffer(obj, &view, PyBUF_FORMAT | PyBUF_C_CONTIGUOUS)) {
+		return -1;
 	}
-
-	int cnt = count;
-  double *nodepoint = node->coords;
-	double point[2];
-	point[0] = search_x;
-	point[1] = search_y;
-	int node_num = node->number;
-
-	if (Py_None == node->left && Py_None == node->right) {
-    if (node_num != point_num) {
-      cnt = add_best(cnt, nodepoint, node_num, point, best);
-		}
-    return cnt;
+	int dims = (2 == view.ndim) ? (int)view.shape[1] : 2;
+	if (!is_native_format(view.format, "d") || view.ndim > 2 || dims < 1 ||
+			0 != (view.len / view.itemsize) % dims) {
+		PyBuffer_Release(&view);
+		PyErr_SetString(PyExc_TypeError,
+										"The points buffer must hold n x dims or x, y pairs of doubles.");
+		return -1;
 	}
 
-  /* Normally we'd select axis based on depth so that axis cycles through 
-     all valid values.  Here we know we have 2-dimensional values, so don't 
-     waste time calculating, but just alternate
-     axis = depth % len(point) */
-
-  /* compare query point and current node along the axis to see which tree is
-     far and which is near */
+	Py_ssize_t n = view.len / view.itemsize / dims;
+	if (0 != alloc_point_set(points, n, dims)) {
+		PyBuffer_Release(&view);
+		return -1;
+	}
+	memcpy(points->coords, view.buf, n * dims * sizeof(double));
+	Py_ssize_t i;
+	for (i = 0; i < n; i++) {
+		points->numbers[i] = (int)i;
+	}
+	PyBuffer_Release(&view);
+	return 0;
+}
 
-	KDTreeNode *near;
-	KDTreeNode *far;
-  if (point[axis] < nodepoint[axis]) {
-    near = (KDTreeNode *)node->left;
-    far = (KDTreeNode *)node->right;
+/* Reads the coordinates of one point from a sequence of dims numbers.  Returns
+   -1 with an exception set on failure. */
+static int read_point(PyObject *obj, double point[], int dims) {
+	if (PyTuple_Check(obj) && dims == PyTuple_GET_SIZE(obj)) {
+		/* the common case: no new reference is needed for a tuple */
+		int i;
+		for (i = 0; i < dims; i++) {
+			point[i] = PyFloat_AsDouble(PyTuple_GET_ITEM(obj, i));
+		}
 	} else {
-    near = (KDTreeNode *)node->right;
-    far = (KDTreeNode *)node->left;
+		PyObject *seq = PySequence_Fast(obj, "The coords must be a sequence of numbers.");
+		if (!seq) {
+			return -1;
+		}
+		if (dims != PySequence_Fast_GET_SIZE(seq)) {
+			Py_DECREF(seq);
+			PyErr_Format(PyExc_ValueError, "Expected %d coordinates.", dims);
+			return -1;
+		}
+		int i;
+		for (i = 0; i < dims; i++) {
+			point[i] = PyFloat_AsDouble(PySequence_Fast_GET_ITEM(seq, i));
+		}
+		Py_DECREF(seq);
 	}
-
-  /* search the near branch */
-  int next_axis = pick_axis(axis);
-
-	if (Py_None != (PyObject *) near) {
-	  cnt = nn_search(near, point_num, search_x, search_y, best, cnt, next_axis);
+	if (PyErr_Occurred()) {
+		return -1;
 	}
+	return 0;
+}
 
-  /* If the current node is closer overall than the current best */
-  if (node_num != point_num) {
-    cnt = add_best(cnt, nodepoint, node_num, point, best);
+/* Reads the points for build() from a sequence of (number, coords) tuples, 
+   where every coords has as many numbers as the first.  Returns -1 with an 
+   exception set on failure. */
+static int
+points_from_sequence(PyObject *obj, PointSet *points) {
+	PyObject *seq = PySequence_Fast(obj, 
+			"build() takes a sequence of (number, coords) tuples or a buffer of doubles.");
+	if (!seq) {
+		return -1;
 	}
 
-  /* maybe search the away branch */
-	if (Py_None != (PyObject *) far) {
-		double largest = largest_dist(best, cnt);
-		int search_other = 0;
-		if (largest < 0) {
-			search_other = 1;
-		} else {
-			double diff = nodepoint[axis] - point[axis];
-			if ((diff * diff) < largest) {
-				search_other = 1;
+	Py_ssize_t n = PySequence_Fast_GET_SIZE(seq);
+	Py_ssize_t i;
+	for (i = 0; i < n; i++) {
+		/* PySequence_Fast_GET_ITEM is a borrowed reference, so don't DECREF it */
+		PyObject *item = PySequence_Fast_GET_ITEM(seq, i);
+		int number;
+		PyObject *coords;
+		if (!PyArg_ParseTuple(item, "iO", &number, &coords)) {
+			break;
+		}
+		if (0 == i) {
+			/* the first point decides the dimensions of the tree */
+			Py_ssize_t dims = PySequence_Size(coords);
+			if (dims < 1) {
+				if (!PyErr_Occurred()) {
+					PyErr_SetString(PyExc_ValueError, "The coords must not be empty.");
+				}
+				break;
+			}
+			if (0 != alloc_point_set(points, n, (int)dims)) {
+				break;
 			}
 		}
-		if (1 == search_other) {
-			cnt = nn_search(far, point_num, search_x, search_y, best, cnt, next_axis);
+		points->numbers[i] = number;
+		if (0 != read_point(coords, &points->coords[i * points->dims], points->dims)) {
+			break;
 		}
 	}
-  return cnt;
+	Py_DECREF(seq);
+	if (i < n) {
+		free_point_set(points);
+		return -1;
+	}
+	if (0 == n) {
+		return alloc_point_set(points, 0, 2);
+	}
+	return 0;
 }
 
 /* Ref counting cycle detection */
@@ -267,6 +303,11 @@ KDTreeNode_clear(KDTreeNode *self) {
 static void
 KDTreeNode_dealloc(KDTreeNode* self) {
 	KDTreeNode_clear(self);
+	free_tree(self->compiled);
+	self->compiled = NULL;
+	if (self->coords != self->inline_coords) {
+		PyMem_Free(self->coords);
+	}
 	self->ob_type->tp_free((PyObject*)self);
 }
 
@@ -280,9 +321,14 @@ KDTreeNode_new(PyTypeObject *type, PyObject *args, PyObject *kwds) {
 		self->left = Py_None;
 		Py_INCREF(Py_None);
 		self->right = Py_None;
+		self->coords = self->inline_coords;
 		self->coords[0] = 0.0;
 		self->coords[1] = 0.0;
+		self->dims = 2;
 		self->number = 0;
+		self->compiled = NULL;
+		self->compiled_generation = 0;
+		self->gathering = 0;
 	}
 
 	return (PyObject *)self;
@@ -299,6 +345,7 @@ KDTreeNode_init(KDTreeNode *self, PyObject *args, PyObject *kwds) {
 																		&coords, &left, &right)) {
 		return -1; 
 	}
+	tree_generation++;
 
 	/* TODO use
 	 * if (! PyObject_TypeCheck(some_object, &MyType)) {
@@ -308,6 +355,11 @@ KDTreeNode_init(KDTreeNode *self, PyObject *args, PyObject *kwds) {
 	 *
 	 * on the left and right */
 
+	/* the coords come first, as the children are checked against them */
+	if (0 != KDTreeNode_setcoords(self, coords, NULL)) {
+		return -1;
+	}
+
 	if (left) {
 		if (0 != KDTreeNode_setleft(self, left, NULL)) {
 			return -1;
@@ -320,16 +372,12 @@ KDTreeNode_init(KDTreeNode *self, PyObject *args, PyObject *kwds) {
 		}
 	}
 
-	if (0 != KDTreeNode_setcoords(self, coords, NULL)) {
-		return -1;
-	}
-
 	return 0;
 }
 
 static PyMemberDef KDTreeNode_members[] = {
-	{"number", T_INT, offsetof(KDTreeNode, number), 0,
-	 "kd-tree node number"},
+	{"dims", T_INT, offsetof(KDTreeNode, dims), READONLY,
+	 "number of coordinates"},
 	{NULL}  /* Sentinel */
 };
 
@@ -346,12 +394,20 @@ static PyGetSetDef KDTreeNode_getseters[] = {
 	 (getter)KDTreeNode_getcoords, (setter)KDTreeNode_setcoords,
 	 "node coordinates",
 	 NULL},
+	{"number", 
+	 (getter)KDTreeNode_getnumber, (setter)KDTreeNode_setnumber,
+	 "kd-tree node number",
+	 NULL},
 	{NULL}  /* Sentinel */
 };
 
 static PyMethodDef KDTreeNode_methods[] = {
-	{"run_nn_search", (PyCFunction)KDTreeNode_run_nn_search, METH_VARARGS,
-	 "Runs a nearest-neighbor search"
+	{"run_nn_search", (PyCFunction)KDTreeNode_run_nn_search, 
+	 METH_VARARGS | METH_KEYWORDS,
+	 "run_nn_search(search_num, coords, k=3, out=None)\n\n"
+	 "Runs a nearest-neighbor search.  Returns an array.array('i') of k node \n"
+	 "numbers, or writes them into out, a writable buffer of C ints, and \n"
+	 "returns out."
 	},
 	{NULL}  /* Sentinel */
 };
@@ -398,35 +454,523 @@ static PyTypeObject KDTreeNodeType = {
 	KDTreeNode_new,                 /* tp_new */
 };
 
+/* Searches a tree for the k nearest neighbors of point, writing their numbers
+   into best_nums padded with -1.  Returns -1 with an exception set on 
+   failure. */
+typedef int (*tree_search)(
+		PyObject *tree,
+		int search_num,
+		const double point[],
+		int dims,
+		int best_nums[],
+		int k);
+
+/* Parses the (search_num, coords, k=LIMIT, out=None) arguments of 
+   run_nn_search.  Plain positional calls are unpacked straight from the 
+   argument tuple, since the format string parser dominates the cost of a 
+   small search; anything else goes through PyArg_ParseTupleAndKeywords.
+   Returns -1 with an exception set on failure. */
+static int
+parse_search_args(
+		PyObject *args,
+		PyObject *kwds,
+		int *search_num,
+		PyObject **search,
+		int *k,
+		PyObject **out) {
+	static char *kwlist[] = {"search_num", "coords", "k", "out", NULL};
+	*k = LIMIT;
+	*out = NULL;
+
+	Py_ssize_t nargs = PyTuple_GET_SIZE(args);
+	if (NULL == kwds && nargs >= 2 && nargs <= 4) {
+		PyObject *num = PyTuple_GET_ITEM(args, 0);
+		PyObject *k_obj = (nargs > 2) ? PyTuple_GET_ITEM(args, 2) : NULL;
+		if (PyInt_CheckExact(num) && (!k_obj || PyInt_CheckExact(k_obj))) {
+			long num_val = PyInt_AS_LONG(num);
+			long k_val = k_obj ? PyInt_AS_LONG(k_obj) : LIMIT;
+			if (num_val >= INT_MIN && num_val <= INT_MAX && 
+					k_val >= INT_MIN && k_val <= INT_MAX) {
+				*search_num = (int)num_val;
+				*k = (int)k_val;
+				*search = PyTuple_GET_ITEM(args, 1);
+				*out = (nargs > 3) ? PyTuple_GET_ITEM(args, 3) : NULL;
+				return 0;
+			}
+		}
+	}
+	/* let the general parser produce the conversions and error messages */
+	if (!PyArg_ParseTupleAndKeywords(args, kwds, "iO|iO", kwlist, 
+																	 search_num, search, k, out)) {
+		return -1;
+	}
+	return 0;
+}
+
+/* Copies the num_results results into out, which must be a writable buffer of
+   at least num_results C ints.  Of the objects with only the old buffer 
+   interface, whose contents have no format, just array.array('i') is 
+   accepted.  Returns -1 with an exception set on failure. */
+static int
+write_results(PyObject *out, const int best_nums[], Py_ssize_t num_results) {
+	Py_buffer view;
+	int *nums;
+	int has_view = 0;
+	Py_ssize_t len;
+	if (PyObject_CheckBuffer(out)) {
+		if (0 != PyObject_GetBuffer(out, &view, PyBUF_WRITABLE | PyBUF_FORMAT | 
+																PyBUF_C_CONTIGUOUS)) {
+			return -1;
+		}
+		has_view = 1;
+		if (!is_native_format(view.format, "i")) {
+			PyBuffer_Release(&view);
+			PyErr_SetString(PyExc_TypeError, "out must be a buffer of C ints.");
+			return -1;
+		}
+		nums = view.buf;
+		len = view.len;
+	} else {
+		int is_int_array = 0;
+		int is_array = PyObject_IsInstance(out, array_type);
+		if (is_array < 0) {
+			return -1;
+		}
+		if (is_array) {
+			PyObject *typecode = PyObject_GetAttrString(out, "typecode");
+			if (NULL == typecode) {
+				return -1;
+			}
+			is_int_array = PyString_Check(typecode) && 
+				0 == strcmp(PyString_AS_STRING(typecode), "i");
+			Py_DECREF(typecode);
+		}
+		if (!is_int_array) {
+			PyErr_SetString(PyExc_TypeError, "out must be a buffer of C ints.");
+			return -1;
+		}
+
+		void *buf;
+		if (0 != PyObject_AsWriteBuffer(out, &buf, &len)) {
+			return -1;
+		}
+		nums = buf;
+	}
+
+	if (len < (Py_ssize_t)(num_results * sizeof(int))) {
+		if (has_view) {
+			PyBuffer_Release(&view);
+		}
+		PyErr_Format(PyExc_ValueError, "out must hold at least %zd ints.", num_results);
+		return -1;
+	}
+	memcpy(nums, best_nums, num_results * sizeof(int));
+	if (has_view) {
+		PyBuffer_Release(&view);
+	}
+	return 0;
+}
+
+/* Builds an array.array('i') of the num_results results.  The array copies 
+   them in one go from their machine representation, rather than making an 
+   int object per result as a list would. */
+static PyObject *
+results_to_array(const int best_nums[], Py_ssize_t num_results) {
+	return PyObject_CallFunction(array_type, "ss#", "i", (const char *)best_nums, 
+															 (Py_ssize_t)(num_results * sizeof(int)));
+}
+
+/* Runs a nearest neighbor search from Python arguments on a tree with dims 
+   dimensions, shared by both tree types. */
+static PyObject *
+run_search(
+		PyObject *tree, 
+		int dims, 
+		tree_search search_fn, 
+		PyObject *args, 
+		PyObject *kwds) {
+	int search_num; 
+	PyObject *search;
+	int k;
+	PyObject *out;
+	if (0 != parse_search_args(args, kwds, &search_num, &search, &k, &out)) {
+		return NULL;
+	}
+	if (k < 1) {
+		PyErr_SetString(PyExc_ValueError, "k must be positive.");
+		return NULL;
+	}
+
+	PyObject *result = NULL;
+	double small_point[SMALL_DIMS];
+	int small_nums[SMALL_K];
+	double *point = small_point;
+	int *best_nums = small_nums;
+	if (dims > SMALL_DIMS) {
+		point = PyMem_New(double, dims);
+	}
+	if (k > SMALL_K) {
+		best_nums = PyMem_New(int, k);
+	}
+	if (!point || !best_nums) {
+		PyErr_NoMemory();
+		goto done;
+	}
+	if (0 != read_point(search, point, dims)) {
+		goto done;
+	}
+
+	if (0 != search_fn(tree, search_num, point, dims, best_nums, k)) {
+		goto done;
+	}
+	if (NULL != out && Py_None != out) {
+		if (0 == write_results(out, best_nums, k)) {
+			Py_INCREF(out);
+			result = out;
+		}
+	} else {
+		result = results_to_array(best_nums, k);
+	}
+
+done:
+	if (point != small_point) {
+		PyMem_Free(point);
+	}
+	if (best_nums != small_nums) {
+		PyMem_Free(best_nums);
+	}
+	return result;
+}
+
+/* The subtree of a KDTreeNode in preorder, gathered to be copied into the 
+   shared C core */
+typedef struct {
+	double *coords;
+	int *nums;
+	long *left;
+	long *right;
+	Py_ssize_t count;
+	Py_ssize_t capacity;
+	int dims;
+} NodeList;
+
+/* Appends node and its subtree to list in preorder, setting *pos to its 
+   position, or to -1 for None.  A node can be given new coords after it was 
+   made a child; such a subtree is left out rather than read past its coords.
+   Like the searches, this recurses as deep as the tree.  Returns -1 with an 
+   exception set on failure, such as a node that is its own descendant. */
+static int
+gather_nodes(PyObject *obj, NodeList *list, long *pos) {
+	*pos = -1;
+	if (Py_None == obj) {
+		return 0;
+	}
+	KDTreeNode *node = (KDTreeNode *)obj;
+	if (node->dims != list->dims) {
+		return 0;
+	}
+	if (node->gathering) {
+		PyErr_SetString(PyExc_ValueError, "A KDTreeNode cannot be its own descendant");
+		return -1;
+	}
+	if (list->count == list->capacity) {
+		Py_ssize_t capacity = list->capacity * 2;
+		double *coords = PyMem_Resize(list->coords, double, capacity * list->dims);
+		if (coords) {
+			list->coords = coords;
+		}
+		int *nums = coords ? PyMem_Resize(list->nums, int, capacity) : NULL;
+		if (nums) {
+			list->nums = nums;
+		}
+		long *left = nums ? PyMem_Resize(list->left, long, capacity) : NULL;
+		if (left) {
+			list->left = left;
+		}
+		long *right = left ? PyMem_Resize(list->right, long, capacity) : NULL;
+		if (!right) {
+			PyErr_NoMemory();
+			return -1;
+		}
+		list->right = right;
+		list->capacity = capacity;
+	}
+	Py_ssize_t idx = list->count++;
+	memcpy(&list->coords[idx * list->dims], node->coords, list->dims * sizeof(double));
+	list->nums[idx] = node->number;
+
+	long child;
+	node->gathering = 1;
+	int status = gather_nodes(node->left, list, &child);
+	list->left[idx] = child;
+	if (0 == status) {
+		status = gather_nodes(node->right, list, &child);
+		list->right[idx] = child;
+	}
+	node->gathering = 0;
+	*pos = (long)idx;
+	return status;
+}
+
+/* Copies the subtree of root into the shared C core, unless the copy it has 
+   is still current.  Returns -1 with an exception set on failure. */
+static int
+compile_nodes(KDTreeNode *root) {
+	if (NULL != root->compiled && tree_generation == root->compiled_generation) {
+		return 0;
+	}
+	NodeList list = {NULL, NULL, NULL, NULL, 0, 64, root->dims};
+	list.coords = PyMem_New(double, list.capacity * list.dims);
+	list.nums = PyMem_New(int, list.capacity);
+	list.left = PyMem_New(long, list.capacity);
+	list.right = PyMem_New(long, list.capacity);
+	int status = -1;
+	long pos;
+	if (!list.coords || !list.nums || !list.left || !list.right) {
+		PyErr_NoMemory();
+	} else if (0 == gather_nodes((PyObject *)root, &list, &pos)) {
+		free_tree(root->compiled);
+		root->compiled = fill_tree_shape(list.coords, list.nums, list.left, list.right,
+																		 list.count, list.dims);
+		root->compiled_generation = tree_generation;
+		status = 0;
+	}
+	PyMem_Free(list.coords);
+	PyMem_Free(list.nums);
+	PyMem_Free(list.left);
+	PyMem_Free(list.right);
+	return status;
+}
+
+/* Searches a tree of KDTreeNode objects with the shared C core, which finds 
+   the same neighbors in the same order as walking the objects would. */
+static int
+node_search(
+		PyObject *tree,
+		int search_num,
+		const double point[],
+		int dims,
+		int best_nums[],
+		int k) {
+	KDTreeNode *root = (KDTreeNode *)tree;
+	if (0 != compile_nodes(root)) {
+		return -1;
+	}
+	point_data search;
+	search.num = search_num;
+	search.coords = (double *)point;
+	search.dims = dims;
+	search.curr_axis = 0;
+	run_nn_search_method(root->compiled, k, search, best_nums, SEARCH_DFS);
+	return 0;
+}
+
 /* Initializes the nearest neighbor search point and starts the search.
- * call it like run_nn_search(kdtree_node, search_num, (search_x, search_y))
+ * call it like run_nn_search(kdtree_node, search_num, (search_x, search_y)),
+ * or with a point of any dimension, the number of neighbors to find and 
+ * optionally a buffer to write them into:
+ * run_nn_search(kdtree_node, search_num, coords, k, out)
  */
 static PyObject *
-KDTreeNode_run_nn_search(KDTreeNode *self, PyObject *args) {
-	/* The number of the node we are running the nearest neighbor search on */
-	int search_num; 
-	/* The X,Y coordinates of the node we are running nearest neighbor search on */
-	double search_x;
-	double search_y;
-	if(!PyArg_ParseTuple(args, "i(dd)", &search_num, &search_x, &search_y)) {
+KDTreeNode_run_nn_search(KDTreeNode *self, PyObject *args, PyObject *kwds) {
+	return run_search((PyObject *)self, self->dims, node_search, args, kwds);
+}
+
+/* Constructors, initializers, and destructors for KDTree */
+static void
+KDTree_dealloc(KDTree* self) {
+	free_tree_packed(self->tree);
+	self->tree = NULL;
+	self->ob_type->tp_free((PyObject*)self);
+}
+
+static PyMethodDef KDTree_methods[] = {
+	{"run_nn_search", (PyCFunction)KDTree_run_nn_search, 
+	 METH_VARARGS | METH_KEYWORDS,
+	 "run_nn_search(search_num, coords, k=3, out=None)\n\n"
+	 "Runs a nearest-neighbor search.  Returns an array.array('i') of k node \n"
+	 "numbers, or writes them into out, a writable buffer of C ints, and \n"
+	 "returns out."
+	},
+	{"run_nn_search_batch", (PyCFunction)KDTree_run_nn_search_batch, 
+	 METH_VARARGS | METH_KEYWORDS,
+	 "run_nn_search_batch(searches, k=3, out=None)\n\n"
+	 "Runs a nearest-neighbor search for each (number, coords) pair in searches, \n"
+	 "or each row of a buffer of doubles, without holding the GIL.  Returns a \n"
+	 "flat array.array('i') of k node numbers per search, or writes them \n"
+	 "into out."
+	},
+	{NULL}  /* Sentinel */
+};
+
+static PyMemberDef KDTree_members[] = {
+	{"dims", T_INT, offsetof(KDTree, dims), READONLY,
+	 "number of coordinates"},
+	{NULL}  /* Sentinel */
+};
+
+static PyTypeObject KDTreeType = {
+	PyObject_HEAD_INIT(NULL)
+	0,                         /*ob_size*/
+	"kdtree.KDTree",           /*tp_name*/
+	sizeof(KDTree),            /*tp_basicsize*/
+	0,                         /*tp_itemsize*/
+	(destructor)KDTree_dealloc, /*tp_dealloc*/
+	0,                         /*tp_print*/
+	0,                         /*tp_getattr*/
+	0,                         /*tp_setattr*/
+	0,                         /*tp_compare*/
+	0,                         /*tp_repr*/
+	0,                         /*tp_as_number*/
+	0,                         /*tp_as_sequence*/
+	0,                         /*tp_as_mapping*/
+	0,                         /*tp_hash */
+	0,                         /*tp_call*/
+	0,                         /*tp_str*/
+	0,                         /*tp_getattro*/
+	0,                         /*tp_setattro*/
+	0,                         /*tp_as_buffer*/
+	Py_TPFLAGS_DEFAULT,        /*tp_flags*/
+	"Packed KD-tree built by kdtree.build()", /* tp_doc */
+	0,		                     /* tp_traverse */
+	0,		                     /* tp_clear */
+	0,		                     /* tp_richcompare */
+	0,		                     /* tp_weaklistoffset */
+	0,		                     /* tp_iter */
+	0,		                     /* tp_iternext */
+	KDTree_methods,            /* tp_methods */
+	KDTree_members,            /* tp_members */
+};
+
+/* Builds a tree in one call, using the shared C core.
+ * call it like build([(number, (x, y)), ...]) or build(buffer_of_doubles); the
+ * points may have any number of dimensions, as long as they all agree.
+ */
+static PyObject *
+kdtree_build(PyObject *module, PyObject *points_obj) {
+	PointSet points = {NULL, NULL, 0, 0};
+	int status;
+	if (PyObject_CheckBuffer(points_obj)) {
+		status = points_from_buffer(points_obj, &points);
+	} else {
+		status = points_from_sequence(points_obj, &points);
+	}
+	if (0 != status) {
 		return NULL;
 	}
 
-	struct best_pair best[LIMIT];
-	nn_search(self, search_num, search_x, search_y, best, 0, 0);
+	KDTree *tree = PyObject_New(KDTree, &KDTreeType);
+	if (!tree) {
+		free_point_set(&points);
+		return NULL;
+	}
+	tree->num_nodes = points.num_points;
+	tree->dims = points.dims;
+	Py_BEGIN_ALLOW_THREADS
+	tree->tree = fill_tree_packed(points.coords, points.numbers, points.num_points, 
+																points.dims);
+	Py_END_ALLOW_THREADS
+	free_point_set(&points);
+	return (PyObject *)tree;
+}
 
-	int i;
-	PyObject *best_list;
-	best_list = PyList_New(LIMIT);
-	for (i = 0; i < LIMIT; i++) {
-		/* PyList_SetItem steals the reference, so no need to explicitly decrement it */
-		if (!PyList_SetItem(best_list, i, PyInt_FromLong(best[i].node_num))) {
-			/* TODO return error */
+/* Searches a tree held by the C core. */
+static int
+core_search(
+		PyObject *tree,
+		int search_num,
+		const double point[],
+		int dims,
+		int best_nums[],
+		int k) {
+	KDTree *self = (KDTree *)tree;
+	run_nn_search_packed(self->tree, k, point, search_num, best_nums);
+	return 0;
+}
+
+/* Initializes the nearest neighbor search point and starts the search.
+ * call it like tree.run_nn_search(search_num, (search_x, search_y)), or with 
+ * the number of neighbors to find and optionally a buffer to write them into:
+ * tree.run_nn_search(search_num, coords, k, out)
+ */
+static PyObject *
+KDTree_run_nn_search(KDTree *self, PyObject *args, PyObject *kwds) {
+	return run_search((PyObject *)self, self->dims, core_search, args, kwds);
+}
+
+/* Runs many searches in one call, handing the whole batch to the C core.
+ * call it like tree.run_nn_search_batch([(number, coords), ...], k, out); rows
+ * of a buffer of doubles are searched as points outside of the tree.
+ */
+static PyObject *
+KDTree_run_nn_search_batch(KDTree *self, PyObject *args, PyObject *kwds) {
+	static char *kwlist[] = {"searches", "k", "out", NULL};
+	PyObject *searches_obj;
+	int k = LIMIT;
+	PyObject *out = NULL;
+	if (!PyArg_ParseTupleAndKeywords(args, kwds, "O|iO", kwlist, 
+																	 &searches_obj, &k, &out)) {
+		return NULL;
+	}
+	if (k < 1) {
+		PyErr_SetString(PyExc_ValueError, "k must be positive.");
+		return NULL;
+	}
+
+	PointSet searches = {NULL, NULL, 0, 0};
+	int from_buffer = PyObject_CheckBuffer(searches_obj);
+	int status;
+	if (from_buffer) {
+		status = points_from_buffer(searches_obj, &searches);
+	} else {
+		status = points_from_sequence(searches_obj, &searches);
+	}
+	if (0 != status) {
+		return NULL;
+	}
+	Py_ssize_t n = searches.num_points;
+	if (n > 0 && searches.dims != self->dims) {
+		free_point_set(&searches);
+		PyErr_Format(PyExc_ValueError, "Expected %d coordinates.", self->dims);
+		return NULL;
+	}
+
+	PyObject *result = NULL;
+	Py_ssize_t alloc_n = n > 0 ? n : 1;
+	point_data *data = PyMem_New(point_data, alloc_n);
+	point_data **ptrs = PyMem_New(point_data *, alloc_n);
+	int *best_nums = PyMem_New(int, alloc_n * k);
+	if (!data || !ptrs || !best_nums) {
+		PyErr_NoMemory();
+		goto done;
+	}
+	Py_ssize_t i;
+	for (i = 0; i < n; i++) {
+		data[i].num = from_buffer ? -1 : searches.numbers[i];
+		data[i].coords = &searches.coords[i * searches.dims];
+		data[i].dims = searches.dims;
+		data[i].curr_axis = 0;
+		ptrs[i] = &data[i];
+	}
+	Py_BEGIN_ALLOW_THREADS
+	run_nn_search_packed_batch(self->tree, k, ptrs, n, best_nums);
+	Py_END_ALLOW_THREADS
+
+	if (NULL != out && Py_None != out) {
+		if (0 == write_results(out, best_nums, n * k)) {
+			Py_INCREF(out);
+			result = out;
 		}
+	} else {
+		result = results_to_array(best_nums, n * k);
 	}
 
-	Py_INCREF(best_list);
-	return best_list;
+done:
+	PyMem_Free(best_nums);
+	PyMem_Free(ptrs);
+	PyMem_Free(data);
+	free_point_set(&searches);
+	return result;
 }
 
 /* getters and setters */
@@ -448,6 +992,11 @@ KDTreeNode_setleft(KDTreeNode *self, PyObject *value, void *closure) {
                     "The left attribute value must be a KDTreeNode");
     return -1;
   }
+	if (value != Py_None && ((KDTreeNode *)value)->dims != self->dims) {
+    PyErr_SetString(PyExc_ValueError, 
+                    "The left node must have as many coords as this node");
+    return -1;
+  }
 
 	PyObject *tmp;
 
@@ -455,6 +1004,7 @@ KDTreeNode_setleft(KDTreeNode *self, PyObject *value, void *closure) {
 	Py_INCREF(value);
   self->left = value;    
 	Py_XDECREF(tmp);
+	tree_generation++;
       
   return 0;
 }
@@ -478,6 +1028,11 @@ KDTreeNode_setright(KDTreeNode *self, PyObject *value, void *closure)
     PyErr_SetString(PyExc_TypeError, 
                     "The right attribute value must be a KDTreeNode");
     return -1;
+  }
+	if (value != Py_None && ((KDTreeNode *)value)->dims != self->dims) {
+    PyErr_SetString(PyExc_ValueError, 
+                    "The right node must have as many coords as this node");
+    return -1;
   }
 	PyObject *tmp;
 
@@ -485,6 +1040,7 @@ KDTreeNode_setright(KDTreeNode *self, PyObject *value, void *closure)
 	Py_INCREF(value);
   self->right = value;    
 	Py_XDECREF(tmp);
+	tree_generation++;
 
   return 0;
 }
@@ -495,13 +1051,13 @@ KDTreeNode_getcoords(KDTreeNode *self, void *closure) {
 	coords = Py_BuildValue("(OO)", PyFloat_FromDouble(self->coords[0]), PyFloat_FromDouble(self->coords[1]));
 	Py_INCREF(coords);*/
 
-	PyObject *coords = PyTuple_New(2);
+	PyObject *coords = PyTuple_New(self->dims);
 	if (!coords) {
 		return PyErr_Format(PyExc_TypeError, "Unable to allocate coords tuple.");
 	}
 
 	int i;
-	for (i = 0; i < 2; i++) {
+	for (i = 0; i < self->dims; i++) {
 		PyTuple_SET_ITEM(coords, i, PyFloat_FromDouble(self->coords[i]));
 	}
 	return coords;
@@ -514,36 +1070,85 @@ KDTreeNode_setcoords(KDTreeNode *self, PyObject *value, void *closure) {
     return -1;
   }
 
-	if (!PyTuple_Check(value)) {
+	if (!PyTuple_Check(value) || 0 == PyTuple_GET_SIZE(value)) {
     PyErr_SetString(PyExc_TypeError, 
                     "The coords value must be a tuple of doubles.");
     return -1;
   }
 
-	Py_ssize_t coord_len = PyTuple_Size(value);
+	int coord_len = (int)PyTuple_GET_SIZE(value);
+	if (coord_len != self->dims && (Py_None != self->left || Py_None != self->right)) {
+    PyErr_SetString(PyExc_ValueError, 
+                    "The coords of a node with children must keep their length");
+    return -1;
+	}
+
 	int i;
 	PyObject * tcoord;
-	for (i = 0; i < 2/*coord_len*/; i++) {
-		/* PyTuple_GetItem is a borrowed reference, so don't DECREF it */
-		tcoord = PyTuple_GetItem(value, i);
-		if (!tcoord) {
-			/* let PyTuple_GetItem handle the error. */
-			return -1;
-		}
+	for (i = 0; i < coord_len; i++) {
+		/* PyTuple_GET_ITEM is a borrowed reference, so don't DECREF it */
+		tcoord = PyTuple_GET_ITEM(value, i);
 		if (!PyFloat_Check(tcoord)) {
 			PyErr_SetString(PyExc_TypeError, 
 				              "The coords value must be a tuple of doubles.");
 			return -1;
 		}
+	}
+
+	/* short points live in the node itself; longer ones get their own array */
+	double *coords = self->inline_coords;
+	if (coord_len > INLINE_DIMS) {
+		coords = (coord_len == self->dims) ? self->coords : PyMem_New(double, coord_len);
+		if (!coords) {
+			PyErr_NoMemory();
+			return -1;
+		}
+	}
+	if (coords != self->coords && self->coords != self->inline_coords) {
+		PyMem_Free(self->coords);
+	}
+	self->coords = coords;
+	self->dims = coord_len;
+
+	for (i = 0; i < coord_len; i++) {
+		self->coords[i] = PyFloat_AS_DOUBLE(PyTuple_GET_ITEM(value, i));
+	}
+	tree_generation++;
+
+  return 0;
+}
+
+static PyObject *
+KDTreeNode_getnumber(KDTreeNode *self, void *closure) {
+	return PyInt_FromLong(self->number);
+}
 
-		double coord = PyFloat_AsDouble(tcoord);
-		self->coords[i] = coord;
+static int
+KDTreeNode_setnumber(KDTreeNode *self, PyObject *value, void *closure) {
+  if (value == NULL) {
+    PyErr_SetString(PyExc_TypeError, "Cannot delete the number attribute");
+    return -1;
+  }
+
+	long number = PyInt_AsLong(value);
+	if (-1 == number && PyErr_Occurred()) {
+		return -1;
+	}
+	if (number < INT_MIN || number > INT_MAX) {
+    PyErr_SetString(PyExc_OverflowError, 
+                    "The number value must fit in a C int");
+    return -1;
 	}
+	self->number = (int)number;
+	tree_generation++;
 
   return 0;
 }
 
 static PyMethodDef module_methods[] = {
+	{"build", (PyCFunction)kdtree_build, METH_O,
+	 "Builds a packed KDTree from a sequence of (number, coords) tuples or a buffer of doubles"
+	},
 	{NULL}  /* Sentinel */
 };
 
@@ -557,9 +1162,22 @@ initkdtree(void) {
 	if (PyType_Ready(&KDTreeNodeType) < 0) {
 		return;
 	}
+	if (PyType_Ready(&KDTreeType) < 0) {
+		return;
+	}
+
+	PyObject *array_module = PyImport_ImportModule("array");
+	if (array_module == NULL) {
+		return;
+	}
+	array_type = PyObject_GetAttrString(array_module, "array");
+	Py_DECREF(array_module);
+	if (array_type == NULL) {
+		return;
+	}
 
 	m = Py_InitModule3("kdtree", module_methods,
-										 "A simple 2-dimensional KDTreeNode extension to Python.");
+										 "A simple KDTreeNode extension to Python.");
 
 	if (m == NULL) {
 		return;
@@ -567,4 +1185,6 @@ initkdtree(void) {
 
 	Py_INCREF(&KDTreeNodeType);
 	PyModule_AddObject(m, "KDTreeNode", (PyObject *)&KDTreeNodeType);
+	Py_INCREF(&KDTreeType);
+	PyModule_AddObject(m, "KDTree", (PyObject *)&KDTreeType);
 }
@@ -1,4 +1,42 @@
+import os
+import shutil
+import tempfile
+from distutils.ccompiler import new_compiler
+from distutils.errors import CompileError, LinkError
+from distutils.sysconfig import customize_compiler
 from distutils.core import setup, Extension
-setup(name="kdtree", version="1.0",
-      ext_modules=[Extension("kdtree", ["kdtree.c"])])
 
+
+def openmp_flags():
+    """Returns ['-fopenmp'] if the compiler builds and links a small OpenMP
+    program, and [] otherwise, so compilers without OpenMP, such as Apple's
+    clang, still build the module, single threaded."""
+    tmp = tempfile.mkdtemp()
+    try:
+        source = os.path.join(tmp, 'omp.c')
+        with open(source, 'w') as f:
+            f.write('#include <omp.h>\n'
+                    'int main(void) { return omp_get_max_threads() > 0 ? 0 : 1; }\n')
+        compiler = new_compiler()
+        customize_compiler(compiler)
+        try:
+            objects = compiler.compile([source], output_dir=tmp,
+                                       extra_postargs=['-fopenmp'])
+            compiler.link_executable(objects, os.path.join(tmp, 'omp'),
+                                     extra_postargs=['-fopenmp'])
+        except (CompileError, LinkError):
+            return []
+        return ['-fopenmp']
+    finally:
+        shutil.rmtree(tmp)
+
+
+# build() trees live in the C core shared with the Cython bindings
+sourcefiles = ['kdtree.c', 'cython_with_c/kdtree_raw.c']
+openmp = openmp_flags()
+
+setup(name="kdtree", version="1.0",
+      ext_modules=[Extension("kdtree", sourcefiles,
+                             include_dirs=['cython_with_c'],
+                             extra_compile_args=openmp,
+                             extra_link_args=openmp)])